@@ -0,0 +1,118 @@
+#!/bin/sh
+#
+# Tests the build cache: an unchanged language should be loaded from the cache, a change to the language or to
+# the options that affect the parser should build it again, and a corrupt entry should be ignored
+
+# Name of the tameparse runner (the compiler is run from the directory it writes to, so this needs to be absolute)
+tameparse=`pwd`/../../parsetool/tameparse
+
+# Work in a temporary directory
+work=`mktemp -d 2>/dev/null || echo /tmp/tameparse-cache-test.$$`
+mkdir -p ${work}
+trap "rm -rf ${work}" 0
+
+cache=${work}/cache
+success=1
+
+# Reports a failed test
+fail() {
+	echo "build-cache: $1 failed"
+	success=0
+}
+
+# Compiles a language with the cache turned on: compile <definition> <output name> [options...]
+# (The output filename is written into the generated code, so each compilation writes to 'test' in its own directory)
+compile() {
+	definition=$1
+	output=$2
+	shift 2
+
+	mkdir -p ${work}/${output}
+	(cd ${work}/${output} && ${tameparse} -v --build-cache ${cache} -T cplusplus -S '<Program>' -o test "$@" ${definition}) > ${work}/${output}.log 2>&1
+}
+
+# True if the last compilation of the specified output used the cache
+used_cache() {
+	grep -q "Using the lexer and parser from the build cache" ${work}/$1.log
+}
+
+# True if the last compilation of the specified output stored a new entry
+stored() {
+	grep -q "Stored lexer and parser in the build cache" ${work}/$1.log
+}
+
+# True if two compilations generated the same parser (ignoring the time they were generated at)
+same_file() {
+	grep -v "generated by TameParse at" ${work}/$1 > ${work}/first
+	grep -v "generated by TameParse at" ${work}/$2 > ${work}/second
+	cmp -s ${work}/first ${work}/second
+}
+
+same_output() {
+	same_file $1/test.cpp $2/test.cpp && same_file $1/test.h $2/test.h
+}
+
+# The language to compile
+cat > ${work}/Test.tp <<EOF
+language Test {
+	lexer {
+		identifier = /[a-z]+/
+	}
+
+	ignore {
+		whitespace = /[ \n]+/
+	}
+
+	grammar {
+		<Program> = <Statement>*
+		<Statement> = identifier "=" identifier ";"
+	}
+}
+EOF
+
+# The first compilation builds the parser and stores it
+compile ${work}/Test.tp miss || fail "Miss"
+stored miss || fail "Store"
+used_cache miss && fail "EmptyCache"
+
+# Entries are moved into place once they are complete, so no temporary files should be left behind
+ls ${cache} | grep -q "\.tmp$" && fail "NoTemporaryFiles"
+
+# Compiling again should load the parser from the cache and generate the same code
+compile ${work}/Test.tp hit || fail "Hit"
+used_cache hit || fail "HitUsedCache"
+same_output miss hit || fail "HitSameOutput"
+
+# Changing an option that affects the parser tables should miss the cache
+compile ${work}/Test.tp option --compress-tables || fail "OptionChange"
+used_cache option && fail "OptionChangeMissed"
+stored option || fail "OptionChangeStored"
+
+# Changing the grammar should also miss the cache
+sed -e 's/identifier "=" identifier ";"/identifier "=" identifier "+" identifier ";"/' ${work}/Test.tp > ${work}/Changed.tp
+
+compile ${work}/Changed.tp grammar || fail "GrammarChange"
+used_cache grammar && fail "GrammarChangeMissed"
+stored grammar || fail "GrammarChangeStored"
+
+# A corrupt entry should be ignored, and replaced by a rebuilt parser (cutting the entries in half keeps their key,
+# so this checks that the rest of the entry is validated)
+for entry in ${cache}/*.tpc
+do
+	size=`wc -c < ${entry}`
+	head -c `expr ${size} / 2` ${entry} > ${work}/truncated
+	mv ${work}/truncated ${entry}
+done
+
+compile ${work}/Test.tp corrupt || fail "Corrupt"
+used_cache corrupt && fail "CorruptIgnored"
+stored corrupt || fail "CorruptReplaced"
+same_output miss corrupt || fail "CorruptSameOutput"
+
+compile ${work}/Test.tp repaired || fail "Repaired"
+used_cache repaired || fail "RepairedUsedCache"
+
+# Return failure if any of the tests failed
+if [ "$success" -ne "1" ]; then
+	exit 1
+fi
@@ -0,0 +1,66 @@
+//
+//  binary.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include "TameParse/Compiler/OutputStages/binary.h"
+#include "TameParse/Compiler/profiler.h"
+#include "TameParse/Lr/binary_tables.h"
+
+using namespace std;
+using namespace dfa;
+using namespace compiler;
+
+/// \brief Creates a new output stage
+output_binary::output_binary(console_container& console, const std::wstring& filename, lexer_stage* lexer, language_stage* language, lr_parser_stage* parser, const std::wstring& filenamePrefix)
+: output_stage(console, filename, lexer, language, parser)
+, m_LexerStage(lexer)
+, m_ParserStage(parser)
+, m_FilenamePrefix(filenamePrefix) {
+}
+
+/// \brief Destructor
+output_binary::~output_binary() {
+}
+
+/// \brief Writes out the tables
+void output_binary::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"output_binary");
+    
+    // Can't write anything if the lexer or parser couldn't be built
+    if (!m_LexerStage->dfa() || !m_ParserStage->get_tables()) {
+        cons().report_error(error(error::sev_bug, filename(), L"BUG_NO_TABLES", L"The lexer or parser tables were not generated", position(-1, -1, -1)));
+        return;
+    }
+    
+    // Write out the tables
+    wstring     tablesFilename  = m_FilenamePrefix + L".tpt";
+    ostream*    tablesFile      = cons().open_binary_file_for_writing(tablesFilename);
+    
+    if (!tablesFile || !lr::binary_tables::write(*tablesFile, *m_LexerStage->dfa(), *m_ParserStage->get_tables())) {
+        cons().report_error(error(error::sev_error, tablesFilename, L"CANT_WRITE_TABLES", L"Unable to write the parser tables", position(-1, -1, -1)));
+    }
+    
+    delete tablesFile;
+}
@@ -0,0 +1,63 @@
+//
+//  binary.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _COMPILER_OUTPUT_BINARY_H
+#define _COMPILER_OUTPUT_BINARY_H
+
+#include <string>
+
+#include "TameParse/Compiler/output_stage.h"
+
+namespace compiler {
+    ///
+    /// \brief Output stage that writes the lexer and parser tables to a binary file
+    ///
+    /// The file can be loaded with lr::binary_tables. The start symbols are numbered in the order they were
+    /// specified, as they are for the C++ output.
+    ///
+    class output_binary : public output_stage {
+    private:
+        /// \brief The lexer stage that builds the lexer DFA
+        lexer_stage* m_LexerStage;
+        
+        /// \brief The parser stage that builds the parser tables
+        lr_parser_stage* m_ParserStage;
+        
+        /// \brief The prefix for the output file
+        std::wstring m_FilenamePrefix;
+        
+    public:
+        /// \brief Creates a new output stage
+        output_binary(console_container& console, const std::wstring& filename, lexer_stage* lexer, language_stage* language, lr_parser_stage* parser, const std::wstring& filenamePrefix);
+        
+        /// \brief Destructor
+        virtual ~output_binary();
+        
+        /// \brief Writes out the tables
+        virtual void compile();
+    };
+}
+
+#endif
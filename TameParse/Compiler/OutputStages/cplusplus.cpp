@@ -29,6 +29,7 @@
 #include <sstream>
 #include <algorithm>
 #include <locale>
+#include <map>
 
 #include "TameParse/Compiler/OutputStages/cplusplus.h"
 
@@ -44,13 +45,16 @@ static const string s_TypeSuffix = "_n";
 static const string s_ContentSuffix = "_content";
 
 /// \brief Creates a new output stage
-output_cplusplus::output_cplusplus(console_container& console, const std::wstring& filename, lexer_stage* lexer, language_stage* language, lr_parser_stage* parser, const std::wstring& filenamePrefix, const std::wstring& className, const std::wstring& namespaceName)
+output_cplusplus::output_cplusplus(console_container& console, const std::wstring& filename, lexer_stage* lexer, language_stage* language, lr_parser_stage* parser, const std::wstring& filenamePrefix, const std::wstring& className, const std::wstring& namespaceName, bool flatAst, bool statsParser, bool lazyAst)
 : output_stage(console, filename, lexer, language, parser)
 , m_FilenamePrefix(filenamePrefix)
 , m_ClassName(className)
 , m_Namespace(namespaceName)
 , m_SourceFile(NULL)
-, m_HeaderFile(NULL) {
+, m_HeaderFile(NULL)
+, m_FlatAst(flatAst)
+, m_StatsParser(statsParser)
+, m_LazyAst(lazyAst && !flatAst) {
 }
 
 /// \brief Destructor
@@ -269,7 +273,17 @@ void output_cplusplus::begin_output() {
 
     *m_HeaderFile << "#include \"TameParse/Util/syntax_ptr.h\"\n";
     *m_HeaderFile << "#include \"TameParse/Dfa/lexer.h\"\n";
+    *m_HeaderFile << "#include \"TameParse/Dfa/hard_coded_symbol_table.h\"\n";
+    *m_HeaderFile << "#include \"TameParse/Dfa/state_machine.h\"\n";
+    *m_HeaderFile << "#include \"TameParse/Dfa/symbol_reader.h\"\n";
     *m_HeaderFile << "#include \"TameParse/Lr/parser.h\"\n";
+    *m_HeaderFile << "#include \"TameParse/Lr/batch_parser.h\"\n";
+    *m_HeaderFile << "#include \"TameParse/Lr/incremental_parser.h\"\n";
+    *m_HeaderFile << "#include \"TameParse/Lr/push_parser.h\"\n";
+    if (m_LazyAst) {
+        *m_HeaderFile << "#include \"TameParse/Lr/lazy_ast.h\"\n";
+    }
+    *m_HeaderFile << "#include \"TameParse/Lr/recogniser.h\"\n";
     *m_HeaderFile << "#include \"TameParse/Lr/parser_tables.h\"\n";
     *m_HeaderFile << "\n";
     
@@ -461,9 +475,18 @@ void output_cplusplus::header_lexer_state_machine() {
     *m_HeaderFile << "\npublic:\n";
     *m_HeaderFile << "    static const dfa::lexer lexer;\n";
 
+    // The tables are also made available directly, so validation can run the lexer without any virtual calls
+    *m_HeaderFile << "\n";
+    *m_HeaderFile << "    typedef dfa::state_machine_tables<wchar_t, dfa::hard_coded_symbol_table<wchar_t, 2> > lexer_state_machine;\n";
+    *m_HeaderFile << "    static const lexer_state_machine lexer_tables;\n";
+    *m_HeaderFile << "    static const int lexer_accepting_states[];\n";
+
     // Add to the list of used class names
     m_UsedClassNames.insert("number_of_lexer_states");
     m_UsedClassNames.insert("lexer");
+    m_UsedClassNames.insert("lexer_state_machine");
+    m_UsedClassNames.insert("lexer_tables");
+    m_UsedClassNames.insert("lexer_accepting_states");
 }
 
 /// \brief Writes out the source code for the lexer state machine
@@ -542,7 +565,7 @@ void output_cplusplus::source_lexer_state_machine() {
     *m_SourceFile << "\n    };\n";
 
     // Write out the table of state actions
-    *m_SourceFile << "\nstatic const int s_AcceptingStates[] = {\n        ";
+    *m_SourceFile << "\nconst int " << get_identifier(m_ClassName, false) << "::lexer_accepting_states[] = {\n        ";
 
     // Iterate through the action table
     for (lexer_state_action_iterator act = begin_lexer_state_action(); act != end_lexer_state_action(); ++act) {
@@ -564,12 +587,12 @@ void output_cplusplus::source_lexer_state_machine() {
     *m_SourceFile << "\n    };\n";
 
     // Create a state machine
-    *m_SourceFile << "\ntypedef dfa::state_machine_tables<wchar_t, dfa::hard_coded_symbol_table<wchar_t, 2> > lexer_state_machine;\n";
-    *m_SourceFile << "static const lexer_state_machine s_StateMachine(s_SymbolMap, s_LexerStates, " << stateToEntryOffset.size()-1 << ");\n";
+    string className = get_identifier(m_ClassName, false);
+    *m_SourceFile << "\nconst " << className << "::lexer_state_machine " << className << "::lexer_tables(s_SymbolMap, s_LexerStates, " << stateToEntryOffset.size()-1 << ");\n";
 
     // Create the lexer itself
-    *m_SourceFile << "\ntypedef dfa::dfa_lexer_base<const lexer_state_machine&, 0, 0, false, const lexer_state_machine&> lexer_definition;\n";
-    *m_SourceFile << "static lexer_definition s_LexerDefinition(s_StateMachine, " << stateToEntryOffset.size()-1 << ", s_AcceptingStates);\n";
+    *m_SourceFile << "\ntypedef dfa::dfa_lexer_base<const " << className << "::lexer_state_machine&, 0, 0, false, const " << className << "::lexer_state_machine&> lexer_definition;\n";
+    *m_SourceFile << "static lexer_definition s_LexerDefinition(" << className << "::lexer_tables, " << stateToEntryOffset.size()-1 << ", " << className << "::lexer_accepting_states);\n";
 
     // Finally, the lexer class itself
     *m_SourceFile << "\nconst dfa::lexer " << get_identifier(m_ClassName, false) << "::lexer(&s_LexerDefinition, false);\n";
@@ -598,9 +621,16 @@ void output_cplusplus::define_parser_tables() {
 typedef lr::parser_tables::action action;
 
 /// \brief Writes out an action table
+///
+/// States with identical sets of actions share a single row in the table
 template<class get_count> void write_action_table(string tableName, const lr::parser_tables::action* const* actionTable, const lr::parser_tables& tables, ostream& output) {
     // Count getter object
     get_count gc;
+    
+    // Maps the content of each row to the state it was first written for
+    typedef vector<int>             row_content;
+    map<row_content, int>           rowStates;
+    vector<int>                     rowOffsets;
 
     // Start the table
     output << "static lr::parser_tables::action " << tableName << "_data[] = {";
@@ -612,6 +642,24 @@ template<class get_count> void write_action_table(string tableName, const lr::pa
         // Add the actions for this state
         int numActions = gc(tables, state);
         
+        // Use the row from an earlier state if it has the same actions
+        row_content content;
+        for (int actionId = 0; actionId < numActions; ++actionId) {
+            const action& thisAction = actionTable[state][actionId];
+            content.push_back(thisAction.type);
+            content.push_back(thisAction.nextState);
+            content.push_back(thisAction.symbolId);
+        }
+        
+        map<row_content, int>::iterator existing = rowStates.find(content);
+        if (existing != rowStates.end()) {
+            rowOffsets.push_back(rowOffsets[existing->second]);
+            continue;
+        }
+        
+        rowStates[content] = state;
+        rowOffsets.push_back(count);
+        
         bool showingState = true;
         output << "\n\n    // State " << state << "\n    ";
 
@@ -642,7 +690,6 @@ template<class get_count> void write_action_table(string tableName, const lr::pa
     // Output the final table
     output << "static lr::parser_tables::action* " << tableName << "[] = {";
 
-    int pos = 0;
     count   = 0;
     first   = true;
     
@@ -658,11 +705,7 @@ template<class get_count> void write_action_table(string tableName, const lr::pa
         }
 
         // Output this state
-        output << tableName << "_data + " << pos;
-        
-        // Add the actions for this state
-        int numActions = gc(tables, state);
-        pos += numActions;
+        output << tableName << "_data + " << rowOffsets[state];
         
         // Move on
         ++count;
@@ -822,6 +865,67 @@ void output_cplusplus::source_parser_tables() {
     
     *m_SourceFile << "\n};\n";
     
+    // The default reductions, if the tables have been compressed
+    if (tables.default_reductions()) {
+        *m_SourceFile << "\nstatic int s_DefaultReductions[] = {";
+        
+        first   = true;
+        count   = 0;
+        for (int stateId=0; stateId < tables.count_states(); ++stateId) {
+            // Comma
+            if (!first) {
+                *m_SourceFile << ", ";
+            }
+            
+            // Newline
+            if ((count%20) == 0) {
+                *m_SourceFile << "\n    ";
+            }
+            
+            // Write out the next item
+            *m_SourceFile << tables.default_reductions()[stateId];
+            
+            // Move on
+            first = false;
+            ++count;
+        }
+        
+        *m_SourceFile << "\n};\n";
+    }
+    
+    // The terminals that have actions in each state, used to find the symbols that the parser can accept
+    if (tables.expected_terminals()) {
+        *m_SourceFile << "\nstatic unsigned int s_ExpectedTerminals[] = {";
+        
+        first   = true;
+        count   = 0;
+        for (int wordId=0; wordId < tables.count_states() * tables.expected_words(); ++wordId) {
+            // Comma
+            if (!first) {
+                *m_SourceFile << ", ";
+            }
+            
+            // Newline
+            if ((count%10) == 0) {
+                *m_SourceFile << "\n    ";
+            }
+            
+            // Write out the next item
+            *m_SourceFile << tables.expected_terminals()[wordId] << "u";
+            
+            // Move on
+            first = false;
+            ++count;
+        }
+        
+        // The array can't be empty
+        if (first) {
+            *m_SourceFile << "\n    0u";
+        }
+        
+        *m_SourceFile << "\n};\n";
+    }
+    
     // Generate the parser tables
     *m_SourceFile   << "\nconst lr::parser_tables " << get_identifier(m_ClassName, false) << "::lr_tables(" 
                     << tables.count_states() << ", " << tables.end_of_input() << ", " 
@@ -830,7 +934,13 @@ void output_cplusplus::source_parser_tables() {
                     << tables.count_end_of_guards() << ", " << tables.count_reduce_rules() << ", "
                     << "s_ReduceRules, " << tables.count_weak_to_strong() << ", "
                     << "s_WeakToStrong"
-                    << ");\n";
+                    << (tables.default_reductions() ? ", s_DefaultReductions" : (tables.expected_terminals() ? ", NULL" : ""));
+    
+    if (tables.expected_terminals()) {
+        *m_SourceFile << ", " << tables.count_terminals() << ", s_ExpectedTerminals";
+    }
+    
+    *m_SourceFile   << ");\n";
 
     // Add to the list of used class names
     m_UsedClassNames.insert("lr_tables");
@@ -842,6 +952,12 @@ void output_cplusplus::source_parser_tables() {
 
 /// \brief Writes out the AST tables
 void output_cplusplus::define_ast_tables() {
+    // The flat AST is generated separately
+    if (m_FlatAst) {
+        define_flat_ast_tables();
+        return;
+    }
+
     header_ast_forward_declarations();
     header_ast_class_declarations();
     header_parser_actions();
@@ -856,10 +972,31 @@ void output_cplusplus::define_ast_tables() {
     *m_HeaderFile   << "\npublic:\n"
                     << "    typedef util::syntax_ptr<syntax_node> syntax_node_container;\n"
                     << "    typedef lr::parser<syntax_node_container, parser_actions> ast_parser_type;\n"
-                    << "    static const ast_parser_type ast_parser;\n";
+                    << "    static const ast_parser_type ast_parser;\n"
+                    << "\n"
+                    << "    typedef lr::batch_parser<syntax_node_container, parser_actions, lr::no_parser_trace, lr::owned_stream_actions_factory<parser_actions> > batch_parser_type;\n"
+                    << "\n"
+                    << "    typedef lr::incremental_parser<syntax_node_container, parser_actions, lr::owned_stream_actions_factory<parser_actions> > incremental_parser_type;\n"
+                    << "\n"
+                    << "    typedef lr::push_parser<syntax_node_container, parser_actions, lr::no_parser_trace, lr::owned_stream_actions_factory<parser_actions> > push_parser_type;\n";
     
     *m_SourceFile   << "\nconst " << get_identifier(m_ClassName, false) << "::ast_parser_type " << get_identifier(m_ClassName, false) << "::ast_parser(&lr_tables, false);\n";
 
+    if (m_StatsParser) {
+        *m_HeaderFile   << "\n"
+                        << "    typedef lr::parser<syntax_node_container, parser_actions, lr::stats_parser_trace> stats_parser_type;\n"
+                        << "    static const stats_parser_type stats_parser;\n";
+        *m_SourceFile   << "const " << get_identifier(m_ClassName, false) << "::stats_parser_type " << get_identifier(m_ClassName, false) << "::stats_parser(&lr_tables, false);\n";
+    }
+
+    if (m_LazyAst) {
+        *m_HeaderFile   << "\n"
+                        << "    typedef lr::parser<lr::reduction_log::entry_id, lr::reduction_log_actions> lazy_parser_type;\n"
+                        << "    static const lazy_parser_type lazy_parser;\n"
+                        << "    typedef lr::lazy_ast<parser_actions> lazy_ast;\n";
+        *m_SourceFile   << "const " << get_identifier(m_ClassName, false) << "::lazy_parser_type " << get_identifier(m_ClassName, false) << "::lazy_parser(&lr_tables, false);\n";
+    }
+
     // Generate functions for creating new parsers
     header_start_symbols();
 }
@@ -870,6 +1007,23 @@ void output_cplusplus::header_start_symbols() {
     *m_HeaderFile   << "\npublic:\n"
                     << "    typedef ast_parser_type::state state;\n";
 
+    if (m_StatsParser) {
+        *m_HeaderFile << "    typedef stats_parser_type::state stats_state;\n";
+    }
+
+    if (m_LazyAst) {
+        *m_HeaderFile << "    typedef lazy_parser_type::state lazy_state;\n";
+    }
+
+    // Validation runs the lexer tables and the parser tables together in one loop (see dfa::symbol_reader)
+    *m_HeaderFile   << "\n"
+                    << "    template<typename char_type, typename custom_stream_alike> inline static bool validate(custom_stream_alike& input, int initialState, lr::recogniser& recogniser) {\n"
+                    << "        dfa::symbol_reader<const lexer_state_machine&, custom_stream_alike, char_type> reader(lexer_tables, lexer_accepting_states, input);\n"
+                    << "        return recogniser.recognise_from(reader, initialState);\n"
+                    << "    }\n"
+                    << "\n";
+    m_UsedClassNames.insert("validate");
+
     // Fetch the start symbols
     const vector<wstring>& startSymbols = get_start_symbols();
 
@@ -897,6 +1051,82 @@ void output_cplusplus::header_start_symbols() {
                         << "        return create_" << startName << "(lexer.create_stream_from<char_type, custom_stream_alike>(input), true);\n"
                         << "    }\n";
 
+        // Versions that collect statistics about the parse (retrieved with get_trace().stats() once the parse is complete)
+        if (m_StatsParser) {
+            *m_HeaderFile   << "\n"
+                            << "    inline static stats_state* create_stats_" << startName << "(parser_actions* actions) {\n"
+                            << "        return stats_parser.create_parser(actions, " << initialState << ");\n"
+                            << "    }\n"
+                            << "\n"
+                            << "    inline static stats_state* create_stats_" << startName << "(dfa::lexeme_stream* stream, bool deleteStream = false) {\n"
+                            << "        return stats_parser.create_parser(new parser_actions(stream, deleteStream), " << initialState << ");\n"
+                            << "    }\n"
+                            << "\n"
+                            << "    template<typename char_type, typename traits> inline static stats_state* create_stats_" << startName << "(std::basic_istream<char_type, traits>& input) {\n"
+                            << "        return create_stats_" << startName << "(lexer.create_stream_from<char_type, traits>(input), true);\n"
+                            << "    }\n";
+        }
+
+        // Validation only: runs the lexer and parser tables without building anything
+        *m_HeaderFile   << "\n"
+                        << "    inline static bool validate_" << startName << "(dfa::lexeme_stream* stream, lr::recogniser& recogniser) {\n"
+                        << "        return recogniser.recognise(stream, " << initialState << ");\n"
+                        << "    }\n"
+                        << "\n"
+                        << "    template<typename char_type, typename traits> inline static bool validate_" << startName << "(std::basic_istream<char_type, traits>& input, lr::recogniser& recogniser) {\n"
+                        << "        return validate<char_type>(input, " << initialState << ", recogniser);\n"
+                        << "    }\n"
+                        << "\n"
+                        << "    template<typename char_type, typename traits> inline static bool validate_" << startName << "(std::basic_istream<char_type, traits>& input) {\n"
+                        << "        lr::recogniser recogniser(lr_tables);\n"
+                        << "        return validate_" << startName << "(input, recogniser);\n"
+                        << "    }\n";
+
+        if (m_FlatAst) {
+            // Flat ASTs are retrieved from the pool belonging to the parser state
+            for (nonterminal_symbol_iterator nonterm = begin_nonterminal_symbol(); nonterm != end_nonterminal_symbol(); ++nonterm) {
+                if (nonterm->item->type() != item::nonterminal) continue;
+                if (gram().name_for_nonterminal(nonterm->item->symbol()) != *startSymbol) continue;
+
+                string rootName = class_name_for_item(nonterm->item) + s_TypeSuffix;
+                *m_HeaderFile   << "\n"
+                                << "    template<typename state_type> inline static " << rootName << " get_" << startName << "(const state_type* parseState) {\n"
+                                << "        return " << rootName << "(&parseState->get_actions()->pool(), parseState->get_item());\n"
+                                << "    }\n";
+                break;
+            }
+        } else {
+            // Batch parser for this start symbol (the caller should delete the result)
+            *m_HeaderFile   << "\n"
+                            << "    inline static batch_parser_type* create_batch_" << startName << "(int numThreads = 0) {\n"
+                            << "        return new batch_parser_type(ast_parser, lexer, " << initialState << ", numThreads);\n"
+                            << "    }\n";
+
+            // Incremental parser for this start symbol (the caller should delete the result)
+            *m_HeaderFile   << "\n"
+                            << "    inline static incremental_parser_type* create_incremental_" << startName << "(size_t checkpointInterval = 64) {\n"
+                            << "        return new incremental_parser_type(lr_tables, lexer, " << initialState << ", checkpointInterval);\n"
+                            << "    }\n";
+
+            // Push parser for this start symbol (the caller should delete the result)
+            *m_HeaderFile   << "\n"
+                            << "    inline static push_parser_type* create_push_" << startName << "() {\n"
+                            << "        return new push_parser_type(ast_parser, lexer, " << initialState << ");\n"
+                            << "    }\n";
+
+            // Parsers that record a reduction log; the AST is built from the log with lazy_ast when it is needed
+            if (m_LazyAst) {
+                *m_HeaderFile   << "\n"
+                                << "    inline static lazy_state* create_lazy_" << startName << "(dfa::lexeme_stream* stream, bool deleteStream = false) {\n"
+                                << "        return lazy_parser.create_parser(new lr::reduction_log_actions(stream, deleteStream), " << initialState << ");\n"
+                                << "    }\n"
+                                << "\n"
+                                << "    template<typename char_type, typename traits> inline static lazy_state* create_lazy_" << startName << "(std::basic_istream<char_type, traits>& input) {\n"
+                                << "        return create_lazy_" << startName << "(lexer.create_stream_from<char_type, traits>(input), true);\n"
+                                << "    }\n";
+            }
+        }
+
         // Move the initial state on
         initialState++;
     }
@@ -1358,7 +1588,12 @@ void output_cplusplus::source_ast_position_functions() {
 
                 // This item has a variable, so we can return its first position as the position of this item
                 foundValid = true;
-                *m_SourceFile << "        return " << get_identifier(ruleItem->uniqueName, false) << "->pos();\n";
+                if (ruleItem->item->type() == item::terminal) {
+                    *m_SourceFile << "        return " << get_identifier(ruleItem->uniqueName, false) << "->pos();\n";
+                } else {
+                    // Nonterminals are NULL if they were passed to a callback instead
+                    *m_SourceFile << "        return " << get_identifier(ruleItem->uniqueName, false) << ".item() ? " << get_identifier(ruleItem->uniqueName, false) << "->pos() : dfa::position(-1, -1, -1);\n";
+                }
 
                 // Only write out a single position item
                 break;
@@ -1400,7 +1635,12 @@ void output_cplusplus::source_ast_position_functions() {
 
                 // This item has a variable, so we can return its final position as the position of this item
                 foundValid = true;
-                *m_SourceFile << "        return " << get_identifier(ruleItem->uniqueName, false) << "->final_pos();\n";
+                if (ruleItem->item->type() == item::terminal) {
+                    *m_SourceFile << "        return " << get_identifier(ruleItem->uniqueName, false) << "->final_pos();\n";
+                } else {
+                    // Nonterminals are NULL if they were passed to a callback instead
+                    *m_SourceFile << "        return " << get_identifier(ruleItem->uniqueName, false) << ".item() ? " << get_identifier(ruleItem->uniqueName, false) << "->final_pos() : dfa::position(-1, -1, -1);\n";
+                }
 
                 // Only write out a single position item
                 break;
@@ -1445,9 +1685,20 @@ void output_cplusplus::header_parser_actions() {
                     << "        typedef lr::parser<node, parser_actions> parser;\n"
                     << "        typedef parser::reduce_list reduce_list;\n"
                     << "\n"
+                    << "        typedef void (*subtree_callback)(const node& subtree, void* context);\n"
+                    << "\n"
                     << "    private:\n"
+                    << "        struct callback {\n"
+                    << "            int nonterminal;\n"
+                    << "            subtree_callback function;\n"
+                    << "            void* context;\n"
+                    << "        };\n"
+                    << "        typedef std::vector<callback> callback_list;\n"
+                    << "\n"
                     << "        dfa::lexeme_stream* m_Stream;\n"
                     << "        bool m_OwnStream;\n"
+                    << "        dfa::lexeme_batch_reader m_Reader;\n"
+                    << "        callback_list m_Callbacks;\n"
                     << "\n"
                     << "        parser_actions(parser_actions& noCopying);\n"
                     << "        parser_actions& operator=(const parser_actions& noCopying);\n"
@@ -1455,7 +1706,8 @@ void output_cplusplus::header_parser_actions() {
                     << "    public:\n"
                     << "        parser_actions(dfa::lexeme_stream* stream, bool ownStream = false)\n"
                     << "        : m_Stream(stream)\n"
-                    << "        , m_OwnStream(ownStream) { }\n"
+                    << "        , m_OwnStream(ownStream)\n"
+                    << "        , m_Reader(stream) { }\n"
                     << "\n"
                     << "        ~parser_actions() {\n"
                     << "            if (m_OwnStream && m_Stream) {\n"
@@ -1464,15 +1716,50 @@ void output_cplusplus::header_parser_actions() {
                     << "            }\n"
                     << "        }\n"
                     << "\n"
+                    << "        inline void reset(dfa::lexeme_stream* stream) {\n"
+                    << "            if (m_OwnStream && m_Stream && m_Stream != stream) {\n"
+                    << "                delete m_Stream;\n"
+                    << "            }\n"
+                    << "            m_Stream = stream;\n"
+                    << "            m_Reader.reset(stream);\n"
+                    << "        }\n"
+                    << "\n"
+                    << "        inline void set_batched(bool batched) {\n"
+                    << "            m_Reader.set_batched(batched);\n"
+                    << "        }\n"
+                    << "\n"
                     << "        inline dfa::lexeme* read() {\n"
-                    << "            dfa::lexeme* result = NULL;\n"
-                    << "            (*m_Stream) >> result;\n"
-                    << "            return result;\n"
+                    << "            return m_Reader.read();\n"
+                    << "        }\n"
+                    << "\n"
+                    << "        inline void on_reduce(int nonterminal, subtree_callback function, void* context = NULL) {\n"
+                    << "            for (callback_list::iterator existing = m_Callbacks.begin(); existing != m_Callbacks.end(); ++existing) {\n"
+                    << "                if (existing->nonterminal == nonterminal) {\n"
+                    << "                    existing->function  = function;\n"
+                    << "                    existing->context   = context;\n"
+                    << "                    return;\n"
+                    << "                }\n"
+                    << "            }\n"
+                    << "\n"
+                    << "            callback newCallback = { nonterminal, function, context };\n"
+                    << "            m_Callbacks.push_back(newCallback);\n"
                     << "        }\n"
                     << "\n"
                     << "        node shift(const dfa::lexeme_container& lexeme);\n"
                     << "\n"
-                    << "        node reduce(int nonterminal, int rule, const reduce_list& reduce, const dfa::position& lookaheadPosition);\n"
+                    << "        inline node reduce(int nonterminal, int rule, const reduce_list& reduce, const dfa::position& lookaheadPosition) {\n"
+                    << "            for (callback_list::const_iterator handler = m_Callbacks.begin(); handler != m_Callbacks.end(); ++handler) {\n"
+                    << "                if (handler->nonterminal == nonterminal) {\n"
+                    << "                    handler->function(create_node(rule, reduce, lookaheadPosition), handler->context);\n"
+                    << "                    return node();\n"
+                    << "                }\n"
+                    << "            }\n"
+                    << "\n"
+                    << "            return create_node(rule, reduce, lookaheadPosition);\n"
+                    << "        }\n"
+                    << "\n"
+                    << "    private:\n"
+                    << "        node create_node(int rule, const reduce_list& reduce, const dfa::position& lookaheadPosition);\n"
                     << "    };\n";
 }
 
@@ -1511,7 +1798,7 @@ void output_cplusplus::source_reduce_actions() {
 
     // Declare the reduce function
     *m_SourceFile   << "\n"
-                    << className << "::parser_actions::node " << className << "::parser_actions::reduce(int nonterminal, int rule, const reduce_list& reduce, const dfa::position& lookaheadPosition) {\n"
+                    << className << "::parser_actions::node " << className << "::parser_actions::create_node(int rule, const reduce_list& reduce, const dfa::position& lookaheadPosition) {\n"
                     << "    switch (rule) {";
 
     // Iterate through the nonterminals
@@ -1569,16 +1856,14 @@ void output_cplusplus::source_reduce_actions() {
                 hasConstructor = false;
             }
 
+            // The reduce list entries for the nonterminals in the content item (these are empty if they were passed to a callback)
+            vector<size_t> nonterminalItems;
+
+            // The parameters for the constructor of the content item
+            stringstream contentParameters;
+
             // Construct the content item for any item with a constructor, or all of the items for a repeating item
             if (hasConstructor || nonterm->item->type() == item::repeat) {
-                if (nonterm->item->type() == item::repeat || nonterm->item->type() == item::repeat_zero_or_one) {
-                    // For repeating items, we construct the content into a variable
-                    *m_SourceFile << "        util::syntax_ptr<class " << ntContentClass << "> content(new " << ntContentClass << "(";
-                } else {
-                    // For non-repeating items, just return the item directly
-                    *m_SourceFile << "        return node(new " << ntContentClass << "(";
-                }
-
                 // Generate the constructor parameters
                 bool first = true;
                 for (size_t index = 0; index < ruleDefn->second.size(); ++index) {
@@ -1596,7 +1881,7 @@ void output_cplusplus::source_reduce_actions() {
 
                     // Add commas to separate the values
                     if (!first) {
-                        *m_SourceFile << ", ";
+                        contentParameters << ", ";
                     }
                     first = false;
 
@@ -1604,15 +1889,22 @@ void output_cplusplus::source_reduce_actions() {
                     size_t reduceIndex = ruleDefn->second.size() - index - 1;
 
                     // Cast to the type
-                    *m_SourceFile  << "reduce[" << reduceIndex << "].cast_to<" << typeName << s_TypeSuffix << ">()";
+                    contentParameters << "reduce[" << reduceIndex << "].cast_to<" << typeName << s_TypeSuffix << ">()";
+
+                    if (ruleItem.item->type() != item::terminal) {
+                        nonterminalItems.push_back(reduceIndex);
+                    }
                 }
 
                 // If there aren't any valid items, then pass in the lookahead position (these items will take a position parameter)
                 if (first) {
-                    *m_SourceFile << "lookaheadPosition";
+                    contentParameters << "lookaheadPosition";
                 }
 
-                *m_SourceFile << "));\n";
+                // Non-repeating items just return the item directly (repeating items construct it when adding it to the list)
+                if (!repeating) {
+                    *m_SourceFile << "        return node(new " << ntContentClass << "(" << contentParameters.str() << "));\n";
+                }
             }
 
             // For repeating items either create or retrieve the node
@@ -1626,7 +1918,8 @@ void output_cplusplus::source_reduce_actions() {
                     *m_SourceFile << "        util::syntax_ptr<class " << ntName << "> list(";
 
                     // If the first item is a repetition then use that, otherwise create a new item
-                    if (!ruleDefn->second.empty() && ruleDefn->second[0].isEbnfRepetition) {
+                    bool existingList = !ruleDefn->second.empty() && ruleDefn->second[0].isEbnfRepetition;
+                    if (existingList) {
                         // The first item is the repetition
                         *m_SourceFile << "reduce[" << ruleDefn->second.size()-1 << "].cast_to<" << ntName << ">());\n";
                     } else {
@@ -1637,9 +1930,31 @@ void output_cplusplus::source_reduce_actions() {
                         *m_SourceFile << "        const_cast<" << ntName << "*>(list.item())->set_position(lookaheadPosition);\n";
                     }
 
-                    // Add the content as a child item
+                    // Construct the content and add it as a child item, unless part of it was passed to a callback
+                    // (so streaming parsers don't build up a list of the items that they have already handled), or
+                    // there is no existing list (lr::lazy_ast doesn't build the nonterminals in a rule). The content
+                    // is only constructed once these have been checked, so discarded items don't allocate a node.
                     // Hideous const cast :-(
-                    *m_SourceFile << "        const_cast<" << ntName << "*>(list.item())->add_child(content);\n";
+                    string indent = "        ";
+                    if (!nonterminalItems.empty() || existingList) {
+                        *m_SourceFile << "        if (";
+                        if (existingList) {
+                            *m_SourceFile << "list.item()";
+                        }
+                        for (size_t index = 0; index < nonterminalItems.size(); ++index) {
+                            if (index > 0 || existingList) *m_SourceFile << " && ";
+                            *m_SourceFile << "reduce[" << nonterminalItems[index] << "].item()";
+                        }
+                        *m_SourceFile << ") {\n";
+                        indent = "            ";
+                    }
+                    
+                    *m_SourceFile << indent << "util::syntax_ptr<class " << ntContentClass << "> content(new " << ntContentClass << "(" << contentParameters.str() << "));\n";
+                    *m_SourceFile << indent << "const_cast<" << ntName << "*>(list.item())->add_child(content);\n";
+                    
+                    if (!nonterminalItems.empty() || existingList) {
+                        *m_SourceFile << "        }\n";
+                    }
 
                     // Cast to a node and return
                     *m_SourceFile << "        return list.cast_to<syntax_node>();\n";
@@ -1657,3 +1972,543 @@ void output_cplusplus::source_reduce_actions() {
                     << "    }\n"
                     << "}\n";
 }
+
+//              ==========
+//               Flat AST
+//              ==========
+
+/// \brief Retrieves the fields declared for a nonterminal in a flat AST, and whether or not it needs a position field
+void output_cplusplus::flat_fields_for_nonterminal(const ast_nonterminal& ntDefn, flat_field_list& fields, bool& needsPosition) {
+    // The names of the variables that have already been added
+    set<string> definedVariables;
+    needsPosition = false;
+
+    for (ast_nonterminal_rules::const_iterator ruleDefn = ntDefn.rules.begin(); ruleDefn != ntDefn.rules.end(); ++ruleDefn) {
+        bool validItems = false;
+
+        for (ast_rule_item_list::const_iterator ruleItem = ruleDefn->second.begin(); ruleItem != ruleDefn->second.end(); ++ruleItem) {
+            // Guards and the repeating item in an EBNF closure don't get fields
+            if (ruleItem->item->type() == item::guard) continue;
+            if (ruleItem->isEbnfRepetition) continue;
+
+            validItems = true;
+
+            // Variables that appear in more than one rule share a field
+            string varName = get_identifier(ruleItem->uniqueName, false);
+            if (definedVariables.find(varName) != definedVariables.end()) continue;
+
+            fields.push_back(make_pair(varName, class_name_for_item(ruleItem->item) + s_TypeSuffix));
+            definedVariables.insert(varName);
+        }
+
+        // Empty rules store the position where they were reduced
+        if (!validItems) {
+            needsPosition = true;
+        }
+    }
+}
+
+/// \brief Writes out the data structures and handle classes for a flat AST to the header file
+void output_cplusplus::header_flat_ast_declarations() {
+    // Nodes are identified by their index in the array for their type
+    *m_HeaderFile   << "\n"
+                    << "public:\n"
+                    << "    typedef unsigned int node_index;\n"
+                    << "    static const node_index no_node = 0xffffffffu;\n"
+                    << "\n"
+                    << "    class ast_pool;\n"
+                    << "    class terminal;\n";
+
+    // Forward declarations for the handle classes
+    for (terminal_symbol_iterator term = begin_terminal_symbol(); term != end_terminal_symbol(); ++term) {
+        *m_HeaderFile << "    class " << class_name_for_item(term->item) << s_TypeSuffix << ";\n";
+    }
+
+    for (nonterminal_symbol_iterator nonterm = begin_nonterminal_symbol(); nonterm != end_nonterminal_symbol(); ++nonterm) {
+        if (nonterm->item->type() == item::guard) continue;
+
+        string ntName = class_name_for_item(nonterm->item) + s_TypeSuffix;
+        *m_HeaderFile << "    class " << ntName << ";\n";
+
+        if (nonterm->item->type() == item::repeat || nonterm->item->type() == item::repeat_zero_or_one) {
+            *m_HeaderFile << "    class " << ntName << s_ContentSuffix << ";\n";
+        }
+    }
+
+    // Terminals refer to a span of the text stored in the pool
+    *m_HeaderFile   << "\n"
+                    << "    struct terminal_data {\n"
+                    << "        int matched;\n"
+                    << "        unsigned int offset;\n"
+                    << "        unsigned int length;\n"
+                    << "        dfa::position pos;\n"
+                    << "    };\n";
+
+    // Nonterminals store the rule that was matched and the indexes of their children
+    for (nonterminal_symbol_iterator nonterm = begin_nonterminal_symbol(); nonterm != end_nonterminal_symbol(); ++nonterm) {
+        if (nonterm->item->type() == item::guard) continue;
+
+        string  ntName      = class_name_for_item(nonterm->item) + s_TypeSuffix;
+        bool    repeating   = nonterm->item->type() == item::repeat || nonterm->item->type() == item::repeat_zero_or_one;
+        string  contentName = repeating ? ntName + s_ContentSuffix : ntName;
+
+        flat_field_list fields;
+        bool            needsPosition;
+        flat_fields_for_nonterminal(get_ast_nonterminal(nonterm->identifier), fields, needsPosition);
+
+        // The list node for a closure holds the position instead of the content
+        if (repeating) needsPosition = false;
+
+        *m_HeaderFile   << "\n"
+                        << "    struct " << contentName << "_data {\n"
+                        << "        int m_Rule;\n";
+
+        for (flat_field_list::const_iterator field = fields.begin(); field != fields.end(); ++field) {
+            *m_HeaderFile << "        node_index " << field->first << ";\n";
+        }
+        if (repeating)      *m_HeaderFile << "        node_index m_Next;\n";
+        if (needsPosition)  *m_HeaderFile << "        dfa::position m_Position;\n";
+
+        *m_HeaderFile << "\n        " << contentName << "_data() : m_Rule(-1)";
+        for (flat_field_list::const_iterator field = fields.begin(); field != fields.end(); ++field) {
+            *m_HeaderFile << ", " << field->first << "(no_node)";
+        }
+        if (repeating) *m_HeaderFile << ", m_Next(no_node)";
+        *m_HeaderFile   << " { }\n"
+                        << "    };\n";
+
+        // Closures are stored as a linked list of their content items
+        if (repeating) {
+            *m_HeaderFile   << "\n"
+                            << "    struct " << ntName << "_data {\n"
+                            << "        node_index m_First;\n"
+                            << "        node_index m_Last;\n"
+                            << "        unsigned int m_Count;\n"
+                            << "        dfa::position m_Position;\n"
+                            << "\n"
+                            << "        " << ntName << "_data() : m_First(no_node), m_Last(no_node), m_Count(0) { }\n"
+                            << "    };\n";
+        }
+    }
+
+    // The base class for the terminal handles
+    *m_HeaderFile   << "\n"
+                    << "    class terminal {\n"
+                    << "    protected:\n"
+                    << "        const ast_pool* m_Pool;\n"
+                    << "        node_index m_Index;\n"
+                    << "\n"
+                    << "    public:\n"
+                    << "        terminal(const ast_pool* pool = NULL, node_index index = no_node) : m_Pool(pool), m_Index(index) { }\n"
+                    << "\n"
+                    << "        inline const terminal* item() const { return m_Index == no_node ? NULL : this; }\n"
+                    << "        inline const terminal* operator->() const { return this; }\n"
+                    << "        inline node_index get_index() const { return m_Index; }\n"
+                    << "\n"
+                    << "        inline int matched() const { return m_Pool->terminal_nodes[m_Index].matched; }\n"
+                    << "\n"
+                    << "        template<class symbol_type> inline std::basic_string<symbol_type> content() const {\n"
+                    << "            const terminal_data& lexeme = m_Pool->terminal_nodes[m_Index];\n"
+                    << "            std::basic_string<symbol_type> result;\n"
+                    << "            result.reserve(lexeme.length);\n"
+                    << "            for (unsigned int offset = lexeme.offset; offset < lexeme.offset + lexeme.length; ++offset) {\n"
+                    << "                result += (symbol_type) m_Pool->text[offset];\n"
+                    << "            }\n"
+                    << "            return result;\n"
+                    << "        }\n"
+                    << "\n"
+                    << "        inline dfa::position pos() const { return m_Pool->terminal_nodes[m_Index].pos; }\n"
+                    << "\n"
+                    << "        inline dfa::position final_pos() const {\n"
+                    << "            const terminal_data& lexeme = m_Pool->terminal_nodes[m_Index];\n"
+                    << "            dfa::position_tracker tracker(lexeme.pos);\n"
+                    << "            tracker.update_position(m_Pool->text.begin() + lexeme.offset, m_Pool->text.begin() + lexeme.offset + lexeme.length);\n"
+                    << "            return tracker.current_position();\n"
+                    << "        }\n"
+                    << "    };\n";
+
+    // Each terminal has its own handle type
+    for (terminal_symbol_iterator term = begin_terminal_symbol(); term != end_terminal_symbol(); ++term) {
+        string name = class_name_for_item(term->item) + s_TypeSuffix;
+
+        *m_HeaderFile   << "\n    // " << get_identifier(terminals().name_for_symbol(term->identifier), true) << "\n"
+                        << "    class " << name << " : public terminal {\n"
+                        << "    public:\n"
+                        << "        " << name << "(const ast_pool* pool = NULL, node_index index = no_node) : terminal(pool, index) { }\n"
+                        << "    };\n";
+    }
+
+    // Nonterminal handles have an accessor for each field
+    for (nonterminal_symbol_iterator nonterm = begin_nonterminal_symbol(); nonterm != end_nonterminal_symbol(); ++nonterm) {
+        if (nonterm->item->type() == item::guard) continue;
+
+        string  ntName      = class_name_for_item(nonterm->item) + s_TypeSuffix;
+        bool    repeating   = nonterm->item->type() == item::repeat || nonterm->item->type() == item::repeat_zero_or_one;
+        string  contentName = repeating ? ntName + s_ContentSuffix : ntName;
+
+        flat_field_list fields;
+        bool            needsPosition;
+        flat_fields_for_nonterminal(get_ast_nonterminal(nonterm->identifier), fields, needsPosition);
+
+        *m_HeaderFile   << "\n"
+                        << "    class " << contentName << " {\n"
+                        << "    private:\n"
+                        << "        const ast_pool* m_Pool;\n"
+                        << "        node_index m_Index;\n"
+                        << "\n"
+                        << "    public:\n"
+                        << "        " << contentName << "(const ast_pool* pool = NULL, node_index index = no_node) : m_Pool(pool), m_Index(index) { }\n"
+                        << "\n"
+                        << "        inline const " << contentName << "* item() const { return m_Index == no_node ? NULL : this; }\n"
+                        << "        inline const " << contentName << "* operator->() const { return this; }\n"
+                        << "        inline node_index get_index() const { return m_Index; }\n"
+                        << "        inline int get_rule() const { return m_Pool->" << contentName << "_nodes[m_Index].m_Rule; }\n"
+                        << "\n";
+
+        for (flat_field_list::const_iterator field = fields.begin(); field != fields.end(); ++field) {
+            *m_HeaderFile << "        inline " << field->second << " " << field->first << "() const { return " << field->second << "(m_Pool, m_Pool->" << contentName << "_nodes[m_Index]." << field->first << "); }\n";
+        }
+        if (!fields.empty()) *m_HeaderFile << "\n";
+
+        *m_HeaderFile   << "        dfa::position pos() const;\n"
+                        << "        dfa::position final_pos() const;\n"
+                        << "    };\n";
+
+        // The list class for closures can be iterated to retrieve the content items
+        if (repeating) {
+            *m_HeaderFile   << "\n"
+                            << "    class " << ntName << " {\n"
+                            << "    private:\n"
+                            << "        const ast_pool* m_Pool;\n"
+                            << "        node_index m_Index;\n"
+                            << "\n"
+                            << "    public:\n"
+                            << "        class iterator {\n"
+                            << "        private:\n"
+                            << "            const ast_pool* m_Pool;\n"
+                            << "            node_index m_Index;\n"
+                            << "\n"
+                            << "        public:\n"
+                            << "            iterator(const ast_pool* pool, node_index index) : m_Pool(pool), m_Index(index) { }\n"
+                            << "\n"
+                            << "            inline " << contentName << " operator*() const { return " << contentName << "(m_Pool, m_Index); }\n"
+                            << "            inline iterator& operator++() { m_Index = m_Pool->" << contentName << "_nodes[m_Index].m_Next; return *this; }\n"
+                            << "            inline bool operator==(const iterator& compareTo) const { return m_Index == compareTo.m_Index; }\n"
+                            << "            inline bool operator!=(const iterator& compareTo) const { return m_Index != compareTo.m_Index; }\n"
+                            << "        };\n"
+                            << "\n"
+                            << "        " << ntName << "(const ast_pool* pool = NULL, node_index index = no_node) : m_Pool(pool), m_Index(index) { }\n"
+                            << "\n"
+                            << "        inline const " << ntName << "* item() const { return m_Index == no_node ? NULL : this; }\n"
+                            << "        inline const " << ntName << "* operator->() const { return this; }\n"
+                            << "        inline node_index get_index() const { return m_Index; }\n"
+                            << "\n"
+                            << "        inline size_t size() const { return m_Pool->" << ntName << "_nodes[m_Index].m_Count; }\n"
+                            << "        inline iterator begin() const { return iterator(m_Pool, m_Pool->" << ntName << "_nodes[m_Index].m_First); }\n"
+                            << "        inline iterator end() const { return iterator(m_Pool, no_node); }\n"
+                            << "\n"
+                            << "        inline " << contentName << " operator[](size_t index) const {\n"
+                            << "            iterator found = begin();\n"
+                            << "            for (; index > 0; --index) ++found;\n"
+                            << "            return *found;\n"
+                            << "        }\n"
+                            << "\n"
+                            << "        dfa::position pos() const;\n"
+                            << "        dfa::position final_pos() const;\n"
+                            << "    };\n";
+        }
+    }
+}
+
+/// \brief Writes out the node pool for a flat AST to the header file
+void output_cplusplus::header_flat_ast_pool() {
+    // The pool has an array for the terminals and for each nonterminal type
+    *m_HeaderFile   << "\n"
+                    << "    class ast_pool {\n"
+                    << "    public:\n"
+                    << "        std::vector<int> text;\n"
+                    << "        std::vector<terminal_data> terminal_nodes;\n";
+
+    // The names of the arrays, so they can be cleared
+    vector<string> arrays;
+    arrays.push_back("text");
+    arrays.push_back("terminal_nodes");
+
+    for (nonterminal_symbol_iterator nonterm = begin_nonterminal_symbol(); nonterm != end_nonterminal_symbol(); ++nonterm) {
+        if (nonterm->item->type() == item::guard) continue;
+
+        string ntName = class_name_for_item(nonterm->item) + s_TypeSuffix;
+
+        *m_HeaderFile << "        std::vector<" << ntName << "_data> " << ntName << "_nodes;\n";
+        arrays.push_back(ntName + "_nodes");
+
+        if (nonterm->item->type() == item::repeat || nonterm->item->type() == item::repeat_zero_or_one) {
+            *m_HeaderFile << "        std::vector<" << ntName << s_ContentSuffix << "_data> " << ntName << s_ContentSuffix << "_nodes;\n";
+            arrays.push_back(ntName + s_ContentSuffix + "_nodes");
+        }
+    }
+
+    *m_HeaderFile   << "\n"
+                    << "        inline void clear() {\n";
+    for (vector<string>::const_iterator array = arrays.begin(); array != arrays.end(); ++array) {
+        *m_HeaderFile << "            " << *array << ".clear();\n";
+    }
+    *m_HeaderFile   << "        }\n"
+                    << "    };\n";
+}
+
+/// \brief Writes out the parser actions for a flat AST to the header file
+void output_cplusplus::header_flat_parser_actions() {
+    // The parser actions own the pool, so the AST lasts as long as the parser state
+    *m_HeaderFile   << "\n"
+                    << "    class parser_actions {\n"
+                    << "    public:\n"
+                    << "        typedef node_index node;\n"
+                    << "        typedef lr::parser<node, parser_actions> parser;\n"
+                    << "        typedef parser::reduce_list reduce_list;\n"
+                    << "\n"
+                    << "    private:\n"
+                    << "        dfa::lexeme_stream* m_Stream;\n"
+                    << "        bool m_OwnStream;\n"
+                    << "        dfa::lexeme_batch_reader m_Reader;\n"
+                    << "        ast_pool m_Pool;\n"
+                    << "\n"
+                    << "        parser_actions(parser_actions& noCopying);\n"
+                    << "        parser_actions& operator=(const parser_actions& noCopying);\n"
+                    << "\n"
+                    << "    public:\n"
+                    << "        parser_actions(dfa::lexeme_stream* stream, bool ownStream = false)\n"
+                    << "        : m_Stream(stream)\n"
+                    << "        , m_OwnStream(ownStream)\n"
+                    << "        , m_Reader(stream) { }\n"
+                    << "\n"
+                    << "        ~parser_actions() {\n"
+                    << "            if (m_OwnStream && m_Stream) {\n"
+                    << "                delete m_Stream;\n"
+                    << "                m_Stream = NULL;\n"
+                    << "            }\n"
+                    << "        }\n"
+                    << "\n"
+                    << "        inline void reset(dfa::lexeme_stream* stream) {\n"
+                    << "            if (m_OwnStream && m_Stream && m_Stream != stream) {\n"
+                    << "                delete m_Stream;\n"
+                    << "            }\n"
+                    << "            m_Stream = stream;\n"
+                    << "            m_Reader.reset(stream);\n"
+                    << "            m_Pool.clear();\n"
+                    << "        }\n"
+                    << "\n"
+                    << "        inline void set_batched(bool batched) {\n"
+                    << "            m_Reader.set_batched(batched);\n"
+                    << "        }\n"
+                    << "\n"
+                    << "        inline dfa::lexeme* read() {\n"
+                    << "            return m_Reader.read();\n"
+                    << "        }\n"
+                    << "\n"
+                    << "        inline const ast_pool& pool() const { return m_Pool; }\n"
+                    << "\n"
+                    << "        inline node shift(const dfa::lexeme_container& lexeme) {\n"
+                    << "            terminal_data data;\n"
+                    << "            data.matched    = lexeme->matched();\n"
+                    << "            data.offset     = (unsigned int) m_Pool.text.size();\n"
+                    << "            data.length     = (unsigned int) lexeme->content().size();\n"
+                    << "            data.pos        = lexeme->pos();\n"
+                    << "\n"
+                    << "            m_Pool.text.insert(m_Pool.text.end(), lexeme->content().begin(), lexeme->content().end());\n"
+                    << "            m_Pool.terminal_nodes.push_back(data);\n"
+                    << "            return (node) (m_Pool.terminal_nodes.size() - 1);\n"
+                    << "        }\n"
+                    << "\n"
+                    << "        node reduce(int nonterminal, int rule, const reduce_list& reduce, const dfa::position& lookaheadPosition);\n"
+                    << "    };\n";
+}
+
+/// \brief Writes out the functions for getting the file positions of the nodes in a flat AST
+void output_cplusplus::source_flat_position_functions() {
+    string className = get_identifier(m_ClassName, false);
+
+    for (nonterminal_symbol_iterator nonterm = begin_nonterminal_symbol(); nonterm != end_nonterminal_symbol(); ++nonterm) {
+        if (nonterm->item->type() == item::guard) continue;
+
+        string  ntName      = class_name_for_item(nonterm->item) + s_TypeSuffix;
+        bool    repeating   = nonterm->item->type() == item::repeat || nonterm->item->type() == item::repeat_zero_or_one;
+        string  contentName = repeating ? ntName + s_ContentSuffix : ntName;
+
+        const ast_nonterminal& astNt = get_ast_nonterminal(nonterm->identifier);
+
+        // Write out the initial and the final position functions for the content class
+        for (int finalPos = 0; finalPos < 2; ++finalPos) {
+            const char* function = finalPos ? "final_pos" : "pos";
+
+            *m_SourceFile   << "\n"
+                            << "dfa::position " << className << "::" << contentName << "::" << function << "() const {\n"
+                            << "    const " << contentName << "_data& data = m_Pool->" << contentName << "_nodes[m_Index];\n"
+                            << "    switch (data.m_Rule) {";
+
+            for (ast_nonterminal_rules::const_iterator ruleDefn = astNt.rules.begin(); ruleDefn != astNt.rules.end(); ++ruleDefn) {
+                // Find the first (or last) item with a field
+                const ast_rule_item* found = NULL;
+                for (ast_rule_item_list::const_iterator ruleItem = ruleDefn->second.begin(); ruleItem != ruleDefn->second.end(); ++ruleItem) {
+                    if (ruleItem->item->type() == item::guard) continue;
+                    if (ruleItem->isEbnfRepetition) continue;
+
+                    found = &*ruleItem;
+                    if (!finalPos) break;
+                }
+
+                // Empty rules in closures are never used for a content item
+                if (!found && repeating) continue;
+
+                *m_SourceFile << "\n    case " << ruleDefn->first << ":\n";
+                if (found) {
+                    string typeName = class_name_for_item(found->item) + s_TypeSuffix;
+                    *m_SourceFile << "        return " << typeName << "(m_Pool, data." << get_identifier(found->uniqueName, false) << ")." << function << "();\n";
+                } else {
+                    *m_SourceFile << "        return data.m_Position;\n";
+                }
+            }
+
+            *m_SourceFile   << "\n"
+                            << "    default:\n"
+                            << "        return dfa::position(-1, -1, -1);\n"
+                            << "    }\n"
+                            << "}\n";
+        }
+
+        // The list class takes its position from the first and last items
+        if (repeating) {
+            *m_SourceFile   << "\n"
+                            << "dfa::position " << className << "::" << ntName << "::pos() const {\n"
+                            << "    const " << ntName << "_data& data = m_Pool->" << ntName << "_nodes[m_Index];\n"
+                            << "    if (data.m_Count == 0) return data.m_Position;\n"
+                            << "    return " << contentName << "(m_Pool, data.m_First).pos();\n"
+                            << "}\n"
+                            << "\n"
+                            << "dfa::position " << className << "::" << ntName << "::final_pos() const {\n"
+                            << "    const " << ntName << "_data& data = m_Pool->" << ntName << "_nodes[m_Index];\n"
+                            << "    if (data.m_Count == 0) return data.m_Position;\n"
+                            << "    return " << contentName << "(m_Pool, data.m_Last).final_pos();\n"
+                            << "}\n";
+        }
+    }
+}
+
+/// \brief Writes out the reduce actions for a flat AST to the source file
+void output_cplusplus::source_flat_reduce_actions() {
+    string className = get_identifier(m_ClassName, false);
+
+    *m_SourceFile   << "\n"
+                    << className << "::parser_actions::node " << className << "::parser_actions::reduce(int nonterminal, int rule, const reduce_list& reduce, const dfa::position& lookaheadPosition) {\n"
+                    << "    switch (rule) {";
+
+    for (nonterminal_symbol_iterator nonterm = begin_nonterminal_symbol(); nonterm != end_nonterminal_symbol(); ++nonterm) {
+        if (nonterm->item->type() == item::guard) continue;
+
+        string  ntName      = class_name_for_item(nonterm->item) + s_TypeSuffix;
+        bool    repeating   = nonterm->item->type() == item::repeat || nonterm->item->type() == item::repeat_zero_or_one;
+        string  contentName = repeating ? ntName + s_ContentSuffix : ntName;
+
+        const ast_nonterminal& ntDefn = get_ast_nonterminal(nonterm->identifier);
+
+        for (ast_nonterminal_rules::const_iterator ruleDefn = ntDefn.rules.begin(); ruleDefn != ntDefn.rules.end(); ++ruleDefn) {
+            *m_SourceFile   << "\n    case " << ruleDefn->first << ":\n"
+                            << "    {\n";
+
+            // The empty rule of a '*' closure creates an empty list
+            if (repeating && ruleDefn->second.empty()) {
+                *m_SourceFile   << "        " << ntName << "_data list;\n"
+                                << "        list.m_Position = lookaheadPosition;\n"
+                                << "        m_Pool." << ntName << "_nodes.push_back(list);\n"
+                                << "        return (node) (m_Pool." << ntName << "_nodes.size() - 1);\n"
+                                << "    }\n";
+                continue;
+            }
+
+            // Fill in the data for the content of this rule
+            *m_SourceFile   << "        " << contentName << "_data data;\n"
+                            << "        data.m_Rule = " << ruleDefn->first << ";\n";
+
+            bool validItems = false;
+            for (size_t index = 0; index < ruleDefn->second.size(); ++index) {
+                const ast_rule_item& ruleItem = ruleDefn->second[index];
+
+                if (ruleItem.item->type() == item::guard) continue;
+                if (ruleItem.isEbnfRepetition) continue;
+
+                // The reduce list is passed in in reverse
+                *m_SourceFile << "        data." << get_identifier(ruleItem.uniqueName, false) << " = reduce[" << ruleDefn->second.size() - index - 1 << "];\n";
+                validItems = true;
+            }
+
+            if (!validItems && !repeating) {
+                *m_SourceFile << "        data.m_Position = lookaheadPosition;\n";
+            }
+
+            *m_SourceFile   << "        m_Pool." << contentName << "_nodes.push_back(data);\n";
+
+            if (!repeating) {
+                *m_SourceFile   << "        return (node) (m_Pool." << contentName << "_nodes.size() - 1);\n"
+                                << "    }\n";
+                continue;
+            }
+
+            // Closures add the content to the end of the list, creating it if this is the first item
+            *m_SourceFile << "        node content = (node) (m_Pool." << contentName << "_nodes.size() - 1);\n";
+
+            if (!ruleDefn->second.empty() && ruleDefn->second[0].isEbnfRepetition) {
+                *m_SourceFile << "        node listIndex = reduce[" << ruleDefn->second.size()-1 << "];\n";
+            } else {
+                *m_SourceFile   << "        " << ntName << "_data newList;\n"
+                                << "        newList.m_Position = lookaheadPosition;\n"
+                                << "        m_Pool." << ntName << "_nodes.push_back(newList);\n"
+                                << "        node listIndex = (node) (m_Pool." << ntName << "_nodes.size() - 1);\n";
+            }
+
+            *m_SourceFile   << "        " << ntName << "_data& list = m_Pool." << ntName << "_nodes[listIndex];\n"
+                            << "        if (list.m_Count == 0) {\n"
+                            << "            list.m_First = content;\n"
+                            << "        } else {\n"
+                            << "            m_Pool." << contentName << "_nodes[list.m_Last].m_Next = content;\n"
+                            << "        }\n"
+                            << "        list.m_Last = content;\n"
+                            << "        ++list.m_Count;\n"
+                            << "        return listIndex;\n"
+                            << "    }\n";
+        }
+    }
+
+    // Guards and unknown rules produce no node
+    *m_SourceFile   << "\n    default:\n"
+                    << "        return no_node;\n"
+                    << "    }\n"
+                    << "}\n";
+}
+
+/// \brief Writes out the parser definitions and the start symbol functions for a flat AST
+void output_cplusplus::define_flat_ast_tables() {
+    header_flat_ast_declarations();
+    header_flat_ast_pool();
+    header_flat_parser_actions();
+
+    source_flat_position_functions();
+    source_flat_reduce_actions();
+
+    // The batch, incremental and push parsers aren't generated, as their ASTs would be spread across several pools
+    *m_HeaderFile   << "\npublic:\n"
+                    << "    typedef lr::parser<node_index, parser_actions> ast_parser_type;\n"
+                    << "    static const ast_parser_type ast_parser;\n";
+
+    *m_SourceFile   << "\nconst " << get_identifier(m_ClassName, false) << "::node_index " << get_identifier(m_ClassName, false) << "::no_node;\n"
+                    << "const " << get_identifier(m_ClassName, false) << "::ast_parser_type " << get_identifier(m_ClassName, false) << "::ast_parser(&lr_tables, false);\n";
+
+    if (m_StatsParser) {
+        *m_HeaderFile   << "\n"
+                        << "    typedef lr::parser<node_index, parser_actions, lr::stats_parser_trace> stats_parser_type;\n"
+                        << "    static const stats_parser_type stats_parser;\n";
+        *m_SourceFile   << "const " << get_identifier(m_ClassName, false) << "::stats_parser_type " << get_identifier(m_ClassName, false) << "::stats_parser(&lr_tables, false);\n";
+    }
+
+    // Generate functions for creating new parsers
+    header_start_symbols();
+}
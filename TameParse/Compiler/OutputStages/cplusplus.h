@@ -62,9 +62,25 @@ namespace compiler {
         /// \brief The used class (and other identifier) names for the class (which should not be re-used)
         std::set<std::string> m_UsedClassNames;
 
+        /// \brief True if the AST should be generated as a flat pool of nodes instead of a graph of syntax_ptr objects
+        bool m_FlatAst;
+
+        /// \brief True if a parser that collects statistics should be generated along with the AST parser
+        bool m_StatsParser;
+
+        /// \brief True if a parser that records a reduction log should be generated along with the AST parser
+        bool m_LazyAst;
+
     public:
         /// \brief Creates a new output stage
-        output_cplusplus(console_container& console, const std::wstring& filename, lexer_stage* lexer, language_stage* language, lr_parser_stage* parser, const std::wstring& filenamePrefix, const std::wstring& className, const std::wstring& namespaceName);
+        ///
+        /// If flatAst is true, the generated AST is stored in per-type arrays owned by the parser actions and the
+        /// node classes are lightweight handles that refer to an entry in these arrays.
+        ///
+        /// Each parser that is generated is a static object, so the parsers that collect statistics (statsParser) and
+        /// record a reduction log to build the AST from later (lazyAst) are only generated if they are asked for.
+        /// The lazy AST isn't available along with a flat AST.
+        output_cplusplus(console_container& console, const std::wstring& filename, lexer_stage* lexer, language_stage* language, lr_parser_stage* parser, const std::wstring& filenamePrefix, const std::wstring& className, const std::wstring& namespaceName, bool flatAst = false, bool statsParser = false, bool lazyAst = false);
 
         /// \brief Destructor
         virtual ~output_cplusplus();
@@ -137,6 +153,30 @@ namespace compiler {
         /// \brief Writes out inline functions to generate initial parser states for specific start symbols
         void header_start_symbols();
 
+        /// \brief A list of the fields in a flat AST node, as (variable name, type name) pairs
+        typedef std::vector<std::pair<std::string, std::string> > flat_field_list;
+
+        /// \brief Retrieves the fields declared for a nonterminal in a flat AST, and whether or not it needs a position field
+        void flat_fields_for_nonterminal(const ast_nonterminal& ntDefn, flat_field_list& fields, bool& needsPosition);
+
+        /// \brief Writes out the data structures and handle classes for a flat AST to the header file
+        void header_flat_ast_declarations();
+
+        /// \brief Writes out the node pool for a flat AST to the header file
+        void header_flat_ast_pool();
+
+        /// \brief Writes out the parser actions for a flat AST to the header file
+        void header_flat_parser_actions();
+
+        /// \brief Writes out the functions for getting the file positions of the nodes in a flat AST
+        void source_flat_position_functions();
+
+        /// \brief Writes out the reduce actions for a flat AST to the source file
+        void source_flat_reduce_actions();
+
+        /// \brief Writes out the parser definitions and the start symbol functions for a flat AST
+        void define_flat_ast_tables();
+
     protected:
         // Functions that represent various steps of the output of a language.
         // These are intended to make it easy to write out a file in the specified language.
@@ -0,0 +1,636 @@
+//
+//  build_cache.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <set>
+#include <map>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include "TameParse/version.h"
+#include "TameParse/Compiler/build_cache.h"
+#include "TameParse/Compiler/profiler.h"
+#include "TameParse/ContextFree/standard_items.h"
+#include "TameParse/ContextFree/ebnf_items.h"
+#include "TameParse/ContextFree/guard.h"
+#include "TameParse/Lr/lr_item.h"
+#include "TameParse/Lr/lr1_item_set.h"
+#include "TameParse/Lr/binary_tables.h"
+#include "TameParse/Util/utf8reader.h"
+
+using namespace std;
+using namespace dfa;
+using namespace lr;
+using namespace contextfree;
+using namespace util;
+using namespace yy_language;
+using namespace compiler;
+
+/// \brief The first value in a cache entry (the characters 'TPBC')
+static const int c_EntryMagic = 0x43425054;
+
+/// \brief The version of the cache entry format
+static const int c_EntryVersion = 1;
+
+/// \brief The options that change the lexer or parser that is built, or whether or not it is accepted
+static const wchar_t* c_KeyOptions[] = {
+    L"enable-lr1-resolver",
+    L"compress-tables",
+    L"disable-compact-dfa",
+    L"disable-merged-dfa",
+    L"allow-reduce-conflicts",
+    L"allow-empty-guards",
+    L"no-conflicts",
+    NULL
+};
+
+/// \brief Writes a single value to a cache entry
+static void write_value(ostream& target, int value) {
+    unsigned int    word        = (unsigned int) value;
+    char            bytes[4]    = { (char) (word & 0xff), (char) ((word >> 8) & 0xff), (char) ((word >> 16) & 0xff), (char) ((word >> 24) & 0xff) };
+    
+    target.write(bytes, 4);
+}
+
+/// \brief Reads a single value from a cache entry, returning false if there are no more values
+static bool read_value(const unsigned char*& pos, const unsigned char* end, int& value) {
+    if (end - pos < 4) return false;
+    
+    value = (int) ((unsigned int) pos[0] | ((unsigned int) pos[1] << 8) | ((unsigned int) pos[2] << 16) | ((unsigned int) pos[3] << 24));
+    pos += 4;
+    
+    return true;
+}
+
+/// \brief Reads a value that counts a number of items, returning false if it is negative or too large to fit in the rest of the entry
+static bool read_count(const unsigned char*& pos, const unsigned char* end, int itemSize, int& count) {
+    if (!read_value(pos, end, count))           return false;
+    if (count < 0)                              return false;
+    if ((end - pos) / itemSize < count)         return false;
+    
+    return true;
+}
+
+/// \brief Writes out a DFA to a cache entry
+///
+/// Only the highest-priority accept action is kept for each state: this is the only one that the lexer or any of the
+/// output stages make use of.
+static void write_dfa(ostream& target, const ndfa& dfa) {
+    // The symbol sets, in identifier order
+    write_value(target, dfa.symbols().count_sets());
+    
+    for (int setId = 0; setId < dfa.symbols().count_sets(); ++setId) {
+        const symbol_set& symbols = dfa.symbols()[setId];
+        
+        int numRanges = 0;
+        for (symbol_set::iterator range = symbols.begin(); range != symbols.end(); ++range) {
+            ++numRanges;
+        }
+        
+        write_value(target, numRanges);
+        for (symbol_set::iterator range = symbols.begin(); range != symbols.end(); ++range) {
+            write_value(target, range->lower());
+            write_value(target, range->upper());
+        }
+    }
+    
+    // The states
+    write_value(target, dfa.count_states());
+    
+    for (int stateId = 0; stateId < dfa.count_states(); ++stateId) {
+        // Find the highest accept action for this state
+        const ndfa::accept_action_list& actions = dfa.actions_for_state(stateId);
+        const accept_action*            highest = NULL;
+        
+        for (ndfa::accept_action_list::const_iterator action = actions.begin(); action != actions.end(); ++action) {
+            if (!highest || *highest < **action) {
+                highest = *action;
+            }
+        }
+        
+        write_value(target, highest ? highest->symbol() : -1);
+        write_value(target, highest && highest->eager() ? 1 : 0);
+        
+        // Write out the transitions
+        const state& thisState = dfa.get_state(stateId);
+        
+        write_value(target, thisState.count_transitions());
+        for (state::iterator transit = thisState.begin(); transit != thisState.end(); ++transit) {
+            write_value(target, transit->symbol_set());
+            write_value(target, transit->new_state());
+        }
+    }
+}
+
+/// \brief Reads a DFA from a cache entry, returning NULL if the entry is not valid
+static ndfa* read_dfa(const unsigned char*& pos, const unsigned char* end) {
+    ndfa* result = new ndfa();
+    
+    // Read the symbol sets
+    int numSets;
+    if (!read_count(pos, end, 4, numSets)) {
+        delete result;
+        return NULL;
+    }
+    
+    for (int setId = 0; setId < numSets; ++setId) {
+        int numRanges;
+        if (!read_count(pos, end, 8, numRanges)) {
+            delete result;
+            return NULL;
+        }
+        
+        symbol_set thisSet;
+        for (int rangeId = 0; rangeId < numRanges; ++rangeId) {
+            int lower, upper;
+            read_value(pos, end, lower);
+            read_value(pos, end, upper);
+            
+            thisSet |= range<int>(lower, upper);
+        }
+        
+        // Each set must get the same identifier that it had when it was written out
+        if (result->symbols().identifier_for_symbols(thisSet) != setId) {
+            delete result;
+            return NULL;
+        }
+    }
+    
+    // Read the states (a new NDFA already has a start state)
+    int numStates;
+    if (!read_count(pos, end, 12, numStates) || numStates < 1) {
+        delete result;
+        return NULL;
+    }
+    
+    while (result->count_states() < numStates) {
+        result->add_state();
+    }
+    
+    for (int stateId = 0; stateId < numStates; ++stateId) {
+        int acceptSymbol, eager, numTransitions;
+        
+        read_value(pos, end, acceptSymbol);
+        read_value(pos, end, eager);
+        if (!read_count(pos, end, 8, numTransitions)) {
+            delete result;
+            return NULL;
+        }
+        
+        if (acceptSymbol >= 0) {
+            result->accept(stateId, accept_action(acceptSymbol, eager != 0));
+        }
+        
+        for (int transitId = 0; transitId < numTransitions; ++transitId) {
+            int symbolSet, newState;
+            read_value(pos, end, symbolSet);
+            read_value(pos, end, newState);
+            
+            if (symbolSet < 0 || symbolSet >= numSets || newState < 0 || newState >= numStates) {
+                delete result;
+                return NULL;
+            }
+            
+            result->add_transition(stateId, result->symbols()[symbolSet], newState);
+        }
+    }
+    
+    return result;
+}
+
+/// \brief Assigns identifiers to a rule and the items that it contains
+static void number_rule(const grammar& gram, const rule_container& newRule) {
+    gram.identifier_for_rule(newRule);
+    gram.identifier_for_item(newRule->nonterminal());
+    
+    for (rule::iterator ruleItem = newRule->items().begin(); ruleItem != newRule->items().end(); ++ruleItem) {
+        gram.identifier_for_item(*ruleItem);
+    }
+}
+
+/// \brief Assigns identifiers to every rule and item that the parser builder can reach from the start symbols
+///
+/// The parser builder assigns identifiers to rules and items as it encounters them, and the output stages expect these
+/// to match the identifiers used in the parser tables. Numbering everything up front means that the identifiers are
+/// the same whether the parser was built during this run or loaded from the cache.
+static void number_grammar(const grammar& gram, const vector<item_container>& startItems) {
+    // The rules that the builder creates for each start symbol ('<language>' $)
+    for (vector<item_container>::const_iterator startItem = startItems.begin(); startItem != startItems.end(); ++startItem) {
+        empty_item  empty;
+        rule        languageRule(empty);
+        
+        languageRule << *startItem;
+        number_rule(gram, rule_container(new rule(languageRule), true));
+    }
+    
+    // The special items used by the builder
+    gram.identifier_for_item(item_container(new end_of_input(), true));
+    gram.identifier_for_item(item_container(new end_of_guard(), true));
+    
+    // Visit the rules and items in turn: numbering a rule can add new items and the reverse, so keep going until
+    // everything has been visited
+    int nextRuleId = 0;
+    int nextItemId = 0;
+    
+    while (nextRuleId < gram.max_rule_identifier() || nextItemId < gram.max_item_identifier()) {
+        // Number the rules that make up each item
+        for (; nextItemId < gram.max_item_identifier(); ++nextItemId) {
+            const item_container& nextItem = gram.item_with_identifier(nextItemId);
+            
+            if (nextItem->type() == item::nonterminal) {
+                const rule_list& ntRules = gram.rules_for_nonterminal(nextItem->symbol());
+                for (rule_list::const_iterator ntRule = ntRules.begin(); ntRule != ntRules.end(); ++ntRule) {
+                    number_rule(gram, *ntRule);
+                }
+            } else if (nextItem->cast_ebnf()) {
+                for (ebnf::rule_iterator ebnfRule = nextItem->cast_ebnf()->first_rule(); ebnfRule != nextItem->cast_ebnf()->last_rule(); ++ebnfRule) {
+                    number_rule(gram, *ebnfRule);
+                }
+            } else if (nextItem->cast_guard()) {
+                number_rule(gram, nextItem->cast_guard()->get_rule());
+            }
+        }
+        
+        // EBNF items generate extra rules when their closure is calculated (repetitions, for instance, are built from a
+        // left-recursive rule), so number the rules in the closure of every EBNF item in every rule
+        for (; nextRuleId < gram.max_rule_identifier(); ++nextRuleId) {
+            const rule_container& nextRule = gram.rule_with_identifier(nextRuleId);
+            
+            for (size_t offset = 0; offset < nextRule->items().size(); ++offset) {
+                const item_container& ruleItem = nextRule->items()[offset];
+                if (!ruleItem->cast_ebnf()) continue;
+                
+                lr1_item_set    closure;
+                item_set        lookahead(&gram);
+                
+                ruleItem->closure(lr1_item(&gram, nextRule, (int) offset, lookahead), closure, gram);
+                
+                for (lr1_item_set::const_iterator closureItem = closure.begin(); closureItem != closure.end(); ++closureItem) {
+                    number_rule(gram, (*closureItem)->rule());
+                }
+            }
+        }
+    }
+}
+
+/// \brief Creates a new build cache stage
+build_cache::build_cache(console_container& console, const std::wstring& filename, const std::wstring& directory, const import_stage* importStage, language_stage* languageStage, const std::wstring& languageName, const std::vector<std::wstring>& startSymbols)
+: compilation_stage(console, filename)
+, m_Imports(importStage)
+, m_Language(languageStage)
+, m_LanguageName(languageName)
+, m_StartSymbols(startSymbols)
+, m_Directory(directory)
+, m_InitialTerminals(0)
+, m_NumberedRules(0)
+, m_NumberedItems(0) {
+}
+
+/// \brief Destructor
+build_cache::~build_cache() {
+}
+
+/// \brief Works out the key for the language being compiled
+void build_cache::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"build_cache");
+
+    m_Key.clear();
+    m_Hash.clear();
+    m_InitialTerminals = m_Language->terminals()->count_symbols();
+    
+    // Start with the version of the library and the settings for this build
+    wstringstream key;
+    
+    key << L"tameparse " << tameparse::version::version_string.c_str() << L"\n";
+    key << L"language " << m_LanguageName << L"\n";
+    
+    for (vector<wstring>::const_iterator startSymbol = m_StartSymbols.begin(); startSymbol != m_StartSymbols.end(); ++startSymbol) {
+        key << L"start " << *startSymbol << L"\n";
+    }
+    
+    for (const wchar_t** option = c_KeyOptions; *option != NULL; ++option) {
+        key << L"option " << *option << L"=" << cons().get_option(*option) << L"\n";
+    }
+    
+    // Add the text of the language block and the blocks it inherits from
+    map<wstring, wstring>   fileText;
+    set<wstring>            visited;
+    vector<wstring>         pending;
+    
+    pending.push_back(m_LanguageName);
+    
+    while (!pending.empty()) {
+        // Get the next language
+        wstring languageName = pending.back();
+        pending.pop_back();
+        
+        if (visited.find(languageName) != visited.end()) continue;
+        visited.insert(languageName);
+        
+        const language_block* language = m_Imports->language_with_name(languageName);
+        if (!language) continue;
+        
+        // Read the file containing this language, if we haven't already
+        wstring                         languageFile    = m_Imports->file_with_language(languageName);
+        map<wstring, wstring>::iterator text            = fileText.find(languageFile);
+        
+        if (text == fileText.end()) {
+            istream* fileStream = cons().open_file(languageFile);
+            
+            if (!fileStream || !fileStream->good()) {
+                // Can't cache this language if we can't read its definition
+                delete fileStream;
+                return;
+            }
+            
+            utf8reader  reader(fileStream, true);
+            wstring     contents;
+            wchar_t     nextChar;
+            
+            for (;;) {
+                reader.get(nextChar);
+                if (!reader.good()) break;
+                contents += nextChar;
+            }
+            
+            text = fileText.insert(pair<wstring, wstring>(languageFile, contents)).first;
+        }
+        
+        // Append the block to the key (carriage returns are left out so that the line endings don't matter)
+        int blockStart  = language->start_pos().offset();
+        int blockEnd    = language->end_pos().offset();
+        
+        if (blockStart < 0 || blockEnd < blockStart || blockEnd > (int) text->second.size()) return;
+        
+        key << L"block " << languageName << L"\n";
+        for (int pos = blockStart; pos < blockEnd; ++pos) {
+            if (text->second[pos] != L'\r') key << text->second[pos];
+        }
+        key << L"\n";
+        
+        // Also need the languages that this one inherits from
+        pending.insert(pending.end(), language->inherits().begin(), language->inherits().end());
+    }
+    
+    m_Key = key.str();
+    
+    // Hash the key (64-bit FNV-1a)
+    unsigned long long hash = 14695981039346656037ULL;
+    
+    for (wstring::const_iterator keyChar = m_Key.begin(); keyChar != m_Key.end(); ++keyChar) {
+        hash ^= (unsigned long long) (unsigned int) *keyChar;
+        hash *= 1099511628211ULL;
+    }
+    
+    wstringstream hashString;
+    hashString.fill(L'0');
+    hashString.width(16);
+    hashString << hex << hash;
+    
+    m_Hash = hashString.str();
+    
+    // Give everything in the grammar an identifier, so the parser tables will match the grammar whether or not they
+    // come from the cache
+    grammar*                gram = m_Language->grammar();
+    vector<item_container>  startItems;
+    
+    for (vector<wstring>::const_iterator startSymbol = m_StartSymbols.begin(); startSymbol != m_StartSymbols.end(); ++startSymbol) {
+        if (gram->nonterminal_is_defined(*startSymbol)) {
+            startItems.push_back(gram->get_nonterminal(*startSymbol));
+        }
+    }
+    
+    number_grammar(*gram, startItems);
+    
+    m_NumberedRules = gram->max_rule_identifier();
+    m_NumberedItems = gram->max_item_identifier();
+}
+
+/// \brief The name of the file containing the cache entry for the language
+wstring build_cache::entry_filename() const {
+    if (m_Hash.empty()) return wstring();
+    
+    wstring result = m_Directory;
+    if (!result.empty() && result[result.size()-1] != L'/' && result[result.size()-1] != L'\\') {
+        result += L'/';
+    }
+    
+    return result + m_Hash + L".tpc";
+}
+
+/// \brief Restores the lexer and parser from the cache, returning false if there is no usable entry for the language
+bool build_cache::load(lexer_stage& lexerStage, lr_parser_stage& parserStage) {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"build_cache");
+
+    // Nothing to do if there's no key for this language
+    wstring entryFile = entry_filename();
+    if (entryFile.empty()) return false;
+    
+    // Read the entry (quietly: it's not an error for there to be no entry)
+    istream* entryStream = cons().open_file(entryFile);
+    if (!entryStream || !entryStream->good()) {
+        delete entryStream;
+        return false;
+    }
+    
+    stringstream contents;
+    contents << entryStream->rdbuf();
+    delete entryStream;
+    
+    string          entry = contents.str();
+    vector<int>     buffer((entry.size() + sizeof(int) - 1) / sizeof(int) + 1);
+    if (!entry.empty()) memcpy(&buffer[0], entry.data(), entry.size());
+    
+    const unsigned char*    pos = (const unsigned char*) &buffer[0];
+    const unsigned char*    end = pos + entry.size();
+    
+    // Check the header
+    int magic, entryVersion;
+    if (!read_value(pos, end, magic) || magic != c_EntryMagic)                  return false;
+    if (!read_value(pos, end, entryVersion) || entryVersion != c_EntryVersion)  return false;
+    
+    // Check that the entry is for this language
+    int keyLength;
+    if (!read_count(pos, end, 4, keyLength) || keyLength != (int) m_Key.size()) return false;
+    
+    for (int keyPos = 0; keyPos < keyLength; ++keyPos) {
+        int keyChar;
+        read_value(pos, end, keyChar);
+        if ((wchar_t) keyChar != m_Key[keyPos]) return false;
+    }
+    
+    // Read the weak symbols that were split off by the lexer stage
+    int initialTerminals, numSplit;
+    if (!read_value(pos, end, initialTerminals) || initialTerminals != m_InitialTerminals) return false;
+    if (m_Language->terminals()->count_symbols() != m_InitialTerminals)                    return false;
+    if (!read_count(pos, end, 4, numSplit))                                                 return false;
+    
+    vector<int> splitFrom;
+    for (int splitId = 0; splitId < numSplit; ++splitId) {
+        int parent;
+        read_value(pos, end, parent);
+        if (parent < 0 || parent >= m_InitialTerminals) return false;
+        splitFrom.push_back(parent);
+    }
+    
+    // Read the DFA
+    ndfa* dfa = read_dfa(pos, end);
+    if (!dfa) return false;
+    
+    // Read the parser tables
+    int tablesSize;
+    binary_tables tables;
+    
+    if (!read_count(pos, end, 1, tablesSize) || (tablesSize % 4) != 0 || !tables.load(pos, tablesSize)) {
+        delete dfa;
+        return false;
+    }
+    
+    // The entry is valid: split the weak symbols and pass the results on to the stages
+    terminal_dictionary* terminals = m_Language->terminals();
+    for (vector<int>::const_iterator parent = splitFrom.begin(); parent != splitFrom.end(); ++parent) {
+        terminals->split(*parent);
+    }
+    
+    lexerStage.use_dfa(dfa);
+    parserStage.use_tables(new parser_tables(tables.get_tables()));
+    
+    cons().verbose_stream() << L"  = Using the lexer and parser from the build cache" << endl;
+    return true;
+}
+
+/// \brief Stores the lexer and parser that were built for the language
+void build_cache::store(const lexer_stage& lexerStage, lr_parser_stage& parserStage) {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"build_cache");
+
+    // Nothing to do if there's no key for this language, or nothing to store
+    wstring entryFile = entry_filename();
+    if (entryFile.empty() || !lexerStage.dfa() || !parserStage.get_tables()) return;
+    
+    // The entry can't be used if the parser builder found rules or nonterminals that weren't numbered in advance
+    const grammar* gram = m_Language->grammar();
+    bool           numbered = gram->max_rule_identifier() == m_NumberedRules;
+    
+    for (int itemId = m_NumberedItems; numbered && itemId < gram->max_item_identifier(); ++itemId) {
+        if (gram->item_with_identifier(itemId)->type() != item::terminal) {
+            numbered = false;
+        }
+    }
+    
+    if (!numbered) {
+        cons().verbose_stream() << L"  = The parser contains rules that were not numbered in advance: not storing it in the build cache" << endl;
+        return;
+    }
+    
+    // Build the entry
+    stringstream entry;
+    
+    write_value(entry, c_EntryMagic);
+    write_value(entry, c_EntryVersion);
+    
+    write_value(entry, (int) m_Key.size());
+    for (wstring::const_iterator keyChar = m_Key.begin(); keyChar != m_Key.end(); ++keyChar) {
+        write_value(entry, (int) *keyChar);
+    }
+    
+    // The weak symbols that were split off by the lexer stage
+    const terminal_dictionary* terminals = m_Language->terminals();
+    
+    write_value(entry, m_InitialTerminals);
+    write_value(entry, terminals->count_symbols() - m_InitialTerminals);
+    for (int symbolId = m_InitialTerminals; symbolId < terminals->count_symbols(); ++symbolId) {
+        write_value(entry, terminals->parent_of(symbolId));
+    }
+    
+    // The DFA
+    write_dfa(entry, *lexerStage.dfa());
+    
+    // The parser tables (the lexer written alongside them is not used)
+    stringstream tables;
+    if (!binary_tables::write(tables, *lexerStage.dfa(), *parserStage.get_tables())) return;
+    
+    string tableData = tables.str();
+    write_value(entry, (int) tableData.size());
+    entry.write(tableData.data(), tableData.size());
+    
+    // Make sure that the cache directory exists
+    string directory = cons().convert_filename(m_Directory);
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0777);
+#endif
+    
+    // Write out the entry to a temporary file, then move it into place. Another compiler reading the cache at the
+    // same time will see either the old entry or the complete new one, never a partially written one.
+#ifdef _WIN32
+    int processId = _getpid();
+#else
+    int processId = (int) getpid();
+#endif
+    
+    wstringstream tempName;
+    tempName << entryFile << L"." << processId << L".tmp";
+    
+    wstring     tempFile    = tempName.str();
+    ostream*    entryStream = cons().open_binary_file_for_writing(tempFile);
+    bool        written     = false;
+    
+    if (entryStream && entryStream->good()) {
+        string entryData = entry.str();
+        entryStream->write(entryData.data(), entryData.size());
+        entryStream->flush();
+        written = entryStream->good();
+    }
+    delete entryStream;
+    
+    string tempPath     = cons().convert_filename(tempFile);
+    string entryPath    = cons().convert_filename(entryFile);
+    
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows
+    if (written) remove(entryPath.c_str());
+#endif
+    
+    if (!written || rename(tempPath.c_str(), entryPath.c_str()) != 0) {
+        remove(tempPath.c_str());
+        cons().report_error(error(error::sev_warning, entryFile, L"CANT_WRITE_BUILD_CACHE", L"Could not write to the build cache", position(-1, -1, -1)));
+        return;
+    }
+    
+    cons().verbose_stream() << L"  = Stored lexer and parser in the build cache" << endl;
+}
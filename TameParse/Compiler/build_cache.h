@@ -0,0 +1,115 @@
+//
+//  build_cache.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _COMPILER_BUILD_CACHE_H
+#define _COMPILER_BUILD_CACHE_H
+
+#include <string>
+#include <vector>
+
+#include "TameParse/Compiler/compilation_stage.h"
+#include "TameParse/Compiler/import_stage.h"
+#include "TameParse/Compiler/language_stage.h"
+#include "TameParse/Compiler/lexer_stage.h"
+#include "TameParse/Compiler/lr_parser_stage.h"
+
+namespace compiler {
+    ///
+    /// \brief Stores the lexer DFA and parser tables built for a language on disk, so that later compilations of an
+    /// unchanged language can skip the lexer and parser stages
+    ///
+    /// Entries are content-addressed: the key is made up of the source text of the language block being compiled and
+    /// of any language blocks that it inherits from, along with the start symbols and the options that affect how the
+    /// lexer and parser are built. Editing other parts of the input file, or other files in the import chain, leaves
+    /// the key unchanged. Each entry records its full key so that a hash collision cannot produce the wrong parser.
+    /// Entries are written to a temporary file that is renamed into place, so compilers sharing a cache directory
+    /// never see a partly written entry.
+    ///
+    /// Only the results of the lexer and parser stages are cached: any warnings that those stages would have produced
+    /// are not reported again when an entry is reused.
+    ///
+    class build_cache : public compilation_stage {
+    private:
+        /// \brief The import stage that located the language blocks
+        const import_stage* m_Imports;
+        
+        /// \brief The language stage for the language being compiled
+        language_stage* m_Language;
+        
+        /// \brief The name of the language being compiled
+        std::wstring m_LanguageName;
+        
+        /// \brief The start symbols for the parser
+        std::vector<std::wstring> m_StartSymbols;
+        
+        /// \brief The directory where the cache entries are stored
+        std::wstring m_Directory;
+        
+        /// \brief The key for the language being compiled (empty until compile() has been called)
+        std::wstring m_Key;
+        
+        /// \brief The hash of the key, used as the name of the cache entry
+        std::wstring m_Hash;
+        
+        /// \brief The number of terminal symbols defined by the language before the lexer stage runs
+        int m_InitialTerminals;
+        
+        /// \brief The number of rules in the grammar once it has been numbered
+        int m_NumberedRules;
+        
+        /// \brief The number of items in the grammar once it has been numbered
+        int m_NumberedItems;
+        
+    public:
+        /// \brief Creates a new build cache stage
+        build_cache(console_container& console, const std::wstring& filename, const std::wstring& directory, const import_stage* importStage, language_stage* languageStage, const std::wstring& languageName, const std::vector<std::wstring>& startSymbols);
+        
+        /// \brief Destructor
+        virtual ~build_cache();
+        
+        /// \brief Works out the key for the language being compiled
+        ///
+        /// This must be called before the lexer stage runs. It also assigns an identifier to every rule and item in the
+        /// grammar, so that the numbering is the same whether the parser is built or loaded from the cache.
+        virtual void compile();
+        
+        /// \brief Restores the lexer and parser from the cache, returning false if there is no usable entry for the language
+        ///
+        /// If this returns true, the lexer and parser stages do not need to be compiled.
+        bool load(lexer_stage& lexerStage, lr_parser_stage& parserStage);
+        
+        /// \brief Stores the lexer and parser that were built for the language
+        void store(const lexer_stage& lexerStage, lr_parser_stage& parserStage);
+        
+    public:
+        /// \brief The key for the language being compiled
+        inline const std::wstring& key() const { return m_Key; }
+        
+        /// \brief The name of the file containing the cache entry for the language
+        std::wstring entry_filename() const;
+    };
+}
+
+#endif
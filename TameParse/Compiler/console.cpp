@@ -59,6 +59,11 @@ bool console::can_start() const {
     return true;
 }
 
+/// \brief Retrieves the profiler that compilation stages should report their phases to
+profiler* console::get_profiler() const {
+    return NULL;
+}
+
 /// \brief Returns a list of values for a particular option
 ///
 /// For some options it is possible to specify more than one value: in this
@@ -36,6 +36,8 @@
 #include "TameParse/Util/container.h"
 
 namespace compiler {
+    class profiler;
+
     ///
     /// \brief Class representing a 'compiler console'
     ///
@@ -103,6 +105,11 @@ namespace compiler {
         /// \brief Returns true if the options are valid and the parser can start
         virtual bool can_start() const;
         
+        /// \brief Retrieves the profiler that compilation stages should report their phases to
+        ///
+        /// This returns NULL if the phases of the compilation are not being profiled (the default behaviour)
+        virtual profiler* get_profiler() const;
+        
     public:
         /// \brief Converts a wstring filename to whatever is the preferred format for the current system
         virtual std::string convert_filename(const std::wstring& filename);
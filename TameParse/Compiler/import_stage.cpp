@@ -30,6 +30,7 @@
 #include <sstream>
 
 #include "TameParse/Compiler/import_stage.h"
+#include "TameParse/Compiler/profiler.h"
 #include "TameParse/Compiler/parser_stage.h"
 
 using namespace std;
@@ -52,6 +53,9 @@ import_stage::~import_stage() {
 
 /// \brief Performs the actions associated with this compilation stage
 void import_stage::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"import_stage");
+
     console_container consContainer = cons_container();
     
     // Create a stack of definitions to look for import statements in
@@ -26,6 +26,7 @@
 //
 
 #include "TameParse/Compiler/language_builder_stage.h"
+#include "TameParse/Compiler/profiler.h"
 
 using namespace dfa;
 using namespace yy_language;
@@ -52,6 +53,9 @@ language_builder_stage::~language_builder_stage() {
 
 /// \brief Performs the actions associated with this compilation stage
 void language_builder_stage::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"language_builder_stage");
+
     // Sanity check
     if (!m_ImportStage) {
         cons().report_error(error(error::sev_bug, filename(), L"BUG_NO_IMPORT_STAGE", L"Import stage missing", position(-1, -1, -1)));
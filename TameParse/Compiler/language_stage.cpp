@@ -28,6 +28,7 @@
 #include <sstream>
 
 #include "TameParse/Compiler/language_stage.h"
+#include "TameParse/Compiler/profiler.h"
 #include "TameParse/Compiler/precedence_block_rewriter.h"
 #include "TameParse/Language/process.h"
 #include "TameParse/Language/formatter.h"
@@ -44,7 +45,8 @@ language_stage::language_stage(console_container& console, const std::wstring& f
 : compilation_stage(console, filename)
 , m_Language(block)
 , m_Import(importStage)
-, m_InheritsFrom(NULL) {
+, m_InheritsFrom(NULL)
+, m_ErrorSymbol(-1) {
 }
 
 /// \brief Destructor
@@ -88,6 +90,9 @@ void language_stage::process_rule_symbols(const contextfree::rule& rule) {
 
 /// \brief Compiles the language, creating the dictionary of terminals, the lexer and the grammar
 void language_stage::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"language_stage");
+
 #ifndef TAMEPARSE_BOOTSTRAP
     // If this language inherits from another, then try to import it and if it exists, compile it first
     if (!m_Language->inherits().empty()) {
@@ -604,6 +609,12 @@ int language_stage::add_ebnf_lexer_items(yy_language::ebnf_item* item) {
                 break;
             }
             
+            // 'error' is used in error productions: it's a terminal symbol that the lexer never produces
+            if (item->identifier() == L"error") {
+                m_ErrorSymbol = m_Terminals.add_symbol(item->identifier());
+                break;
+            }
+            
             // Defining literal symbols in this way produces a warning
             wstringstream warningMsg;
             warningMsg << L"Implicitly defining keyword: " << item->identifier();
@@ -872,6 +883,7 @@ void language_stage::export_to(language_stage* target) {
     target->m_IgnoredSymbols        = m_IgnoredSymbols;
     target->m_TypeForTerminal       = m_TypeForTerminal;
     target->m_UnusedSymbols         = m_UnusedSymbols;
+    target->m_ErrorSymbol           = m_ErrorSymbol;
     target->m_UsedIgnoredSymbols    = m_UsedIgnoredSymbols;
     target->m_RuleItemData          = m_RuleItemData;
     target->m_ActionRewriters       = m_ActionRewriters;
@@ -105,6 +105,9 @@ namespace compiler {
         /// \brief Symbols defined in the lexer that are marked as 'unused'
         std::set<int> m_UnusedSymbols;
         
+        /// \brief The terminal symbol used in error productions, or -1 if the grammar doesn't use it
+        int m_ErrorSymbol;
+        
         /// \brief The type of the definition for each terminal symbol
         std::map<int, yy_language::language_unit::unit_type> m_TypeForTerminal;
         
@@ -190,6 +193,9 @@ namespace compiler {
 
         /// \brief The symbols that are usually ignored but occasionally have syntactic meaning
         inline const std::set<int>* used_ignored_symbols() const            { return &m_UsedIgnoredSymbols; }
+        
+        /// \brief The terminal symbol used in error productions (called 'error' in the grammar), or -1 if there isn't one
+        inline int error_symbol() const                                     { return m_ErrorSymbol; }
 
         /// \brief A list of the action rewriters defined by this language
         inline const rewriter_list* action_rewriters() const                { return &m_ActionRewriters; }
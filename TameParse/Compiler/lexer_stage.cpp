@@ -31,6 +31,7 @@
 
 #include <sstream>
 #include "TameParse/Compiler/lexer_stage.h"
+#include "TameParse/Compiler/profiler.h"
 
 using namespace std;
 using namespace dfa;
@@ -270,6 +271,9 @@ void lexer_stage::check_regex(dfa::ndfa_regex* ndfa, const std::wstring& regex,
 
 /// \brief Compiles the lexer
 void lexer_stage::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"lexer_stage");
+
     // Grab the input
     const lexer_data*       lex             = m_Language->lexer();
     terminal_dictionary*    terminals       = m_Language->terminals();
@@ -288,6 +292,8 @@ void lexer_stage::compile() {
     cons().verbose_stream() << L"  = Constructing final lexer" << endl;
 
     // Create the ndfa
+    profile_phase ndfaPhase(cons(), L"ndfa");
+
     typedef lexer_data::item_list item_list;
     ndfa_lexer_compiler*    stage0 = new ndfa_lexer_compiler(lex);
 
@@ -406,8 +412,12 @@ void lexer_stage::compile() {
     // Write out some stats about the ndfa
     cons().verbose_stream() << L"    Number states in the NDFA:              " << stage0->count_states() << endl;
     
+    ndfaPhase.end();
+
     // Compile the NDFA to a NDFA without overlapping symbol sets
+    profile_phase uniquePhase(cons(), L"unique_symbols");
     dfa::ndfa* stage1 = stage0->to_ndfa_with_unique_symbols();
+    uniquePhase.end();
     
     if (!stage1) {
         cons().report_error(error(error::sev_bug, filename(), L"BUG_DFA_FAILED_TO_CONVERT", L"Failed to create an NDFA with unique symbols", position(-1, -1, -1)));
@@ -422,9 +432,11 @@ void lexer_stage::compile() {
     stage0 = NULL;
     
     // Compile the NDFA to a DFA
+    profile_phase dfaPhase(cons(), L"dfa");
     dfa::ndfa* stage2 = stage1->to_dfa();
     delete stage1;
     stage1 = NULL;
+    dfaPhase.end();
     
     if (!stage2) {
         cons().report_error(error(error::sev_bug, filename(), L"BUG_DFA_FAILED_TO_COMPILE", L"Failed to compile DFA", position(-1, -1, -1)));
@@ -470,6 +482,11 @@ void lexer_stage::compile() {
             continue;
         }
 
+        // The error symbol is never generated by the lexer
+        if (*unusedSymbol == m_Language->error_symbol()) {
+            continue;
+        }
+
         // Get the position of this terminal
         position        pos     = m_Language->terminal_definition_pos(*unusedSymbol);
         const wstring&  file    = m_Language->terminal_definition_file(*unusedSymbol);
@@ -511,7 +528,9 @@ void lexer_stage::compile() {
         }
         
         // Add these symbols to the weak symbols object
+        profile_phase weakPhase(cons(), L"weak_symbols");
         m_WeakSymbols.add_symbols(*stage2, weakSymSet, *terminals);
+        weakPhase.end();
         
         // Display how many new terminal symbols were added
         int finalSymCount = terminals->count_symbols();
@@ -525,6 +544,7 @@ void lexer_stage::compile() {
     dfa::ndfa* stage3;
 
     if (cons().get_option(L"disable-compact-dfa").empty()) {
+        profile_phase compactPhase(cons(), L"compact");
         stage3 = stage2->to_compact_dfa();
         delete stage2;
         stage2 = NULL;
@@ -540,6 +560,7 @@ void lexer_stage::compile() {
     dfa::ndfa* stage4;
     
     if (cons().get_option(L"disable-merged-dfa").empty()) {
+        profile_phase mergePhase(cons(), L"merged_symbols");
         stage4 = stage3->to_ndfa_with_merged_symbols();
         delete stage3;
         stage3 = NULL;
@@ -554,9 +575,32 @@ void lexer_stage::compile() {
     m_Dfa = stage4;
     
     // Build the final lexer
+    profile_phase lexerPhase(cons(), L"lexer");
     m_Lexer = new lexer(*m_Dfa);
+    lexerPhase.end();
     
     // Write some parting words
     // (Well, this is really kibibytes but I can't take blibblebytes seriously as a unit of measurement)
     cons().verbose_stream() << L"    Approximate size of final lexer:        " << (m_Lexer->size() + 512) / 1024 << L" kilobytes" << endl;
 }
+
+/// \brief Uses a DFA that was built by an earlier compilation instead of compiling a new one
+void lexer_stage::use_dfa(dfa::ndfa* dfa) {
+    // Replace any existing DFA
+    if (m_Dfa) {
+        delete m_Dfa;
+    }
+    
+    if (m_Lexer) {
+        delete m_Lexer;
+    }
+    
+    m_Dfa = dfa;
+    
+    // Build the lexer
+    cons().verbose_stream() << L"  = Using cached lexer" << endl;
+    
+    profile_phase lexerPhase(cons(), L"lexer");
+    m_Lexer = new lexer(*m_Dfa);
+    lexerPhase.end();
+}
@@ -68,6 +68,12 @@ namespace compiler {
         
         /// \brief Compiles the lexer (the language compiler must have completed its work by this point)
         void compile();
+        
+        /// \brief Uses a DFA that was built by an earlier compilation instead of compiling a new one
+        ///
+        /// This stage takes ownership of the DFA. Any weak symbols that were split off when the DFA was built should
+        /// already have been added to the terminal dictionary for the language.
+        void use_dfa(dfa::ndfa* dfa);
 
     private:
         /// \brief Reports any errors that might have occurred in the specified regular expression
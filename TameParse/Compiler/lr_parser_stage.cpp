@@ -27,6 +27,7 @@
 
 #include <sstream>
 #include "TameParse/Compiler/lr_parser_stage.h"
+#include "TameParse/Compiler/profiler.h"
 #include "TameParse/Lr/conflict.h"
 #include "TameParse/Lr/ignored_symbols.h"
 #include "TameParse/Language/formatter.h"
@@ -213,6 +214,9 @@ static void warn_clashing_guards(console& cons, const language_stage* language,
 
 /// \brief Compiles the parser specified by the parameters to this stage
 void lr_parser_stage::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"lr_parser_stage");
+
     // Verbose message to say which stage we're at
     cons().verbose_stream() << L"  = Building parser" << endl;
 
@@ -335,12 +339,30 @@ void lr_parser_stage::compile() {
     m_Parser->add_rewriter(ignoreContainer);
 
     // Build the parser
-    m_Parser->complete_parser();
+    profile_phase lr0Phase(cons(), L"lr0");
+    m_Parser->complete_lr0_machine();
+    lr0Phase.end();
+
+    profile_phase lookaheadPhase(cons(), L"lookahead_propagation");
+    m_Parser->complete_lookaheads();
+    lookaheadPhase.end();
+
+    // Generate the actions for every state (these are cached by the builder, so this is only done here so the time they
+    // take is recorded separately from the time taken to find conflicts)
+    if (cons().get_profiler()) {
+        profile_phase actionPhase(cons(), L"actions");
+        for (int stateId = 0; stateId < m_Parser->count_states(); ++stateId) {
+            m_Parser->actions_for_state(stateId);
+        }
+    }
 
     // Get any conflicts that might exist
     conflict_list conflictList;
     cons().verbose_stream() << L"  = Checking for conflicts" << endl;
+
+    profile_phase conflictPhase(cons(), L"conflicts");
     conflict::find_conflicts(*m_Parser, conflictList);
+    conflictPhase.end();
 
     // Report the conflicts
     error::severity shiftReduceSev  = error::sev_warning;
@@ -448,8 +470,15 @@ void lr_parser_stage::compile() {
     warn_clashing_guards(cons(), m_Language, m_Parser);
     
     // Build an actual AST parser so we can display some stats
+    profile_phase tablesPhase(cons(), L"tables");
     m_Tables = new parser_tables(*m_Parser, m_LexerCompiler->weak_symbols());
     
+    // Use default reductions if requested
+    if (!cons().get_option(L"compress-tables").empty()) {
+        m_Tables->compress();
+    }
+    tablesPhase.end();
+    
     // Display some stats
     int totalActions = 0;
     for (int stateId = 0; stateId < m_Tables->count_states(); ++stateId) {
@@ -462,6 +491,23 @@ void lr_parser_stage::compile() {
     cons().verbose_stream() << L"    Approximate size of final parse tables: " << m_Tables->size()/1024 << L" kilobytes" << endl;
 }
 
+/// \brief Uses parser tables that were built by an earlier compilation instead of compiling new ones
+void lr_parser_stage::use_tables(lr::parser_tables* tables) {
+    // Replace any existing parser
+    if (m_Parser) {
+        delete m_Parser;
+        m_Parser = NULL;
+    }
+    
+    if (m_Tables) {
+        delete m_Tables;
+    }
+    
+    m_Tables = tables;
+    
+    cons().verbose_stream() << L"  = Using cached parser" << endl;
+}
+
 /// \brief Reports errors for a particular reduce conflict (the 'in' and 'to' messages)
 void lr_parser_stage::report_reduce_conflict(lr::conflict::reduce_iterator& reduceItem, item_container nonterminal, set<item_container>& displayedNonterminals, int level) {
     // Only display the set for a given target nonterminal once
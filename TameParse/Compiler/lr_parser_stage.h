@@ -83,13 +83,18 @@ namespace compiler {
 
         /// \brief Compiles the parser specified by the parameters to this stage
         void compile();
+        
+        /// \brief Uses parser tables that were built by an earlier compilation instead of compiling new ones
+        ///
+        /// This stage takes ownership of the tables. No LALR builder is available when the tables are supplied this way.
+        void use_tables(lr::parser_tables* tables);
 
     private:
         /// \brief Reports errors for a particular reduce conflict (the 'in' and 'to' messages)
         void report_reduce_conflict(lr::conflict::reduce_iterator& reduceItem, contextfree::item_container nonterminal, std::set<contextfree::item_container>& displayedNonterminals, int level);
         
     public:
-        /// \brief Returns the parser built by this stage
+        /// \brief Returns the parser built by this stage (NULL if the tables were supplied by use_tables)
         inline lr::lalr_builder* get_parser() { return m_Parser; }
         
         /// \brief Returns the parse tables built by this stage
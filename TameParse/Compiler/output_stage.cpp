@@ -29,6 +29,7 @@
 #include <sstream>
 
 #include "TameParse/Compiler/output_stage.h"
+#include "TameParse/Compiler/profiler.h"
 
 using namespace std;
 using namespace dfa;
@@ -52,6 +53,9 @@ output_stage::~output_stage() {
 /// Subclasses can override this if they want to substantially change the way that the
 /// compiler is generated.
 void output_stage::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"output_stage");
+
     // TODO: sanity check
 
     // Start writing the output
@@ -468,6 +472,10 @@ void output_stage::generate_ast_rules() {
         // Set it up
         thisNt.nonterminalId = nonterminalId;
 
+        // The items that each name refers to within this nonterminal
+        // (Names are shared between rules, so the same name can't be used for different items)
+        map<wstring, item_container> itemForName;
+
         for (rule_list::iterator nextRule = rulesForNonterminal[nonterminalId].begin(); nextRule != rulesForNonterminal[nonterminalId].end(); ++nextRule) {
             // Get the identifier for this rule
             int ruleId = gram().identifier_for_rule(*nextRule);
@@ -496,7 +504,15 @@ void output_stage::generate_ast_rules() {
                 wstring uniqueName  = baseName;
                 int     offset      = 1;
 
-                while (usedNames.find(uniqueName) != usedNames.end() || !name_is_valid(uniqueName)) {
+                for (;;) {
+                    // Stop if this name is unused in this rule and doesn't refer to a different item in another rule
+                    if (usedNames.find(uniqueName) == usedNames.end() && name_is_valid(uniqueName)) {
+                        map<wstring, item_container>::const_iterator existing = itemForName.find(uniqueName);
+                        if (existing == itemForName.end() || *existing->second == **ruleItem) {
+                            break;
+                        }
+                    }
+
                     // Append _2, etc if this name has already been encountered in this rule or is invalid
                     offset++;
 
@@ -509,6 +525,7 @@ void output_stage::generate_ast_rules() {
 
                 // Remember the unique name
                 usedNames.insert(uniqueName);
+                itemForName.insert(map<wstring, item_container>::value_type(uniqueName, *ruleItem));
 
                 // Set the 'EBNF repetition' flag
                 bool isEbnfRepeat = false;
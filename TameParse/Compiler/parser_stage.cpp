@@ -31,6 +31,7 @@
 #include "TameParse/Util/utf8reader.h"
 #include "TameParse/Language/language_parser.h"
 #include "TameParse/Compiler/parser_stage.h"
+#include "TameParse/Compiler/profiler.h"
 
 using namespace std;
 using namespace util;
@@ -45,6 +46,9 @@ parser_stage::parser_stage(console_container& console, const std::wstring& filen
 
 /// \brief Performs the actions associated with this compilation stage
 void parser_stage::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"parser_stage");
+
     // Message to say what we're doing
     cons().verbose_stream() << "  = Reading " << filename() << endl;
 
@@ -0,0 +1,197 @@
+//
+//  profiler.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy 
+//  of this software and associated documentation files (the \"Software\"), to 
+//  deal in the Software without restriction, including without limitation the 
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+//  sell copies of the Software, and to permit persons to whom the Software is 
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+//  IN THE SOFTWARE.
+//
+
+#include <iomanip>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "TameParse/Compiler/profiler.h"
+
+using namespace std;
+using namespace compiler;
+
+/// \brief Creates a new profiler (and begins the root phase)
+profiler::profiler(const std::wstring& name)
+: m_Current(-1) {
+    begin_phase(name);
+}
+
+/// \brief Begins a new phase, as a sub-phase of the phase that is currently running
+void profiler::begin_phase(const std::wstring& name) {
+    // Create the data for this phase
+    phase_data newPhase;
+
+    newPhase.name           = name;
+    newPhase.parent         = m_Current;
+    newPhase.seconds        = -1;
+    newPhase.startPeakKb    = peak_memory_kb();
+    newPhase.endPeakKb      = -1;
+
+    // Add to the list of phases
+    int phaseId = (int) m_Phases.size();
+    m_Phases.push_back(newPhase);
+
+    if (m_Current >= 0) {
+        m_Phases[m_Current].children.push_back(phaseId);
+    }
+
+    // This is now the running phase
+    m_Current = phaseId;
+
+    // Start the clock last so the time taken to set up the phase is not included
+    m_Phases[phaseId].start = clock::now();
+}
+
+/// \brief Ends the phase that is currently running
+void profiler::end_phase() {
+    // The root phase only ends when the profiler is written out
+    if (m_Current <= 0) return;
+
+    // Record the results for this phase
+    phase_data& phase = m_Phases[m_Current];
+
+    phase.seconds   = chrono::duration<double>(clock::now() - phase.start).count();
+    phase.endPeakKb = peak_memory_kb();
+
+    // Move back to the parent phase
+    m_Current = phase.parent;
+}
+
+/// \brief Retrieves the peak memory usage of this process so far, in kilobytes (or -1 if this is unavailable)
+long profiler::peak_memory_kb() {
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+
+#ifdef __APPLE__
+    // OS X reports this value in bytes rather than kilobytes
+    return (long) (usage.ru_maxrss / 1024);
+#else
+    return (long) usage.ru_maxrss;
+#endif
+#endif
+}
+
+/// \brief Writes a string in JSON format
+static void write_json_string(ostream& out, const wstring& str) {
+    out << '"';
+
+    for (wstring::const_iterator chr = str.begin(); chr != str.end(); ++chr) {
+        switch (*chr) {
+            case L'"':  out << "\\\""; break;
+            case L'\\': out << "\\\\"; break;
+            case L'\n': out << "\\n"; break;
+            case L'\r': out << "\\r"; break;
+            case L'\t': out << "\\t"; break;
+
+            default:
+                if (*chr < 0x20 || *chr > 0x7e) {
+                    // Use an escape sequence for anything that isn't printable ASCII
+                    // (Characters outside the BMP are truncated, which is harmless for phase names)
+                    out << "\\u" << hex << setw(4) << setfill('0') << (unsigned int) (*chr & 0xffff) << dec << setfill(' ');
+                } else {
+                    out << (char) *chr;
+                }
+                break;
+        }
+    }
+
+    out << '"';
+}
+
+/// \brief Writes out the phase with the specified index
+void profiler::write_phase(std::ostream& out, int phaseId, int indent, const clock::time_point& now, long nowPeakKb) const {
+    const phase_data&   phase   = m_Phases[phaseId];
+    string              prefix(indent, ' ');
+
+    // Phases that are still running are measured up to the current time
+    double  seconds     = phase.seconds;
+    long    endPeakKb   = phase.endPeakKb;
+
+    if (seconds < 0) {
+        seconds     = chrono::duration<double>(now - phase.start).count();
+        endPeakKb   = nowPeakKb;
+    }
+
+    out << prefix << "{\n";
+    out << prefix << "  \"name\": ";
+    write_json_string(out, phase.name);
+    out << ",\n";
+    out << prefix << "  \"wall_seconds\": " << fixed << setprecision(6) << seconds << ",\n";
+
+    // Write out the memory usage (null if it couldn't be measured)
+    out << prefix << "  \"peak_rss_kb\": ";
+    if (endPeakKb >= 0) out << endPeakKb; else out << "null";
+    out << ",\n";
+
+    out << prefix << "  \"peak_rss_growth_kb\": ";
+    if (endPeakKb >= 0 && phase.startPeakKb >= 0) out << endPeakKb - phase.startPeakKb; else out << "null";
+    out << ",\n";
+
+    // Write out the sub-phases
+    out << prefix << "  \"phases\": [";
+
+    for (size_t childId = 0; childId < phase.children.size(); ++childId) {
+        out << (childId > 0 ? ",\n" : "\n");
+        write_phase(out, phase.children[childId], indent + 4, now, nowPeakKb);
+    }
+
+    if (!phase.children.empty()) {
+        out << "\n" << prefix << "  ";
+    }
+    out << "]\n";
+    out << prefix << "}";
+}
+
+/// \brief Writes out the phases recorded so far in JSON format
+void profiler::write_json(std::ostream& out) const {
+    if (m_Phases.empty()) return;
+
+    write_phase(out, 0, 0, clock::now(), peak_memory_kb());
+    out << "\n";
+}
+
+/// \brief Begins a phase with the specified name
+profile_phase::profile_phase(console& cons, const std::wstring& name)
+: m_Profiler(cons.get_profiler()) {
+    if (m_Profiler) m_Profiler->begin_phase(name);
+}
+
+/// \brief Ends the phase, if it has not already been ended
+profile_phase::~profile_phase() {
+    end();
+}
+
+/// \brief Ends the phase before this object goes out of scope
+void profile_phase::end() {
+    if (m_Profiler) {
+        m_Profiler->end_phase();
+        m_Profiler = NULL;
+    }
+}
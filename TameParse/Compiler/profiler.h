@@ -0,0 +1,132 @@
+//
+//  profiler.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy 
+//  of this software and associated documentation files (the \"Software\"), to 
+//  deal in the Software without restriction, including without limitation the 
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+//  sell copies of the Software, and to permit persons to whom the Software is 
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+//  IN THE SOFTWARE.
+//
+
+#ifndef _COMPILER_PROFILER_H
+#define _COMPILER_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <chrono>
+
+#include "TameParse/Compiler/console.h"
+
+namespace compiler {
+    ///
+    /// \brief Records the time and memory used by the phases of a compilation
+    ///
+    /// Phases are nested: a phase that begins while another is running is treated as a sub-phase of that phase. The
+    /// profiler itself is the root phase and begins when it is created. Memory usage is measured as the peak resident
+    /// set size of the process, so the value for a phase is the largest amount of memory used by the process up to the
+    /// point where the phase finished.
+    ///
+    class profiler {
+    private:
+        /// \brief The clock used to measure phases
+        typedef std::chrono::steady_clock clock;
+
+        /// \brief Data recorded for a single phase
+        struct phase_data {
+            /// \brief The name of this phase
+            std::wstring name;
+
+            /// \brief The index of the parent phase (-1 for the root phase)
+            int parent;
+
+            /// \brief The indexes of the sub-phases of this phase
+            std::vector<int> children;
+
+            /// \brief The time when this phase started
+            clock::time_point start;
+
+            /// \brief The number of seconds taken by this phase, or a negative value if the phase is still running
+            double seconds;
+
+            /// \brief Peak memory usage of the process when this phase started (in kilobytes)
+            long startPeakKb;
+
+            /// \brief Peak memory usage of the process when this phase finished (in kilobytes)
+            long endPeakKb;
+        };
+
+        /// \brief The phases that have been recorded (the first phase is the root phase)
+        std::vector<phase_data> m_Phases;
+
+        /// \brief The phase that is currently running
+        int m_Current;
+
+        profiler(const profiler& noCopying);
+        profiler& operator=(const profiler& noCopying);
+
+    public:
+        /// \brief Creates a new profiler (and begins the root phase)
+        explicit profiler(const std::wstring& name = L"tameparse");
+
+        /// \brief Begins a new phase, as a sub-phase of the phase that is currently running
+        void begin_phase(const std::wstring& name);
+
+        /// \brief Ends the phase that is currently running
+        void end_phase();
+
+        /// \brief Writes out the phases recorded so far in JSON format
+        ///
+        /// Phases that are still running (including the root phase) are reported as if they finished at the time this
+        /// is called.
+        void write_json(std::ostream& out) const;
+
+        /// \brief Retrieves the peak memory usage of this process so far, in kilobytes (or -1 if this is unavailable)
+        static long peak_memory_kb();
+
+    private:
+        /// \brief Writes out the phase with the specified index
+        void write_phase(std::ostream& out, int phaseId, int indent, const clock::time_point& now, long nowPeakKb) const;
+    };
+
+    ///
+    /// \brief Class that records a phase for the profiler associated with a console while it is in scope
+    ///
+    /// Nothing is recorded if the console does not have a profiler.
+    ///
+    class profile_phase {
+    private:
+        /// \brief The profiler that the phase is being recorded for (NULL if there is no profiler or the phase has ended)
+        profiler* m_Profiler;
+
+        profile_phase(const profile_phase& noCopying);
+        profile_phase& operator=(const profile_phase& noCopying);
+
+    public:
+        /// \brief Begins a phase with the specified name
+        profile_phase(console& cons, const std::wstring& name);
+
+        /// \brief Ends the phase, if it has not already been ended
+        ~profile_phase();
+
+        /// \brief Ends the phase before this object goes out of scope
+        void end();
+    };
+}
+
+#endif
@@ -52,13 +52,15 @@ static nullstream s_NullStream;
 /// \brief Creates a standard console with the specified input filename
 std_console::std_console(const std::wstring& inputFilename)
 : m_InputFilename(inputFilename)
-, m_ExitCode(0) {
+, m_ExitCode(0)
+, m_Profiler(NULL) {
 }
 
 /// \brief Creates a copy of this console
 console* std_console::clone() const {
     std_console* res = new std_console(m_InputFilename);
     res->m_ExitCode = m_ExitCode;
+    res->m_Profiler = m_Profiler;
     return res;
 }
 
@@ -183,6 +185,16 @@ const std::wstring& std_console::input_file() const {
     return m_InputFilename;
 }
 
+/// \brief Retrieves the profiler that compilation stages should report their phases to
+profiler* std_console::get_profiler() const {
+    return m_Profiler;
+}
+
+/// \brief Sets the profiler that compilation stages should report their phases to
+void std_console::set_profiler(profiler* newProfiler) {
+    m_Profiler = newProfiler;
+}
+
 /// \brief Opens a file with the specified name for reading
 ///
 /// The caller should delete the stream once it has finished with it
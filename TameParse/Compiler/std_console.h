@@ -42,6 +42,9 @@ namespace compiler {
         /// \brief The exit code to use
         int m_ExitCode;
         
+        /// \brief The profiler used by this console (NULL if none)
+        profiler* m_Profiler;
+        
     public:
         /// \brief Creates a standard console with the specified input filename
         std_console(const std::wstring& inputFilename);
@@ -73,6 +76,14 @@ namespace compiler {
         /// \brief The name of the initial input file
         virtual const std::wstring& input_file() const;
         
+        /// \brief Retrieves the profiler that compilation stages should report their phases to
+        virtual profiler* get_profiler() const;
+        
+        /// \brief Sets the profiler that compilation stages should report their phases to
+        ///
+        /// The profiler is not owned by this console and must remain valid while the console is in use.
+        void set_profiler(profiler* newProfiler);
+        
     public:
         /// \brief Opens a file with the specified name for reading
         ///
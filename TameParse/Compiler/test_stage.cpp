@@ -29,6 +29,7 @@
 
 #include "TameParse/Util/utf8reader.h"
 #include "TameParse/Compiler/test_stage.h"
+#include "TameParse/Compiler/profiler.h"
 #include "TameParse/Language/test_block.h"
 
 using namespace std;
@@ -171,6 +172,9 @@ lr_parser_stage* test_stage::get_parser(const std::wstring& languageName, const
 
 /// \brief Performs the actions associated with this compilation stage
 void test_stage::compile() {
+    // Record this stage with the profiler
+    profile_phase phase(cons(), L"test_stage");
+
     // Sanity check
     if (!m_Definition.item()) {
         cons().report_error(error(error::sev_bug, filename(), L"BUG_MISSING_DEFINITION", L"Definition for testing stage not specified", position(-1, -1, -1)));
@@ -40,6 +40,75 @@ void lexeme_stream::set_initial_state(int initialState) {
     // Default action is to do nothing
 }
 
+/// \brief Restarts this stream so that it reads from a new source of symbols
+bool lexeme_stream::reset(lexer_symbol_stream* newSource) {
+    // Streams can't be reset by default
+    return false;
+}
+
+/// \brief Sets whether or not this stream should work out the line and column of each lexeme
+bool lexeme_stream::set_offsets_only(bool offsetsOnly) {
+    // Streams always track lines and columns by default
+    return false;
+}
+
+/// \brief Retrieves a checkpoint that can be used to restart this stream at the next lexeme
+bool lexeme_stream::get_checkpoint(lexer_checkpoint& result) const {
+    // Streams don't support checkpoints by default
+    return false;
+}
+
+/// \brief Restarts this stream from a checkpoint, reading from a new source of symbols
+bool lexeme_stream::restart(lexer_symbol_stream* newSource, const lexer_checkpoint& from) {
+    return false;
+}
+
+/// \brief Reads the symbol ID and position of the next lexeme without keeping its text
+bool lexeme_stream::read_symbol(int& matched, position& pos) {
+    // The default implementation just reads a lexeme and throws it away
+    lexeme* next = NULL;
+    (*this) >> next;
+    
+    if (!next) return false;
+    
+    matched = next->matched();
+    pos     = next->pos();
+    delete next;
+    
+    return true;
+}
+
+/// \brief Reads up to count tokens into the specified array, returning the number that were read
+size_t lexeme_stream::read_batch(token* out, size_t count) {
+    // The default implementation reads lexemes one at a time and throws them away
+    for (size_t index = 0; index < count; ++index) {
+        lexeme* next = NULL;
+        (*this) >> next;
+        
+        // Lexemes don't say where the end of the file is, so the end of input token has an unknown offset
+        if (!next) {
+            out[index] = token(symbol_set::end_of_input, -1, 0);
+            return index + 1;
+        }
+        
+        out[index] = token(next->matched(), next->pos().offset(), (int) next->content().size());
+        delete next;
+    }
+    
+    return count;
+}
+
+/// \brief Reads up to count lexemes into the specified array, returning the number that were read
+size_t lexeme_stream::read_batch(lexeme** out, size_t count) {
+    // The default implementation reads lexemes one at a time
+    for (size_t index = 0; index < count; ++index) {
+        (*this) >> out[index];
+        if (!out[index]) return index;
+    }
+    
+    return count;
+}
+
 /// \brief Destructor
 lexeme_stream::~lexeme_stream() {
 }
@@ -36,8 +36,63 @@
 #include "TameParse/Dfa/state_machine.h"
 #include "TameParse/Dfa/lexeme.h"
 #include "TameParse/Dfa/position.h"
+#include "TameParse/Dfa/token.h"
 
 namespace dfa {
+    class lexer_symbol_stream;
+    
+    ///
+    /// \brief The state of a lexeme stream between two lexemes
+    ///
+    /// A lexeme stream can be restarted from a checkpoint, which is much cheaper than lexing everything before it
+    /// again. The lexemes after the checkpoint can only change if the document is changed after examined().
+    ///
+    class lexer_checkpoint {
+    private:
+        /// \brief The number of symbols that make up the lexemes before this checkpoint
+        size_t m_Offset;
+        
+        /// \brief The number of symbols that the lexer had read from its source when this checkpoint was made
+        size_t m_Examined;
+        
+        /// \brief The initial state to use for the next lexeme
+        int m_InitialState;
+        
+        /// \brief The position of the next lexeme
+        position_tracker m_Position;
+        
+    public:
+        inline lexer_checkpoint()
+        : m_Offset(0)
+        , m_Examined(0)
+        , m_InitialState(0) {
+        }
+        
+        inline lexer_checkpoint(size_t offset, size_t examined, int initialState, const position_tracker& pos)
+        : m_Offset(offset)
+        , m_Examined(examined)
+        , m_InitialState(initialState)
+        , m_Position(pos) {
+        }
+        
+        /// \brief The number of symbols that make up the lexemes before this checkpoint
+        ///
+        /// A stream restarted from this checkpoint should read from a source that starts at this offset.
+        inline size_t offset() const { return m_Offset; }
+        
+        /// \brief The number of symbols that the lexer had read when this checkpoint was made
+        ///
+        /// The lexer reads ahead to find the longest match, so this is usually larger than the offset. Reading the
+        /// end of input counts as reading a symbol.
+        inline size_t examined() const { return m_Examined; }
+        
+        /// \brief The initial state to use for the next lexeme
+        inline int initial_state() const { return m_InitialState; }
+        
+        /// \brief The position of the next lexeme
+        inline const position_tracker& position() const { return m_Position; }
+    };
+    
     ///
     /// \brief Abstract base class that represents a session with a lexer
     ///
@@ -51,11 +106,237 @@ namespace dfa {
         /// The caller needs to delete the resulting lexeme object
         virtual lexeme_stream& operator>>(lexeme*& result) = 0;
         
+        ///
+        /// \brief Reads the symbol ID and position of the next lexeme without keeping its text
+        ///
+        /// Returns false if the end of input has been reached. This is for callers that only need to know which
+        /// symbols are in the input, such as a recogniser: the default implementation reads a lexeme and deletes
+        /// it, but lexers can override it to avoid allocating anything at all.
+        ///
+        virtual bool read_symbol(int& matched, position& pos);
+        
+        ///
+        /// \brief Reads up to count tokens into the specified array, returning the number that were read
+        ///
+        /// This lets the lexer run on its own for a while rather than being called once for each symbol. The batch
+        /// ends early if the end of input is reached: the last token is then an end of input token, whose symbol is
+        /// symbol_set::end_of_input and whose offset is the length of the input. Every later call returns just that
+        /// token again.
+        ///
+        /// Tokens only record their offset, so the lexer doesn't need to work out the line and column of each one.
+        /// Use a dfa::line_index built from the input to find them.
+        ///
+        /// The tokens in a batch are lexed before any of them are seen by the caller, so set_initial_state() only
+        /// affects the tokens in later batches. A parser that changes the lexer state in response to the symbols it
+        /// sees should read a single token at a time.
+        ///
+        virtual size_t read_batch(token* out, size_t count);
+        
+        ///
+        /// \brief Reads up to count lexemes into the specified array, returning the number that were read
+        ///
+        /// The batch is empty only if the end of input was reached. It can be shorter than count before then if the
+        /// stream can't read ahead. The caller needs to delete the lexemes. As for the token version,
+        /// set_initial_state() only affects the lexemes in later batches, so the parser actions only read batches
+        /// when this is turned on (see lexeme_batch_reader).
+        ///
+        virtual size_t read_batch(lexeme** out, size_t count);
+        
         /// \brief Sets the initial state to be used by the next run through of the state machine
         ///
         /// Might not do anything, the meaning of the 'initialState' is defined by the implementation of the lexer. However, the default initial 
         /// state is always 0.
         virtual void set_initial_state(int initialState);
+        
+        ///
+        /// \brief Restarts this stream so that it reads from a new source of symbols
+        ///
+        /// Any buffered symbols are discarded and the position is set back to the start of the file, but the storage
+        /// used by the stream is kept. If this returns true, the stream takes ownership of the new source (and destroys
+        /// the old one). If it returns false, then the stream can't be reset and the caller still owns the new source.
+        ///
+        virtual bool reset(lexer_symbol_stream* newSource);
+        
+        ///
+        /// \brief Sets whether or not this stream should work out the line and column of each lexeme
+        ///
+        /// Keeping track of lines and columns means looking at every symbol in the input as it is read. Streams that
+        /// are set to report offsets only skip this: positions they produce have the offset of the symbol in the
+        /// input (counting every symbol) and -1 for the line and column. These can be filled in later, if they are
+        /// needed, with a dfa::line_index built from the input.
+        ///
+        /// Returns false if this stream can't report offsets only. Checkpoints aren't available from streams that
+        /// are reporting offsets only. This should be called before the first lexeme is read.
+        ///
+        virtual bool set_offsets_only(bool offsetsOnly);
+        
+        ///
+        /// \brief Retrieves a checkpoint that can be used to restart this stream at the next lexeme
+        ///
+        /// Returns false if this stream doesn't support checkpoints.
+        ///
+        virtual bool get_checkpoint(lexer_checkpoint& result) const;
+        
+        ///
+        /// \brief Restarts this stream from a checkpoint, reading from a new source of symbols
+        ///
+        /// The new source should start at the checkpoint's offset into the original document. As for reset(), the
+        /// stream takes ownership of the new source if this returns true.
+        ///
+        virtual bool restart(lexer_symbol_stream* newSource, const lexer_checkpoint& from);
+    };
+    
+    ///
+    /// \brief Reads symbols from a lexeme stream a batch of tokens at a time
+    ///
+    /// This has the same next_symbol() method as dfa::symbol_reader, so it can be used with
+    /// lr::recogniser::recognise_from(). The stream is not owned by this object.
+    ///
+    class batch_reader {
+    public:
+        /// \brief The number of tokens read from the stream at once
+        enum { batch_size = 64 };
+        
+    private:
+        /// \brief The stream to read from
+        lexeme_stream* m_Stream;
+        
+        /// \brief The tokens in the current batch
+        token m_Batch[batch_size];
+        
+        /// \brief The number of tokens in the current batch
+        size_t m_Count;
+        
+        /// \brief The index of the next token to return from the current batch
+        size_t m_Pos;
+        
+    public:
+        /// \brief Creates a reader for the specified stream
+        explicit batch_reader(lexeme_stream* stream)
+        : m_Stream(stream)
+        , m_Count(0)
+        , m_Pos(0) {
+        }
+        
+        /// \brief Reads the next symbol, fetching a new batch from the stream when the current one is used up
+        ///
+        /// Returns false at the end of input, setting pos to the end of the file. Positions only contain an offset
+        /// (use dfa::line_index::resolve() to find the line and column).
+        inline bool next_symbol(int& matched, position& pos) {
+            if (m_Pos >= m_Count) {
+                m_Count = m_Stream->read_batch(m_Batch, batch_size);
+                m_Pos   = 0;
+            }
+            
+            const token& next = m_Batch[m_Pos];
+            pos = next.pos();
+            
+            // The stream returns the end of input token again if it is read past the end, so it's never skipped
+            if (next.matched() == symbol_set::end_of_input) return false;
+            
+            matched = next.matched();
+            ++m_Pos;
+            return true;
+        }
+    };
+    
+    ///
+    /// \brief Reads lexemes from a lexeme stream, optionally a batch at a time
+    ///
+    /// This is used by the parser actions classes to fill the parser's lookahead. By default, each lexeme is read
+    /// from the stream when the parser asks for it. If batches are turned on with set_batched(), the lexer runs for
+    /// a whole batch before returning rather than being called once for each symbol. This is faster, but the lexer
+    /// then reads ahead of the parser: set_initial_state() only affects the lexemes in later batches, and the
+    /// source has to supply the symbols for a whole batch before the parser sees the first of them. Only turn
+    /// batches on for languages that never change the lexer state.
+    ///
+    /// Lexemes that have been read from the stream but not returned are destroyed when the reader is reset or
+    /// destroyed. The stream is not owned by this object.
+    ///
+    class lexeme_batch_reader {
+    public:
+        /// \brief The number of lexemes read from the stream at once
+        enum { batch_size = 32 };
+        
+    private:
+        /// \brief The stream to read from
+        lexeme_stream* m_Stream;
+        
+        /// \brief The lexemes in the current batch
+        lexeme* m_Batch[batch_size];
+        
+        /// \brief The number of lexemes in the current batch
+        size_t m_Count;
+        
+        /// \brief The index of the next lexeme to return from the current batch
+        size_t m_Pos;
+        
+        /// \brief True if lexemes should be read from the stream a batch at a time
+        bool m_Batched;
+        
+        lexeme_batch_reader(const lexeme_batch_reader& noCopying);
+        lexeme_batch_reader& operator=(const lexeme_batch_reader& noCopying);
+        
+        /// \brief Destroys the lexemes in the current batch that have not been returned
+        inline void discard() {
+            for (; m_Pos < m_Count; ++m_Pos) {
+                delete m_Batch[m_Pos];
+            }
+        }
+        
+    public:
+        /// \brief Creates a reader for the specified stream
+        explicit lexeme_batch_reader(lexeme_stream* stream)
+        : m_Stream(stream)
+        , m_Count(0)
+        , m_Pos(0)
+        , m_Batched(false) {
+        }
+        
+        /// \brief Destructor
+        ~lexeme_batch_reader() {
+            discard();
+        }
+        
+        /// \brief Discards the current batch and starts reading from the specified stream (which can be the same one after it has been reset)
+        inline void reset(lexeme_stream* stream) {
+            discard();
+            
+            m_Stream    = stream;
+            m_Count     = 0;
+            m_Pos       = 0;
+        }
+        
+        /// \brief True if lexemes are read from the stream a batch at a time
+        inline bool batched() const { return m_Batched; }
+        
+        ///
+        /// \brief Sets whether or not lexemes are read from the stream a batch at a time
+        ///
+        /// Any lexemes that have already been read ahead are still returned if batches are turned off.
+        ///
+        inline void set_batched(bool batched) { m_Batched = batched; }
+        
+        /// \brief Reads the next lexeme, or returns NULL at the end of input (the caller needs to delete the result)
+        ///
+        /// The stream is read again once a batch is used up, even after the end of input, so a stream that is reset
+        /// once the parser has read everything from it can be used again without resetting this object.
+        inline lexeme* read() {
+            if (m_Pos < m_Count) return m_Batch[m_Pos++];
+            
+            // Read a single lexeme unless batches have been turned on
+            if (!m_Batched) {
+                lexeme* result = NULL;
+                (*m_Stream) >> result;
+                return result;
+            }
+            
+            m_Count = m_Stream->read_batch(m_Batch, batch_size);
+            m_Pos   = 0;
+            
+            if (m_Count == 0) return NULL;
+            return m_Batch[m_Pos++];
+        }
     };
     
     ///
@@ -232,7 +513,21 @@ namespace dfa {
             /// \brief The initial state to use before retrieving the next lexeme
             int m_InitialState;
             
+            /// \brief The number of symbols in the lexemes returned so far
+            size_t m_Consumed;
+            
+            /// \brief True if the end of input has been read from the stream
+            bool m_ReadEnd;
+            
+            /// \brief True if positions should only contain the offset (see lexeme_stream::set_offsets_only())
+            bool m_OffsetsOnly;
+            
         private:
+            /// \brief The position of the start of the next lexeme
+            inline position current_position() const {
+                if (m_OffsetsOnly) return position((int) m_Consumed, -1, -1);
+                return m_Position.current_position();
+            }
             
         public:
             /// \brief Creates a new stream that works with the specified state machine, list of accepting actions and symbol stream
@@ -240,7 +535,10 @@ namespace dfa {
             : m_StateMachine(sm)
             , m_Accept(acc)
             , m_Stream(str)
-            , m_InitialState(firstState) {
+            , m_InitialState(firstState)
+            , m_Consumed(0)
+            , m_ReadEnd(false)
+            , m_OffsetsOnly(false) {
             }
             
             /// \brief Destructor
@@ -255,15 +553,64 @@ namespace dfa {
             virtual void set_initial_state(int initialState) {
                 m_InitialState = initialState;
             }
+            
+            /// \brief Restarts this stream so that it reads from a new source of symbols
+            ///
+            /// The buffer keeps its storage, so a stream that is reset for each new document will stop allocating
+            /// once the buffer has grown to fit the longest lexeme.
+            virtual bool reset(lexer_symbol_stream* newSource) {
+                if (newSource != m_Stream) {
+                    delete m_Stream;
+                    m_Stream = newSource;
+                }
+                
+                m_Buffer.clear();
+                m_Position      = position_tracker();
+                m_InitialState  = firstState;
+                m_Consumed      = 0;
+                m_ReadEnd       = false;
+                
+                return true;
+            }
+            
+            /// \brief Sets whether or not this stream should work out the line and column of each lexeme
+            virtual bool set_offsets_only(bool offsetsOnly) {
+                m_OffsetsOnly = offsetsOnly;
+                return true;
+            }
+            
+            /// \brief Retrieves a checkpoint that can be used to restart this stream at the next lexeme
+            virtual bool get_checkpoint(lexer_checkpoint& result) const {
+                // The checkpoint needs the line and column to restart from
+                if (m_OffsetsOnly) return false;
+                
+                size_t examined = m_Consumed + m_Buffer.size();
+                if (m_ReadEnd) ++examined;
+                
+                result = lexer_checkpoint(m_Consumed, examined, m_InitialState, m_Position);
+                return true;
+            }
+            
+            /// \brief Restarts this stream from a checkpoint, reading from a new source of symbols
+            virtual bool restart(lexer_symbol_stream* newSource, const lexer_checkpoint& from) {
+                reset(newSource);
+                
+                m_Position      = from.position();
+                m_InitialState  = from.initial_state();
+                m_Consumed      = from.offset();
+                
+                return true;
+            }
 
-            /// \brief Fills in the contents of the specified pointer with the next lexeme (or NULL if the end of input has been reached)
-            virtual lexeme_stream& operator>>(lexeme*& result) {
+        private:
+            /// \brief Runs the state machine over the buffer from the specified index, returning the number of symbols in the next lexeme (0 at the end of input)
+            inline int match(int& acceptSymbol, int start = 0) {
                 // Create the initial lexer state
                 int     state           = m_InitialState;
-                int     pos             = 0;
-                int     acceptSymbol    = -1;
+                int     pos             = start;
                 int     acceptPos       = -1;
-                bool    atEof           = false;
+                
+                acceptSymbol = -1;
                 
                 for (;;) {
                     // Add to the end of the buffer if it is empty
@@ -274,7 +621,7 @@ namespace dfa {
                         
                         // Stop once we reach the end of file marker
                         if (nextSym == symbol_set::end_of_input) {
-                            atEof = true;
+                            m_ReadEnd   = true;
                             break;
                         }
                         
@@ -301,37 +648,150 @@ namespace dfa {
                     }
                 }
                 
-                // If the buffer is empty, then the result is always NULL 
-                if (m_Buffer.empty()) {
-                    result = NULL;
-                    return *this;
+                // If the buffer is empty, then there is no lexeme
+                if (start == (int) m_Buffer.size()) {
+                    return 0;
                 }
                 
-                // If the accept position is -1 or 0, change it to 1 so we reject at least one character
-                if (acceptPos <= 0) acceptPos = 1;
-                
-                // Create the lexeme for this item
-                result = new lexeme(m_Buffer.begin(), m_Buffer.begin() + acceptPos, m_Position.current_position(), acceptSymbol, acceptPos);
+                // If there was no accepting state, reject at least one character
+                if (acceptPos <= start) acceptPos = start + 1;
                 
-                // Choose the new initial state
+                return acceptPos - start;
+            }
+            
+            /// \brief Chooses the initial state for the lexeme after one that ends with the specified character
+            inline void choose_initial_state(int lastChar) {
                 m_InitialState = 0;
                 if (newlineState != m_InitialState) {
                     // Use the newline state if the last character in the lexeme is a newline
-                    int lastChar = m_Buffer[acceptPos-1];
                     if (lastChar == 0x0a || lastChar == 0x0b || lastChar == 0x0c || lastChar == 0x0d || lastChar == 0x85 || lastChar == 0x2028 || lastChar == 0x2029) {
                         m_InitialState = newlineState;
                     }
                 }
+            }
+            
+            /// \brief Removes a lexeme of the specified length from the start of the buffer
+            inline void consume(int length) {
+                // Choose the new initial state
+                choose_initial_state(m_Buffer[length-1]);
                 
-                // Update the position to point after the accepted lexeme
-                m_Position.update_position(m_Buffer.begin(), m_Buffer.begin() + acceptPos);
+                // Update the position to point after the accepted lexeme (m_Consumed is all that's needed if only the offset is reported)
+                if (!m_OffsetsOnly) {
+                    m_Position.update_position(m_Buffer.begin(), m_Buffer.begin() + length);
+                }
                 
                 // Delete the accepted symbols from the buffer
-                m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + acceptPos);
+                m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + length);
+                m_Consumed += length;
+            }
+            
+            /// \brief Removes a batch of lexemes whose initial states have already been chosen from the start of the buffer
+            inline void consume_batch(int length) {
+                if (!m_OffsetsOnly) {
+                    m_Position.update_position(m_Buffer.begin(), m_Buffer.begin() + length);
+                }
+                
+                m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + length);
+                m_Consumed += length;
+            }
+
+        public:
+            /// \brief Fills in the contents of the specified pointer with the next lexeme (or NULL if the end of input has been reached)
+            virtual lexeme_stream& operator>>(lexeme*& result) {
+                int acceptSymbol;
+                int acceptPos = match(acceptSymbol);
+                
+                // The result is NULL at the end of the input
+                if (acceptPos == 0) {
+                    result = NULL;
+                    return *this;
+                }
+                
+                // Create the lexeme for this item
+                result = new lexeme(m_Buffer.begin(), m_Buffer.begin() + acceptPos, current_position(), acceptSymbol, acceptPos);
+                
+                // Move past it
+                consume(acceptPos);
                 
                 // Done
                 return *this;
             }
+            
+            /// \brief Reads the symbol ID and position of the next lexeme without keeping its text
+            virtual bool read_symbol(int& matched, position& pos) {
+                int acceptPos = match(matched);
+                
+                // At the end of input, the position is the end of the file
+                pos = current_position();
+                if (acceptPos == 0) return false;
+                
+                // Move past the lexeme
+                consume(acceptPos);
+                return true;
+            }
+            
+            /// \brief Reads up to count tokens into the specified array, returning the number that were read
+            ///
+            /// The symbols in the batch stay in the buffer until it is complete, so the buffer is only shortened once
+            /// for each batch, and the position is only updated then.
+            virtual size_t read_batch(token* out, size_t count) {
+                size_t  index;
+                int     used = 0;
+                
+                for (index = 0; index < count; ++index) {
+                    int matched;
+                    int length = match(matched, used);
+                    
+                    // Finish the batch with an end of input token
+                    if (length == 0) {
+                        out[index++] = token(symbol_set::end_of_input, (int) m_Consumed + used, 0);
+                        break;
+                    }
+                    
+                    out[index] = token(matched, (int) m_Consumed + used, length);
+                    
+                    choose_initial_state(m_Buffer[used + length - 1]);
+                    used += length;
+                }
+                
+                consume_batch(used);
+                return index;
+            }
+            
+            /// \brief Reads up to count lexemes into the specified array, returning the number that were read
+            virtual size_t read_batch(lexeme** out, size_t count) {
+                position_tracker    tracker = m_Position;
+                size_t              index;
+                int                 used    = 0;
+                
+                for (index = 0; index < count; ++index) {
+                    int matched;
+                    int length = match(matched, used);
+                    
+                    if (length == 0) break;
+                    
+                    // Work out the position of this lexeme
+                    position pos;
+                    if (m_OffsetsOnly) {
+                        pos = position((int) m_Consumed + used, -1, -1);
+                    } else {
+                        pos = tracker.current_position();
+                        tracker.update_position(m_Buffer.begin() + used, m_Buffer.begin() + used + length);
+                    }
+                    
+                    out[index] = new lexeme(m_Buffer.begin() + used, m_Buffer.begin() + used + length, pos, matched, length);
+                    
+                    choose_initial_state(m_Buffer[used + length - 1]);
+                    used += length;
+                }
+                
+                // The position has already been worked out, so only the buffer needs to be updated
+                m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + used);
+                m_Consumed += used;
+                m_Position  = tracker;
+                
+                return index;
+            }
         };
         
     public:
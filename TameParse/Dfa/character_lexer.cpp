@@ -57,6 +57,17 @@ lexeme_stream& character_lexer::lstream::operator>>(lexeme*& result) {
     return *this;
 }
 
+/// \brief Restarts this stream so that it reads from a new source of symbols
+bool character_lexer::lstream::reset(lexer_symbol_stream* newSource) {
+    if (newSource != m_Stream) {
+        delete m_Stream;
+        m_Stream = newSource;
+    }
+    
+    m_Position = position_tracker();
+    return true;
+}
+
 ///
 /// \brief Creates a new lexer to process the specified symbol stream
 ///
@@ -54,6 +54,9 @@ namespace dfa {
             ///
             /// The caller needs to delete the resulting lexeme object
             virtual lexeme_stream& operator>>(lexeme*& result);
+            
+            /// \brief Restarts this stream so that it reads from a new source of symbols
+            virtual bool reset(lexer_symbol_stream* newSource);
         };
         
     public:
@@ -0,0 +1,250 @@
+//
+//  incremental_lexer.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <algorithm>
+
+#include "TameParse/Dfa/incremental_lexer.h"
+
+using namespace std;
+using namespace dfa;
+
+/// \brief Returns true if the lexer had read past the specified offset when the checkpoint was made
+bool incremental_lexer::examined_after(size_t offset, const checkpoint& saved) {
+    return offset < saved.state.examined();
+}
+
+/// \brief Returns a checkpoint that has examined at least the specified number of symbols
+///
+/// A restarted stream only knows about the symbols it has read itself, but the lexemes before the checkpoint it was
+/// restarted from might have read further.
+static lexer_checkpoint examined_at_least(const lexer_checkpoint& checkpoint, size_t examined) {
+    if (checkpoint.examined() >= examined) return checkpoint;
+    return lexer_checkpoint(checkpoint.offset(), examined, checkpoint.initial_state(), checkpoint.position());
+}
+
+/// \brief Creates an incremental lexer that saves its state every checkpointInterval lexemes
+incremental_lexer::incremental_lexer(const basic_lexer& lexer, size_t checkpointInterval)
+: m_Lexer(lexer)
+, m_CheckpointInterval(checkpointInterval > 0 ? checkpointInterval : 1)
+, m_FirstChanged(0)
+, m_LexemesRemoved(0)
+, m_LexemesLexed(0)
+, m_OffsetDiff(0)
+, m_LineDiff(0)
+, m_ColumnDiff(0) {
+    // An empty document has no lexemes and a single checkpoint at the start
+    checkpoint initial = { 0, lexer_checkpoint() };
+    m_Checkpoints.push_back(initial);
+    m_Start.push_back(0);
+}
+
+/// \brief Reads lexemes from a stream that starts at the specified checkpoint
+size_t incremental_lexer::relex(const checkpoint& from, size_t oldEditEnd, size_t newEditEnd, lexeme_list& lexemes, vector<size_t>& start, vector<int>& initialState, checkpoint_list& checkpoints, lexer_checkpoint& finalState) {
+    size_t numOld   = m_Lexemes.size();
+    size_t textPos  = from.state.offset();
+    
+    // Create a stream that reads from the checkpoint (a new stream is already in the right state for the start of the document)
+    text_symbol_stream* source = new text_symbol_stream(m_Text.begin() + textPos, m_Text.end());
+    lexeme_stream*      stream = m_Lexer.create_stream(source);
+    
+    if (from.lexeme > 0) {
+        stream->restart(source, from.state);
+    }
+    
+    lexer_checkpoint    state;
+    bool                haveState       = stream->get_checkpoint(state);
+    if (haveState) state = examined_at_least(state, from.state.examined());
+    size_t              lexemeId        = from.lexeme;
+    size_t              lastCheckpoint  = from.lexeme;
+    size_t              result          = numOld;
+    
+    for (;;) {
+        // Save the lexer state every few lexemes
+        if (haveState && lexemeId - lastCheckpoint >= m_CheckpointInterval) {
+            checkpoint saved = { lexemeId, state };
+            checkpoints.push_back(saved);
+            lastCheckpoint = lexemeId;
+        }
+        
+        // Stop once the lexer is in the same state at the same place as it was before the edit
+        if (haveState && oldEditEnd != text::npos && can_resynchronise(m_Text, textPos, newEditEnd)) {
+            size_t                              oldPos  = textPos - newEditEnd + oldEditEnd;
+            vector<size_t>::const_iterator      found   = lower_bound(m_Start.begin() + from.lexeme, m_Start.end(), oldPos);
+            
+            if (found != m_Start.end() && *found == oldPos) {
+                size_t oldId = (size_t) (found - m_Start.begin());
+                
+                if (oldId == numOld || m_InitialState[oldId] == state.initial_state()) {
+                    result = oldId;
+                    break;
+                }
+            }
+        }
+        
+        // Read the next lexeme
+        lexeme* next = NULL;
+        (*stream) >> next;
+        if (!next) break;
+        
+        lexemes.push_back(lexeme_container(next, true));
+        start.push_back(textPos);
+        initialState.push_back(haveState ? state.initial_state() : -1);
+        
+        textPos += next->content().size();
+        ++lexemeId;
+        
+        haveState = stream->get_checkpoint(state);
+        if (haveState) state = examined_at_least(state, from.state.examined());
+    }
+    
+    finalState = state;
+    delete stream;
+    
+    return result;
+}
+
+/// \brief Lexes a new document
+void incremental_lexer::lex(const text& document) {
+    size_t numOld = m_Lexemes.size();
+    
+    m_Text = document;
+    m_Lexemes.clear();
+    m_Start.clear();
+    m_InitialState.clear();
+    m_Checkpoints.clear();
+    
+    // Lex everything
+    checkpoint initial = { 0, lexer_checkpoint() };
+    m_Checkpoints.push_back(initial);
+    
+    lexeme_list         lexemes;
+    vector<size_t>      start;
+    vector<int>         initialState;
+    lexer_checkpoint    finalState;
+    
+    relex(initial, text::npos, text::npos, lexemes, start, initialState, m_Checkpoints, finalState);
+    
+    m_Lexemes.swap(lexemes);
+    m_Start.swap(start);
+    m_InitialState.swap(initialState);
+    m_Start.push_back(m_Text.size());
+    
+    m_FirstChanged      = 0;
+    m_LexemesRemoved    = numOld;
+    m_LexemesLexed      = m_Lexemes.size();
+    
+    m_EditEnd           = position();
+    m_OffsetDiff        = 0;
+    m_LineDiff          = 0;
+    m_ColumnDiff        = 0;
+}
+
+/// \brief Replaces length characters starting at offset in the document with the specified text, and relexes the part that changed
+void incremental_lexer::edit(size_t offset, size_t length, const text& replacement) {
+    // Update the text
+    if (offset > m_Text.size())             offset = m_Text.size();
+    if (length > m_Text.size() - offset)    length = m_Text.size() - offset;
+    
+    m_Text.replace(offset, length, replacement);
+    
+    size_t oldEditEnd   = offset + length;
+    size_t newEditEnd   = offset + replacement.size();
+    size_t numOld       = m_Lexemes.size();
+    
+    // Find the last checkpoint where the lexer hadn't read any of the edited text (the first checkpoint never has)
+    checkpoint_list::iterator resume = upper_bound(m_Checkpoints.begin() + 1, m_Checkpoints.end(), offset, examined_after);
+    --resume;
+    
+    checkpoint      from = *resume;
+    checkpoint_list checkpoints(m_Checkpoints.begin(), resume + 1);
+    
+    // Relex until the lexer is back in sync with the old lexemes
+    lexeme_list         lexemes;
+    vector<size_t>      start;
+    vector<int>         initialState;
+    lexer_checkpoint    finalState;
+    
+    size_t firstUnchanged   = relex(from, oldEditEnd, newEditEnd, lexemes, start, initialState, checkpoints, finalState);
+    size_t firstNew         = from.lexeme + lexemes.size();
+    
+    // Move the lexemes after the edit
+    position    newPos      = finalState.position().current_position();
+    position    oldPos      = firstUnchanged < numOld ? m_Lexemes[firstUnchanged]->pos() : newPos;
+    int         offsetDiff  = newPos.offset() - oldPos.offset();
+    int         lineDiff    = newPos.line() - oldPos.line();
+    int         columnDiff  = newPos.column() - oldPos.column();
+    
+    if (offsetDiff != 0 || lineDiff != 0 || columnDiff != 0) {
+        for (size_t lexemeId = firstUnchanged; lexemeId < numOld; ++lexemeId) {
+            // The lexemes might be shared with the results of a parser, so this updates them as well
+            lexeme* moving = const_cast<lexeme*>(m_Lexemes[lexemeId].item());
+            moving->set_position(moved_position(moving->pos(), oldPos, offsetDiff, lineDiff, columnDiff));
+        }
+    }
+    
+    // Keep the checkpoints after the edit
+    for (checkpoint_list::const_iterator old = resume + 1; old != m_Checkpoints.end(); ++old) {
+        if (old->lexeme < firstUnchanged) continue;
+        
+        if (old->lexeme == firstUnchanged) {
+            // The relexed state is the same apart from how far the lexer has read
+            if (checkpoints.back().lexeme != firstNew) {
+                checkpoint replaced = { firstNew, finalState };
+                checkpoints.push_back(replaced);
+            }
+            continue;
+        }
+        
+        // The relexed lexemes might have read further than the lexemes that were there before
+        const lexer_checkpoint& oldState    = old->state;
+        size_t                  examined    = max(oldState.examined() + replacement.size() - length, finalState.examined());
+        position_tracker        movedPos(moved_position(oldState.position().current_position(), oldPos, offsetDiff, lineDiff, columnDiff), oldState.position().seen_return());
+        checkpoint              moved       = { old->lexeme - firstUnchanged + firstNew, lexer_checkpoint(oldState.offset() + replacement.size() - length, examined, oldState.initial_state(), movedPos) };
+        
+        checkpoints.push_back(moved);
+    }
+    
+    // Replace the lexemes that changed
+    for (size_t lexemeId = firstUnchanged; lexemeId < m_Start.size(); ++lexemeId) {
+        m_Start[lexemeId] = m_Start[lexemeId] + replacement.size() - length;
+    }
+    
+    m_Lexemes.erase(m_Lexemes.begin() + from.lexeme, m_Lexemes.begin() + firstUnchanged);
+    m_Lexemes.insert(m_Lexemes.begin() + from.lexeme, lexemes.begin(), lexemes.end());
+    m_Start.erase(m_Start.begin() + from.lexeme, m_Start.begin() + firstUnchanged);
+    m_Start.insert(m_Start.begin() + from.lexeme, start.begin(), start.end());
+    m_InitialState.erase(m_InitialState.begin() + from.lexeme, m_InitialState.begin() + firstUnchanged);
+    m_InitialState.insert(m_InitialState.begin() + from.lexeme, initialState.begin(), initialState.end());
+    m_Checkpoints.swap(checkpoints);
+    
+    m_FirstChanged      = from.lexeme;
+    m_LexemesRemoved    = firstUnchanged - from.lexeme;
+    m_LexemesLexed      = lexemes.size();
+    
+    m_EditEnd           = oldPos;
+    m_OffsetDiff        = offsetDiff;
+    m_LineDiff          = lineDiff;
+    m_ColumnDiff        = columnDiff;
+}
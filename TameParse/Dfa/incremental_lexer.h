@@ -0,0 +1,181 @@
+//
+//  incremental_lexer.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _DFA_INCREMENTAL_LEXER_H
+#define _DFA_INCREMENTAL_LEXER_H
+
+#include <string>
+#include <vector>
+
+#include "TameParse/Dfa/basic_lexer.h"
+#include "TameParse/Dfa/text_symbol_stream.h"
+
+namespace dfa {
+    ///
+    /// \brief Keeps the lexemes for a document up to date as it is edited
+    ///
+    /// The lexer state is saved every few lexemes while the document is lexed. When the document is edited, lexing
+    /// restarts from the last checkpoint that didn't examine the edited text, and stops as soon as a new lexeme
+    /// starts at the same place and in the same lexer state as one of the old lexemes after the edit. The lexemes
+    /// after this point are kept, and their positions are updated in place.
+    ///
+    /// Lexers whose streams don't support checkpoints can still be used, but every edit relexes everything from the
+    /// start of the document.
+    ///
+    class incremental_lexer {
+    public:
+        /// \brief The type of the document being lexed
+        typedef std::wstring text;
+        
+        /// \brief List of lexemes
+        typedef std::vector<lexeme_container> lexeme_list;
+        
+    private:
+        /// \brief A lexer checkpoint along with the index of the lexeme that follows it
+        struct checkpoint {
+            /// \brief The index of the lexeme that will be read next if the lexer is restarted from this checkpoint
+            size_t lexeme;
+            
+            /// \brief The lexer state
+            lexer_checkpoint state;
+        };
+        
+        /// \brief List of checkpoints
+        typedef std::vector<checkpoint> checkpoint_list;
+        
+        /// \brief The lexer
+        const basic_lexer& m_Lexer;
+        
+        /// \brief The number of lexemes between each checkpoint
+        size_t m_CheckpointInterval;
+        
+        /// \brief The document
+        text m_Text;
+        
+        /// \brief The lexemes in the document
+        lexeme_list m_Lexemes;
+        
+        /// \brief The offset of each lexeme in the document, followed by the length of the document
+        std::vector<size_t> m_Start;
+        
+        /// \brief The lexer state each lexeme was read in (or -1 if the stream does not support checkpoints)
+        std::vector<int> m_InitialState;
+        
+        /// \brief Saved lexer states, in document order
+        checkpoint_list m_Checkpoints;
+        
+        /// \brief The index of the first lexeme that was replaced by the last change
+        size_t m_FirstChanged;
+        
+        /// \brief The number of old lexemes replaced by the last change
+        size_t m_LexemesRemoved;
+        
+        /// \brief The number of lexemes that were read by the last change
+        size_t m_LexemesLexed;
+        
+        /// \brief The old position of the first lexeme after the last change
+        position m_EditEnd;
+        
+        /// \brief How far the lexemes after the last change moved
+        int m_OffsetDiff;
+        
+        /// \brief How many lines the lexemes after the last change moved
+        int m_LineDiff;
+        
+        /// \brief How many columns the lexemes on the same line as the end of the last change moved
+        int m_ColumnDiff;
+        
+    private:
+        incremental_lexer(const incremental_lexer& noCopying);
+        incremental_lexer& operator=(const incremental_lexer& noCopying);
+        
+    public:
+        ///
+        /// \brief Creates an incremental lexer that saves its state every checkpointInterval lexemes
+        ///
+        /// The lexer must not be destroyed before this object.
+        ///
+        incremental_lexer(const basic_lexer& lexer, size_t checkpointInterval = 64);
+        
+        /// \brief Lexes a new document
+        void lex(const text& document);
+        
+        ///
+        /// \brief Replaces length characters starting at offset in the document with the specified text, and relexes the part that changed
+        ///
+        /// Afterwards, lexemes_removed() lexemes starting at first_changed() have been replaced with lexemes_lexed() new ones.
+        ///
+        void edit(size_t offset, size_t length, const text& replacement);
+        
+    public:
+        /// \brief The lexer used to read the document
+        inline const basic_lexer& lexer() const { return m_Lexer; }
+        
+        /// \brief The current document
+        inline const text& document() const { return m_Text; }
+        
+        /// \brief The lexemes for the current document
+        inline const lexeme_list& lexemes() const { return m_Lexemes; }
+        
+        /// \brief The offset into the document of the specified lexeme
+        inline size_t lexeme_offset(size_t lexemeId) const { return m_Start[lexemeId]; }
+        
+        /// \brief The index of the first lexeme that was replaced by the last change
+        inline size_t first_changed() const { return m_FirstChanged; }
+        
+        /// \brief The number of old lexemes that were replaced by the last change
+        inline size_t lexemes_removed() const { return m_LexemesRemoved; }
+        
+        /// \brief The number of lexemes that were read by the last change
+        inline size_t lexemes_lexed() const { return m_LexemesLexed; }
+        
+        /// \brief The number of checkpoints currently saved
+        inline size_t checkpoint_count() const { return m_Checkpoints.size(); }
+        
+        ///
+        /// \brief Works out where a position that was after the last change has moved to
+        ///
+        /// The lexemes after the change are moved in place, so this is only needed for copies of them that are kept
+        /// elsewhere.
+        ///
+        inline position moved(const position& pos) const { return moved_position(pos, m_EditEnd, m_OffsetDiff, m_LineDiff, m_ColumnDiff); }
+        
+    private:
+        /// \brief Returns true if the lexer had read past the specified offset when the checkpoint was made
+        static bool examined_after(size_t offset, const checkpoint& saved);
+        
+        ///
+        /// \brief Reads lexemes from a stream that starts at the specified checkpoint
+        ///
+        /// If oldEditEnd is not text::npos, lexing stops once the lexer is in the same state as it was for one of the
+        /// lexemes that started at or after that offset before the edit (newEditEnd is where the edit finishes in the
+        /// new text). Returns the index of that old lexeme, or the number of old lexemes if lexing reached the end of
+        /// the document.
+        ///
+        size_t relex(const checkpoint& from, size_t oldEditEnd, size_t newEditEnd, lexeme_list& lexemes, std::vector<size_t>& start, std::vector<int>& initialState, checkpoint_list& checkpoints, lexer_checkpoint& finalState);
+    };
+}
+
+#endif
@@ -107,6 +107,9 @@ namespace dfa {
         /// \brief The initial location of this lexeme
         inline const position& pos() const { return m_Position; }
         
+        /// \brief Moves this lexeme to a new location (used when text before the lexeme has been edited)
+        inline void set_position(const position& newPos) { m_Position = newPos; }
+        
         /// \brief The final position of this lexeme
         ///
         /// Note that the line count will be off by 1 if the symbol preceeding this lexeme is a carriage return
@@ -34,7 +34,13 @@
 #include "TameParse/Dfa/basic_lexer.h"
 
 namespace dfa {
+    ///
     /// \brief Class used to build and run lexers
+    ///
+    /// Once compiled, a lexer is not modified by create_stream(), so one lexer can be used to create streams
+    /// on many threads at once. A lexer that has not been compiled is compiled by the first call to create_stream(),
+    /// so call compile() before sharing a lexer built from regular expressions between threads.
+    ///
     class lexer : public basic_lexer {
     private:
         /// \brief NULL if the NDFA is compiled, or the NDFA associated with this lexer
@@ -0,0 +1,135 @@
+//
+//  line_index.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include "TameParse/Dfa/line_index.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TAMEPARSE_LINE_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace dfa;
+
+/// \brief Creates an empty index
+line_index::line_index() {
+    clear();
+}
+
+/// \brief Removes everything from this index
+void line_index::clear() {
+    line_start firstLine;
+    firstLine.start         = 0;
+    firstLine.offset        = 0;
+    firstLine.column_start  = 0;
+    firstLine.after_return  = false;
+    
+    m_Lines.clear();
+    m_Lines.push_back(firstLine);
+    m_Size = 0;
+}
+
+#ifdef TAMEPARSE_LINE_INDEX_SSE2
+
+/// \brief Returns the index of the lowest bit that is set in a non-zero mask
+static inline int lowest_bit(unsigned int mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int) index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/// \brief Returns a mask with a bit set for each of the 16 characters at the specified address that might be a line break
+///
+/// LF, VT, FF and CR are the characters from 0x0a to 0x0d. NEL (0x85) is only a line break if the characters are unsigned.
+static inline unsigned int line_break_mask(const void* chars, bool unsignedChars) {
+    __m128i block       = _mm_loadu_si128((const __m128i*) chars);
+    
+    // (c - 0x0a) <= 3 as an unsigned comparison
+    __m128i fromLf      = _mm_sub_epi8(block, _mm_set1_epi8(0x0a));
+    __m128i isBreak     = _mm_cmpeq_epi8(_mm_min_epu8(fromLf, _mm_set1_epi8(3)), fromLf);
+    
+    if (unsignedChars) {
+        isBreak = _mm_or_si128(isBreak, _mm_cmpeq_epi8(block, _mm_set1_epi8((char) 0x85)));
+    }
+    
+    return (unsigned int) _mm_movemask_epi8(isBreak);
+}
+
+#endif
+
+/// \brief Adds a string of 8-bit characters to the end of the index
+void line_index::append(const char* begin, const char* end) {
+    const char* chr = begin;
+    
+#ifdef TAMEPARSE_LINE_INDEX_SSE2
+    // Most blocks don't contain any line breaks, so these can be skipped without looking at each character
+    for (; end - chr >= 16; chr += 16) {
+        unsigned int mask = line_break_mask(chr, ((char) 0x85) > 0);
+        
+        while (mask) {
+            int bit = lowest_bit(mask);
+            add_line_break(m_Size + bit, (int)(unsigned) chr[bit]);
+            mask &= mask - 1;
+        }
+        
+        m_Size += 16;
+    }
+#endif
+    
+    // Where char is signed, characters above 0x7f aren't line breaks (as for position_tracker)
+    for (; chr != end; ++chr) {
+        append((int)(unsigned) *chr);
+    }
+}
+
+/// \brief Adds a string of 8-bit characters to the end of the index
+void line_index::append(const unsigned char* begin, const unsigned char* end) {
+    const unsigned char* chr = begin;
+    
+#ifdef TAMEPARSE_LINE_INDEX_SSE2
+    for (; end - chr >= 16; chr += 16) {
+        unsigned int mask = line_break_mask(chr, true);
+        
+        while (mask) {
+            int bit = lowest_bit(mask);
+            add_line_break(m_Size + bit, chr[bit]);
+            mask &= mask - 1;
+        }
+        
+        m_Size += 16;
+    }
+#endif
+    
+    for (; chr != end; ++chr) {
+        append((int) *chr);
+    }
+}
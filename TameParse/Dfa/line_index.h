@@ -0,0 +1,190 @@
+//
+//  line_index.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _DFA_LINE_INDEX_H
+#define _DFA_LINE_INDEX_H
+
+#include <vector>
+#include <algorithm>
+
+#include "TameParse/Dfa/position.h"
+
+namespace dfa {
+    ///
+    /// \brief Index of the line breaks in an input, used to find the line and column of a symbol offset
+    ///
+    /// Lexeme streams that are set to report offsets only (see lexeme_stream::set_offsets_only()) don't keep track of
+    /// lines and columns as they read their input. This class finds them later, by making a list of where each line
+    /// begins. The positions it produces are the same as the ones produced by position_tracker, including for CR/LF
+    /// pairs and the Unicode line and paragraph separators.
+    ///
+    /// Offsets passed to this class count every symbol in the input. Note that position_tracker doesn't count
+    /// carriage returns or the other line breaks apart from LF in the offsets it reports, so the offset of the
+    /// position that is returned may be lower than the one that was passed in.
+    ///
+    /// Input made of 8-bit characters is scanned 16 characters at a time on processors with SSE2.
+    ///
+    class line_index {
+    private:
+        /// \brief Where a line begins
+        struct line_start {
+            /// \brief The offset in symbols of the first symbol after the line break
+            size_t start;
+            
+            /// \brief The offset that position_tracker reports for the start of the line
+            size_t offset;
+            
+            /// \brief The offset of the symbol in column 0 (one after start if the line break is a CR/LF pair)
+            size_t column_start;
+            
+            /// \brief True if the line break was a carriage return
+            bool after_return;
+        };
+        
+        /// \brief The start of each line, in order
+        std::vector<line_start> m_Lines;
+        
+        /// \brief The number of symbols that have been added to this index
+        size_t m_Size;
+        
+    public:
+        /// \brief Creates an empty index
+        line_index();
+        
+        /// \brief Creates an index of the symbols in the specified range
+        template<typename iterator> line_index(iterator begin, iterator end) {
+            clear();
+            append(begin, end);
+        }
+        
+        /// \brief Removes everything from this index
+        void clear();
+        
+        /// \brief Adds the symbols in the specified range to the end of the index
+        template<typename iterator> inline void append(iterator begin, iterator end) {
+            for (iterator symbol = begin; symbol != end; ++symbol) {
+                append((int)(unsigned)*symbol);
+            }
+        }
+        
+        /// \brief Adds a string of 8-bit characters to the end of the index
+        void append(const char* begin, const char* end);
+        
+        /// \brief Adds a string of 8-bit characters to the end of the index
+        void append(const unsigned char* begin, const unsigned char* end);
+        
+        /// \brief Adds a single symbol to the end of the index
+        inline void append(int symbol) {
+            switch (symbol) {
+                case 0x0a:
+                case 0x0b:
+                case 0x0c:
+                case 0x0d:
+                case 0x85:
+                case 0x2028:
+                case 0x2029:
+                    add_line_break(m_Size, symbol);
+                    break;
+            }
+            
+            ++m_Size;
+        }
+        
+    private:
+        /// \brief Records the line break symbol found at the specified offset
+        inline void add_line_break(size_t pos, int symbol) {
+            const line_start& last = m_Lines.back();
+            
+            // The offset that position_tracker would report for this symbol
+            size_t offset = last.offset + (pos - last.start);
+            
+            // A LF straight after a CR is part of the same line break: it moves the start of column 0 along
+            if (symbol == 0x0a && last.after_return && last.start == pos) {
+                m_Lines.back().column_start = pos + 1;
+                return;
+            }
+            
+            // Only a LF moves the offset on: the other line breaks don't count as symbols
+            line_start newLine;
+            newLine.start           = pos + 1;
+            newLine.offset          = symbol == 0x0a ? offset + 1 : offset;
+            newLine.column_start    = pos + 1;
+            newLine.after_return    = symbol == 0x0d;
+            
+            m_Lines.push_back(newLine);
+        }
+        
+        /// \brief Finds the line containing the specified offset
+        inline const line_start& line_for(size_t offset, int& line) const {
+            // Find the first line that starts after the offset: the line before it contains the offset
+            std::vector<line_start>::const_iterator found = std::upper_bound(m_Lines.begin(), m_Lines.end(), offset, compare_start);
+            
+            --found;
+            line = (int) (found - m_Lines.begin());
+            return *found;
+        }
+        
+        /// \brief Orders offsets and line starts
+        static inline bool compare_start(size_t offset, const line_start& line) {
+            return offset < line.start;
+        }
+        
+    public:
+        /// \brief The number of symbols in this index
+        inline size_t size() const { return m_Size; }
+        
+        /// \brief The number of lines in this index (one more than the number of line breaks)
+        inline int count_lines() const { return (int) m_Lines.size(); }
+        
+        /// \brief Returns the position that position_tracker would report after reading the specified number of symbols
+        inline position position_at(size_t offset) const {
+            int                 line;
+            const line_start&   start = line_for(offset, line);
+            
+            int column = offset > start.column_start ? (int) (offset - start.column_start) : 0;
+            return position((int) (start.offset + (offset - start.start)), line, column);
+        }
+        
+        /// \brief Returns a position_tracker in the state it would be in after reading the specified number of symbols
+        ///
+        /// This can be used to continue tracking the position from the middle of the input.
+        inline position_tracker tracker_at(size_t offset) const {
+            int                 line;
+            const line_start&   start = line_for(offset, line);
+            
+            return position_tracker(position_at(offset), start.after_return && start.start == offset);
+        }
+        
+        /// \brief Fills in the line and column of a position that was produced by a stream reporting offsets only
+        ///
+        /// Positions that already have a line number are returned unchanged.
+        inline position resolve(const position& pos) const {
+            if (pos.line() >= 0) return pos;
+            return position_at((size_t) pos.offset());
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,272 @@
+//
+//  pipelined_stream.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _DFA_PIPELINED_STREAM_H
+#define _DFA_PIPELINED_STREAM_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+#include "TameParse/Dfa/basic_lexer.h"
+
+namespace dfa {
+    ///
+    /// \brief Lexeme stream that runs another lexeme stream on its own thread
+    ///
+    /// For large documents, this lets the lexer and the parser run at the same time. A producer thread reads
+    /// lexemes from the source stream into a bounded queue, and the parser takes them from the other end. There is
+    /// only ever one thread at each end of the queue, so it doesn't need any locks.
+    ///
+    /// The producer lexes ahead of the parser, so this can only be used if the parser never changes the state of
+    /// the lexer. A language whose actions change the lexer state should say so when the stream is constructed:
+    /// the source is then read synchronously, one lexeme at a time, so every change takes effect immediately.
+    ///
+    /// Otherwise, calls to set_initial_state() are passed on to the source stream until the first lexeme is read.
+    /// After that they are refused: the producer is stopped and the stream reports the end of input, so the parse
+    /// fails rather than using lexemes that were read in the wrong state. refused() returns true when this has
+    /// happened.
+    ///
+    /// If the source stream throws an exception on the producer thread, the lexemes read before it are passed on
+    /// as normal, and then the exception is thrown again by operator>> on the consumer's thread.
+    ///
+    class pipelined_stream : public lexeme_stream {
+    private:
+        /// \brief The stream that the producer reads from (destroyed with this object)
+        lexeme_stream* m_Source;
+        
+        /// \brief Ring buffer of lexemes waiting to be read (a NULL lexeme marks the end of the input)
+        std::vector<lexeme*> m_Queue;
+        
+        /// \brief Mask used to turn a count into an index into m_Queue (the size of the queue is a power of 2)
+        size_t m_Mask;
+        
+        /// \brief The number of lexemes that have been taken from the queue (only written by the consumer)
+        std::atomic<size_t> m_Head;
+        
+        /// \brief Keeps the head and the tail in separate cache lines, so the two threads don't contend for them
+        char m_Padding[64];
+        
+        /// \brief The number of lexemes that have been added to the queue (only written by the producer)
+        std::atomic<size_t> m_Tail;
+        
+        /// \brief Set to true to ask the producer to stop early
+        std::atomic<bool> m_Stop;
+        
+        /// \brief The producer thread
+        std::thread m_Producer;
+        
+        /// \brief True once the producer has been started
+        bool m_Started;
+        
+        /// \brief True once the consumer has read the end of the input
+        bool m_EndOfInput;
+        
+        /// \brief True if a change to the lexer state has been refused
+        bool m_Refused;
+        
+        /// \brief True if the source is read on the consumer's thread, because the parser can change the lexer state
+        bool m_Synchronous;
+        
+        /// \brief The exception thrown by the source stream on the producer thread (set before the end of the queue)
+        std::exception_ptr m_Error;
+        
+        pipelined_stream(const pipelined_stream& noCopying);
+        pipelined_stream& operator=(const pipelined_stream& noCopying);
+        
+    public:
+        ///
+        /// \brief Creates a stream that reads from the specified source on a separate thread
+        ///
+        /// This takes ownership of the source stream. The capacity is the number of lexemes that the producer can
+        /// read ahead of the parser, and is rounded up to a power of 2. Set changesLexerState to true if any of the
+        /// language's actions call set_initial_state(): no producer thread is started in this case.
+        ///
+        explicit pipelined_stream(lexeme_stream* source, size_t capacity = 4096, bool changesLexerState = false)
+        : m_Source(source)
+        , m_Head(0)
+        , m_Tail(0)
+        , m_Stop(false)
+        , m_Started(false)
+        , m_EndOfInput(false)
+        , m_Refused(false)
+        , m_Synchronous(changesLexerState) {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+            
+            m_Queue.resize(size, NULL);
+            m_Mask = size - 1;
+        }
+        
+        /// \brief Stops the producer and destroys the source stream
+        virtual ~pipelined_stream() {
+            stop();
+            delete m_Source;
+        }
+        
+        /// \brief True if a change to the lexer state was refused because the producer had already started
+        inline bool refused() const { return m_Refused; }
+        
+        /// \brief True if the source stream is read on the consumer's thread rather than by a producer
+        inline bool synchronous() const { return m_Synchronous; }
+        
+        /// \brief Fills in the contents of the specified pointer with the next lexeme (or NULL if the end of input has been reached)
+        ///
+        /// Any exception thrown by the source stream is thrown again from here, once the lexemes read before it
+        /// have been returned.
+        virtual lexeme_stream& operator>>(lexeme*& result) {
+            result = NULL;
+            if (m_EndOfInput) return *this;
+            
+            // Read directly from the source if the parser can change its state
+            if (m_Synchronous) {
+                (*m_Source) >> result;
+                return *this;
+            }
+            
+            // The producer starts when the first lexeme is needed
+            if (!m_Started) {
+                m_Started   = true;
+                m_Producer  = std::thread(&pipelined_stream::produce, this);
+            }
+            
+            // Wait for the producer to supply a lexeme
+            size_t head = m_Head.load(std::memory_order_relaxed);
+            while (m_Tail.load(std::memory_order_acquire) == head) {
+                std::this_thread::yield();
+            }
+            
+            // Take it from the queue
+            result = m_Queue[head & m_Mask];
+            m_Head.store(head + 1, std::memory_order_release);
+            
+            if (!result) {
+                m_EndOfInput = true;
+                
+                // Pass on the reason the producer stopped, if it failed
+                if (m_Error) {
+                    std::exception_ptr error = m_Error;
+                    m_Error = std::exception_ptr();
+                    std::rethrow_exception(error);
+                }
+            }
+            
+            return *this;
+        }
+        
+        /// \brief Reads up to count lexemes into the specified array, returning the number that were read
+        ///
+        /// When the source is read synchronously, this only reads a single lexeme, so a change to the lexer state
+        /// made in response to it applies to the next one.
+        virtual size_t read_batch(lexeme** out, size_t count) {
+            if (!m_Synchronous) return lexeme_stream::read_batch(out, count);
+            if (count == 0) return 0;
+            
+            lexeme* next = NULL;
+            (*this) >> next;
+            if (!next) return 0;
+            
+            out[0] = next;
+            return 1;
+        }
+        
+        /// \brief Sets the initial state to be used by the next run through of the state machine
+        ///
+        /// This is refused once the producer has started, as it will already have read lexemes using the old state.
+        virtual void set_initial_state(int initialState) {
+            if (!m_Started || m_Synchronous) {
+                m_Source->set_initial_state(initialState);
+                return;
+            }
+            
+            // The lexemes in the queue can't be used, so finish here
+            m_Refused       = true;
+            m_EndOfInput    = true;
+            stop();
+        }
+        
+        /// \brief Sets whether or not the source stream should work out the line and column of each lexeme
+        ///
+        /// This can only be changed before the producer has started.
+        virtual bool set_offsets_only(bool offsetsOnly) {
+            if (m_Started) return false;
+            return m_Source->set_offsets_only(offsetsOnly);
+        }
+        
+    private:
+        /// \brief Runs the producer thread
+        void produce() {
+            size_t tail = m_Tail.load(std::memory_order_relaxed);
+            
+            for (;;) {
+                // Read the next lexeme. If the source fails, the exception is kept for the consumer and the
+                // input ends here
+                lexeme* next = NULL;
+                try {
+                    (*m_Source) >> next;
+                } catch (...) {
+                    m_Error = std::current_exception();
+                    next    = NULL;
+                }
+                
+                // Wait until there's space for it
+                while (tail - m_Head.load(std::memory_order_acquire) >= m_Queue.size()) {
+                    if (m_Stop.load(std::memory_order_relaxed)) {
+                        delete next;
+                        return;
+                    }
+                    
+                    std::this_thread::yield();
+                }
+                
+                // Pass it to the consumer
+                m_Queue[tail & m_Mask] = next;
+                ++tail;
+                m_Tail.store(tail, std::memory_order_release);
+                
+                // Finished at the end of the input, or if the consumer has no more use for the lexemes
+                if (!next || m_Stop.load(std::memory_order_relaxed)) return;
+            }
+        }
+        
+        /// \brief Stops the producer, and deletes any lexemes that are still in the queue
+        void stop() {
+            if (m_Producer.joinable()) {
+                m_Stop.store(true);
+                m_Producer.join();
+            }
+            
+            size_t tail = m_Tail.load();
+            for (size_t pos = m_Head.load(); pos != tail; ++pos) {
+                delete m_Queue[pos & m_Mask];
+            }
+            
+            m_Head.store(tail);
+        }
+    };
+}
+
+#endif
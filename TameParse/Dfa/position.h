@@ -148,6 +148,12 @@ namespace dfa {
         , m_SeenReturn(false) {
         }
         
+        /// \brief Creates a new position tracker at the specified position, which may be immediately after a carriage return character
+        inline position_tracker(const position& copyFrom, bool seenReturn)
+        : m_CurrentPosition(copyFrom)
+        , m_SeenReturn(seenReturn) {
+        }
+        
         /// \brief Copies this position tracker
         inline position_tracker(const position_tracker& copyFrom) 
         : m_CurrentPosition(copyFrom.m_CurrentPosition)
@@ -157,6 +163,9 @@ namespace dfa {
         /// \brief Returns a copy of the current position
         inline position current_position() const { return m_CurrentPosition; }
         
+        /// \brief True if the last symbol was a carriage return (so a following line feed does not start a new line)
+        inline bool seen_return() const { return m_SeenReturn; }
+        
         /// \brief Moves the position on by a single symbol
         inline void update_position(int symbol) {
             switch (symbol) {
@@ -0,0 +1,128 @@
+//
+//  push_lexer.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include "TameParse/Dfa/push_lexer.h"
+#include "TameParse/Dfa/symbol_set.h"
+
+using namespace dfa;
+
+/// \brief Symbol stream that reads the symbols that have been fed to a push lexer
+class push_lexer::pending_symbol_stream : public lexer_symbol_stream {
+private:
+    /// \brief The lexer that owns this stream
+    push_lexer& m_Lexer;
+    
+public:
+    explicit pending_symbol_stream(push_lexer& lexer)
+    : m_Lexer(lexer) {
+    }
+    
+    /// \brief Reads the next symbol from this stream
+    ///
+    /// The end of the input received so far is reported as the end of input: the push lexer discards any lexeme
+    /// that was matched after reading it until finish() has been called.
+    virtual lexer_symbol_stream& operator>>(int& result) {
+        if (m_Lexer.m_ReadPos >= m_Lexer.m_Pending.size()) {
+            result = symbol_set::end_of_input;
+        } else {
+            result = m_Lexer.m_Pending[m_Lexer.m_ReadPos];
+            ++m_Lexer.m_ReadPos;
+        }
+        return *this;
+    }
+};
+
+/// \brief Creates a push lexer that uses the specified lexer to match lexemes
+push_lexer::push_lexer(const basic_lexer& lexer)
+: m_ReadPos(0)
+, m_NeedRestart(false)
+, m_Received(false)
+, m_Finished(false) {
+    m_Stream        = lexer.create_stream(new pending_symbol_stream(*this));
+    m_CanRestart    = m_Stream->get_checkpoint(m_Checkpoint);
+}
+
+/// \brief Destructor
+push_lexer::~push_lexer() {
+    delete m_Stream;
+}
+
+/// \brief Indicates that the end of the input has been reached
+void push_lexer::finish() {
+    m_Finished = true;
+    m_Received = true;
+}
+
+/// \brief Returns the next lexeme, or NULL if there isn't enough input to finish one yet
+lexeme* push_lexer::next() {
+    // Lexers that can't be restarted must see all of the input at once
+    if (!m_CanRestart && !m_Finished) {
+        return NULL;
+    }
+    
+    // If the stream ran out of input, then restart it from the start of the pending symbols once there is more
+    if (m_NeedRestart) {
+        if (!m_Received) return NULL;
+        
+        m_ReadPos = 0;
+        m_Stream->restart(new pending_symbol_stream(*this), m_Checkpoint);
+        m_NeedRestart = false;
+    }
+    
+    // Read the next lexeme
+    lexeme* result = NULL;
+    (*m_Stream) >> result;
+    
+    if (!result) {
+        // Out of input
+        if (!m_Finished) {
+            m_NeedRestart   = true;
+            m_Received      = false;
+        }
+        return NULL;
+    }
+    
+    if (m_CanRestart) {
+        lexer_checkpoint after;
+        m_Stream->get_checkpoint(after);
+        
+        // If the lexer read up to the end of the pending symbols, then this lexeme might be longer once more input arrives
+        if (!m_Finished && after.examined() > m_Checkpoint.offset() + m_Pending.size()) {
+            delete result;
+            m_NeedRestart   = true;
+            m_Received      = false;
+            return NULL;
+        }
+        
+        m_Checkpoint = after;
+    }
+    
+    // Discard the symbols that make up this lexeme
+    size_t length = result->content().size();
+    m_Pending.erase(m_Pending.begin(), m_Pending.begin() + length);
+    m_ReadPos -= length;
+    
+    return result;
+}
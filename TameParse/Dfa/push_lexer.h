@@ -0,0 +1,114 @@
+//
+//  push_lexer.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _DFA_PUSH_LEXER_H
+#define _DFA_PUSH_LEXER_H
+
+#include <deque>
+
+#include "TameParse/Dfa/basic_lexer.h"
+
+namespace dfa {
+    ///
+    /// \brief Lexer that is given its input a piece at a time
+    ///
+    /// Input is added with feed() as it arrives, and lexemes are read with next(), which returns NULL when the
+    /// lexer needs more input. A lexeme that might continue past the end of the input received so far is not
+    /// returned: the lexer restarts from the checkpoint before it once more input arrives. Only the symbols from
+    /// the start of the next lexeme onwards are kept, so the memory used does not grow with the document.
+    ///
+    /// The lexer must create streams that support checkpoints (as DFA lexers do). With other lexers, no lexemes
+    /// are returned until finish() has been called.
+    ///
+    class push_lexer {
+    private:
+        /// \brief Symbol stream that reads the input that has been received so far
+        class pending_symbol_stream;
+        friend class pending_symbol_stream;
+        
+        /// \brief Symbols that have been received but not returned as part of a lexeme
+        std::deque<int> m_Pending;
+        
+        /// \brief The index in m_Pending of the next symbol that the lexer will read
+        size_t m_ReadPos;
+        
+        /// \brief The stream that reads lexemes from the pending symbols
+        lexeme_stream* m_Stream;
+        
+        /// \brief The state of the lexer at the start of the pending symbols
+        lexer_checkpoint m_Checkpoint;
+        
+        /// \brief True if the stream supports checkpoints
+        bool m_CanRestart;
+        
+        /// \brief True if the stream has read past the end of the pending symbols, and must be restarted
+        bool m_NeedRestart;
+        
+        /// \brief True if more input has been received since the stream last ran out
+        bool m_Received;
+        
+        /// \brief True once finish() has been called
+        bool m_Finished;
+        
+    private:
+        push_lexer(const push_lexer& noCopying);
+        push_lexer& operator=(const push_lexer& noCopying);
+        
+    public:
+        /// \brief Creates a push lexer that uses the specified lexer to match lexemes
+        explicit push_lexer(const basic_lexer& lexer);
+        
+        /// \brief Destructor
+        ~push_lexer();
+        
+        /// \brief Adds symbols to the end of the input
+        template<typename iterator> inline void feed(iterator begin, iterator end) {
+            for (iterator symbol = begin; symbol != end; ++symbol) {
+                m_Pending.push_back((int)(unsigned)*symbol);
+            }
+            
+            m_Received = true;
+        }
+        
+        /// \brief Indicates that the end of the input has been reached
+        void finish();
+        
+        ///
+        /// \brief Returns the next lexeme, or NULL if there isn't enough input to finish one yet
+        ///
+        /// The caller needs to delete the resulting lexeme object. Once finish() has been called, this returns NULL
+        /// at the end of the input.
+        ///
+        lexeme* next();
+        
+        /// \brief True once finish() has been called
+        inline bool finished() const { return m_Finished; }
+        
+        /// \brief The number of symbols that have been received but not returned as part of a lexeme
+        inline size_t pending() const { return m_Pending.size(); }
+    };
+}
+
+#endif
@@ -0,0 +1,164 @@
+//
+//  symbol_reader.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _DFA_SYMBOL_READER_H
+#define _DFA_SYMBOL_READER_H
+
+#include <vector>
+
+#include "TameParse/Dfa/symbol_set.h"
+#include "TameParse/Dfa/position.h"
+
+namespace dfa {
+    ///
+    /// \brief Runs a lexer's state machine directly over a source of characters, producing symbol IDs
+    ///
+    /// This does the same job as the lexeme streams created by dfa_lexer_base, but nothing is virtual and no lexemes
+    /// are created. The state machine and the source are template parameters, so code that knows their concrete types
+    /// (such as a generated parser) can have the whole of the lexer inlined into its own loop. The source needs the
+    /// get() and good() methods of a std::basic_istream for the specified character type.
+    ///
+    /// As there are no lexemes, this can only be used by parsers that don't need them: generated parsers use it for
+    /// validation, but their parse functions still read lexemes from a lexeme stream.
+    ///
+    template<typename state_machine_ref, typename source_type, typename char_type, int firstState = 0, int newlineState = 0> class symbol_reader {
+    private:
+        /// \brief The state machine for the lexer
+        state_machine_ref m_StateMachine;
+        
+        /// \brief Array of symbols that are accepted in each state
+        const int* m_Accept;
+        
+        /// \brief The source of characters
+        source_type& m_Source;
+        
+        /// \brief The position of the next lexeme
+        position_tracker m_Position;
+        
+        /// \brief Characters read from the source that are not yet part of a lexeme start at m_BufferPos in this buffer
+        std::vector<int> m_Buffer;
+        
+        /// \brief The index of the first character in the buffer that is not part of a lexeme
+        size_t m_BufferPos;
+        
+        /// \brief The state to start the state machine in for the next lexeme
+        int m_InitialState;
+        
+        /// \brief True once the source has run out of characters
+        bool m_ReadEnd;
+        
+        symbol_reader(const symbol_reader& noCopying);
+        symbol_reader& operator=(const symbol_reader& noCopying);
+        
+    public:
+        /// \brief Creates a reader that runs the specified state machine over a source
+        symbol_reader(state_machine_ref stateMachine, const int* accept, source_type& source)
+        : m_StateMachine(stateMachine)
+        , m_Accept(accept)
+        , m_Source(source)
+        , m_BufferPos(0)
+        , m_InitialState(firstState)
+        , m_ReadEnd(false) {
+        }
+        
+        ///
+        /// \brief Reads the symbol ID and position of the next lexeme
+        ///
+        /// Returns false at the end of the input, in which case pos is set to the position of the end of the input.
+        /// Characters that are not matched by the lexer produce a symbol ID of -1, as for dfa_lexer_base.
+        ///
+        inline bool next_symbol(int& matched, position& pos) {
+            int     state       = m_InitialState;
+            size_t  next        = m_BufferPos;
+            size_t  acceptEnd   = 0;
+            
+            matched = -1;
+            pos     = m_Position.current_position();
+            
+            for (;;) {
+                // Read another character if the buffer has been used up
+                if (next == m_Buffer.size()) {
+                    if (m_ReadEnd) break;
+                    
+                    char_type nextChar = char_type();
+                    m_Source.get(nextChar);
+                    
+                    if (!m_Source.good()) {
+                        m_ReadEnd = true;
+                        break;
+                    }
+                    
+                    m_Buffer.push_back((int)(unsigned)nextChar);
+                }
+                
+                // Run the state machine
+                state = m_StateMachine.run_unsafe(state, m_Buffer[next]);
+                ++next;
+                
+                if (state < 0) break;
+                
+                // Remember the longest match
+                if (m_Accept[state] >= 0) {
+                    acceptEnd   = next;
+                    matched     = m_Accept[state];
+                }
+            }
+            
+            // Nothing left at the end of the input
+            if (m_BufferPos == m_Buffer.size()) {
+                return false;
+            }
+            
+            // Always consume at least one character
+            if (acceptEnd <= m_BufferPos) acceptEnd = m_BufferPos + 1;
+            
+            // Choose the next initial state
+            m_InitialState = 0;
+            if (newlineState != m_InitialState) {
+                int lastChar = m_Buffer[acceptEnd-1];
+                if (lastChar == 0x0a || lastChar == 0x0b || lastChar == 0x0c || lastChar == 0x0d || lastChar == 0x85 || lastChar == 0x2028 || lastChar == 0x2029) {
+                    m_InitialState = newlineState;
+                }
+            }
+            
+            // Move past the lexeme
+            m_Position.update_position(m_Buffer.begin() + m_BufferPos, m_Buffer.begin() + acceptEnd);
+            m_BufferPos = acceptEnd;
+            
+            // Throw away the characters that have been used up, without moving the buffer for every lexeme
+            if (m_BufferPos == m_Buffer.size()) {
+                m_Buffer.clear();
+                m_BufferPos = 0;
+            } else if (m_BufferPos >= 4096) {
+                m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + m_BufferPos);
+                m_BufferPos = 0;
+            }
+            
+            return true;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,102 @@
+//
+//  text_symbol_stream.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _DFA_TEXT_SYMBOL_STREAM_H
+#define _DFA_TEXT_SYMBOL_STREAM_H
+
+#include <string>
+
+#include "TameParse/Dfa/basic_lexer.h"
+#include "TameParse/Dfa/symbol_set.h"
+
+namespace dfa {
+    ///
+    /// \brief Symbol stream that reads the characters from part of a document held in memory
+    ///
+    /// The incremental lexer uses this to relex the part of a document around an edit. An empty stream is used by the
+    /// incremental parser, which gives the symbols to the parser directly.
+    ///
+    class text_symbol_stream : public lexer_symbol_stream {
+    public:
+        /// \brief The type of the document being read
+        typedef std::wstring text;
+        
+    private:
+        /// \brief The next character to read
+        text::const_iterator m_Pos;
+        
+        /// \brief The end of the document
+        text::const_iterator m_End;
+        
+    public:
+        /// \brief Creates a stream that contains no symbols
+        text_symbol_stream()
+        : m_Pos()
+        , m_End() {
+        }
+        
+        /// \brief Creates a stream that reads the characters from begin up to end
+        text_symbol_stream(text::const_iterator begin, text::const_iterator end)
+        : m_Pos(begin)
+        , m_End(end) {
+        }
+        
+        /// \brief Reads the next symbol from this stream
+        virtual lexer_symbol_stream& operator>>(int& result) {
+            if (m_Pos == m_End) {
+                result = symbol_set::end_of_input;
+            } else {
+                result = (int) *m_Pos;
+                ++m_Pos;
+            }
+            return *this;
+        }
+    };
+    
+    ///
+    /// \brief Works out where a position after an edit has moved to
+    ///
+    /// editEnd is the old position of the first thing after the edit. Only positions on the same line as editEnd have
+    /// their column changed.
+    ///
+    inline position moved_position(const position& pos, const position& editEnd, int offsetDiff, int lineDiff, int columnDiff) {
+        int column = pos.line() == editEnd.line() ? pos.column() + columnDiff : pos.column();
+        return position(pos.offset() + offsetDiff, pos.line() + lineDiff, column);
+    }
+    
+    ///
+    /// \brief Returns true if a lexeme that starts at textPos in an edited document can line up with one from before the edit
+    ///
+    /// newEditEnd is the offset where the edit finishes in the new document. Lexemes before that point are always new.
+    /// A line feed straight after the edit might have followed a carriage return before it, which changes the line it
+    /// is on, so lexing can't stop there either.
+    ///
+    inline bool can_resynchronise(const std::wstring& document, size_t textPos, size_t newEditEnd) {
+        if (textPos < newEditEnd) return false;
+        return textPos > newEditEnd || textPos >= document.size() || document[textPos] != 0x0a;
+    }
+}
+
+#endif
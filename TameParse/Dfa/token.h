@@ -0,0 +1,80 @@
+//
+//  token.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _DFA_TOKEN_H
+#define _DFA_TOKEN_H
+
+#include "TameParse/Dfa/position.h"
+
+namespace dfa {
+    ///
+    /// \brief A symbol read by a lexer, without its text
+    ///
+    /// Tokens are produced in batches by lexeme_stream::read_batch(). They record which symbol was matched, where it
+    /// starts and how many input symbols it covers. Only the offset of the start is kept: the line and column can
+    /// be found with dfa::line_index::position_at() if they are needed, and the offset can be used to find the text
+    /// of the token in the original input.
+    ///
+    class token {
+    private:
+        /// \brief The offset of the start of this token from the beginning of the input
+        int m_Offset;
+        
+        /// \brief The ID of the symbol that was matched
+        int m_Matched;
+        
+        /// \brief The number of input symbols that make up this token
+        int m_Length;
+        
+    public:
+        /// \brief Creates a nonsensical empty token
+        inline token()
+        : m_Offset(-1)
+        , m_Matched(-1)
+        , m_Length(0) {
+        }
+        
+        /// \brief Creates a new token
+        inline token(int matched, int offset, int length)
+        : m_Offset(offset)
+        , m_Matched(matched)
+        , m_Length(length) {
+        }
+        
+        /// \brief The ID of the symbol that was matched (symbol_set::end_of_input if this marks the end of the input)
+        inline int matched() const { return m_Matched; }
+        
+        /// \brief The offset of the start of this token from the beginning of the input (-1 if it is not known)
+        inline int offset() const { return m_Offset; }
+        
+        /// \brief The number of input symbols that make up this token
+        inline int length() const { return m_Length; }
+        
+        /// \brief The position of the start of this token, with no line or column (see dfa::line_index::resolve())
+        inline position pos() const { return position(m_Offset, -1, -1); }
+    };
+}
+
+#endif
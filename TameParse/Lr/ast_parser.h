@@ -57,6 +57,9 @@ namespace lr {
         /// \brief The stream of lexemes that this actions object will read from
         lexeme_stream* m_Stream;
         
+        /// \brief Reads lexemes from the stream (a batch at a time if set_batched() has been called)
+        dfa::lexeme_batch_reader m_Reader;
+        
         ast_parser_actions(const ast_parser_actions& copyFrom);
         ast_parser_actions& operator=(ast_parser_actions& copyFrom);
         
@@ -65,17 +68,33 @@ namespace lr {
         ///
         /// The stream will be deleted when this object is deleted
         ast_parser_actions(dfa::lexeme_stream* stream)
-        : m_Stream(stream) {
+        : m_Stream(stream)
+        , m_Reader(stream) {
         }
         
         /// \brief Destroys an existing actions object
         ~ast_parser_actions() { delete m_Stream; }
         
+        /// \brief Starts reading from a new stream (the old stream is destroyed)
+        inline void reset(dfa::lexeme_stream* stream) {
+            if (stream != m_Stream) {
+                delete m_Stream;
+                m_Stream = stream;
+            }
+            
+            m_Reader.reset(stream);
+        }
+        
+        /// \brief Sets whether or not lexemes are read from the stream a batch at a time (see dfa::lexeme_batch_reader)
+        ///
+        /// This is faster, but should only be turned on if the parser never changes the lexer state.
+        inline void set_batched(bool batched) {
+            m_Reader.set_batched(batched);
+        }
+        
         /// \brief Reads the next symbol from the stream
         inline dfa::lexeme* read() {
-            dfa::lexeme* result = NULL;
-            (*m_Stream) >> result;
-            return result;
+            return m_Reader.read();
         }
         
         /// \brief Returns the item resulting from a shift action
@@ -88,12 +107,15 @@ namespace lr {
         }
         
         /// \brief Returns the item resulting from a reduce action
-        inline astnode_container reduce(int nonterminal, int rule, const reduce_list& reduce, const dfa::position& lookaheadPosition) {
+        ///
+        /// The reduce list belongs to the parser and is discarded after this call, so the child nodes are moved
+        /// out of it rather than copied.
+        inline astnode_container reduce(int nonterminal, int rule, reduce_list& reduce, const dfa::position& lookaheadPosition) {
             // Create a new nonterminal node
             astnode* newNode = new astnode(nonterminal, rule);
             
             // Add the contents of the reduce list to this node
-            newNode->add_children(reduce.rbegin(), reduce.rend());
+            newNode->move_children(reduce.rbegin(), reduce.rend());
             
             // Create the container for this node
             return astnode_container(newNode, true);
@@ -0,0 +1,399 @@
+//
+//  batch_parser.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy 
+//  of this software and associated documentation files (the \"Software\"), to 
+//  deal in the Software without restriction, including without limitation the 
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+//  sell copies of the Software, and to permit persons to whom the Software is 
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+//  IN THE SOFTWARE.
+//
+
+#ifndef _LR_BATCH_PARSER_H
+#define _LR_BATCH_PARSER_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+#include "TameParse/Dfa/basic_lexer.h"
+#include "TameParse/Dfa/symbol_set.h"
+#include "TameParse/Lr/parser.h"
+
+namespace lr {
+    ///
+    /// \brief Creates parser actions for a batch parser by passing the lexeme stream to the constructor
+    ///
+    /// This is suitable for actions classes that take ownership of the stream they are constructed with, such as
+    /// ast_parser_actions and simple_parser_actions.
+    ///
+    template<typename parser_actions> class stream_actions_factory {
+    public:
+        /// \brief Creates a new actions object that will read from (and destroy) the specified stream
+        inline static parser_actions* create(dfa::lexeme_stream* stream) {
+            return new parser_actions(stream);
+        }
+    };
+    
+    ///
+    /// \brief Creates parser actions for a batch parser using the (stream, ownStream) constructor
+    ///
+    /// This is suitable for the parser_actions class declared by generated parsers.
+    ///
+    template<typename parser_actions> class owned_stream_actions_factory {
+    public:
+        /// \brief Creates a new actions object that will read from (and destroy) the specified stream
+        inline static parser_actions* create(dfa::lexeme_stream* stream) {
+            return new parser_actions(stream, true);
+        }
+    };
+    
+    ///
+    /// \brief Parses a batch of documents across several threads
+    ///
+    /// Each worker keeps one parser state and lexer stream, and resets them for each document it parses. The
+    /// documents are divided evenly between the worker threads to begin with. Once a worker runs out of
+    /// documents, it steals half of the remaining documents from another worker, so a few large documents
+    /// won't leave the other threads idle. The parser and the lexer are shared between the workers (see the
+    /// notes on thread safety in the parser class).
+    ///
+    /// Documents can be any type that has begin() and end() iterators over their characters (std::string,
+    /// std::wstring or std::vector<char>, for instance).
+    ///
+    template<typename item_type, typename parser_actions, typename parser_trace = no_parser_trace, typename actions_factory = stream_actions_factory<parser_actions> > 
+    class batch_parser {
+    public:
+        /// \brief The type of parser used by the batch parser
+        typedef parser<item_type, parser_actions, parser_trace> parser_type;
+        
+        /// \brief The result of parsing a single document
+        struct result {
+            result() : accepted(false) { }
+            
+            /// \brief True if the document was accepted by the parser
+            bool accepted;
+            
+            /// \brief The item that the document was reduced to, if it was accepted
+            item_type item;
+            
+            /// \brief The position of the symbol that was rejected if the document was not accepted
+            ///
+            /// This is set to (-1, -1, -1) if the document was rejected at the end of the input.
+            dfa::position error_position;
+        };
+        
+        /// \brief List of results, in the same order as the documents they were produced from
+        typedef std::vector<result> result_list;
+        
+    private:
+        /// \brief List of the exceptions thrown while parsing each document (NULL for documents that didn't throw one)
+        typedef std::vector<std::exception_ptr> exception_list;
+        
+        /// \brief Symbol stream that reads the characters from a document
+        template<typename char_iterator> class document_symbol_stream : public dfa::lexer_symbol_stream {
+        private:
+            /// \brief The next character to read
+            char_iterator m_Pos;
+            
+            /// \brief The end of the document
+            char_iterator m_End;
+            
+        public:
+            document_symbol_stream(char_iterator begin, char_iterator end)
+            : m_Pos(begin)
+            , m_End(end) {
+            }
+            
+            /// \brief Reads the next symbol from this stream
+            virtual dfa::lexer_symbol_stream& operator>>(int& result) {
+                if (m_Pos == m_End) {
+                    result = dfa::symbol_set::end_of_input;
+                } else {
+                    result = (int)(unsigned)*m_Pos;
+                    ++m_Pos;
+                }
+                return *this;
+            }
+        };
+        
+        ///
+        /// \brief A range of documents that are waiting to be parsed by a worker
+        ///
+        /// The start and end of the range are packed into a single value so that the owner can take documents
+        /// from the start while other workers steal from the end without needing a lock.
+        ///
+        class work_range {
+        private:
+            /// \brief The start of the range in the upper 32 bits and the end in the lower 32 bits
+            std::atomic<unsigned long long> m_Range;
+            
+            /// \brief Packs a range into a single value
+            inline static unsigned long long pack(unsigned long long begin, unsigned long long end) {
+                return (begin << 32) | end;
+            }
+            
+        public:
+            work_range() : m_Range(0) { }
+            
+            /// \brief Replaces the range (should only be called by the owner when its range is empty)
+            inline void set(size_t begin, size_t end) {
+                m_Range.store(pack(begin, end));
+            }
+            
+            /// \brief Takes the next document from the start of the range, returning false if there are none left
+            inline bool take(size_t& index) {
+                unsigned long long range = m_Range.load();
+                for (;;) {
+                    size_t begin    = (size_t) (range >> 32);
+                    size_t end      = (size_t) (range & 0xffffffffull);
+                    if (begin >= end) return false;
+                    
+                    if (m_Range.compare_exchange_weak(range, pack(begin + 1, end))) {
+                        index = begin;
+                        return true;
+                    }
+                }
+            }
+            
+            /// \brief Steals the second half of the remaining documents in this range, returning false if there are none left
+            inline bool steal(size_t& stolenBegin, size_t& stolenEnd) {
+                unsigned long long range = m_Range.load();
+                for (;;) {
+                    size_t begin    = (size_t) (range >> 32);
+                    size_t end      = (size_t) (range & 0xffffffffull);
+                    if (begin >= end) return false;
+                    
+                    size_t split    = begin + (end - begin) / 2;
+                    if (m_Range.compare_exchange_weak(range, pack(begin, split))) {
+                        stolenBegin = split;
+                        stolenEnd   = end;
+                        return true;
+                    }
+                }
+            }
+        };
+        
+    private:
+        /// \brief The parser used for the documents
+        const parser_type& m_Parser;
+        
+        /// \brief The lexer used for the documents
+        const dfa::basic_lexer& m_Lexer;
+        
+        /// \brief The initial parser state
+        int m_InitialState;
+        
+        /// \brief The number of threads to use
+        int m_NumThreads;
+        
+        batch_parser(const batch_parser& noCopying);
+        batch_parser& operator=(const batch_parser& noCopying);
+        
+    public:
+        ///
+        /// \brief Creates a batch parser that will use the specified parser and lexer
+        ///
+        /// The lexer must already be compiled. If numThreads is 0, one thread is used for each hardware thread.
+        ///
+        batch_parser(const parser_type& parser, const dfa::basic_lexer& lexer, int initialState = 0, int numThreads = 0)
+        : m_Parser(parser)
+        , m_Lexer(lexer)
+        , m_InitialState(initialState)
+        , m_NumThreads(numThreads) {
+            if (m_NumThreads <= 0) {
+                m_NumThreads = (int) std::thread::hardware_concurrency();
+                if (m_NumThreads <= 0) m_NumThreads = 1;
+            }
+        }
+        
+    private:
+        ///
+        /// \brief The parser state and lexer stream used by a single worker
+        ///
+        /// These are created for the first document that the worker parses and then reset for each document after
+        /// that, so the stack, lookahead and lexer buffers are recycled rather than reallocated.
+        ///
+        class worker_state {
+        private:
+            /// \brief The parser state, or NULL if no document has been parsed yet
+            typename parser_type::state* m_State;
+            
+            /// \brief The stream that the parser actions are reading from
+            dfa::lexeme_stream* m_Stream;
+            
+            worker_state(const worker_state& noCopying);
+            worker_state& operator=(const worker_state& noCopying);
+            
+        public:
+            worker_state()
+            : m_State(NULL)
+            , m_Stream(NULL) {
+            }
+            
+            ~worker_state() {
+                // The actions own the stream, so it is destroyed along with the state
+                delete m_State;
+            }
+            
+            /// \brief Returns a parser state that will read from the specified source
+            inline typename parser_type::state* state_for(const batch_parser& batch, dfa::lexer_symbol_stream* source) {
+                if (m_State == NULL) {
+                    // Create the state for the first document
+                    m_Stream    = batch.m_Lexer.create_stream(source);
+                    m_State     = batch.m_Parser.create_parser(actions_factory::create(m_Stream), batch.m_InitialState);
+                } else if (m_Stream->reset(source)) {
+                    // The existing stream has been pointed at the new document (the actions are given the same stream so they
+                    // discard any lexemes that they read ahead of the parser)
+                    m_State->reset(m_Stream, batch.m_InitialState);
+                } else {
+                    // The stream can't be reset: replace it
+                    m_Stream = batch.m_Lexer.create_stream(source);
+                    m_State->reset(m_Stream, batch.m_InitialState);
+                }
+                
+                return m_State;
+            }
+            
+            /// \brief Destroys the parser state, so that a new one is created for the next document
+            ///
+            /// Used when parsing a document is abandoned part way through.
+            inline void discard() {
+                delete m_State;
+                m_State     = NULL;
+                m_Stream    = NULL;
+            }
+        };
+        
+        /// \brief Parses a single document
+        template<typename document_type> inline void parse_document(worker_state& worker, const document_type& document, result& target) const {
+            typedef typename document_type::const_iterator char_iterator;
+            
+            // Get the parser for this document
+            typename parser_type::state* state = worker.state_for(*this, new document_symbol_stream<char_iterator>(document.begin(), document.end()));
+            
+            // Parse it
+            target.accepted = state->parse();
+            
+            if (target.accepted) {
+                target.item = state->get_item();
+            } else {
+                // The lookahead is left at the symbol that was rejected
+                const dfa::lexeme_container& rejected = state->look();
+                
+                if (rejected.item()) {
+                    target.error_position = rejected->pos();
+                } else {
+                    target.error_position = dfa::position(-1, -1, -1);
+                }
+            }
+        }
+        
+        /// \brief Runs a worker thread
+        ///
+        /// Exceptions can't be allowed to leave a thread, so any that are thrown while parsing a document are stored
+        /// in the exception list to be thrown again once all of the workers have finished.
+        ///
+        template<typename document_iterator> void run_worker(int workerId, std::vector<work_range>* ranges, document_iterator documents, result_list* results, exception_list* exceptions) const {
+            work_range&     ourRange = (*ranges)[workerId];
+            worker_state    worker;
+            
+            for (;;) {
+                // Parse the documents in our range
+                size_t index;
+                while (ourRange.take(index)) {
+                    try {
+                        parse_document(worker, documents[index], (*results)[index]);
+                    } catch (...) {
+                        // The parser state might be part way through an action, so start again with a new one
+                        (*exceptions)[index] = std::current_exception();
+                        worker.discard();
+                    }
+                }
+                
+                // Try to steal some documents from the other workers
+                bool    stolen = false;
+                size_t  stolenBegin;
+                size_t  stolenEnd;
+                
+                for (int offset = 1; offset < (int) ranges->size() && !stolen; ++offset) {
+                    int victim = (workerId + offset) % (int) ranges->size();
+                    stolen = (*ranges)[victim].steal(stolenBegin, stolenEnd);
+                }
+                
+                // Finished if there's nothing left to steal
+                if (!stolen) return;
+                
+                ourRange.set(stolenBegin, stolenEnd);
+            }
+        }
+        
+    public:
+        ///
+        /// \brief Parses the documents in the specified range, storing the results in the same order in the result list
+        ///
+        /// The document iterator must be a random access iterator. If parsing any of the documents throws an
+        /// exception, the rest of the documents are still parsed, and then the exception for the first of these
+        /// documents is thrown again on the calling thread.
+        ///
+        template<typename document_iterator> void parse(document_iterator begin, document_iterator end, result_list& results) const {
+            // Create a result for each document
+            size_t numDocuments = (size_t) (end - begin);
+            
+            results.clear();
+            results.resize(numDocuments);
+            if (numDocuments == 0) return;
+            
+            // Share the documents out evenly between the workers
+            size_t numWorkers = (size_t) m_NumThreads;
+            if (numWorkers > numDocuments) numWorkers = numDocuments;
+            
+            std::vector<work_range> ranges(numWorkers);
+            for (size_t workerId = 0; workerId < numWorkers; ++workerId) {
+                ranges[workerId].set(numDocuments * workerId / numWorkers, numDocuments * (workerId + 1) / numWorkers);
+            }
+            
+            // Start the workers (this thread acts as the first worker)
+            exception_list              exceptions(numDocuments);
+            std::vector<std::thread>    threads;
+            for (size_t workerId = 1; workerId < numWorkers; ++workerId) {
+                threads.push_back(std::thread(&batch_parser::run_worker<document_iterator>, this, (int) workerId, &ranges, begin, &results, &exceptions));
+            }
+            
+            run_worker(0, &ranges, begin, &results, &exceptions);
+            
+            // Wait for the other workers to finish
+            for (typename std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread) {
+                thread->join();
+            }
+            
+            // Pass on the first exception that was thrown by any of the workers
+            for (typename exception_list::const_iterator exception = exceptions.begin(); exception != exceptions.end(); ++exception) {
+                if (*exception) std::rethrow_exception(*exception);
+            }
+        }
+        
+        ///
+        /// \brief Parses all of the documents in the specified container
+        ///
+        template<typename document_list> inline void parse(const document_list& documents, result_list& results) const {
+            parse(documents.begin(), documents.end(), results);
+        }
+    };
+}
+
+#endif
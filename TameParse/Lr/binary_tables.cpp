@@ -0,0 +1,534 @@
+//
+//  binary_tables.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "TameParse/Dfa/symbol_table.h"
+#include "TameParse/Lr/binary_tables.h"
+
+using namespace std;
+using namespace dfa;
+using namespace lr;
+
+/// \brief The first value in a binary tables file (the characters 'TPBT')
+static const int c_Magic = 0x54425054;
+
+///
+/// \brief The values in the header of a binary tables file
+///
+/// The header is followed by the tables, in this order: the symbol table, the offset of the first entry for each
+/// lexer state (plus a final offset for the end of the last state), the lexer state entries (symbol set, new state
+/// pairs), the accepting symbol for each lexer state, the action counts for each parser state (terminal and
+/// nonterminal), the terminal actions, the nonterminal actions, the end of guard states, the reduce rules
+/// (nonterminal, rule, length), the weak-to-strong table (weak symbol, strong symbol), the default reduction
+/// for each parser state (this table is empty if the tables are not compressed) and the expected terminals bitset
+/// for each parser state ((terminals+31)/32 values per state, empty in files that don't have it). Actions are
+/// stored as two values: type | (nextState << 8) followed by the symbol ID.
+///
+enum header_value {
+    hdr_magic,
+    hdr_version,
+    hdr_symbol_table_size,
+    hdr_lexer_states,
+    hdr_lexer_entries,
+    hdr_parser_states,
+    hdr_end_of_input,
+    hdr_end_of_guard,
+    hdr_terminal_actions,
+    hdr_nonterminal_actions,
+    hdr_end_guard_states,
+    hdr_rules,
+    hdr_weak_to_strong,
+    hdr_default_reductions,
+    hdr_expected_terminals,
+    
+    /// \brief The number of values in the header (the unused values are reserved, and are written as 0)
+    hdr_size = 16
+};
+
+/// \brief Writes a single value to a binary tables file
+static void write_value(ostream& target, int value) {
+    unsigned int    word        = (unsigned int) value;
+    char            bytes[4]    = { (char) (word & 0xff), (char) ((word >> 8) & 0xff), (char) ((word >> 16) & 0xff), (char) ((word >> 24) & 0xff) };
+    
+    target.write(bytes, 4);
+}
+
+/// \brief Reads a single value from a binary tables file
+static inline int read_value(const unsigned char* source) {
+    return (int) ((unsigned int) source[0] | ((unsigned int) source[1] << 8) | ((unsigned int) source[2] << 16) | ((unsigned int) source[3] << 24));
+}
+
+/// \brief Orders lexer state entries by symbol set
+static bool compare_entries(const binary_tables::state_machine_entry& a, const binary_tables::state_machine_entry& b) {
+    return a.symbolSet < b.symbolSet;
+}
+
+/// \brief Returns true if the tables in a file can be used in place on this machine
+///
+/// This is the case if the machine is little-endian and lays out the table structures in the same way as the file.
+static bool file_layout_matches() {
+    if (sizeof(int) != 4)                                               return false;
+    if (sizeof(binary_tables::state_machine_entry) != 2*sizeof(int))    return false;
+    if (sizeof(parser_tables::action) != 2*sizeof(int))                 return false;
+    if (sizeof(parser_tables::action_count) != 2*sizeof(int))           return false;
+    if (sizeof(parser_tables::reduce_rule) != 3*sizeof(int))            return false;
+    if (sizeof(parser_tables::symbol_equivalent) != 2*sizeof(int))      return false;
+    
+    // Check the byte order
+    const unsigned char expectedInt[4]  = { 0x04, 0x03, 0x02, 0x01 };
+    int                 probeInt        = 0x01020304;
+    if (memcmp(&probeInt, expectedInt, 4) != 0) return false;
+    
+    // Check the layout of the action bitfields
+    const unsigned char     expectedAction[8] = { 0x12, 0x78, 0x56, 0x34, 0x21, 0x43, 0x65, 0x07 };
+    parser_tables::action   probeAction;
+    
+    memset(&probeAction, 0, sizeof(probeAction));
+    probeAction.type        = 0x12;
+    probeAction.nextState   = 0x345678;
+    probeAction.symbolId    = 0x07654321;
+    
+    return memcmp(&probeAction, expectedAction, 8) == 0;
+}
+
+/// \brief Creates an empty set of tables
+binary_tables::binary_tables()
+: m_Data(NULL)
+, m_Size(0)
+, m_Mapped(false)
+, m_Swapped(NULL)
+, m_Actions(NULL)
+, m_FileBuffer(NULL)
+, m_LexerStates(NULL)
+, m_StateActions(NULL)
+, m_SymbolTable(NULL)
+, m_StateMachine(NULL)
+, m_LexerDefinition(NULL)
+, m_Lexer(NULL)
+, m_Tables(NULL) {
+}
+
+/// \brief Destructor
+binary_tables::~binary_tables() {
+    unload();
+}
+
+/// \brief Unloads the tables
+void binary_tables::unload() {
+    // Destroy the lexer and parser objects
+    delete m_Tables;
+    delete m_Lexer;
+    delete m_LexerDefinition;
+    delete m_StateMachine;
+    delete m_SymbolTable;
+    delete[] m_StateActions;
+    delete[] m_LexerStates;
+    delete[] m_Actions;
+    delete[] m_Swapped;
+    
+    // Release the file contents
+#ifndef _WIN32
+    if (m_Mapped && m_Data) {
+        munmap((void*) m_Data, m_Size);
+    }
+#endif
+    delete[] m_FileBuffer;
+    
+    m_Data              = NULL;
+    m_Size              = 0;
+    m_Mapped            = false;
+    m_Swapped           = NULL;
+    m_Actions           = NULL;
+    m_FileBuffer        = NULL;
+    m_LexerStates       = NULL;
+    m_StateActions      = NULL;
+    m_SymbolTable       = NULL;
+    m_StateMachine      = NULL;
+    m_LexerDefinition   = NULL;
+    m_Lexer             = NULL;
+    m_Tables            = NULL;
+}
+
+/// \brief Writes out a lexer and parser tables
+bool binary_tables::write(ostream& target, const ndfa& lexerDfa, const parser_tables& tables) {
+    // Build the symbol table
+    dfa::symbol_table<wchar_t> symbolLevels;
+    
+    for (symbol_map::iterator setIt = lexerDfa.symbols().begin(); setIt != lexerDfa.symbols().end(); ++setIt) {
+        for (symbol_set::iterator rangeIt = setIt->first->begin(); rangeIt != setIt->first->end(); ++rangeIt) {
+            symbolLevels.add_range(*rangeIt, setIt->second);
+        }
+    }
+    
+    size_t  symbolTableSize;
+    int*    symbolTable = symbolLevels.table.to_hard_coded_table(symbolTableSize);
+    
+    // Build the lexer state machine, and find the accepting symbol for each state
+    vector<state_machine_entry> entries;
+    vector<int>                 stateOffsets;
+    vector<int>                 accept;
+    
+    for (int stateId = 0; stateId < lexerDfa.count_states(); ++stateId) {
+        const state& thisState = lexerDfa.get_state(stateId);
+        
+        // Entries for this state, sorted by symbol set
+        stateOffsets.push_back((int) entries.size());
+        for (state::iterator transit = thisState.begin(); transit != thisState.end(); ++transit) {
+            state_machine_entry entry = { transit->symbol_set(), transit->new_state() };
+            entries.push_back(entry);
+        }
+        sort(entries.begin() + stateOffsets.back(), entries.end(), compare_entries);
+        
+        // The accepting symbol is the highest ranked action for this state
+        const ndfa::accept_action_list& actions = lexerDfa.actions_for_state(stateId);
+        if (actions.begin() == actions.end()) {
+            accept.push_back(-1);
+        } else {
+            ndfa::accept_action_list::const_iterator    action  = actions.begin();
+            const accept_action*                        highest = *action;
+            
+            for (++action; action != actions.end(); ++action) {
+                if ((*highest) < **action) {
+                    highest = *action;
+                }
+            }
+            
+            accept.push_back(highest->symbol());
+        }
+    }
+    stateOffsets.push_back((int) entries.size());
+    
+    // Count the parser actions
+    int numTerminalActions      = 0;
+    int numNonterminalActions   = 0;
+    
+    for (int stateId = 0; stateId < tables.count_states(); ++stateId) {
+        numTerminalActions      += tables.action_counts()[stateId].numTerminals;
+        numNonterminalActions   += tables.action_counts()[stateId].numNonterminals;
+    }
+    
+    // Write out the header
+    int header[hdr_size];
+    for (int valueId = 0; valueId < hdr_size; ++valueId) {
+        header[valueId] = 0;
+    }
+    
+    header[hdr_magic]               = c_Magic;
+    header[hdr_version]             = file_version;
+    header[hdr_symbol_table_size]   = (int) symbolTableSize;
+    header[hdr_lexer_states]        = lexerDfa.count_states();
+    header[hdr_lexer_entries]       = (int) entries.size();
+    header[hdr_parser_states]       = tables.count_states();
+    header[hdr_end_of_input]        = tables.end_of_input();
+    header[hdr_end_of_guard]        = tables.end_of_guard();
+    header[hdr_terminal_actions]    = numTerminalActions;
+    header[hdr_nonterminal_actions] = numNonterminalActions;
+    header[hdr_end_guard_states]    = tables.count_end_of_guards();
+    header[hdr_rules]               = tables.count_reduce_rules();
+    header[hdr_weak_to_strong]      = tables.count_weak_to_strong();
+    header[hdr_default_reductions]  = tables.default_reductions() ? tables.count_states() : 0;
+    header[hdr_expected_terminals]  = tables.expected_terminals() ? tables.count_terminals() : 0;
+    
+    for (int valueId = 0; valueId < hdr_size; ++valueId) {
+        write_value(target, header[valueId]);
+    }
+    
+    // The lexer tables
+    for (size_t tablePos = 0; tablePos < symbolTableSize; ++tablePos) {
+        write_value(target, symbolTable[tablePos]);
+    }
+    delete[] symbolTable;
+    
+    for (vector<int>::const_iterator offset = stateOffsets.begin(); offset != stateOffsets.end(); ++offset) {
+        write_value(target, *offset);
+    }
+    
+    for (vector<state_machine_entry>::const_iterator entry = entries.begin(); entry != entries.end(); ++entry) {
+        write_value(target, entry->symbolSet);
+        write_value(target, entry->state);
+    }
+    
+    for (vector<int>::const_iterator acceptSymbol = accept.begin(); acceptSymbol != accept.end(); ++acceptSymbol) {
+        write_value(target, *acceptSymbol);
+    }
+    
+    // The parser tables
+    for (int stateId = 0; stateId < tables.count_states(); ++stateId) {
+        write_value(target, tables.action_counts()[stateId].numTerminals);
+        write_value(target, tables.action_counts()[stateId].numNonterminals);
+    }
+    
+    for (int stateId = 0; stateId < tables.count_states(); ++stateId) {
+        for (int actionId = 0; actionId < tables.action_counts()[stateId].numTerminals; ++actionId) {
+            const parser_tables::action& act = tables.terminal_actions()[stateId][actionId];
+            write_value(target, (int) (act.type | (act.nextState << 8)));
+            write_value(target, act.symbolId);
+        }
+    }
+    
+    for (int stateId = 0; stateId < tables.count_states(); ++stateId) {
+        for (int actionId = 0; actionId < tables.action_counts()[stateId].numNonterminals; ++actionId) {
+            const parser_tables::action& act = tables.nonterminal_actions()[stateId][actionId];
+            write_value(target, (int) (act.type | (act.nextState << 8)));
+            write_value(target, act.symbolId);
+        }
+    }
+    
+    for (int guardId = 0; guardId < tables.count_end_of_guards(); ++guardId) {
+        write_value(target, tables.end_of_guard_states()[guardId]);
+    }
+    
+    for (int ruleId = 0; ruleId < tables.count_reduce_rules(); ++ruleId) {
+        const parser_tables::reduce_rule& rule = tables.reduce_rules()[ruleId];
+        write_value(target, rule.identifier);
+        write_value(target, rule.ruleId);
+        write_value(target, rule.length);
+    }
+    
+    for (int weakId = 0; weakId < tables.count_weak_to_strong(); ++weakId) {
+        write_value(target, tables.weak_to_strong()[weakId].m_OriginalSymbol);
+        write_value(target, tables.weak_to_strong()[weakId].m_MappedTo);
+    }
+    
+    for (int stateId = 0; stateId < header[hdr_default_reductions]; ++stateId) {
+        write_value(target, tables.default_reductions()[stateId]);
+    }
+    
+    if (header[hdr_expected_terminals] > 0) {
+        for (int wordId = 0; wordId < tables.count_states() * tables.expected_words(); ++wordId) {
+            write_value(target, (int) tables.expected_terminals()[wordId]);
+        }
+    }
+    
+    return !target.fail();
+}
+
+/// \brief Loads tables from a file, returning false if the file could not be loaded
+bool binary_tables::load(const string& filename) {
+    unload();
+    
+#ifdef _WIN32
+    // Read the whole file into memory
+    ifstream file(filename.c_str(), ios::in | ios::binary);
+    if (!file) return false;
+    
+    file.seekg(0, ios::end);
+    streamoff fileSize = file.tellg();
+    file.seekg(0, ios::beg);
+    if (fileSize <= 0) return false;
+    
+    m_FileBuffer = new int[(size_t) (fileSize + 3) / 4];
+    file.read((char*) m_FileBuffer, fileSize);
+    if (file.gcount() != fileSize) {
+        unload();
+        return false;
+    }
+    
+    m_Data = m_FileBuffer;
+    m_Size = (size_t) fileSize;
+#else
+    // Map the file into memory
+    int file = open(filename.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size <= 0) {
+        close(file);
+        return false;
+    }
+    
+    void* mapped = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapped == MAP_FAILED) return false;
+    
+    m_Data      = mapped;
+    m_Size      = (size_t) fileStat.st_size;
+    m_Mapped    = true;
+#endif
+    
+    if (!use_data()) {
+        unload();
+        return false;
+    }
+    
+    return true;
+}
+
+/// \brief Loads tables from a block of memory, returning false if it does not contain valid tables
+bool binary_tables::load(const void* data, size_t size) {
+    unload();
+    
+    m_Data = data;
+    m_Size = size;
+    
+    if (!use_data()) {
+        unload();
+        return false;
+    }
+    
+    return true;
+}
+
+/// \brief Sets up the lexer and parser from the contents of m_Data
+bool binary_tables::use_data() {
+    const unsigned char* bytes = (const unsigned char*) m_Data;
+    
+    // Check the header
+    if (bytes == NULL || m_Size < hdr_size * 4 || (m_Size % 4) != 0)    return false;
+    if (read_value(bytes) != c_Magic)                                   return false;
+    if (read_value(bytes + hdr_version*4) != file_version)              return false;
+    
+    size_t  numValues = m_Size / 4;
+    int     header[hdr_size];
+    
+    for (int valueId = 0; valueId < hdr_size; ++valueId) {
+        header[valueId] = read_value(bytes + valueId*4);
+    }
+    
+    // The expected terminals table has a bitset for each state
+    if (header[hdr_expected_terminals] < 0)         return false;
+    int expectedWords = (int) (((unsigned int) header[hdr_expected_terminals] + 31) / 32);
+    if ((size_t) expectedWords > numValues)         return false;
+    
+    // Work out where each table starts, and check that the file is large enough for all of them
+    const int       tableCounts[]   = { header[hdr_symbol_table_size], header[hdr_lexer_states] + 1, header[hdr_lexer_entries], header[hdr_lexer_states], 
+                                        header[hdr_parser_states], header[hdr_terminal_actions], header[hdr_nonterminal_actions], header[hdr_end_guard_states], 
+                                        header[hdr_rules], header[hdr_weak_to_strong], header[hdr_default_reductions], header[hdr_parser_states] };
+    const size_t    tableWidths[]   = { 1, 1, 2, 1, 2, 2, 2, 1, 3, 2, 1, (size_t) expectedWords };
+    const int       numTables       = (int) (sizeof(tableCounts) / sizeof(tableCounts[0]));
+    size_t          tableStart[sizeof(tableCounts) / sizeof(tableCounts[0]) + 1];
+    
+    tableStart[0] = hdr_size;
+    for (int tableId = 0; tableId < numTables; ++tableId) {
+        if (tableCounts[tableId] < 0 || (size_t) tableCounts[tableId] > numValues) return false;
+        tableStart[tableId+1] = tableStart[tableId] + tableWidths[tableId] * (size_t) tableCounts[tableId];
+    }
+    if (tableStart[numTables] != numValues) return false;
+    
+    // Use the file in place if we can, or make a copy in the byte order for this machine
+    const int* values;
+    
+    if (file_layout_matches() && (((size_t) m_Data) % sizeof(int)) == 0) {
+        values = (const int*) m_Data;
+    } else {
+        m_Swapped = new int[numValues];
+        for (size_t valueId = 0; valueId < numValues; ++valueId) {
+            m_Swapped[valueId] = read_value(bytes + valueId*4);
+        }
+        values = m_Swapped;
+    }
+    
+    const int*                          symbolTable     = values + tableStart[0];
+    const int*                          stateOffsets    = values + tableStart[1];
+    const state_machine_entry*          entries         = (const state_machine_entry*) (values + tableStart[2]);
+    const int*                          accept          = values + tableStart[3];
+    parser_tables::action_count*        counts          = (parser_tables::action_count*) (values + tableStart[4]);
+    parser_tables::action*              actions         = (parser_tables::action*) (values + tableStart[5]);
+    int*                                endGuardStates  = (int*) (values + tableStart[7]);
+    parser_tables::reduce_rule*         rules           = (parser_tables::reduce_rule*) (values + tableStart[8]);
+    parser_tables::symbol_equivalent*   weakToStrong    = (parser_tables::symbol_equivalent*) (values + tableStart[9]);
+    int*                                defaultReduce   = header[hdr_default_reductions] ? (int*) (values + tableStart[10]) : NULL;
+    unsigned int*                       expected        = header[hdr_expected_terminals] ? (unsigned int*) (values + tableStart[11]) : NULL;
+    
+    int numLexerStates  = header[hdr_lexer_states];
+    int numParserStates = header[hdr_parser_states];
+    int numActions      = header[hdr_terminal_actions] + header[hdr_nonterminal_actions];
+    
+    // There is either no default reduction table or one entry for every state
+    if (defaultReduce && header[hdr_default_reductions] != numParserStates) return false;
+    
+    // The actions need to be decoded if the bitfields are laid out differently on this machine
+    if (m_Swapped) {
+        m_Actions = new parser_tables::action[numActions];
+        
+        for (int actionId = 0; actionId < numActions; ++actionId) {
+            int typeAndState = values[tableStart[5] + actionId*2];
+            
+            m_Actions[actionId].type        = (unsigned int) typeAndState & 0xff;
+            m_Actions[actionId].nextState   = ((unsigned int) typeAndState >> 8) & 0xffffff;
+            m_Actions[actionId].symbolId    = values[tableStart[5] + actionId*2 + 1];
+        }
+        
+        actions = m_Actions;
+    }
+    
+    // Find the entries for each lexer state
+    m_LexerStates = new const state_machine_entry*[numLexerStates + 1];
+    
+    for (int stateId = 0; stateId <= numLexerStates; ++stateId) {
+        int offset = stateOffsets[stateId];
+        if (offset < 0 || offset > header[hdr_lexer_entries]) return false;
+        if (stateId > 0 && offset < stateOffsets[stateId-1]) return false;
+        
+        m_LexerStates[stateId] = entries + offset;
+    }
+    
+    // Find the actions for each parser state
+    m_StateActions = new parser_tables::action*[numParserStates * 2];
+    
+    parser_tables::action* nextTerminal     = actions;
+    parser_tables::action* nextNonterminal  = actions + header[hdr_terminal_actions];
+    
+    for (int stateId = 0; stateId < numParserStates; ++stateId) {
+        if (counts[stateId].numTerminals < 0 || counts[stateId].numNonterminals < 0) return false;
+        
+        m_StateActions[stateId]                     = nextTerminal;
+        m_StateActions[numParserStates + stateId]   = nextNonterminal;
+        
+        nextTerminal    += counts[stateId].numTerminals;
+        nextNonterminal += counts[stateId].numNonterminals;
+    }
+    
+    if (nextTerminal != actions + header[hdr_terminal_actions])  return false;
+    if (nextNonterminal != actions + numActions)                 return false;
+    
+    // Create the lexer
+    m_SymbolTable       = new symbol_table(symbolTable);
+    m_StateMachine      = new state_machine(*m_SymbolTable, m_LexerStates, numLexerStates);
+    m_LexerDefinition   = new lexer_definition(*m_StateMachine, numLexerStates, accept);
+    m_Lexer             = new lexer(m_LexerDefinition, false);
+    
+    // Create the parser tables
+    m_Tables = new parser_tables(numParserStates, header[hdr_end_of_input], header[hdr_end_of_guard], 
+                                 m_StateActions, m_StateActions + numParserStates, counts, 
+                                 endGuardStates, header[hdr_end_guard_states], 
+                                 header[hdr_rules], rules, 
+                                 header[hdr_weak_to_strong], weakToStrong, defaultReduce, 
+                                 header[hdr_expected_terminals], expected);
+    
+    return true;
+}
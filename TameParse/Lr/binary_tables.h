@@ -0,0 +1,164 @@
+//
+//  binary_tables.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _LR_BINARY_TABLES_H
+#define _LR_BINARY_TABLES_H
+
+#include <string>
+#include <iostream>
+
+#include "TameParse/Dfa/ndfa.h"
+#include "TameParse/Dfa/lexer.h"
+#include "TameParse/Dfa/state_machine.h"
+#include "TameParse/Dfa/hard_coded_symbol_table.h"
+#include "TameParse/Lr/parser_tables.h"
+
+namespace lr {
+    ///
+    /// \brief Lexer and parser tables that are stored in a binary file
+    ///
+    /// This makes it possible to save a lexer and parser that were built at runtime and load them again without
+    /// having to rebuild them. The tables are stored in the same form as the tables generated for C++ parsers, as
+    /// a series of 32-bit little-endian values. On little-endian machines, the loaded lexer and parser use the
+    /// file contents in place: loading a file just maps it into memory and builds the per-state pointer tables.
+    /// Other machines copy the contents into memory with the bytes swapped.
+    ///
+    /// The file has a version number, and files with an unknown version are rejected. The sizes of the tables are
+    /// checked against the size of the file, but the contents of the tables are not, so files should come from a
+    /// trusted source.
+    ///
+    class binary_tables {
+    public:
+        /// \brief The version of the file format written by this class
+        static const int file_version = 1;
+        
+        /// \brief The type of the symbol table used by the lexer
+        typedef dfa::hard_coded_symbol_table<wchar_t, 2> symbol_table;
+        
+        /// \brief The type of the lexer state machine
+        typedef dfa::state_machine_tables<wchar_t, symbol_table> state_machine;
+        
+        /// \brief The type of an entry in the lexer state machine
+        typedef state_machine::entry state_machine_entry;
+        
+        /// \brief The lexer that runs the state machine
+        typedef dfa::dfa_lexer_base<const state_machine&, 0, 0, false, const state_machine&> lexer_definition;
+        
+    private:
+        /// \brief The memory containing the file, or NULL if nothing is loaded
+        const void* m_Data;
+        
+        /// \brief The size of the file in bytes
+        size_t m_Size;
+        
+        /// \brief True if m_Data was mapped from a file
+        bool m_Mapped;
+        
+        /// \brief Contents of the file with the bytes swapped into the machine's order (NULL if the file is used in place)
+        int* m_Swapped;
+        
+        /// \brief Actions decoded from the file (NULL if the file is used in place)
+        parser_tables::action* m_Actions;
+        
+        /// \brief The file contents if they were read into memory instead of being mapped
+        int* m_FileBuffer;
+        
+        /// \brief The first entry for each lexer state (with a final entry marking the end of the last state)
+        const state_machine_entry** m_LexerStates;
+        
+        /// \brief The actions for each parser state (the terminal actions followed by the nonterminal actions)
+        parser_tables::action** m_StateActions;
+        
+        /// \brief The table that maps characters to symbol sets
+        symbol_table* m_SymbolTable;
+        
+        /// \brief The lexer state machine
+        state_machine* m_StateMachine;
+        
+        /// \brief The definition of the lexer
+        lexer_definition* m_LexerDefinition;
+        
+        /// \brief The lexer
+        dfa::lexer* m_Lexer;
+        
+        /// \brief The parser tables
+        parser_tables* m_Tables;
+        
+    private:
+        binary_tables(const binary_tables& noCopying);
+        binary_tables& operator=(const binary_tables& noCopying);
+        
+        /// \brief Sets up the lexer and parser from the contents of m_Data
+        bool use_data();
+        
+    public:
+        /// \brief Creates an empty set of tables
+        binary_tables();
+        
+        /// \brief Destructor
+        ~binary_tables();
+        
+        ///
+        /// \brief Writes out a lexer and parser tables
+        ///
+        /// The lexer is supplied as a DFA (an NDFA which has been transformed by to_ndfa_with_unique_symbols() and
+        /// to_dfa(), in that order). Returns false if the tables could not be written.
+        ///
+        static bool write(std::ostream& target, const dfa::ndfa& lexerDfa, const parser_tables& tables);
+        
+        ///
+        /// \brief Loads tables from a file, returning false if the file could not be loaded
+        ///
+        /// The file is mapped into memory where the platform supports it, and stays mapped until these tables are
+        /// unloaded.
+        ///
+        bool load(const std::string& filename);
+        
+        ///
+        /// \brief Loads tables from a block of memory, returning false if it does not contain valid tables
+        ///
+        /// The memory must be aligned to a 4-byte boundary, and must not be changed or freed until these tables are
+        /// unloaded.
+        ///
+        bool load(const void* data, size_t size);
+        
+        /// \brief Unloads the tables
+        void unload();
+        
+        /// \brief True if tables have been loaded
+        inline bool loaded() const { return m_Tables != NULL; }
+        
+        /// \brief True if the tables are being used in place (rather than copied from the file)
+        inline bool in_place() const { return m_Tables != NULL && m_Swapped == NULL; }
+        
+        /// \brief The lexer (only valid while the tables are loaded)
+        inline const dfa::lexer& get_lexer() const { return *m_Lexer; }
+        
+        /// \brief The parser tables (only valid while the tables are loaded)
+        inline const parser_tables& get_tables() const { return *m_Tables; }
+    };
+}
+
+#endif
@@ -0,0 +1,390 @@
+//
+//  chunked_parser.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _LR_CHUNKED_PARSER_H
+#define _LR_CHUNKED_PARSER_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+
+#include "TameParse/Dfa/basic_lexer.h"
+#include "TameParse/Dfa/line_index.h"
+#include "TameParse/Dfa/symbol_set.h"
+#include "TameParse/Lr/parser.h"
+#include "TameParse/Lr/batch_parser.h"
+
+namespace lr {
+    ///
+    /// \brief Finds the boundaries between chunks for a chunked_parser by looking for a sequence of symbols
+    ///
+    /// The boundary is placed just after the sequence. For newline-delimited JSON the sequence would be "\n", and
+    /// for C code where every top-level definition ends with a closing brace at the start of a line, it could be
+    /// "\n}". The sequence should only occur between top-level items: if it is found inside a comment or a string,
+    /// the chunks on either side will usually fail to parse and have to be parsed again.
+    ///
+    template<typename char_type> class sequence_boundary {
+    private:
+        /// \brief The sequence that marks the end of a chunk
+        std::basic_string<char_type> m_Sequence;
+        
+    public:
+        explicit sequence_boundary(const std::basic_string<char_type>& sequence)
+        : m_Sequence(sequence) {
+        }
+        
+        /// \brief Returns the offset of the first boundary after the specified offset, or the length of the document if there isn't one
+        template<typename char_iterator> inline size_t find(char_iterator begin, char_iterator end, size_t from) const {
+            char_iterator found = std::search(begin + from, end, m_Sequence.begin(), m_Sequence.end());
+            
+            if (found == end) return (size_t) (end - begin);
+            return (size_t) (found - begin) + m_Sequence.size();
+        }
+    };
+    
+    ///
+    /// \brief Parses a single large document by splitting it into chunks and parsing them in parallel (experimental)
+    ///
+    /// The document is split at boundaries that are found by a boundary finder (such as sequence_boundary) that
+    /// knows where top-level items can end in the language. Each chunk is then parsed on its own from the initial
+    /// state, which should be for a start symbol that matches a list of top-level items. The results are returned
+    /// in document order, so the items for the chunks make up the items for the whole document when taken together.
+    ///
+    /// Parsing the chunks separately is speculative: a boundary might turn out to be in the middle of an item after
+    /// all. A chunk that is rejected is parsed again on the calling thread together with the chunks that follow it,
+    /// doubling the number of chunks each time, until it is accepted or the end of the document is reached. If the
+    /// rest of the document is rejected, an earlier chunk might have ended too soon, so it is parsed again along with
+    /// the chunks before it in the same way, until the whole document has been parsed on its own. An error is only
+    /// reported if the whole document is rejected, and is in the same place as it would be for a sequential parse.
+    ///
+    /// Lexemes have the same positions as they would if the whole document was parsed at once, provided that the
+    /// lexer streams support restart(). Each chunk is lexed starting in the lexer's initial state.
+    ///
+    template<typename item_type, typename parser_actions, typename parser_trace = no_parser_trace, typename actions_factory = stream_actions_factory<parser_actions> > 
+    class chunked_parser {
+    public:
+        /// \brief The type of parser used by the chunked parser
+        typedef parser<item_type, parser_actions, parser_trace> parser_type;
+        
+        /// \brief The result of parsing one chunk of a document
+        struct chunk {
+            chunk() : offset(0), length(0), accepted(false), speculative(false), item() { }
+            
+            /// \brief The offset of the start of this chunk in the document
+            size_t offset;
+            
+            /// \brief The number of characters in this chunk
+            size_t length;
+            
+            /// \brief True if the chunk was accepted by the parser
+            bool accepted;
+            
+            /// \brief True if the chunk was parsed in parallel with the others, false if it was parsed again after a failed speculation
+            bool speculative;
+            
+            /// \brief The item that the chunk was reduced to, if it was accepted
+            item_type item;
+            
+            /// \brief The position of the symbol that was rejected if the chunk was not accepted
+            ///
+            /// This is set to (-1, -1, -1) if the chunk was rejected at the end of the input.
+            dfa::position error_position;
+        };
+        
+        /// \brief List of chunks, in the order that they appear in the document
+        typedef std::vector<chunk> chunk_list;
+        
+    private:
+        /// \brief Symbol stream that reads the characters in a chunk
+        template<typename char_iterator> class chunk_symbol_stream : public dfa::lexer_symbol_stream {
+        private:
+            /// \brief The next character to read
+            char_iterator m_Pos;
+            
+            /// \brief The end of the chunk
+            char_iterator m_End;
+            
+        public:
+            chunk_symbol_stream(char_iterator begin, char_iterator end)
+            : m_Pos(begin)
+            , m_End(end) {
+            }
+            
+            /// \brief Reads the next symbol from this stream
+            virtual dfa::lexer_symbol_stream& operator>>(int& result) {
+                if (m_Pos == m_End) {
+                    result = dfa::symbol_set::end_of_input;
+                } else {
+                    result = (int)(unsigned)*m_Pos;
+                    ++m_Pos;
+                }
+                return *this;
+            }
+        };
+        
+        /// \brief The parser used for the chunks
+        const parser_type& m_Parser;
+        
+        /// \brief The lexer used for the chunks
+        const dfa::basic_lexer& m_Lexer;
+        
+        /// \brief The parser state used to parse each chunk
+        int m_InitialState;
+        
+        /// \brief The number of threads to use
+        int m_NumThreads;
+        
+        chunked_parser(const chunked_parser& noCopying);
+        chunked_parser& operator=(const chunked_parser& noCopying);
+        
+    public:
+        ///
+        /// \brief Creates a chunked parser that will use the specified parser and lexer
+        ///
+        /// The lexer must already be compiled. If numThreads is 0, one thread is used for each hardware thread.
+        ///
+        chunked_parser(const parser_type& parser, const dfa::basic_lexer& lexer, int initialState = 0, int numThreads = 0)
+        : m_Parser(parser)
+        , m_Lexer(lexer)
+        , m_InitialState(initialState)
+        , m_NumThreads(numThreads) {
+            if (m_NumThreads <= 0) {
+                m_NumThreads = (int) std::thread::hardware_concurrency();
+                if (m_NumThreads <= 0) m_NumThreads = 1;
+            }
+        }
+        
+    private:
+        ///
+        /// \brief The parser state and lexer stream used by a single worker
+        ///
+        /// As for the batch parser, these are reused for every chunk that the worker parses.
+        ///
+        class worker_state {
+        private:
+            /// \brief The parser state, or NULL if no chunk has been parsed yet
+            typename parser_type::state* m_State;
+            
+            /// \brief The stream that the parser actions are reading from
+            dfa::lexeme_stream* m_Stream;
+            
+            worker_state(const worker_state& noCopying);
+            worker_state& operator=(const worker_state& noCopying);
+            
+        public:
+            worker_state()
+            : m_State(NULL)
+            , m_Stream(NULL) {
+            }
+            
+            ~worker_state() {
+                // The actions own the stream, so it is destroyed along with the state
+                delete m_State;
+            }
+            
+            /// \brief Returns a parser state that will read from the specified source, which starts at the specified checkpoint
+            inline typename parser_type::state* state_for(const chunked_parser& chunked, dfa::lexer_symbol_stream* source, const dfa::lexer_checkpoint& from) {
+                if (m_State == NULL) {
+                    // Create the state for the first chunk
+                    m_Stream    = chunked.m_Lexer.create_stream(source);
+                    m_Stream->restart(source, from);
+                    m_State     = chunked.m_Parser.create_parser(actions_factory::create(m_Stream), chunked.m_InitialState);
+                } else if (m_Stream->restart(source, from)) {
+                    // The existing stream has been moved to the new chunk (the actions are given the same stream so they
+                    // discard any lexemes that they read ahead of the parser)
+                    m_State->reset(m_Stream, chunked.m_InitialState);
+                } else {
+                    // The stream can't be restarted: replace it (the positions will be relative to the start of the chunk)
+                    m_Stream = chunked.m_Lexer.create_stream(source);
+                    m_State->reset(m_Stream, chunked.m_InitialState);
+                }
+                
+                return m_State;
+            }
+        };
+        
+        /// \brief Parses the part of a document described by a chunk, which starts at the specified position
+        template<typename char_iterator> inline void parse_chunk(worker_state& worker, char_iterator document, const dfa::position_tracker& startPos, chunk& target) const {
+            // Get the parser for this chunk
+            dfa::lexer_checkpoint           from(target.offset, target.offset, 0, startPos);
+            char_iterator                   begin   = document + target.offset;
+            typename parser_type::state*    state   = worker.state_for(*this, new chunk_symbol_stream<char_iterator>(begin, begin + target.length), from);
+            
+            // Parse it
+            target.accepted = state->parse();
+            
+            if (target.accepted) {
+                target.item             = state->get_item();
+                target.error_position   = dfa::position();
+            } else {
+                // The lookahead is left at the symbol that was rejected
+                const dfa::lexeme_container& rejected = state->look();
+                
+                target.item = item_type();
+                if (rejected.item()) {
+                    target.error_position = rejected->pos();
+                } else {
+                    target.error_position = dfa::position(-1, -1, -1);
+                }
+            }
+        }
+        
+        /// \brief Runs a worker thread, which parses chunks until there are none left
+        template<typename char_iterator> void run_worker(std::atomic<size_t>* nextChunk, char_iterator document, const std::vector<dfa::position_tracker>* startPositions, chunk_list* chunks) const {
+            worker_state worker;
+            
+            for (;;) {
+                size_t index = nextChunk->fetch_add(1);
+                if (index >= chunks->size()) return;
+                
+                parse_chunk(worker, document, (*startPositions)[index], (*chunks)[index]);
+                (*chunks)[index].speculative = true;
+            }
+        }
+        
+    public:
+        ///
+        /// \brief Parses the characters in the specified range, storing the chunks that it was divided into in the result list
+        ///
+        /// The document is divided into chunks of approximately chunkSize characters, using the boundary finder to
+        /// move each boundary to somewhere that a top-level item ends. Returns true if every chunk was accepted. If
+        /// the document is rejected, the last chunk in the result describes the error.
+        ///
+        template<typename char_iterator, typename boundary_finder> bool parse(char_iterator begin, char_iterator end, const boundary_finder& boundaries, size_t chunkSize, chunk_list& results) const {
+            size_t length = (size_t) (end - begin);
+            if (chunkSize == 0) chunkSize = 1;
+            
+            // Divide the document into chunks
+            chunk_list chunks;
+            size_t offset = 0;
+            
+            do {
+                chunk next;
+                size_t boundary = offset + chunkSize;
+                
+                if (boundary >= length) {
+                    boundary = length;
+                } else {
+                    boundary = boundaries.find(begin, end, boundary);
+                }
+                
+                next.offset = offset;
+                next.length = boundary - offset;
+                chunks.push_back(next);
+                
+                offset = boundary;
+            } while (offset < length);
+            
+            // Work out where each chunk starts
+            std::vector<dfa::position_tracker>  startPositions;
+            dfa::line_index                     lines(begin, end);
+            
+            startPositions.reserve(chunks.size());
+            for (typename chunk_list::const_iterator nextChunk = chunks.begin(); nextChunk != chunks.end(); ++nextChunk) {
+                startPositions.push_back(lines.tracker_at(nextChunk->offset));
+            }
+            
+            // Parse the chunks in parallel (this thread acts as the first worker)
+            std::atomic<size_t>         nextChunk(0);
+            std::vector<std::thread>    threads;
+            size_t                      numWorkers = (size_t) m_NumThreads;
+            if (numWorkers > chunks.size()) numWorkers = chunks.size();
+            
+            for (size_t workerId = 1; workerId < numWorkers; ++workerId) {
+                threads.push_back(std::thread(&chunked_parser::run_worker<char_iterator>, this, &nextChunk, begin, &startPositions, &chunks));
+            }
+            
+            run_worker(&nextChunk, begin, &startPositions, &chunks);
+            
+            for (typename std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread) {
+                thread->join();
+            }
+            
+            // Stitch the results together, parsing the chunks that were rejected again along with the ones after them
+            worker_state    worker;
+            bool            accepted = true;
+            
+            results.clear();
+            for (size_t index = 0; index < chunks.size(); ) {
+                // Keep chunks that were accepted
+                if (chunks[index].accepted) {
+                    results.push_back(chunks[index]);
+                    ++index;
+                    continue;
+                }
+                
+                // Merge a rejected chunk with the chunks after it until it is accepted
+                chunk   merged  = chunks[index];
+                size_t  last    = index;
+                size_t  count   = 1;
+                
+                while (!merged.accepted && last + 1 < chunks.size()) {
+                    last = std::min(index + count, chunks.size() - 1);
+                    
+                    merged.length       = chunks[last].offset + chunks[last].length - merged.offset;
+                    merged.speculative  = false;
+                    parse_chunk(worker, begin, startPositions[index], merged);
+                    
+                    count *= 2;
+                }
+                
+                // A chunk before this one might have been accepted when it should have been part of this one (for
+                // example, 'if (a) b;' followed by 'else c;'), so try again from earlier boundaries, doubling the
+                // number of chunks each time, ending with the start of the document
+                for (size_t back = 1; !merged.accepted && !results.empty(); back *= 2) {
+                    size_t first = back < results.size() ? results.size() - back : 0;
+                    
+                    merged.offset       = results[first].offset;
+                    merged.length       = length - merged.offset;
+                    merged.speculative  = false;
+                    parse_chunk(worker, begin, lines.tracker_at(merged.offset), merged);
+                    
+                    if (merged.accepted || first == 0) {
+                        results.resize(first);
+                    }
+                }
+                
+                // The document is rejected if the rest of it couldn't be parsed
+                if (!merged.accepted) accepted = false;
+                
+                results.push_back(merged);
+                index = last + 1;
+            }
+            
+            return accepted;
+        }
+        
+        ///
+        /// \brief Parses a document, which can be any type with begin() and end() random access iterators over its characters
+        ///
+        template<typename document_type, typename boundary_finder> inline bool parse(const document_type& document, const boundary_finder& boundaries, size_t chunkSize, chunk_list& results) const {
+            return parse(document.begin(), document.end(), boundaries, chunkSize, results);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,648 @@
+//
+//  incremental_parser.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _LR_INCREMENTAL_PARSER_H
+#define _LR_INCREMENTAL_PARSER_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "TameParse/Dfa/incremental_lexer.h"
+#include "TameParse/Lr/parser.h"
+#include "TameParse/Lr/batch_parser.h"
+
+namespace lr {
+    ///
+    /// \brief Parser trace used by the incremental parser to track which symbols each item on the stack was built from
+    ///
+    /// This keeps a shadow of the parser stack that records the index of the first symbol covered by each entry.
+    /// The incremental parser calls begin_action() with the index of the lookahead symbol before each action.
+    ///
+    class incremental_parser_trace : public no_parser_trace {
+    public:
+        /// \brief Information about an entry on the parser stack
+        struct entry {
+            /// \brief The index of the first symbol covered by this entry
+            size_t start;
+
+            /// \brief The number of weak reduce tests that had been made when this entry was started
+            size_t weak_reductions;
+        };
+
+    private:
+        /// \brief The shadow stack
+        std::vector<entry> m_Stack;
+
+        /// \brief The index of the lookahead symbol for the current action
+        size_t m_Position;
+
+        /// \brief The number of weak reduce tests made so far
+        size_t m_WeakReductions;
+
+        /// \brief The number of weak reduce tests that had been made when the current action started
+        size_t m_ActionWeakReductions;
+
+        /// \brief Largest number of symbols examined by a guard during the current action
+        int m_GuardDepth;
+
+        /// \brief The entry for the nonterminal being reduced, which is pushed when the goto is performed
+        entry m_Reducing;
+
+        /// \brief The nonterminal being reduced
+        int m_ReducingNonterminal;
+
+        /// \brief True if a reduction has been performed but the goto has not
+        bool m_PendingGoto;
+
+        /// \brief True if the current action reduced a nonterminal and pushed it onto the stack
+        bool m_Reduced;
+
+        /// \brief True if the current action shifted a lexeme
+        bool m_DidShift;
+
+        /// \brief The lexeme shifted by the last action that performed a shift
+        lexeme_container m_Shifted;
+
+    public:
+        /// \brief Creates a trace for a parser whose stack only contains the initial state
+        incremental_parser_trace()
+        : m_Position(0)
+        , m_WeakReductions(0)
+        , m_ActionWeakReductions(0)
+        , m_GuardDepth(0)
+        , m_ReducingNonterminal(-1)
+        , m_PendingGoto(false)
+        , m_Reduced(false)
+        , m_DidShift(false)
+        , m_Shifted((lexeme*) NULL) {
+            entry initial = { 0, 0 };
+            m_Stack.push_back(initial);
+            m_Reducing = initial;
+        }
+
+        /// \brief Starts a new parser action with the symbol at the specified index in the lookahead
+        inline void begin_action(size_t position) {
+            m_Position              = position;
+            m_ActionWeakReductions  = m_WeakReductions;
+            m_GuardDepth            = 0;
+            m_PendingGoto           = false;
+            m_Reduced               = false;
+            m_DidShift              = false;
+        }
+
+        /// \brief Pushes an entry for a nonterminal that was reused from an earlier parse
+        inline void push_reused(size_t start) {
+            entry reused = { start, m_WeakReductions };
+            m_Stack.push_back(reused);
+        }
+
+        /// \brief The entry on top of the shadow stack
+        inline const entry& top() const { return m_Stack.back(); }
+
+        /// \brief True if the last action reduced a nonterminal and pushed it onto the stack
+        inline bool reduced() const { return m_Reduced; }
+
+        /// \brief True if the last action shifted a lexeme
+        inline bool did_shift() const { return m_DidShift; }
+
+        /// \brief The lexeme that was shifted by the last action
+        ///
+        /// For weak symbols that were shifted as their strong equivalent, this is a copy of the lexeme in the lookahead.
+        inline const lexeme_container& shifted() const { return m_Shifted; }
+
+        /// \brief The nonterminal that was reduced by the last action
+        inline int reduced_nonterminal() const { return m_ReducingNonterminal; }
+
+        /// \brief The number of weak reduce tests made so far
+        inline size_t weak_reductions() const { return m_WeakReductions; }
+
+        /// \brief Largest number of symbols examined by a guard during the last action
+        inline int guard_depth() const { return m_GuardDepth; }
+
+    public:
+        inline void shift(const lexeme_container& lookahead, int newState) {
+            entry shifted = { m_Position, m_ActionWeakReductions };
+            m_Stack.push_back(shifted);
+            m_DidShift  = true;
+            m_Shifted   = lookahead;
+        }
+
+        inline void reduce(int nonterminalId, int ruleId, int length) {
+            // Empty rules start at the lookahead, other rules start with the first symbol that they pop
+            entry reducing = { m_Position, m_ActionWeakReductions };
+
+            if (length > 0 && (size_t) length < m_Stack.size()) {
+                reducing = m_Stack[m_Stack.size() - length];
+                m_Stack.resize(m_Stack.size() - length);
+            }
+
+            m_Reducing              = reducing;
+            m_ReducingNonterminal   = nonterminalId;
+            m_PendingGoto           = true;
+        }
+
+        inline void goto_state(int newState) {
+            // Gotos that aren't part of a reduction just change the state on top of the stack
+            if (!m_PendingGoto) return;
+
+            m_Stack.push_back(m_Reducing);
+            m_PendingGoto   = false;
+            m_Reduced       = true;
+        }
+
+        inline void guard_depth(int initialState, int depth) {
+            if (depth > m_GuardDepth) m_GuardDepth = depth;
+        }
+
+        inline void weak_reduce(int symbolId, bool canReduce) {
+            ++m_WeakReductions;
+        }
+    };
+
+    ///
+    /// \brief Parser that can update the result of a parse after a small edit to the document
+    ///
+    /// The parser keeps the document, the symbols that the lexer produced for it and a copy of the parser state
+    /// (sharing its stack, so this is cheap) every few symbols. It also records, for each nonterminal that was
+    /// reduced, the parser state it was reduced from and the range of symbols that it covered and examined.
+    ///
+    /// When the document is edited, only the symbols around the edit are relexed by a dfa::incremental_lexer, which
+    /// saves the lexer state after every symbol and stops as soon as the new symbols line up with the old ones
+    /// again. Parsing resumes from the last saved state that did not look
+    /// at any of the changed symbols, so everything on its stack is reused. Once the parser gets past the edit,
+    /// any nonterminal that was built from unchanged symbols in the same parser state is pushed directly, without
+    /// parsing the symbols again. Nonterminals that depended on a weak reduction are always parsed again, as the
+    /// result of the test depends on the whole stack.
+    ///
+    /// Lexemes after the edit are reused by the new parse, and their positions are updated in place, so the
+    /// positions reported by reused items stay correct.
+    ///
+    /// The parser actions are created by actions_factory with a lexeme stream that reads nothing: the parser
+    /// states are given the lexed symbols directly.
+    ///
+    template<typename item_type, typename parser_actions, typename actions_factory = stream_actions_factory<parser_actions> >
+    class incremental_parser {
+    public:
+        /// \brief The type of parser used by the incremental parser
+        typedef parser<item_type, parser_actions, incremental_parser_trace> parser_type;
+
+        /// \brief The parser state type
+        typedef typename parser_type::state state;
+
+        /// \brief The type of the document being parsed
+        typedef dfa::incremental_lexer::text text;
+
+    private:
+        /// \brief List of lexemes
+        typedef dfa::incremental_lexer::lexeme_list lexeme_list;
+
+        ///
+        /// \brief Record of a nonterminal that was reduced by the parser
+        ///
+        struct reduction {
+            /// \brief The index of the first symbol covered by the nonterminal
+            size_t start;
+
+            /// \brief The index of the symbol after the last symbol covered by the nonterminal
+            size_t end;
+
+            /// \brief The index of the symbol after the last symbol the parser had examined when it was reduced
+            size_t depends_on;
+
+            /// \brief The state on the stack underneath the nonterminal
+            int state;
+
+            /// \brief The identifier of the nonterminal
+            int nonterminal;
+
+            /// \brief The item that the nonterminal was reduced to
+            item_type item;
+
+            /// \brief Orders reductions by their start position, longest first
+            inline bool operator<(const reduction& compareTo) const {
+                if (start < compareTo.start) return true;
+                if (start > compareTo.start) return false;
+
+                return end > compareTo.end;
+            }
+
+            /// \brief Orders reductions by their start position only
+            inline static bool starts_before(const reduction& a, size_t b) {
+                return a.start < b;
+            }
+        };
+
+        /// \brief List of reductions
+        typedef std::vector<reduction> reduction_list;
+
+        ///
+        /// \brief A copy of the parser state that the parser can be resumed from
+        ///
+        struct checkpoint {
+            /// \brief The parser state
+            state* snapshot;
+
+            /// \brief The position of the parser state in the list of symbols
+            size_t position;
+
+            /// \brief The index of the symbol after the last symbol the parser had examined when the copy was made
+            size_t depends_on;
+        };
+
+        /// \brief List of checkpoints
+        typedef std::vector<checkpoint> checkpoint_list;
+
+        /// \brief A range of symbols
+        typedef std::pair<size_t, size_t> span;
+
+        /// \brief A copy of a symbol made by the parser (weak symbols are copied when they are shifted as their strong equivalent)
+        typedef std::pair<size_t, dfa::lexeme_container> copied_symbol;
+
+        /// \brief List of copied symbols
+        typedef std::vector<copied_symbol> copied_symbol_list;
+
+        /// \brief Orders copied symbols by the index of the original symbol
+        inline static bool copied_before(const copied_symbol& a, const copied_symbol& b) {
+            return a.first < b.first;
+        }
+
+    private:
+        /// \brief The parser
+        parser_type m_Parser;
+
+        /// \brief The document and the symbols that the lexer produced for it
+        dfa::incremental_lexer m_Lexer;
+
+        /// \brief The initial parser state
+        int m_InitialState;
+
+        /// \brief The number of symbols between checkpoints
+        size_t m_CheckpointInterval;
+
+        /// \brief The nonterminals that have been reduced so far
+        reduction_list m_Reductions;
+
+        /// \brief Nonterminals from before the last edit which might be reused, sorted by position
+        reduction_list m_Reusable;
+
+        /// \brief The ranges of symbols covered by the nonterminals that were reused by the current parse
+        std::vector<span> m_ReusedSpans;
+
+        /// \brief Copies of symbols that have been shifted, along with the index of the original symbol
+        ///
+        /// These need to be moved along with the original symbols when the document is edited.
+        copied_symbol_list m_CopiedSymbols;
+
+        /// \brief Copied symbols from before the last edit which might be in a reused nonterminal
+        copied_symbol_list m_ReusableCopies;
+
+        /// \brief Saved copies of the parser state, in order
+        checkpoint_list m_Checkpoints;
+
+        /// \brief The parser state, or NULL if nothing has been parsed yet
+        state* m_State;
+
+        /// \brief The index of the symbol after the last symbol the parser has examined
+        size_t m_DependsOn;
+
+        /// \brief The index of the first symbol that is unchanged after the last edit
+        size_t m_ReuseFrom;
+
+        /// \brief True if the document was accepted by the parser
+        bool m_Accepted;
+
+        /// \brief The number of nonterminals reused by the last parse
+        size_t m_NonterminalsReused;
+
+        incremental_parser(const incremental_parser& noCopying);
+        incremental_parser& operator=(const incremental_parser& noCopying);
+
+    public:
+        ///
+        /// \brief Creates an incremental parser that will use the specified parser tables and lexer
+        ///
+        /// The lexer must already be compiled. A copy of the parser state is kept every checkpointInterval symbols:
+        /// larger values use less memory but mean that more symbols are parsed again after an edit. The lexer state
+        /// is much smaller, and is saved after every symbol so that only the symbols that changed are relexed.
+        ///
+        incremental_parser(const parser_tables& tables, const dfa::basic_lexer& lexer, int initialState = 0, size_t checkpointInterval = 64)
+        : m_Parser(&tables, false)
+        , m_Lexer(lexer, 1)
+        , m_InitialState(initialState)
+        , m_CheckpointInterval(checkpointInterval > 0 ? checkpointInterval : 1)
+        , m_State(NULL)
+        , m_DependsOn(0)
+        , m_ReuseFrom(0)
+        , m_Accepted(false)
+        , m_NonterminalsReused(0) {
+        }
+
+        /// \brief Destructor
+        ~incremental_parser() {
+            clear_states(0);
+        }
+
+    private:
+        /// \brief Destroys the parser state and the checkpoints after the specified number of checkpoints
+        void clear_states(size_t keepCheckpoints) {
+            // The later states are destroyed first, so the session never has to look for a new minimum position
+            delete m_State;
+            m_State = NULL;
+
+            while (m_Checkpoints.size() > keepCheckpoints) {
+                delete m_Checkpoints.back().snapshot;
+                m_Checkpoints.pop_back();
+            }
+        }
+
+        /// \brief Saves a copy of the current parser state if it has moved far enough past the last checkpoint
+        inline void add_checkpoint() {
+            size_t position = m_State->lookahead_position();
+            if (position < m_Checkpoints.back().position + m_CheckpointInterval) return;
+
+            checkpoint newCheckpoint = { new state(*m_State), position, m_DependsOn };
+            m_Checkpoints.push_back(newCheckpoint);
+        }
+
+        /// \brief Pushes a nonterminal from the previous parse that starts at the specified position, if one can be reused
+        bool reuse(size_t position) {
+            int currentState = m_State->get_stack()->state;
+
+            for (typename reduction_list::iterator candidate = std::lower_bound(m_Reusable.begin(), m_Reusable.end(), position, reduction::starts_before);
+                 candidate != m_Reusable.end() && candidate->start == position;
+                 ++candidate) {
+                // The nonterminal must have been reduced in the same state
+                if (candidate->state != currentState) continue;
+
+                // Push it and skip the symbols it covers
+                if (!m_State->shift_nonterminal(candidate->nonterminal, candidate->item, candidate->end - candidate->start)) continue;
+
+                m_State->get_trace().push_reused(position);
+                if (candidate->depends_on > m_DependsOn) m_DependsOn = candidate->depends_on;
+
+                m_ReusedSpans.push_back(span(candidate->start, candidate->end));
+                ++m_NonterminalsReused;
+                return true;
+            }
+
+            return false;
+        }
+
+        /// \brief Runs the parser until the document is accepted or rejected
+        void run() {
+            for (;;) {
+                size_t position = m_State->lookahead_position();
+
+                // Push an unchanged nonterminal from the previous parse if there is one
+                if (position >= m_ReuseFrom && !m_Reusable.empty() && reuse(position)) {
+                    add_checkpoint();
+                    continue;
+                }
+
+                // Perform the next action
+                incremental_parser_trace& trace = m_State->get_trace();
+                trace.begin_action(position);
+
+                parser_result::result result = m_State->process();
+
+                // Remember any copy of the lookahead that was shifted
+                const lexeme_list& symbols = m_Lexer.lexemes();
+                
+                if (trace.did_shift() && position < symbols.size() && trace.shifted().item() != symbols[position].item()) {
+                    m_CopiedSymbols.push_back(copied_symbol(position, trace.shifted()));
+                }
+
+                // Work out how far the parser has looked
+                size_t examined = position + (trace.guard_depth() > 1 ? trace.guard_depth() : 1);
+                if (examined > m_DependsOn) m_DependsOn = examined;
+
+                // Record any nonterminal that was reduced (unless a weak reduction was tested while it was being parsed)
+                if (trace.reduced() && trace.top().weak_reductions == trace.weak_reductions()) {
+                    reduction reduced;
+
+                    reduced.start       = trace.top().start;
+                    reduced.end         = position;
+                    reduced.depends_on  = m_DependsOn;
+                    reduced.state       = m_State->get_stack()[-1].state;
+                    reduced.nonterminal = trace.reduced_nonterminal();
+                    reduced.item        = m_State->get_item();
+
+                    m_Reductions.push_back(reduced);
+                }
+
+                // Stop if the document was accepted or rejected
+                if (result != parser_result::more) {
+                    m_Accepted = result == parser_result::accept;
+                    break;
+                }
+
+                add_checkpoint();
+            }
+
+            // Keep the reused nonterminals (and the nonterminals and copied symbols inside them) so they can be reused again
+            typename std::vector<span>::const_iterator reusedSpan = m_ReusedSpans.begin();
+
+            for (typename reduction_list::const_iterator candidate = m_Reusable.begin(); candidate != m_Reusable.end() && reusedSpan != m_ReusedSpans.end(); ++candidate) {
+                while (reusedSpan != m_ReusedSpans.end() && reusedSpan->second <= candidate->start) ++reusedSpan;
+                if (reusedSpan == m_ReusedSpans.end()) break;
+
+                if (reusedSpan->first <= candidate->start && candidate->end <= reusedSpan->second) {
+                    m_Reductions.push_back(*candidate);
+                }
+            }
+
+            reusedSpan = m_ReusedSpans.begin();
+
+            for (typename copied_symbol_list::const_iterator copied = m_ReusableCopies.begin(); copied != m_ReusableCopies.end() && reusedSpan != m_ReusedSpans.end(); ++copied) {
+                while (reusedSpan != m_ReusedSpans.end() && reusedSpan->second <= copied->first) ++reusedSpan;
+                if (reusedSpan == m_ReusedSpans.end()) break;
+
+                if (reusedSpan->first <= copied->first) {
+                    m_CopiedSymbols.push_back(*copied);
+                }
+            }
+
+            m_Reusable.clear();
+            m_ReusableCopies.clear();
+            m_ReusedSpans.clear();
+        }
+
+    public:
+        ///
+        /// \brief Parses a new document, discarding anything that was remembered about the previous one
+        ///
+        /// Returns true if the document was accepted.
+        ///
+        bool parse(const text& document) {
+            clear_states(0);
+            m_Reductions.clear();
+            m_CopiedSymbols.clear();
+
+            // Lex the whole document
+            m_Lexer.lex(document);
+            m_NonterminalsReused = 0;
+
+            // Create the parser state, and give it the symbols
+            const lexeme_list&  symbols     = m_Lexer.lexemes();
+            dfa::lexeme_stream* noSymbols   = m_Lexer.lexer().create_stream(new dfa::text_symbol_stream());
+
+            m_State = m_Parser.create_parser(actions_factory::create(noSymbols), m_InitialState);
+            m_State->replace_lookahead(symbols.begin(), symbols.end());
+
+            // The first checkpoint is the initial state
+            checkpoint initial = { new state(*m_State), 0, 0 };
+            m_Checkpoints.push_back(initial);
+
+            // Run the parser
+            m_DependsOn = 0;
+            m_ReuseFrom = symbols.size();
+            run();
+
+            return m_Accepted;
+        }
+
+        ///
+        /// \brief Replaces length characters starting at offset in the document with the specified text, and parses the result
+        ///
+        /// Returns true if the new document was accepted.
+        ///
+        bool edit(size_t offset, size_t length, const text& replacement) {
+            // Keep the edit inside the document
+            const text& oldText = m_Lexer.document();
+            
+            if (offset > oldText.size())            offset = oldText.size();
+            if (length > oldText.size() - offset)   length = oldText.size() - offset;
+
+            // Parse from scratch if nothing has been parsed yet
+            if (m_State == NULL) {
+                text newText = oldText;
+                newText.replace(offset, length, replacement);
+                return parse(newText);
+            }
+
+            // Relex the symbols that changed (the unchanged symbols after them are moved to their new positions)
+            m_Lexer.edit(offset, length, replacement);
+            
+            size_t firstChanged     = m_Lexer.first_changed();
+            size_t firstUnchanged   = firstChanged + m_Lexer.lexemes_removed();
+            size_t reuseFrom        = firstChanged + m_Lexer.lexemes_lexed();
+
+            // Move the copies of the unchanged symbols as well
+            for (typename copied_symbol_list::const_iterator copied = m_CopiedSymbols.begin(); copied != m_CopiedSymbols.end(); ++copied) {
+                if (copied->first >= firstUnchanged) {
+                    // The copies are shared with the items that the parser produced, so this updates them as well
+                    dfa::lexeme* lexeme = const_cast<dfa::lexeme*>(copied->second.item());
+                    lexeme->set_position(m_Lexer.moved(lexeme->pos()));
+                }
+            }
+
+            m_NonterminalsReused = 0;
+
+            // Resume from the last checkpoint that didn't look at any of the changed symbols
+            size_t resumeFrom = m_Checkpoints.size() - 1;
+            while (resumeFrom > 0 && m_Checkpoints[resumeFrom].depends_on > firstChanged) --resumeFrom;
+
+            const checkpoint& resume = m_Checkpoints[resumeFrom];
+            clear_states(resumeFrom + 1);
+
+            // Keep the nonterminals that were reduced before the checkpoint, and move the ones after the edit
+            reduction_list kept;
+
+            for (typename reduction_list::iterator reduced = m_Reductions.begin(); reduced != m_Reductions.end(); ++reduced) {
+                if (reduced->depends_on <= resume.position) {
+                    kept.push_back(*reduced);
+                } else if (reduced->start >= firstUnchanged && reduced->end > reduced->start) {
+                    reduced->start      = reduced->start + reuseFrom - firstUnchanged;
+                    reduced->end        = reduced->end + reuseFrom - firstUnchanged;
+                    reduced->depends_on = reduced->depends_on + reuseFrom - firstUnchanged;
+                    m_Reusable.push_back(*reduced);
+                }
+            }
+
+            m_Reductions.swap(kept);
+            std::sort(m_Reusable.begin(), m_Reusable.end());
+
+            // Do the same for the copied symbols
+            copied_symbol_list keptCopies;
+
+            for (typename copied_symbol_list::iterator copied = m_CopiedSymbols.begin(); copied != m_CopiedSymbols.end(); ++copied) {
+                if (copied->first < resume.position) {
+                    keptCopies.push_back(*copied);
+                } else if (copied->first >= firstUnchanged) {
+                    copied->first = copied->first + reuseFrom - firstUnchanged;
+                    m_ReusableCopies.push_back(*copied);
+                }
+            }
+
+            m_CopiedSymbols.swap(keptCopies);
+            std::sort(m_ReusableCopies.begin(), m_ReusableCopies.end(), copied_before);
+
+            // Parse from the checkpoint
+            const lexeme_list& symbols = m_Lexer.lexemes();
+            
+            m_State = new state(*resume.snapshot);
+            m_State->replace_lookahead(symbols.begin() + resume.position, symbols.end());
+
+            m_DependsOn = resume.depends_on;
+            m_ReuseFrom = reuseFrom;
+            run();
+
+            return m_Accepted;
+        }
+
+    public:
+        /// \brief The document that was parsed
+        inline const text& document() const { return m_Lexer.document(); }
+
+        /// \brief True if the document was accepted by the parser
+        inline bool accepted() const { return m_Accepted; }
+
+        /// \brief The item that the document was reduced to, if it was accepted
+        inline const item_type& item() const { return m_State->get_item(); }
+
+        /// \brief The position of the symbol that was rejected if the document was not accepted
+        ///
+        /// This is (-1, -1, -1) if the document was rejected at the end of the input.
+        inline dfa::position error_position() const {
+            size_t              position    = m_State->lookahead_position();
+            const lexeme_list&  symbols     = m_Lexer.lexemes();
+            if (position >= symbols.size()) return dfa::position(-1, -1, -1);
+
+            return symbols[position]->pos();
+        }
+
+        /// \brief The number of symbols in the document
+        inline size_t symbol_count() const { return m_Lexer.lexemes().size(); }
+
+        /// \brief The number of symbols produced by the lexer for the last parse or edit
+        inline size_t symbols_lexed() const { return m_Lexer.lexemes_lexed(); }
+
+        /// \brief The number of nonterminals from the previous parse that were reused by the last edit
+        inline size_t nonterminals_reused() const { return m_NonterminalsReused; }
+    };
+}
+
+#endif
@@ -122,6 +122,15 @@ void lalr_builder::create_closure(closure_set& target, const lalr_state& state,
 
 /// \brief Finishes building the parser (the LALR machine will contain a LALR parser after this call completes)
 void lalr_builder::complete_parser() {
+    // Build the LR(0) machine
+    complete_lr0_machine();
+    
+    // Need the lookaheads to build a complete parser
+    complete_lookaheads();
+}
+
+/// \brief Builds the states and transitions of the parser (the LALR machine will contain a LR(0) parser after this call completes)
+void lalr_builder::complete_lr0_machine() {
     empty_item      empty;
 
     // Queue of states that still need to be processed
@@ -221,9 +230,6 @@ void lalr_builder::complete_parser() {
             }
         }
     }
-    
-    // Need the lookaheads to build a complete parser
-    complete_lookaheads();
 }
  
 /// \brief Generates the lookaheads for the parser (when the machine has been built up as a LR(0) grammar)
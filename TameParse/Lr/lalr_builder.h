@@ -141,8 +141,13 @@ namespace lr {
         int add_initial_state(const contextfree::item_container& language);
         
         /// \brief Finishes building the parser (the LALR machine will contain a LALR parser after this call completes)
+        ///
+        /// This is the same as calling complete_lr0_machine() followed by complete_lookaheads()
         void complete_parser();
         
+        /// \brief Builds the states and transitions of the parser (the LALR machine will contain a LR(0) parser after this call completes)
+        void complete_lr0_machine();
+        
         /// \brief Generates the lookaheads for the parser (when the machine has been built up as a LR(0) grammar)
         void complete_lookaheads();
         
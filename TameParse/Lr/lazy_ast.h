@@ -0,0 +1,208 @@
+//
+//  lazy_ast.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _LR_LAZY_AST_H
+#define _LR_LAZY_AST_H
+
+#include <vector>
+#include <map>
+
+#include "TameParse/Lr/reduction_log.h"
+
+namespace lr {
+    ///
+    /// \brief Builds the AST for parts of a reduction log when they are requested
+    ///
+    /// The nodes are built by replaying the log into a parser actions object of the type that would normally
+    /// be used to build the AST (for example, the parser_actions class generated by the parser tool). Each node
+    /// is built at most once, and nodes that are never requested are not built at all.
+    ///
+    /// get() only builds the requested node: terminal symbols in its rule are filled in, but nonterminals are
+    /// left empty until they are fetched with child(). get_tree() builds a node along with everything below it,
+    /// giving the same result as the normal parser.
+    ///
+    /// The log must outlive this object.
+    ///
+    template<typename actions_type> class lazy_ast {
+    public:
+        /// \brief The type of the list of items passed to a reduce action
+        typedef typename actions_type::reduce_list reduce_list;
+
+        /// \brief The type of a node in the AST
+        typedef typename reduce_list::value_type node;
+
+        /// \brief Identifies an entry in the log
+        typedef reduction_log::entry_id entry_id;
+
+    private:
+        /// \brief Maps log entries to the nodes built for them
+        typedef std::map<entry_id, node> node_map;
+
+        /// \brief The log that the nodes are built from
+        const reduction_log& m_Log;
+
+        /// \brief The actions used to build the nodes (these have no stream)
+        actions_type m_Actions;
+
+        /// \brief The nodes built by get() (terminal nodes are shared with get_tree())
+        node_map m_Nodes;
+
+        /// \brief The nodes built by get_tree()
+        node_map m_Trees;
+
+        /// \brief Item passed to the actions in place of the nonterminals that get() doesn't build
+        node m_Empty;
+
+        /// \brief Scratch list of items passed to the actions
+        reduce_list m_Items;
+
+        /// \brief Scratch list of child entries
+        std::vector<entry_id> m_Children;
+
+        lazy_ast(const lazy_ast& noCopying);
+        lazy_ast& operator=(const lazy_ast& noCopying);
+
+        /// \brief Retrieves the node for a terminal entry, building it if necessary
+        const node& terminal(entry_id id);
+
+    public:
+        /// \brief Creates an object that builds nodes from the specified log
+        lazy_ast(const reduction_log& log)
+        : m_Log(log)
+        , m_Actions(NULL) {
+        }
+
+        /// \brief The log used by this object
+        inline const reduction_log& log() const { return m_Log; }
+
+        /// \brief The number of items in the rule reduced for the specified entry (0 for terminals)
+        inline size_t count_children(entry_id id) const { return m_Log[id].length; }
+
+        /// \brief Retrieves the node for the specified log entry, building it if necessary
+        ///
+        /// The nonterminals in the node's rule are not built, and are passed to the actions as empty items. They
+        /// can be retrieved with child().
+        const node& get(entry_id id);
+
+        /// \brief Retrieves the node for a child of the specified entry, building it if necessary
+        ///
+        /// Children are numbered in the order that they appear in the rule.
+        inline const node& child(entry_id id, size_t index) {
+            m_Log.children(id, m_Children);
+            return get(m_Children[index]);
+        }
+
+        /// \brief Retrieves the node for the specified log entry along with all of its children, building them if necessary
+        const node& get_tree(entry_id id);
+    };
+
+    /// \brief Retrieves the node for a terminal entry, building it if necessary
+    template<typename actions_type> const typename lazy_ast<actions_type>::node& lazy_ast<actions_type>::terminal(entry_id id) {
+        typename node_map::iterator found = m_Nodes.find(id);
+        if (found != m_Nodes.end()) return found->second;
+
+        node& result = m_Nodes[id];
+        result = m_Actions.shift(m_Log.lexeme(id));
+        return result;
+    }
+
+    /// \brief Retrieves the node for the specified log entry, building it if necessary
+    template<typename actions_type> const typename lazy_ast<actions_type>::node& lazy_ast<actions_type>::get(entry_id id) {
+        if (m_Log.is_terminal(id)) return terminal(id);
+
+        // Nothing to do if this node has already been built
+        typename node_map::iterator found = m_Nodes.find(id);
+        if (found != m_Nodes.end()) return found->second;
+
+        // Only the terminal children are built (the children are passed in reverse order, as they would be by the parser)
+        m_Items.clear();
+        for (entry_id child = m_Log.last_child(id); child != reduction_log::no_entry; child = m_Log.previous_sibling(id, child)) {
+            if (m_Log.is_terminal(child)) {
+                m_Items.push_back(terminal(child));
+            } else {
+                m_Items.push_back(m_Empty);
+            }
+        }
+
+        const reduction_log::entry& reduction = m_Log[id];
+
+        node& result = m_Nodes[id];
+        result = m_Actions.reduce(reduction.symbol, reduction.rule, m_Items, reduction.lookahead);
+        return result;
+    }
+
+    /// \brief Retrieves the node for the specified log entry along with all of its children, building them if necessary
+    template<typename actions_type> const typename lazy_ast<actions_type>::node& lazy_ast<actions_type>::get_tree(entry_id id) {
+        if (m_Log.is_terminal(id)) return terminal(id);
+
+        // Nothing to do if this tree has already been built
+        typename node_map::iterator found = m_Trees.find(id);
+        if (found != m_Trees.end()) return found->second;
+
+        // Children must be built before their parents. Lists can be very deep, so this uses an explicit stack
+        // rather than recursion.
+        std::vector<entry_id> pending;
+
+        pending.push_back(id);
+        while (!pending.empty()) {
+            entry_id next = pending.back();
+
+            // Skip nodes that were built since they were added to the stack
+            if (m_Trees.find(next) != m_Trees.end()) {
+                pending.pop_back();
+                continue;
+            }
+
+            // Queue any children that haven't been built yet
+            bool ready = true;
+            for (entry_id child = m_Log.last_child(next); child != reduction_log::no_entry; child = m_Log.previous_sibling(next, child)) {
+                if (!m_Log.is_terminal(child) && m_Trees.find(child) == m_Trees.end()) {
+                    pending.push_back(child);
+                    ready = false;
+                }
+            }
+
+            if (!ready) continue;
+
+            // Reduce the children (these are passed in reverse order, as they would be by the parser)
+            m_Items.clear();
+            for (entry_id child = m_Log.last_child(next); child != reduction_log::no_entry; child = m_Log.previous_sibling(next, child)) {
+                if (m_Log.is_terminal(child)) {
+                    m_Items.push_back(terminal(child));
+                } else {
+                    m_Items.push_back(m_Trees[child]);
+                }
+            }
+
+            const reduction_log::entry& reduction = m_Log[next];
+            m_Trees[next] = m_Actions.reduce(reduction.symbol, reduction.rule, m_Items, reduction.lookahead);
+            pending.pop_back();
+        }
+
+        return m_Trees[id];
+    }
+}
+
+#endif
@@ -29,6 +29,7 @@
 #define _LR_PARSER_H
 
 #include <vector>
+#include <deque>
 #include <stack>
 #include <iostream>
 
@@ -54,7 +55,103 @@ namespace lr {
             accept
         };
     };
-    
+
+    ///
+    /// \brief Settings that control how a parser state recovers from syntax errors
+    ///
+    /// Parser states don't try to recover from errors unless they are given a set of these settings by calling
+    /// parser::state::set_recovery().
+    ///
+    struct recovery_options {
+        /// \brief Creates the default settings, using the specified terminal symbol in error productions
+        explicit recovery_options(int errorSymbol = -1)
+        : error_symbol(errorSymbol)
+        , try_repairs(true)
+        , repair_distance(3)
+        , max_errors(100) { }
+
+        /// \brief The terminal symbol used in the error productions of the grammar, or -1 if there isn't one
+        ///
+        /// This is the symbol called 'error' in the grammar definition language. The lexer never produces it.
+        int error_symbol;
+
+        /// \brief True if the parser should try inserting, deleting or replacing a single symbol before it
+        /// unwinds the stack
+        bool try_repairs;
+
+        /// \brief The number of symbols that must be parsed after a repair for it to be used
+        ///
+        /// Errors found within this many symbols of the point where the parser recovered from an earlier error
+        /// are assumed to be caused by it, and are not reported.
+        int repair_distance;
+
+        /// \brief The parser gives up after recovering from this many errors (0 to never give up)
+        int max_errors;
+    };
+
+    ///
+    /// \brief Description of a syntax error that a parser state has recovered from
+    ///
+    struct syntax_error {
+        /// \brief The ways that the parser can recover from an error
+        enum recovery {
+            /// \brief The rejected symbol was removed from the input
+            deleted,
+
+            /// \brief A symbol was inserted before the rejected symbol
+            inserted,
+
+            /// \brief The rejected symbol was replaced by a different one
+            replaced,
+
+            /// \brief Entries were discarded from the stack and symbols were skipped until the parser could carry on
+            ///
+            /// If the grammar has an error production that could be used, repair_symbol is the error symbol, which
+            /// is inserted before the first symbol that was not skipped.
+            skipped,
+
+            /// \brief The parser could not recover from this error (or had already found too many), and stopped
+            stopped
+        };
+
+        /// \brief Creates a description of an error at the end of the input
+        syntax_error()
+        : pos(-1, -1, -1)
+        , symbol(-1)
+        , repair(skipped)
+        , repair_symbol(-1)
+        , skipped_symbols(0)
+        , popped_states(0) { }
+
+        /// \brief True if the specified terminal symbol was one of the symbols that the parser could have accepted
+        inline bool is_expected(int terminal) const {
+            return terminal >= 0 && (size_t) (terminal / 32) < expected.size() && (expected[terminal / 32] & (1u << (terminal % 32))) != 0;
+        }
+
+        /// \brief The position of the rejected symbol (-1, -1, -1 if the input ended too early)
+        dfa::position pos;
+
+        /// \brief The rejected symbol (the end of input symbol if the input ended too early)
+        int symbol;
+
+        /// \brief How the parser recovered from this error
+        recovery repair;
+
+        /// \brief The symbol that was inserted into the input, or -1
+        int repair_symbol;
+
+        /// \brief The number of symbols that were discarded from the input
+        int skipped_symbols;
+
+        /// \brief The number of entries that were discarded from the stack
+        int popped_states;
+
+        /// \brief Bitset of the terminal symbols that the parser could have accepted instead of the rejected symbol
+        ///
+        /// Bit (n%32) of entry (n/32) is set for terminal n (see parser::state::expected_terminals())
+        std::vector<unsigned int> expected;
+    };
+
     ///
     /// \brief Parser trace class that performs no actions
     ///
@@ -74,6 +171,15 @@ namespace lr {
         inline void goto_state(int newState)                                { }
         inline void checked_guard(int initialState, int result)             { }
         inline void reject(const lexeme_container& lookahead)               { }
+        
+        /// \brief A guard starting at initialState finished after looking at the specified number of lookahead symbols
+        inline void guard_depth(int initialState, int depth)                { }
+        
+        /// \brief A weak reduce action was tested against the stack to see if the symbol would be shifted
+        inline void weak_reduce(int symbolId, bool canReduce)               { }
+        
+        /// \brief A symbol was read into the lookahead, which now contains the specified number of symbols
+        inline void lookahead_size(size_t size)                             { }
     };
     
     ///
@@ -113,9 +219,154 @@ namespace lr {
         }
     };
 
+    ///
+    /// \brief Counts of the actions performed by a parser, as collected by stats_parser_trace
+    ///
+    struct parser_stats {
+        /// \brief Creates a new set of statistics with all the counts set to zero
+        parser_stats()
+        : shifts(0)
+        , reductions(0)
+        , ignored(0)
+        , rejected(0)
+        , guard_checks(0)
+        , guards_matched(0)
+        , guard_symbols(0)
+        , max_guard_depth(0)
+        , weak_reduce_lookups(0)
+        , weak_reduce_succeeded(0)
+        , max_lookahead(0)
+        , stack_depth(1)
+        , max_stack_depth(1) { }
+        
+        /// \brief Number of symbols shifted onto the stack
+        size_t shifts;
+        
+        /// \brief Number of reductions performed
+        size_t reductions;
+        
+        /// \brief Number of reductions performed for each rule, indexed by rule ID
+        std::vector<size_t> rule_reductions;
+        
+        /// \brief Number of symbols that were ignored
+        size_t ignored;
+        
+        /// \brief Number of symbols that were rejected
+        size_t rejected;
+        
+        /// \brief Number of guards that were checked (including guards that were checked from within other guards)
+        size_t guard_checks;
+        
+        /// \brief Number of guard checks made by the parser that matched a guard symbol
+        size_t guards_matched;
+        
+        /// \brief Total number of lookahead symbols examined while checking guards
+        size_t guard_symbols;
+        
+        /// \brief Largest number of lookahead symbols examined by a single guard
+        size_t max_guard_depth;
+        
+        /// \brief Number of weak reduce actions that were tested against the stack
+        size_t weak_reduce_lookups;
+        
+        /// \brief Number of weak reduce tests that resulted in the reduction being performed
+        size_t weak_reduce_succeeded;
+        
+        /// \brief Largest number of symbols held in the lookahead at once
+        size_t max_lookahead;
+        
+        /// \brief Current depth of the parser stack
+        size_t stack_depth;
+        
+        /// \brief Largest depth reached by the parser stack
+        size_t max_stack_depth;
+    };
+    
+    ///
+    /// \brief Parser trace class that collects statistics about the actions performed by the parser
+    ///
+    /// The statistics for a parser state can be retrieved after a parse by calling get_trace().stats()
+    ///
+    class stats_parser_trace : public no_parser_trace {
+    private:
+        /// \brief The statistics collected so far
+        parser_stats m_Stats;
+        
+    public:
+        /// \brief The statistics collected so far
+        inline const parser_stats& stats() const { return m_Stats; }
+        
+        /// \brief Resets the statistics
+        inline void clear() { m_Stats = parser_stats(); }
+        
+    public:
+        inline void ignore(const lexeme_container& lookahead) {
+            ++m_Stats.ignored;
+        }
+        
+        inline void shift(const lexeme_container& lookahead, int newState) {
+            ++m_Stats.shifts;
+            push_stack(1);
+        }
+        
+        inline void reduce(int nonterminalId, int ruleId, int length) {
+            ++m_Stats.reductions;
+            
+            if (ruleId >= 0) {
+                if ((size_t) ruleId >= m_Stats.rule_reductions.size()) {
+                    m_Stats.rule_reductions.resize(ruleId + 1, 0);
+                }
+                ++m_Stats.rule_reductions[ruleId];
+            }
+            
+            // Symbols are popped from the stack and the goto state for the rule is pushed in their place
+            m_Stats.stack_depth -= length;
+            push_stack(1);
+        }
+        
+        inline void checked_guard(int initialState, int result) {
+            if (result >= 0) ++m_Stats.guards_matched;
+        }
+        
+        inline void reject(const lexeme_container& lookahead) {
+            ++m_Stats.rejected;
+        }
+        
+        inline void guard_depth(int initialState, int depth) {
+            ++m_Stats.guard_checks;
+            m_Stats.guard_symbols += depth;
+            if ((size_t) depth > m_Stats.max_guard_depth) m_Stats.max_guard_depth = depth;
+        }
+        
+        inline void weak_reduce(int symbolId, bool canReduce) {
+            ++m_Stats.weak_reduce_lookups;
+            if (canReduce) ++m_Stats.weak_reduce_succeeded;
+        }
+        
+        inline void lookahead_size(size_t size) {
+            if (size > m_Stats.max_lookahead) m_Stats.max_lookahead = size;
+        }
+        
+    private:
+        /// \brief Pushes entries onto the stack
+        inline void push_stack(size_t count) {
+            m_Stats.stack_depth += count;
+            if (m_Stats.stack_depth > m_Stats.max_stack_depth) m_Stats.max_stack_depth = m_Stats.stack_depth;
+        }
+    };
+
     ///
     /// \brief Generic parser implementation.
     ///
+    /// A parser object is immutable once it has been constructed, so a single parser (and the tables it uses) can
+    /// be shared between threads. Each state created by create_parser() belongs to its own session, which owns the
+    /// lookahead and the parser actions: states from different sessions can be run on different threads at the same
+    /// time without any locking. States that share a session (ie, states that were copied from one another) must
+    /// only be used from one thread at a time.
+    ///
+    /// The reference counts used by the lexemes and the items on the stack are not atomic, so items should not be
+    /// shared between sessions that are running on different threads.
+    ///
     template<typename item_type, typename parser_actions, typename parser_trace = no_parser_trace> class parser {
     private:
         /// \brief The parser tables
@@ -138,6 +389,9 @@ namespace lr {
         /// \brief List of items passed to a reduce action
         typedef std::vector<item_type> reduce_list;
         
+        /// \brief List of the syntax errors that a state has recovered from
+        typedef std::vector<syntax_error> error_list;
+        
         /// \brief Forward declaration of the state class
         class state;
         
@@ -189,20 +443,46 @@ namespace lr {
         /// ensuring that the symbols remain in memory when they're needed, and are removed once there are
         /// no more states referring to them.
         ///
+        /// States store their lookahead position as an absolute offset into the stream of symbols. The
+        /// session keeps track of the minimum position across all of its states and the number of states
+        /// that are at that position, so symbols can be discarded without visiting every state each time
+        /// one of them moves on. With a single state, this reduces to popping the front of the lookahead.
+        ///
         class session {
         public:
             friend class state;
             
             /// \brief Session lookahead
-            typedef std::vector<dfa::lexeme_container> lookahead_list;
+            typedef std::deque<dfa::lexeme_container> lookahead_list;
             
         private:
             /// \brief The symbols that are in the parser lookahead
             lookahead_list m_Lookahead;
             
+            /// \brief The absolute position of the first symbol in m_Lookahead
+            size_t m_LookaheadBase;
+            
+            /// \brief The smallest lookahead position of any state in this session
+            size_t m_MinLookaheadPos;
+            
+            /// \brief The number of states whose lookahead position is m_MinLookaheadPos
+            int m_StatesAtMinimum;
+            
             /// \brief Set to true if we've reached the end of the file
             bool m_EndOfFile;
             
+            /// \brief True while symbols are being fed to a state (the actions are not asked to read symbols)
+            bool m_Pushing;
+            
+            /// \brief Set to true when a state being fed symbols runs out of lookahead
+            bool m_Starved;
+            
+            /// \brief Lexeme container returned as the lookahead once the end of the file has been reached
+            ///
+            /// This belongs to the session rather than being shared so that its reference count is never
+            /// updated by more than one thread.
+            lexeme_container m_EndOfFileLexeme;
+            
             /// \brief The first active state in the parser
             state* m_FirstState;
             
@@ -212,10 +492,29 @@ namespace lr {
         public:
             session(parser_actions* actions)
             : m_Actions(actions)
+            , m_LookaheadBase(0)
+            , m_MinLookaheadPos(0)
+            , m_StatesAtMinimum(0)
             , m_EndOfFile(false)
+            , m_Pushing(false)
+            , m_Starved(false)
+            , m_EndOfFileLexeme((lexeme*)NULL)
             , m_FirstState(NULL) {
             }
             
+        private:
+            /// \brief Registers a state at the specified lookahead position with this session
+            inline void add_state(size_t lookaheadPos);
+            
+            /// \brief Indicates that a state has left the specified lookahead position
+            ///
+            /// If this was the last state at the minimum position, the minimum is recalculated and any
+            /// symbols that are no longer needed are discarded.
+            inline void leave_position(size_t lookaheadPos);
+            
+            /// \brief Discards the lookahead and moves the session back to the start of the stream
+            inline void reset();
+            
             ~session() {
                 // We consider that the parser owns its own actions, so we destroy them here
                 delete m_Actions;
@@ -242,8 +541,8 @@ namespace lr {
             /// \brief The session that this is a part of
             session* m_Session;
             
-            /// \brief The position in the lookahead of this state
-            int m_LookaheadPos;
+            /// \brief The position in the lookahead of this state (relative to the start of the stream)
+            size_t m_LookaheadPos;
             
             /// \brief The next state in the state list
             state* m_NextState;
@@ -254,6 +553,23 @@ namespace lr {
             /// \brief The parser trace class
             parser_trace m_Trace;
             
+            /// \brief Scratch list used to pass items to the reduce action
+            ///
+            /// This is kept with the state so that its storage can be re-used between reductions
+            reduce_list m_ReduceItems;
+            
+            /// \brief True if this state should try to recover from syntax errors
+            bool m_RecoveryEnabled;
+            
+            /// \brief The settings used when recovering from a syntax error
+            recovery_options m_Recovery;
+            
+            /// \brief The syntax errors that this state has recovered from
+            error_list m_Errors;
+            
+            /// \brief The lookahead position of the first symbol read after the last recovery (or -1)
+            size_t m_ResumePos;
+            
         private:
             /// \brief States can't be assigned
             state& operator=(const state& noAssignment) { }
@@ -270,10 +586,6 @@ namespace lr {
             /// \brief Destructor
             ~state();
             
-        private:
-            /// \brief Trims the lookahead in the sessions (removes any symbols that won't be visited again)
-            inline void trim_lookahead();
-            
         public:
             ///
             /// \brief Moves on a single symbol (ie, throws away the current lookahead)
@@ -296,8 +608,14 @@ namespace lr {
             ///
             class standard_actions {
             private:
-                /// \brief The trace for these actions
-                parser_trace m_Trace;
+                /// \brief The trace for these actions (this belongs to the state being acted upon)
+                parser_trace& m_Trace;
+                
+            public:
+                /// \brief Creates a set of standard actions that report to the specified trace
+                explicit standard_actions(parser_trace& trace)
+                : m_Trace(trace) {
+                }
                 
             public:
                 /// \brief Ignore action
@@ -321,27 +639,36 @@ namespace lr {
                     m_Trace.reduce(rule.identifier, rule.ruleId, rule.length);
                     
                     // Pop items from the stack, and create an item for them by calling the actions
-                    reduce_list items;
-                    for (int x=0; x < rule.length; ++x) {
-                        items.push_back(state->m_Stack->item);
-                        state->m_Stack.pop();
+                    // If nothing else refers to the stack, then the popped entries can't be visited again, so we can
+                    // move their items instead of copying them.
+                    reduce_list& items = state->m_ReduceItems;
+                    items.clear();
+                    
+                    if (state->m_Stack.is_unique()) {
+                        for (int x=0; x < rule.length; ++x) {
+                            items.push_back(std::move(state->m_Stack->item));
+                            state->m_Stack.pop();
+                        }
+                    } else {
+                        for (int x=0; x < rule.length; ++x) {
+                            items.push_back(state->m_Stack->item);
+                            state->m_Stack.pop();
+                        }
                     }
                     
                     // Fetch the state that's now on top of the stack
                     int gotoState = state->m_Stack->state;
                     
                     // Work out the lookahead position
+                    // At the end of the file, we use an invalid position
+                    // (Alternatively: modify the actions so it's possible to retrieve the current position)
                     const lexeme_container& la              = state->look();
-                    const dfa::position*    lookaheadPos    = NULL;
+                    const dfa::position     eofPos(-1, -1, -1);
+                    const dfa::position*    lookaheadPos    = &eofPos;
                     
-                    if (state->look().item()) {
+                    if (la.item()) {
                         // Still following symbols
                         lookaheadPos = &la->pos();
-                    } else {
-                        // At end: use an invalid position
-                        // (Alternatively: modify the actions so it's possible to retrieve the current position)
-                        static const dfa::position eofPos(-1, -1, -1);
-                        lookaheadPos = &eofPos;
                     }
                     
                     // Get the goto action for this nonterminal
@@ -351,13 +678,17 @@ namespace lr {
                         if (gotoAct->type == lr_action::act_goto) {
                             // Found the goto action, perform the reduction
                             // (Note that this will perform the goto action for the next nonterminal if the nonterminal isn't in this state. This can only happen if the parser is in an invalid state)
+                            // The actions may move items out of the reduce list: it is cleared before it is next used
                             state->m_Stack.push(gotoAct->nextState, state->m_Session->m_Actions->reduce(rule.identifier, rule.ruleId, items, *lookaheadPos));
                             
                             // Tell the trace about this
                             m_Trace.goto_state(gotoAct->nextState);
                             break;
                         }
-                    }                    
+                    }
+                    
+                    // Release anything the actions left behind
+                    items.clear();
                 }
                 
                 /// \brief Sets the current state of the parser
@@ -408,7 +739,9 @@ namespace lr {
                     state->fake_reduce(act, stackPos, fakeStack, state->m_Stack);
 
                     // Do a can_reduce on what remains
-                    return state->template can_reduce<terminal_fetcher>(terminal, stackPos, fakeStack, state->m_Stack);
+                    bool result = state->template can_reduce<terminal_fetcher>(terminal, stackPos, fakeStack, state->m_Stack);
+                    m_Trace.weak_reduce(terminal, result);
+                    return result;
                 }
                 
                 /// \brief Returns true if the specified terminal symbol can be reduced
@@ -425,7 +758,9 @@ namespace lr {
                     state->fake_reduce(act, stackPos, fakeStack, state->m_Stack);
 
                     // Do a can_reduce on what remains
-                    return state->template can_reduce<nonterminal_fetcher>(terminal, stackPos, fakeStack, state->m_Stack);
+                    bool result = state->template can_reduce<nonterminal_fetcher>(terminal, stackPos, fakeStack, state->m_Stack);
+                    m_Trace.weak_reduce(terminal, result);
+                    return result;
                 }
             };
             
@@ -573,7 +908,7 @@ namespace lr {
             ///
             inline bool perform(const lexeme_container& lookahead, const action* act) {
                 // Call perform_generic with the standard actions
-                standard_actions standard;
+                standard_actions standard(m_Trace);
                 return perform_generic(lookahead, act, standard);
             }
             
@@ -592,14 +927,9 @@ namespace lr {
                 /// \brief The parser tables action iterator type
                 typedef parser_tables::action_iterator action_iterator;
                 
-                /// \brief Returns an iterator pointing to the first action referring to a terminal symbol in the specified state
-                inline static action_iterator find_symbol(const parser_tables* tables, int state, int terminal) {
-                    return tables->find_terminal(state, terminal);
-                }
-                
-                /// \brief Returns an iterator pointing to the last action referring to a terminal symbol in the specified state
-                inline static action_iterator last_symbol_action(const parser_tables* tables, int state) {
-                    return tables->last_terminal_action(state);
+                /// \brief Finds the range of actions for a terminal symbol, using the default reduction for the state if it has no actions
+                inline static void find_actions(const parser_tables* tables, int state, int terminal, action_iterator& act, action_iterator& end, parser_tables::action& defaultAction) {
+                    tables->find_terminal_actions(state, terminal, act, end, defaultAction);
                 }
             };
             
@@ -613,14 +943,10 @@ namespace lr {
                 /// \brief The parser tables action iterator type
                 typedef parser_tables::action_iterator action_iterator;
                 
-                /// \brief Returns an iterator pointing to the first action referring to a terminal symbol in the specified state
-                inline static action_iterator find_symbol(const parser_tables* tables, int state, int terminal) {
-                    return tables->find_nonterminal(state, terminal);
-                }
-                
-                /// \brief Returns an iterator pointing to the last action referring to a terminal symbol in the specified state
-                inline static action_iterator last_symbol_action(const parser_tables* tables, int state) {
-                    return tables->last_nonterminal_action(state);
+                /// \brief Finds the range of actions for a nonterminal symbol (nonterminals never have default reductions)
+                inline static void find_actions(const parser_tables* tables, int state, int nonterminal, action_iterator& act, action_iterator& end, parser_tables::action& defaultAction) {
+                    act = tables->find_nonterminal(state, nonterminal);
+                    end = tables->last_nonterminal_action(state);
                 }
             };
             
@@ -654,12 +980,48 @@ namespace lr {
                 return can_reduce(look());
             }
             
+            ///
+            /// \brief Finds the terminal symbols that the parser can accept next, for reporting syntax errors
+            ///
+            /// The result is a bitset: bit (n%32) of entry (n/32) is set if terminal n has an action. The bitsets
+            /// for each state are generated with the parser tables, so this only needs to combine the set for the
+            /// current state with the sets for the states that its default reduction (and any default reductions
+            /// after that) would leave on the stack. This takes time proportional to the number of states that
+            /// would be popped.
+            ///
+            /// Only default reductions are followed, so in LALR states that reduce a rule for a terminal that
+            /// could not be shifted afterwards the terminal will still be included. Use can_reduce() to rule
+            /// these out if that matters.
+            ///
+            void expected_terminals(std::vector<unsigned int>& expected);
+            
         private:
             /// \brief As for can_reduce, but with a fake nonterminal lookahead value
             inline bool can_reduce_nonterminal(int nt) {
                 return can_reduce<nonterminal_fetcher>(nt, 0, std::stack<int>(), m_Stack);
             }
             
+            /// \brief Updates a fake stack as if the specified symbol had been shifted
+            ///
+            /// This performs any reductions needed to shift the symbol, and then pushes the state that it is shifted
+            /// to. The result is parser_result::more if the symbol was shifted, accept if it was accepted or reject
+            /// if the parser would reject it. If ignored is not NULL, it is set to true if the symbol was ignored
+            /// rather than shifted.
+            template<class symbol_fetcher> parser_result::result fake_shift(int symbol, int& stackPos, std::stack<int>& pushed, const stack& underlyingStack, bool* ignored = NULL);
+            
+            /// \brief Returns the number of lookahead symbols starting at the specified offset that can be parsed
+            /// after the specified symbol (or repair_distance if they can all be parsed)
+            int trial_parse(int firstSymbol, int offset);
+            
+            /// \brief Inserts a symbol into the lookahead at the current position
+            inline void insert_lookahead(const lexeme_container& symbol);
+            
+            /// \brief Tries to recover from an error by inserting, deleting or replacing a single symbol
+            bool repair(syntax_error& error);
+            
+            /// \brief Recovers from an error by unwinding the stack and skipping symbols
+            bool unwind(syntax_error& error, bool useErrorSymbol);
+            
         public:
             typedef parser_result::result result;
 
@@ -690,12 +1052,16 @@ namespace lr {
         public:
             /// \brief Performs a single parsing action, and returns the result
             inline result process() {
-                standard_actions actions;
+                standard_actions actions(m_Trace);
                 return process_generic(actions);
             }
             
             /// \brief Parses the input file specified by the actions object, and returns true if it was accepted
             /// or false if it was rejected.
+            ///
+            /// If error recovery has been turned on with set_recovery(), this carries on after any syntax errors
+            /// that the parser can recover from. The result is then false if there were any errors, even if the
+            /// parser reached an accepting state.
             inline bool parse() {
                 for (;;) {
                     // Perform the next action
@@ -704,11 +1070,125 @@ namespace lr {
                     // Keep going if there are more results
                     if (next == parser_result::more) continue;
                     
+                    // Try to carry on after a syntax error if recovery is turned on
+                    if (next == parser_result::reject && m_RecoveryEnabled && recover()) continue;
+                    
                     // Stop, and indicate if the result was successful
-                    return next == parser_result::accept;
+                    return next == parser_result::accept && m_Errors.empty();
                 }
             }
             
+            ///
+            /// \brief Turns on error recovery for this state
+            ///
+            /// Recovery only happens once the parser has rejected a symbol, so parsing input with no errors in it
+            /// is no slower with it turned on.
+            ///
+            inline void set_recovery(const recovery_options& options) {
+                m_Recovery          = options;
+                m_RecoveryEnabled   = true;
+            }
+            
+            /// \brief Turns off error recovery for this state
+            inline void disable_recovery() {
+                m_RecoveryEnabled = false;
+            }
+            
+            ///
+            /// \brief Updates the state so that it can carry on after process() has rejected the lookahead
+            ///
+            /// The error is added to the list returned by errors(), unless it is too close to the last error to be
+            /// reported (see recovery_options::repair_distance). Returns false if the parser can't recover or if it
+            /// has already recovered from the maximum number of errors: the error is then always added to the list,
+            /// with its repair set to syntax_error::stopped.
+            ///
+            /// The parser first tries to find a symbol that can be inserted, deleted or replaced so that the next
+            /// few symbols can be parsed. If there isn't one, it unwinds the stack to a state that can shift the
+            /// error symbol, inserts it and skips symbols until one that can follow it is found. If no state can
+            /// shift the error symbol, symbols are skipped until one that a state on the stack can shift is found,
+            /// and the stack is unwound to that state.
+            ///
+            /// The items for the stack entries and symbols that are discarded are not passed to the actions. This
+            /// changes the lookahead, so this must only be used when there are no other states in the session, and
+            /// the state must be reading symbols from its actions rather than having them fed to it.
+            ///
+            bool recover();
+            
+            /// \brief The syntax errors that this state has recovered from
+            inline const error_list& errors() const {
+                return m_Errors;
+            }
+            
+            ///
+            /// \brief Adds a symbol to the end of the input, and parses as far as possible without any more input
+            ///
+            /// This is an alternative to parse() for when the input arrives a piece at a time: instead of the parser
+            /// reading symbols from the actions object, symbols are fed to it as they become available. The result
+            /// is parser_result::more if the parser is waiting for another symbol, or accept or reject once the parse
+            /// has finished. Call finish() once there are no more symbols.
+            ///
+            /// The actions object is never asked to read a symbol while the state is being fed. If a guard needs to
+            /// look past the symbols fed so far, it is checked again when the next symbol arrives (so the trace may
+            /// see the same guard check more than once).
+            ///
+            result feed(const lexeme_container& symbol);
+            
+            /// \brief Indicates that no more symbols will be fed to this state, and finishes the parse
+            ///
+            /// The result is parser_result::accept or parser_result::reject.
+            result finish();
+            
+        private:
+            /// \brief Parses the symbols that have been fed to this state
+            result process_fed();
+            
+        public:
+            
+            ///
+            /// \brief Resets this state so that it can parse a new document from the start
+            ///
+            /// The stack is cleared and the lookahead is discarded, but the memory allocated for them is kept so a
+            /// state that is reused for many documents stops allocating once it has grown to fit them. The actions
+            /// object is kept, and should be made to read from the new document before the state is used again.
+            /// Actions that read lexemes ahead of the parser (such as ast_parser_actions) need to be reset as well,
+            /// so if their stream is reset, use reset(stream, initialState) with the same stream.
+            ///
+            /// This must only be called when there are no other states in the session (that is, when no copies of
+            /// this state exist).
+            ///
+            void reset(int initialState = 0);
+            
+            ///
+            /// \brief Resets this state so that it can parse a new document read from the specified stream
+            ///
+            /// This calls reset(stream) on the actions object, which should replace (and usually destroy) the stream
+            /// that it was reading from before. The stream can be the one that the actions are already using.
+            ///
+            void reset(dfa::lexeme_stream* stream, int initialState = 0);
+
+            /// \brief The position of this state in the stream of symbols read by its session
+            inline size_t lookahead_position() const {
+                return m_LookaheadPos;
+            }
+
+            ///
+            /// \brief Replaces the symbols from this state's position onwards with the specified list of symbols
+            ///
+            /// The end of the list is treated as the end of the input, so the actions will not be asked to read any
+            /// more symbols. Any other states in the session must not be past this state's position. This is used by
+            /// the incremental parser to feed a session with a list of symbols that it has already lexed.
+            ///
+            template<typename lexeme_iterator> void replace_lookahead(lexeme_iterator begin, lexeme_iterator end);
+
+            ///
+            /// \brief Pushes an item for a nonterminal symbol and moves past the specified number of lookahead symbols
+            ///
+            /// This has the same effect as if the symbols had been parsed and reduced to the nonterminal, but the
+            /// actions and the trace are not called. Returns false (and leaves the state unchanged) if there is no
+            /// goto action for the nonterminal in the current state.
+            ///
+            bool shift_nonterminal(int nonterminal, const item_type& item, size_t length);
+
             /// \brief Returns the parser stack associated with this state
             inline const stack& get_stack() const {
                 return m_Stack;
@@ -718,6 +1198,25 @@ namespace lr {
             inline const item_type& get_item() const {
                 return m_Stack->item;
             }
+            
+            /// \brief Returns the trace object for this state
+            ///
+            /// For parsers declared with stats_parser_trace, get_trace().stats() returns the statistics for the parse
+            inline const parser_trace& get_trace() const {
+                return m_Trace;
+            }
+            
+            /// \brief Returns the trace object for this state
+            inline parser_trace& get_trace() {
+                return m_Trace;
+            }
+
+            /// \brief Returns the parser actions used by this state
+            ///
+            /// The actions are shared by every state in the same session, and are destroyed along with the last of them
+            inline const parser_actions* get_actions() const {
+                return m_Session->m_Actions;
+            }
         };
         
     public:
@@ -742,25 +1241,44 @@ namespace lr {
         /// \brief The lexer associated with the object, destroyed when the object is destructed
         dfa::lexeme_stream* m_Lexer;
         
-        simple_parser_actions(const simple_parser_actions& noCopying) { }
-        simple_parser_actions& operator=(const simple_parser_actions& noCopying) { return *this; }
+        /// \brief Reads lexemes from the lexer (a batch at a time if set_batched() has been called)
+        dfa::lexeme_batch_reader m_Reader;
+        
+        simple_parser_actions(const simple_parser_actions& noCopying);
+        simple_parser_actions& operator=(const simple_parser_actions& noCopying);
         
     public:
         /// \brief Creates a new actions object that will read from the specified stream.
         ///
         /// The stream will be deleted when this object is deleted
         simple_parser_actions(dfa::lexeme_stream* lexer)
-        : m_Lexer(lexer) {
+        : m_Lexer(lexer)
+        , m_Reader(lexer) {
         }
         
         /// \brief Destroys an existing actions object
         ~simple_parser_actions() { delete m_Lexer; }
         
+        /// \brief Starts reading from a new stream (the old stream is destroyed)
+        inline void reset(dfa::lexeme_stream* lexer) {
+            if (lexer != m_Lexer) {
+                delete m_Lexer;
+                m_Lexer = lexer;
+            }
+            
+            m_Reader.reset(lexer);
+        }
+        
+        /// \brief Sets whether or not lexemes are read from the stream a batch at a time (see dfa::lexeme_batch_reader)
+        ///
+        /// This is faster, but should only be turned on if the parser never changes the lexer state.
+        inline void set_batched(bool batched) {
+            m_Reader.set_batched(batched);
+        }
+        
         /// \brief Reads the next symbol from the stream
         inline dfa::lexeme* read() {
-            dfa::lexeme* result = NULL;
-            (*m_Lexer) >> result;
-            return result;
+            return m_Reader.read();
         }
         
         /// \brief Returns the item resulting from a shift action
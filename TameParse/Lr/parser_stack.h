@@ -32,6 +32,7 @@
 
 #include <vector>
 #include <stack>
+#include <utility>
 
 namespace lr {
     ///
@@ -94,6 +95,42 @@ namespace lr {
             : m_PreviousIndex(empty) {
             }
             
+            /// \brief Creates an unused entry that shares the specified empty item
+            inline explicit entry(const item_type& emptyItem)
+            : m_PreviousIndex(empty)
+            , item(emptyItem) {
+            }
+            
+            /// \brief Copies an entry
+            inline entry(const entry& copyFrom)
+            : m_PreviousIndex(copyFrom.m_PreviousIndex)
+            , item(copyFrom.item)
+            , state(copyFrom.state) {
+            }
+            
+            /// \brief Moves an entry (used when the stack grows, so the items don't need to be copied)
+            inline entry(entry&& moveFrom) noexcept
+            : m_PreviousIndex(moveFrom.m_PreviousIndex)
+            , item(std::move(moveFrom.item))
+            , state(moveFrom.state) {
+            }
+            
+            /// \brief Assigns an entry
+            inline entry& operator=(const entry& assignFrom) {
+                m_PreviousIndex = assignFrom.m_PreviousIndex;
+                item            = assignFrom.item;
+                state           = assignFrom.state;
+                return *this;
+            }
+            
+            /// \brief Assigns an entry by moving the item from another entry
+            inline entry& operator=(entry&& moveFrom) noexcept {
+                m_PreviousIndex = moveFrom.m_PreviousIndex;
+                item            = std::move(moveFrom.item);
+                state           = moveFrom.state;
+                return *this;
+            }
+            
             /// \brief The item associated with this entry
             item_type item;
             
@@ -117,6 +154,9 @@ namespace lr {
             /// \brief The number of free entries in the stack
             int m_NumFree;
             
+            /// \brief Item shared by all of the unused entries, so releasing or adding entries doesn't need to create new items
+            item_type m_EmptyItem;
+            
             internal_stack(const internal_stack& copyFrom);
             
             /// \brief Disabled assignment
@@ -126,7 +166,7 @@ namespace lr {
             /// \brief Creates a new stack
             internal_stack()
             : m_RootReference(NULL) {
-                m_Stack.resize(initial_depth);
+                m_Stack.resize(initial_depth, entry(m_EmptyItem));
                 m_FirstUnused = 0;
                 m_NumFree = (int)m_Stack.size();
             }
@@ -182,6 +222,22 @@ namespace lr {
                 }
             }
             
+            /// \brief Marks every entry in the stack as unused, releasing any items they refer to
+            ///
+            /// The storage used by the stack is kept. There must not be any references to the stack that are
+            /// still in use.
+            void clear() {
+                for (typename std::vector<entry>::iterator stackEntry = m_Stack.begin(); stackEntry != m_Stack.end(); ++stackEntry) {
+                    if (stackEntry->m_PreviousIndex != entry::empty) {
+                        stackEntry->item            = m_EmptyItem;
+                        stackEntry->m_PreviousIndex = entry::empty;
+                    }
+                }
+                
+                m_FirstUnused   = 0;
+                m_NumFree       = (int) m_Stack.size();
+            }
+            
         private:
             void grow_stack() {
                 // Work out how many new items to create
@@ -189,7 +245,7 @@ namespace lr {
                 if (numNew > initial_depth * 8) numNew = initial_depth * 8;
                 
                 // Resize the stack by this amount
-                m_Stack.resize(m_Stack.size() + numNew);
+                m_Stack.resize(m_Stack.size() + numNew, entry(m_EmptyItem));
                 m_NumFree += numNew;
             }
             
@@ -240,11 +296,17 @@ namespace lr {
         pstack* m_Next;
         
     private:
-        parser_stack(pstack* stack, int index)
-        : m_Index(index)
-        , m_Stack(stack) {
+        parser_stack(internal_stack* stack, int index)
+        : m_Stack(stack)
+        , m_Index(index) {
+            add_reference();
+        }
+        
+        /// \brief Adds this object to the list of references to the stack
+        inline void add_reference() {
             m_Next = m_Stack->m_RootReference;
             m_Last = NULL;
+            if (m_Next) m_Next->m_Last = this;
             m_Stack->m_RootReference = this;
         }
         
@@ -252,18 +314,14 @@ namespace lr {
         parser_stack() 
         : m_Stack(new internal_stack())
         , m_Index(m_Stack->get_new()) {
-            m_Next = m_Stack->m_RootReference;
-            m_Last = NULL;
-            m_Stack->m_RootReference = this;
+            add_reference();
         }
         
         /// \brief Creates a copy of a particular reference
         inline parser_stack(const parser_stack& copyFrom)
         : m_Stack(copyFrom.m_Stack)
         , m_Index(copyFrom.m_Index) {
-            m_Next = m_Stack->m_RootReference;
-            m_Last = NULL;
-            m_Stack->m_RootReference = this;
+            add_reference();
         }
         
         /// \brief Assignment operator
@@ -344,6 +402,37 @@ namespace lr {
             m_Index = newIndex;
         }
         
+        /// \brief Pushes a new item onto the stack by moving it into place, and updates this to point at it
+        inline void push(int state, item_type&& newItem) {
+            int newIndex = m_Stack->get_new();
+            
+            entry& newEntry = m_Stack->m_Stack[newIndex];
+            
+            newEntry.state              = state;
+            newEntry.item               = std::move(newItem);
+            newEntry.m_PreviousIndex    = m_Index;
+            
+            m_Index = newIndex;
+        }
+        
+        /// \brief Returns true if this is the only reference to the underlying stack
+        ///
+        /// When this is true, entries that are popped from this reference can never be visited again, so
+        /// their items can be moved out rather than copied.
+        inline bool is_unique() const {
+            return m_Stack->m_RootReference == this && m_Next == NULL;
+        }
+        
+        /// \brief Resets the stack so that it only contains a single entry with the specified state
+        ///
+        /// This must only be called when is_unique() is true. The storage allocated for the stack is kept, so
+        /// a parser that is reset for each new document does not need to grow its stack again.
+        inline void reset(int state) {
+            m_Stack->clear();
+            m_Index = m_Stack->get_new();
+            m_Stack->m_Stack[m_Index].state = state;
+        }
+        
         /// \brief Pops an item from the stack (returns false if this is currently pointing at a head item)
         ///
         /// This reference is adjusted to point at the new head of the stack
@@ -31,13 +31,69 @@
 #include "TameParse/Lr/parser.h"
 
 namespace lr {
+    ///
+    /// \brief Registers a state at the specified lookahead position with this session
+    ///
+    template<typename I, typename A, typename T> inline void parser<I, A, T>::session::add_state(size_t lookaheadPos) {
+        if (m_StatesAtMinimum == 0 || lookaheadPos < m_MinLookaheadPos) {
+            // This state is the new minimum
+            m_MinLookaheadPos   = lookaheadPos;
+            m_StatesAtMinimum   = 1;
+        } else if (lookaheadPos == m_MinLookaheadPos) {
+            // One more state at the minimum
+            ++m_StatesAtMinimum;
+        }
+    }
+    
+    ///
+    /// \brief Indicates that a state has left the specified lookahead position
+    ///
+    template<typename I, typename A, typename T> inline void parser<I, A, T>::session::leave_position(size_t lookaheadPos) {
+        // Nothing changes unless the state was holding back the start of the lookahead
+        if (lookaheadPos != m_MinLookaheadPos) return;
+        if (--m_StatesAtMinimum > 0) return;
+        
+        // Find the new minimum lookahead position
+        // The position can only increase, so we only need to visit the states when the last one leaves the old minimum
+        m_StatesAtMinimum = 0;
+        for (state* whichState = m_FirstState; whichState != NULL; whichState = whichState->m_NextState) {
+            add_state(whichState->m_LookaheadPos);
+        }
+        
+        // Give up if there are no more states
+        if (m_StatesAtMinimum == 0) return;
+        
+        // Remove the symbols that no state will visit again
+        while (m_LookaheadBase < m_MinLookaheadPos && !m_Lookahead.empty()) {
+            m_Lookahead.pop_front();
+            ++m_LookaheadBase;
+        }
+    }
+    
+    ///
+    /// \brief Discards the lookahead and moves the session back to the start of the stream
+    ///
+    template<typename I, typename A, typename T> inline void parser<I, A, T>::session::reset() {
+        // Clear out the lookahead, keeping the deque's storage where possible
+        m_Lookahead.clear();
+        
+        m_LookaheadBase     = 0;
+        m_MinLookaheadPos   = 0;
+        m_StatesAtMinimum   = 0;
+        m_EndOfFile         = false;
+        m_Pushing           = false;
+        m_Starved           = false;
+    }
+    
     ///
     /// \brief Constructs a new state, used by the parser
     ///
     template<typename I, typename A, typename T> parser<I, A, T>::state::state(const parser_tables* tables, int initialState, session* session) 
     : m_Tables(tables)
     , m_Session(session)
-    , m_LookaheadPos(0) {
+    , m_LookaheadPos(session->m_LookaheadBase)
+    , m_RecoveryEnabled(false)
+    , m_ResumePos((size_t) -1) {
         // Push the initial state
         m_Stack->state          = initialState;
         m_NextState             = m_Session->m_FirstState;
@@ -45,6 +101,7 @@ namespace lr {
         m_Session->m_FirstState = this;
         
         if (m_NextState) m_NextState->m_LastState = this;
+        m_Session->add_state(m_LookaheadPos);
     }
     
     ///
@@ -54,12 +111,18 @@ namespace lr {
     : m_Tables(copyFrom.m_Tables)
     , m_Session(copyFrom.m_Session)
     , m_Stack(copyFrom.m_Stack)
-    , m_LookaheadPos(copyFrom.m_LookaheadPos) {
+    , m_LookaheadPos(copyFrom.m_LookaheadPos)
+    , m_Trace(copyFrom.m_Trace)
+    , m_RecoveryEnabled(copyFrom.m_RecoveryEnabled)
+    , m_Recovery(copyFrom.m_Recovery)
+    , m_Errors(copyFrom.m_Errors)
+    , m_ResumePos(copyFrom.m_ResumePos) {
         m_NextState             = m_Session->m_FirstState;
         m_LastState             = NULL;
         m_Session->m_FirstState = this;
         
         if (m_NextState) m_NextState->m_LastState = this;
+        m_Session->add_state(m_LookaheadPos);
     }
     
     ///
@@ -79,29 +142,131 @@ namespace lr {
         // Destroy the session if it is now empty of states
         if (!m_Session->m_FirstState) {
             delete m_Session;
+        } else {
+            // Allow the session to discard any lookahead that only this state was using
+            m_Session->leave_position(m_LookaheadPos);
         }
     }
 
     ///
-    /// \brief Trims the lookahead in the sessions (removes any symbols that won't be visited again)
+    /// \brief Resets this state so that it can parse a new document from the start
     ///
-    template<typename I, typename A, typename T> inline void parser<I, A, T>::state::trim_lookahead() {
-        // Find the minimum lookahead position in all of the states
-        int minPos = m_LookaheadPos;
-        for (state* whichState = m_Session->m_FirstState; whichState != NULL; whichState = whichState->m_NextState) {
-            if (whichState->m_LookaheadPos < minPos) minPos = whichState->m_LookaheadPos;
-                }
+    template<typename I, typename A, typename T> void parser<I, A, T>::state::reset(int initialState) {
+        // Return the stack to the initial state
+        m_Stack.reset(initialState);
         
-        // Give up if there's no work to do
-        if (minPos == 0) return;
+        // Move back to the start of the lookahead
+        m_Session->reset();
+        m_LookaheadPos = 0;
+        m_Session->add_state(m_LookaheadPos);
         
-        // Remove the symbols from the session
-        m_Session->m_Lookahead.erase(m_Session->m_Lookahead.begin(), m_Session->m_Lookahead.begin() + minPos);
+        // Start a new trace
+        m_Trace = T();
         
-        // Update the state lookahead positions
-        for (state* whichState = m_Session->m_FirstState; whichState != NULL; whichState = whichState->m_NextState) {
-            whichState->m_LookaheadPos -= minPos;
+        // Forget about any errors in the previous document
+        m_Errors.clear();
+        m_ResumePos = (size_t) -1;
+    }
+    
+    ///
+    /// \brief Resets this state so that it can parse a new document read from the specified stream
+    ///
+    template<typename I, typename A, typename T> void parser<I, A, T>::state::reset(dfa::lexeme_stream* stream, int initialState) {
+        // Tell the actions about the new stream
+        m_Session->m_Actions->reset(stream);
+        
+        // Reset the state
+        reset(initialState);
+    }
+
+    ///
+    /// \brief Adds a symbol to the end of the input, and parses as far as possible without any more input
+    ///
+    template<typename I, typename A, typename T> typename parser<I, A, T>::state::result parser<I, A, T>::state::feed(const lexeme_container& symbol) {
+        // Add to the lookahead
+        m_Session->m_Lookahead.push_back(symbol);
+        m_Trace.lookahead_size(m_Session->m_Lookahead.size());
+        
+        return process_fed();
+    }
+    
+    ///
+    /// \brief Indicates that no more symbols will be fed to this state, and finishes the parse
+    ///
+    template<typename I, typename A, typename T> typename parser<I, A, T>::state::result parser<I, A, T>::state::finish() {
+        m_Session->m_EndOfFile = true;
+        return process_fed();
+    }
+    
+    ///
+    /// \brief Parses the symbols that have been fed to this state
+    ///
+    template<typename I, typename A, typename T> typename parser<I, A, T>::state::result parser<I, A, T>::state::process_fed() {
+        result next;
+        
+        m_Session->m_Pushing = true;
+        for (;;) {
+            // Perform actions until the parser finishes or needs another symbol
+            m_Session->m_Starved = false;
+            next = process();
+            
+            if (next != parser_result::more || m_Session->m_Starved) break;
         }
+        
+        m_Session->m_Pushing = false;
+        m_Session->m_Starved = false;
+        
+        return next;
+    }
+    
+    ///
+    /// \brief Replaces the symbols from this state's position onwards with the specified list of symbols
+    ///
+    template<typename I, typename A, typename T> template<typename lexeme_iterator> void parser<I, A, T>::state::replace_lookahead(lexeme_iterator begin, lexeme_iterator end) {
+        // Discard anything after this state
+        size_t pos = m_LookaheadPos - m_Session->m_LookaheadBase;
+        if (pos < m_Session->m_Lookahead.size()) {
+            m_Session->m_Lookahead.erase(m_Session->m_Lookahead.begin() + pos, m_Session->m_Lookahead.end());
+        }
+
+        // Append the new symbols
+        for (lexeme_iterator symbol = begin; symbol != end; ++symbol) {
+            m_Session->m_Lookahead.push_back(*symbol);
+        }
+
+        // There is nothing more to read
+        m_Session->m_EndOfFile = true;
+    }
+
+    ///
+    /// \brief Pushes an item for a nonterminal symbol and moves past the specified number of lookahead symbols
+    ///
+    template<typename I, typename A, typename T> bool parser<I, A, T>::state::shift_nonterminal(int nonterminal, const I& item, size_t length) {
+        // Find the goto action for this nonterminal
+        int currentState = m_Stack->state;
+
+        for (parser_tables::action_iterator gotoAct = m_Tables->find_nonterminal(currentState, nonterminal);
+             gotoAct != m_Tables->last_nonterminal_action(currentState);
+             ++gotoAct) {
+            if (gotoAct->symbolId != nonterminal) break;
+
+            if (gotoAct->type == lr_action::act_goto) {
+                // Push the item
+                m_Stack.push(gotoAct->nextState, item);
+
+                // Move past the symbols that it covers
+                if (length > 0) {
+                    size_t oldPos = m_LookaheadPos;
+                    m_LookaheadPos += length;
+                    m_Session->leave_position(oldPos);
+                }
+
+                return true;
+            }
+        }
+
+        // No goto action
+        return false;
     }
 
     ///
@@ -110,22 +275,27 @@ namespace lr {
     /// It is an error to call this without calling lookahead() at least once since the last call.
     ///
     template<typename I, typename A, typename T> inline void parser<I, A, T>::state::next() {
+        size_t oldPos = m_LookaheadPos;
         ++m_LookaheadPos;
-        trim_lookahead();
+        m_Session->leave_position(oldPos);
     }
     
     ///
     /// \brief Retrieves the current lookahead character
     ///
     template<typename I, typename A, typename T> inline const typename parser<I, A, T>::lexeme_container& parser<I, A, T>::state::look(int offset) {
-        // Static lexeme container representing the end of the file
-        static lexeme_container endOfFile((lexeme*)NULL);
+        // Lexeme container representing the end of the file
+        const lexeme_container& endOfFile = m_Session->m_EndOfFileLexeme;
         
         // Read a new symbol if necessary
-        size_t pos = m_LookaheadPos + offset;
+        size_t pos = m_LookaheadPos + offset - m_Session->m_LookaheadBase;
         
         while (pos >= m_Session->m_Lookahead.size()) {
-            if (!m_Session->m_EndOfFile) {
+            if (m_Session->m_Pushing && !m_Session->m_EndOfFile) {
+                // Symbols are being fed to this state, and it needs another one
+                m_Session->m_Starved = true;
+                return endOfFile;
+            } else if (!m_Session->m_EndOfFile) {
                 // Read the next symbol using the parser actions
                 dfa::lexeme_container nextLexeme(m_Session->m_Actions->read(), true);
                 
@@ -136,7 +306,8 @@ namespace lr {
                 }
                 
                 // Store in the lookahead
-                m_Session->m_Lookahead.push_back(nextLexeme);
+                m_Session->m_Lookahead.push_back(std::move(nextLexeme));
+                m_Trace.lookahead_size(m_Session->m_Lookahead.size());
             } else {
                 // EOF
                 return endOfFile;
@@ -244,13 +415,13 @@ namespace lr {
             bool isTerminal;
             parser_tables::action_iterator act;
             parser_tables::action_iterator end;
+            parser_tables::action defaultAction;
             
             if (la.item() != NULL) {
                 // The item is a terminal
                 sym         = la->matched();
-                act         = m_Tables->find_terminal(state, sym);
-                end         = m_Tables->last_terminal_action(state);
                 isTerminal  = true;
+                m_Tables->find_terminal_actions(state, sym, act, end, defaultAction);
             } else {
                 // The item is the end-of-input symbol (which counts as a nonterminal)
                 sym         = m_Tables->end_of_input();
@@ -306,6 +477,7 @@ namespace lr {
                     
                     // Return the nonterminal ID for this rule, which should be the ID of the guard that was 
                     // matched
+                    m_Trace.guard_depth(initialState, guardActions.offset() - initialOffset + 1);
                     return rule.identifier;
                 }
                 
@@ -343,6 +515,7 @@ namespace lr {
             
             if (!ok) {
                 // We reject if we reach here (no actions matched the lookahead)
+                m_Trace.guard_depth(initialState, guardActions.offset() - initialOffset + 1);
                 return -1;
             }
         }
@@ -424,10 +597,14 @@ namespace lr {
         }
         
         // Get the initial action for the terminal
-        parser_tables::action_iterator act = symbol_fetcher::find_symbol(m_Tables, state, symbol);
+        parser_tables::action_iterator  act;
+        parser_tables::action_iterator  end;
+        parser_tables::action           defaultAction;
+        
+        symbol_fetcher::find_actions(m_Tables, state, symbol, act, end, defaultAction);
         
         // Find the first reduce action for this item
-        while (act != symbol_fetcher::last_symbol_action(m_Tables, state)) {
+        while (act != end) {
             // Fail if there are no actions for this terminal
             if (act->symbolId != symbol) return false;
             
@@ -488,7 +665,7 @@ namespace lr {
                     }
                     
                     // Get the initial action for the terminal
-                    act = symbol_fetcher::find_symbol(m_Tables, state, symbol);
+                    symbol_fetcher::find_actions(m_Tables, state, symbol, act, end, defaultAction);
                     
                     // Carry on looking with the new state
                     break;
@@ -538,6 +715,11 @@ namespace lr {
                 // Check if this guard generates a guard symbol
                 int guardSym = actDelegate.check_guard(this, act->nextState);
                 
+                // Wait for more symbols if the guard ran out of lookahead while being fed symbols
+                if (m_Session->m_Starved) {
+                    return parser_result::more;
+                }
+                
                 // If the guard was not matched, continue to the next action for this symbol
                 if (guardSym < 0) {
                     continue;
@@ -584,15 +766,20 @@ namespace lr {
         int                             sym;
         parser_tables::action_iterator  act;
         parser_tables::action_iterator  end;
+        parser_tables::action           defaultAction;
         bool                            isTerminal;
         
         if (la.item() != NULL) {
-            // The item is a terminal
+            // The item is a terminal (using the default reduction for this state if it has no actions)
             sym         = la->matched();
             isTerminal  = true;
-            act         = m_Tables->find_terminal(state, sym);
-            end         = m_Tables->last_terminal_action(state);
+            m_Tables->find_terminal_actions(state, sym, act, end, defaultAction);
         } else {
+            // Wait for more symbols if the state is being fed and has run out
+            if (m_Session->m_Starved) {
+                return parser_result::more;
+            }
+            
             // The item is the end-of-input symbol (which counts as a nonterminal)
             sym         = m_Tables->end_of_input();
             isTerminal  = false;
@@ -699,6 +886,397 @@ namespace lr {
         // Looks good
         return true;
     }
+
+    /// \brief Finds the terminal symbols that the parser can accept next
+    template<typename I, typename A, typename T> void parser<I, A, T>::state::expected_terminals(std::vector<unsigned int>& expected) {
+        std::stack<int> pushed;
+        int             stackPos = 0;
+        
+        expected.assign(m_Tables->expected_words(), 0u);
+        
+        for (;;) {
+            // Get the current state
+            int state;
+            if (!pushed.empty()) {
+                state = pushed.top();
+            } else {
+                state = m_Stack[stackPos].state;
+            }
+            
+            // Add the terminals that have actions in this state
+            const unsigned int* bits = m_Tables->expected_terminals(state);
+            
+            if (bits) {
+                for (size_t wordId = 0; wordId < expected.size(); ++wordId) {
+                    expected[wordId] |= bits[wordId];
+                }
+            } else {
+                // Tables generated without the bitsets have to be searched instead
+                const parser_tables::action*    act         = m_Tables->terminal_actions()[state];
+                int                             numActions  = m_Tables->action_counts()[state].numTerminals;
+                
+                for (int actionId = 0; actionId < numActions; ++actionId) {
+                    if (act[actionId].type == lr_action::act_ignore) continue;
+                    
+                    size_t wordId = act[actionId].symbolId / 32;
+                    if (wordId >= expected.size()) expected.resize(wordId + 1, 0u);
+                    
+                    expected[wordId] |= 1u << (act[actionId].symbolId % 32);
+                }
+            }
+            
+            // Any other terminal is reduced by the default reduction, so the state it leads to decides if it can be accepted
+            int defaultRule = m_Tables->default_reduction(state);
+            if (defaultRule < 0) break;
+            
+            parser_tables::action defaultAction;
+            defaultAction.type      = lr_action::act_reduce;
+            defaultAction.nextState = defaultRule;
+            defaultAction.symbolId  = -1;
+            
+            fake_reduce(&defaultAction, stackPos, pushed, m_Stack);
+        }
+    }
+    
+    /// \brief Updates a fake stack as if the specified symbol had been shifted
+    template<typename I, typename A, typename T> template<class symbol_fetcher> parser_result::result parser<I, A, T>::state::fake_shift(int symbol, int& stackPos, std::stack<int>& pushed, const stack& underlyingStack, bool* ignored) {
+        if (ignored) *ignored = false;
+        
+        for (;;) {
+            // Get the current state
+            int state;
+            if (!pushed.empty()) {
+                state = pushed.top();
+            } else {
+                state = underlyingStack[stackPos].state;
+            }
+            
+            // Get the actions for this symbol
+            parser_tables::action_iterator  act;
+            parser_tables::action_iterator  end;
+            parser_tables::action           defaultAction;
+            
+            symbol_fetcher::find_actions(m_Tables, state, symbol, act, end, defaultAction);
+            
+            // Find the first action that can be performed
+            bool moved = false;
+            for (; act != end && !moved; ++act) {
+                // Reject if there are no more actions for this symbol
+                if (act->symbolId != symbol) return parser_result::reject;
+                
+                switch (act->type) {
+                    case lr_action::act_shift:
+                    case lr_action::act_shiftstrong:
+                        // Push the new state, and we're done
+                        pushed.push(act->nextState);
+                        return parser_result::more;
+                        
+                    case lr_action::act_ignore:
+                        // The symbol is consumed without changing the stack
+                        if (ignored) *ignored = true;
+                        return parser_result::more;
+                        
+                    case lr_action::act_accept:
+                        return parser_result::accept;
+                        
+                    case lr_action::act_divert:
+                        // Push the new state and try again with the same symbol
+                        pushed.push(act->nextState);
+                        moved = true;
+                        break;
+                        
+                    case lr_action::act_weakreduce:
+                    {
+                        // Only perform weak reductions if the symbol can be shifted afterwards
+                        int             weakPos = stackPos;
+                        std::stack<int> weakStack(pushed);
+                        
+                        fake_reduce(act, weakPos, weakStack, underlyingStack);
+                        if (can_reduce<symbol_fetcher>(symbol, weakPos, weakStack, underlyingStack)) {
+                            stackPos    = weakPos;
+                            pushed      = weakStack;
+                            moved       = true;
+                        }
+                        break;
+                    }
+                        
+                    case lr_action::act_reduce:
+                        fake_reduce(act, stackPos, pushed, underlyingStack);
+                        moved = true;
+                        break;
+                        
+                    default:
+                        // Guards and other actions are skipped (as for can_reduce)
+                        break;
+                }
+            }
+            
+            // Reject if no action could be performed
+            if (!moved) return parser_result::reject;
+        }
+    }
+    
+    /// \brief Returns the number of lookahead symbols starting at the specified offset that can be parsed after the
+    /// specified symbol (or repair_distance if they can all be parsed)
+    template<typename I, typename A, typename T> int parser<I, A, T>::state::trial_parse(int firstSymbol, int offset) {
+        std::stack<int> pushed;
+        int             stackPos = 0;
+        int             distance = m_Recovery.repair_distance;
+        
+        // Shift the first symbol, if there is one
+        if (firstSymbol >= 0) {
+            if (fake_shift<terminal_fetcher>(firstSymbol, stackPos, pushed, m_Stack) != parser_result::more) {
+                return 0;
+            }
+        }
+        
+        // Count how many of the following symbols can be shifted (ignored symbols such as whitespace don't count)
+        int count = 0;
+        
+        for (int pos = offset; count < distance; ++pos) {
+            const lexeme_container& la = look(pos);
+            
+            // Reaching the end of the input counts as parsing everything if the input can then be accepted
+            if (!la.item()) {
+                if (fake_shift<nonterminal_fetcher>(m_Tables->end_of_input(), stackPos, pushed, m_Stack) == parser_result::accept) {
+                    return distance;
+                }
+                return count;
+            }
+            
+            bool ignored;
+            if (fake_shift<terminal_fetcher>(la->matched(), stackPos, pushed, m_Stack, &ignored) != parser_result::more) {
+                return count;
+            }
+            
+            if (!ignored) ++count;
+        }
+        
+        return distance;
+    }
+    
+    /// \brief Inserts a symbol into the lookahead at the current position
+    template<typename I, typename A, typename T> inline void parser<I, A, T>::state::insert_lookahead(const lexeme_container& symbol) {
+        size_t pos = m_LookaheadPos - m_Session->m_LookaheadBase;
+        m_Session->m_Lookahead.insert(m_Session->m_Lookahead.begin() + pos, symbol);
+    }
+    
+    /// \brief Tries to recover from an error by inserting, deleting or replacing a single symbol
+    template<typename I, typename A, typename T> bool parser<I, A, T>::state::repair(syntax_error& error) {
+        lexeme_container    rejected = look();
+        int                 distance = m_Recovery.repair_distance;
+        
+        // Try deleting the rejected symbol
+        if (rejected.item() && trial_parse(-1, 1) >= distance) {
+            next();
+            error.repair            = syntax_error::deleted;
+            error.skipped_symbols   = 1;
+            return true;
+        }
+        
+        // Try inserting a symbol, then replacing the rejected symbol
+        for (int offset = 0; offset < 2; ++offset) {
+            // Can't replace the end of the input
+            if (offset == 1 && !rejected.item()) break;
+            
+            // Only the terminals that the parser can accept next are worth trying
+            for (int terminal = 0; terminal < (int) error.expected.size() * 32; ++terminal) {
+                if (!error.is_expected(terminal)) continue;
+                
+                // The error symbol is only used when unwinding the stack
+                if (terminal == m_Recovery.error_symbol) continue;
+                if (offset == 1 && terminal == rejected->matched()) continue;
+                
+                // Check that the symbol can really be shifted before trying to parse the symbols after it
+                if (!can_reduce(terminal)) continue;
+                if (trial_parse(terminal, offset) < distance) continue;
+                
+                // Create the new symbol
+                lexeme_container repairSymbol;
+                if (offset == 0) {
+                    repairSymbol = lexeme_container(new dfa::lexeme(dfa::lexeme::symbols(), error.pos, terminal), true);
+                } else {
+                    repairSymbol = lexeme_container(new dfa::lexeme(rejected->content(), error.pos, terminal), true);
+                }
+                
+                // Insert it into the lookahead
+                if (offset == 1) {
+                    next();
+                }
+                insert_lookahead(repairSymbol);
+                
+                error.repair        = offset == 0 ? syntax_error::inserted : syntax_error::replaced;
+                error.repair_symbol = terminal;
+                return true;
+            }
+        }
+        
+        // No single symbol repair was found
+        return false;
+    }
+    
+    /// \brief Recovers from an error by unwinding the stack and skipping symbols
+    template<typename I, typename A, typename T> bool parser<I, A, T>::state::unwind(syntax_error& error, bool useErrorSymbol) {
+        int errorSymbol = m_Recovery.error_symbol;
+        
+        error.repair = syntax_error::skipped;
+        
+        if (useErrorSymbol && errorSymbol >= 0) {
+            // Find the topmost state that can shift the error symbol
+            stack   probe(m_Stack);
+            int     depth = 0;
+            
+            while (!can_reduce<terminal_fetcher>(errorSymbol, 0, std::stack<int>(), probe)) {
+                if (!probe.pop()) {
+                    depth = -1;
+                    break;
+                }
+                ++depth;
+            }
+            
+            if (depth >= 0) {
+                // Work out the state the parser is in after the error symbol is shifted
+                std::stack<int> pushed;
+                int             stackPos = 0;
+                
+                fake_shift<terminal_fetcher>(errorSymbol, stackPos, pushed, probe);
+                
+                // Skip symbols until one that can follow the error symbol is found
+                // If the end of the input is reached, it is left to the parser to decide if it can be accepted
+                for (;;) {
+                    lexeme_container la = look();
+                    
+                    if (!la.item()) break;
+                    if (can_reduce<terminal_fetcher>(la->matched(), stackPos, pushed, probe)) break;
+                    
+                    next();
+                    ++error.skipped_symbols;
+                }
+                
+                // Discard the states above the one that can shift the error symbol
+                for (int x = 0; x < depth; ++x) {
+                    m_Stack.pop();
+                }
+                
+                // Insert the error symbol
+                insert_lookahead(lexeme_container(new dfa::lexeme(dfa::lexeme::symbols(), error.pos, errorSymbol), true));
+                
+                error.repair_symbol = errorSymbol;
+                error.popped_states = depth;
+                return true;
+            }
+        }
+        
+        // Skip symbols until one that one of the states on the stack can shift is found
+        for (;;) {
+            lexeme_container la = look();
+            
+            // Check the states on the stack, starting at the top
+            stack probe(m_Stack);
+            for (int depth = 0; ; ++depth) {
+                bool canShift;
+                if (la.item()) {
+                    canShift = can_reduce<terminal_fetcher>(la->matched(), 0, std::stack<int>(), probe);
+                } else {
+                    canShift = can_reduce<nonterminal_fetcher>(m_Tables->end_of_input(), 0, std::stack<int>(), probe);
+                }
+                
+                if (canShift) {
+                    // Discard the states above the one that can shift this symbol
+                    for (int x = 0; x < depth; ++x) {
+                        m_Stack.pop();
+                    }
+                    
+                    error.popped_states = depth;
+                    return true;
+                }
+                
+                if (!probe.pop()) break;
+            }
+            
+            // Give up if the end of the input can't be reached
+            if (!la.item()) return false;
+            
+            next();
+            ++error.skipped_symbols;
+        }
+    }
+    
+    ///
+    /// \brief Updates the state so that it can carry on after process() has rejected the lookahead
+    ///
+    template<typename I, typename A, typename T> bool parser<I, A, T>::state::recover() {
+        // Describe the error
+        syntax_error        error;
+        lexeme_container    rejected = look();
+        
+        if (rejected.item()) {
+            error.pos       = rejected->pos();
+            error.symbol    = rejected->matched();
+        } else {
+            error.symbol    = m_Tables->end_of_input();
+        }
+        
+        expected_terminals(error.expected);
+        
+        // Give up if there have been too many errors
+        if (m_Recovery.max_errors > 0 && (int) m_Errors.size() >= m_Recovery.max_errors) {
+            error.repair = syntax_error::stopped;
+            m_Errors.push_back(error);
+            return false;
+        }
+        
+        // Errors just after the parser resumed from an earlier one are usually caused by it, so aren't reported
+        bool afterRecovery  = m_ResumePos != (size_t) -1;
+        bool report         = !afterRecovery || m_LookaheadPos >= m_ResumePos + m_Recovery.repair_distance;
+        
+        // The parser must consume at least one symbol after each recovery: if it got no further than the last
+        // one, then the rejected symbol is discarded and no new symbols are inserted, so it can't get stuck
+        bool stuck = afterRecovery && m_LookaheadPos <= m_ResumePos;
+        int  skipped = 0;
+        
+        bool recovered = false;
+        
+        if (stuck) {
+            if (rejected.item()) {
+                next();
+                skipped = 1;
+            }
+        } else if (m_Recovery.try_repairs) {
+            // Try a simple repair first
+            recovered = repair(error);
+        }
+        
+        // Unwind the stack if there's no simple repair
+        if (!recovered && (rejected.item() || !stuck)) {
+            recovered = unwind(error, !stuck);
+        }
+        
+        // Stop if the parser can't carry on
+        if (!recovered) {
+            error.repair            = syntax_error::stopped;
+            error.repair_symbol     = -1;
+            error.skipped_symbols   = 0;
+            error.popped_states     = 0;
+            m_Errors.push_back(error);
+            return false;
+        }
+        
+        error.skipped_symbols += skipped;
+        
+        // Work out where the parser resumes (after the symbol that was inserted, if there was one)
+        m_ResumePos = m_LookaheadPos;
+        if (error.repair_symbol >= 0) {
+            ++m_ResumePos;
+        }
+        
+        // Store the error
+        if (report) {
+            m_Errors.push_back(error);
+        }
+        
+        return true;
+    }
 }
 
 #endif
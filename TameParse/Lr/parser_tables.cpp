@@ -81,7 +81,10 @@ static inline bool compare_actions(const parser_tables::action& a, const parser_
 
 /// \brief Creates a parser from the result of the specified builder class
 parser_tables::parser_tables(const lalr_builder& builder, const weak_symbols* weakSymbols) 
-: m_DeleteTables(true) {
+: m_DefaultReductions(NULL)
+, m_NumTerminals(0)
+, m_ExpectedTerminals(NULL)
+, m_DeleteTables(true) {
     // Allocate the tables
     m_NumStates             = builder.count_states();
     m_NonterminalActions    = new action*[m_NumStates+1];
@@ -235,10 +238,13 @@ parser_tables::parser_tables(const lalr_builder& builder, const weak_symbols* we
         // Sort the items
         sort(m_WeakToStrong, m_WeakToStrong + m_NumWeakToStrong);
     }
+    
+    // Work out which terminals each state can accept
+    fill_expected_terminals();
 }
 
 /// \brief Creates a parser from a set of tables. Tables passed into this constructor will not be deleted by the destructor
-parser_tables::parser_tables(int numStates, int endOfInputSymbol, int endOfGuardSymbol, action** terminalActions, action** nonterminalActions, action_count* actionCounts, int* endGuardStates, int numEndGuards, int numRules, reduce_rule* reduceRules, int numWeakToStrong, symbol_equivalent* weakToStrong)
+parser_tables::parser_tables(int numStates, int endOfInputSymbol, int endOfGuardSymbol, action** terminalActions, action** nonterminalActions, action_count* actionCounts, int* endGuardStates, int numEndGuards, int numRules, reduce_rule* reduceRules, int numWeakToStrong, symbol_equivalent* weakToStrong, int* defaultReductions, int numTerminals, unsigned int* expectedTerminals)
 : m_NumStates(numStates)
 , m_EndOfInput(endOfInputSymbol)
 , m_EndOfGuard(endOfGuardSymbol)
@@ -251,6 +257,9 @@ parser_tables::parser_tables(int numStates, int endOfInputSymbol, int endOfGuard
 , m_Rules(reduceRules)
 , m_NumWeakToStrong(numWeakToStrong)
 , m_WeakToStrong(weakToStrong)
+, m_DefaultReductions(defaultReductions)
+, m_NumTerminals(expectedTerminals ? numTerminals : 0)
+, m_ExpectedTerminals(expectedTerminals)
 , m_DeleteTables(false) {
 }
 
@@ -260,7 +269,7 @@ parser_tables::parser_tables(const parser_tables& copyFrom)
 , m_NumRules(copyFrom.m_NumRules)
 , m_EndOfInput(copyFrom.m_EndOfInput)
 , m_EndOfGuard(copyFrom.m_EndOfGuard)
-, m_DeleteTables(copyFrom.m_DeleteTables)
+, m_DeleteTables(true)
 , m_NumWeakToStrong(copyFrom.m_NumWeakToStrong) {
     // Allocate the action tables
     m_TerminalActions       = new action*[m_NumStates+1];
@@ -310,6 +319,30 @@ parser_tables::parser_tables(const parser_tables& copyFrom)
     } else {
         m_WeakToStrong = NULL;
     }
+
+    // Copy the default reductions
+    if (copyFrom.m_DefaultReductions) {
+        m_DefaultReductions = new int[m_NumStates+1];
+        
+        for (int x=0; x<m_NumStates; ++x) {
+            m_DefaultReductions[x] = copyFrom.m_DefaultReductions[x];
+        }
+    } else {
+        m_DefaultReductions = NULL;
+    }
+    
+    // Copy the expected terminals
+    m_NumTerminals = copyFrom.m_NumTerminals;
+    if (copyFrom.m_ExpectedTerminals) {
+        int numWords        = m_NumStates * expected_words();
+        m_ExpectedTerminals = new unsigned int[numWords+1];
+        
+        for (int x=0; x<numWords; ++x) {
+            m_ExpectedTerminals[x] = copyFrom.m_ExpectedTerminals[x];
+        }
+    } else {
+        m_ExpectedTerminals = NULL;
+    }
 }
 
 /// \brief Assignment
@@ -332,6 +365,8 @@ parser_tables& parser_tables::operator=(const parser_tables& copyFrom) {
         delete[] m_Counts;
         delete[] m_EndGuardStates;
         if (m_WeakToStrong) delete[] m_WeakToStrong;
+        if (m_DefaultReductions) delete[] m_DefaultReductions;
+        if (m_ExpectedTerminals) delete[] m_ExpectedTerminals;
     }
 
     // Copy the data from the target object
@@ -339,7 +374,7 @@ parser_tables& parser_tables::operator=(const parser_tables& copyFrom) {
     m_NumRules          = copyFrom.m_NumRules;
     m_EndOfInput        = copyFrom.m_EndOfInput;
     m_EndOfGuard        = copyFrom.m_EndOfGuard;
-    m_DeleteTables      = copyFrom.m_DeleteTables;
+    m_DeleteTables      = true;
     m_NumWeakToStrong   = copyFrom.m_NumWeakToStrong;
 
     // Allocate the action tables
@@ -391,6 +426,30 @@ parser_tables& parser_tables::operator=(const parser_tables& copyFrom) {
         m_WeakToStrong = NULL;
     }
 
+    // Copy the default reductions
+    if (copyFrom.m_DefaultReductions) {
+        m_DefaultReductions = new int[m_NumStates+1];
+        
+        for (int x=0; x<m_NumStates; ++x) {
+            m_DefaultReductions[x] = copyFrom.m_DefaultReductions[x];
+        }
+    } else {
+        m_DefaultReductions = NULL;
+    }
+    
+    // Copy the expected terminals
+    m_NumTerminals = copyFrom.m_NumTerminals;
+    if (copyFrom.m_ExpectedTerminals) {
+        int numWords        = m_NumStates * expected_words();
+        m_ExpectedTerminals = new unsigned int[numWords+1];
+        
+        for (int x=0; x<numWords; ++x) {
+            m_ExpectedTerminals[x] = copyFrom.m_ExpectedTerminals[x];
+        }
+    } else {
+        m_ExpectedTerminals = NULL;
+    }
+
     return *this;
 }
 
@@ -410,6 +469,8 @@ parser_tables::~parser_tables() {
         delete[] m_Counts;
         delete[] m_EndGuardStates;
         if (m_WeakToStrong) delete[] m_WeakToStrong;
+        if (m_DefaultReductions) delete[] m_DefaultReductions;
+        if (m_ExpectedTerminals) delete[] m_ExpectedTerminals;
     }
 }
 
@@ -422,6 +483,12 @@ size_t parser_tables::size() const {
     total += 2 * sizeof(action*) * m_NumStates;                 // Size of the nonterminal and terminal action arrays
     total += sizeof(action_count) * m_NumStates;                // m_Counts
     total += sizeof(reduce_rule) * m_NumRules;                  // m_Rules
+    if (m_DefaultReductions) {
+        total += sizeof(int) * m_NumStates;                     // m_DefaultReductions
+    }
+    if (m_ExpectedTerminals) {
+        total += sizeof(unsigned int) * m_NumStates * expected_words(); // m_ExpectedTerminals
+    }
     
     // Add up the size of the various rule arrays
     for (int stateId = 0; stateId < m_NumStates; ++stateId) {
@@ -432,3 +499,124 @@ size_t parser_tables::size() const {
     // This is the result
     return total;
 }
+
+/// \brief Replaces the most common reduce action in each state with a default reduction
+void parser_tables::compress() {
+    // We can only rewrite tables that belong to us
+    if (!m_DeleteTables) return;
+    
+    // Allocate the default reductions table
+    if (!m_DefaultReductions) {
+        m_DefaultReductions = new int[m_NumStates+1];
+        for (int stateId = 0; stateId < m_NumStates; ++stateId) {
+            m_DefaultReductions[stateId] = -1;
+        }
+    }
+    
+    for (int stateId = 0; stateId < m_NumStates; ++stateId) {
+        // Skip states that already have a default reduction
+        if (m_DefaultReductions[stateId] >= 0) continue;
+        
+        action* termActions = m_TerminalActions[stateId];
+        int     termCount   = m_Counts[stateId].numTerminals;
+        
+        // Count the number of terminals that can only reduce each rule. States containing guards or weak reductions
+        // are left alone, as those actions can fall back to others for the same symbol.
+        map<int, int>   reduceCounts;
+        bool            canCompress = true;
+        
+        for (int actionId = 0; actionId < termCount; ++actionId) {
+            const action& act = termActions[actionId];
+            
+            if (act.type == lr_action::act_guard || act.type == lr_action::act_weakreduce) {
+                canCompress = false;
+                break;
+            }
+            
+            // Only count reductions that are the sole action for their symbol
+            if (act.type != lr_action::act_reduce) continue;
+            if (actionId > 0 && termActions[actionId-1].symbolId == act.symbolId) continue;
+            if (actionId+1 < termCount && termActions[actionId+1].symbolId == act.symbolId) continue;
+            
+            reduceCounts[act.nextState]++;
+        }
+        
+        if (!canCompress || reduceCounts.empty()) continue;
+        
+        // Pick the rule that is reduced by the most terminals
+        int defaultRule     = -1;
+        int defaultCount    = 0;
+        
+        for (map<int, int>::const_iterator reduceCount = reduceCounts.begin(); reduceCount != reduceCounts.end(); ++reduceCount) {
+            if (reduceCount->second > defaultCount) {
+                defaultRule     = reduceCount->first;
+                defaultCount    = reduceCount->second;
+            }
+        }
+        
+        // Build a new action table without the actions covered by the default reduction
+        action* newActions  = new action[termCount - defaultCount + 1];
+        int     newCount    = 0;
+        
+        for (int actionId = 0; actionId < termCount; ++actionId) {
+            const action& act = termActions[actionId];
+            
+            if (act.type == lr_action::act_reduce && (int) act.nextState == defaultRule
+                && (actionId == 0 || termActions[actionId-1].symbolId != act.symbolId)
+                && (actionId+1 >= termCount || termActions[actionId+1].symbolId != act.symbolId)) {
+                continue;
+            }
+            
+            newActions[newCount++] = act;
+        }
+        
+        // Replace the old table
+        delete[] termActions;
+        
+        m_TerminalActions[stateId]      = newActions;
+        m_Counts[stateId].numTerminals  = newCount;
+        m_DefaultReductions[stateId]    = defaultRule;
+    }
+    
+    // The terminals that are reduced by default no longer appear in the expected terminals
+    fill_expected_terminals();
+}
+
+/// \brief Rebuilds the expected terminals table from the terminal actions
+void parser_tables::fill_expected_terminals() {
+    // Discard the old table
+    if (m_ExpectedTerminals) delete[] m_ExpectedTerminals;
+    
+    // Find the number of terminals
+    m_NumTerminals = 0;
+    for (int stateId = 0; stateId < m_NumStates; ++stateId) {
+        int numActions = m_Counts[stateId].numTerminals;
+        
+        // The actions are sorted by symbol, so the last one has the highest ID
+        if (numActions > 0 && m_TerminalActions[stateId][numActions-1].symbolId >= m_NumTerminals) {
+            m_NumTerminals = m_TerminalActions[stateId][numActions-1].symbolId + 1;
+        }
+    }
+    
+    // Allocate the table
+    int numWords        = expected_words();
+    m_ExpectedTerminals = new unsigned int[m_NumStates * numWords + 1];
+    
+    for (int x=0; x < m_NumStates * numWords; ++x) {
+        m_ExpectedTerminals[x] = 0;
+    }
+    
+    // Set a bit for every terminal with an action. Ignored terminals are skipped over by the parser rather than
+    // accepted, so they aren't included.
+    for (int stateId = 0; stateId < m_NumStates; ++stateId) {
+        unsigned int*   bits = m_ExpectedTerminals + stateId * numWords;
+        const action*   act  = m_TerminalActions[stateId];
+        
+        for (int actionId = 0; actionId < m_Counts[stateId].numTerminals; ++actionId) {
+            if (act[actionId].type == lr_action::act_ignore) continue;
+            
+            int terminal = act[actionId].symbolId;
+            bits[terminal / 32] |= 1u << (terminal % 32);
+        }
+    }
+}
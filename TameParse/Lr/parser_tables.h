@@ -132,6 +132,17 @@ namespace lr {
         
         /// \brief Ordered list of weak symbols and their strong equivalent
         symbol_equivalent* m_WeakToStrong;
+        
+        /// \brief The rule to reduce in each state when the lookahead terminal has no action (-1 for states with no default), or NULL if there are no default reductions
+        int* m_DefaultReductions;
+        
+        /// \brief The number of terminal symbols in the expected terminals table (0 if there is no table)
+        int m_NumTerminals;
+        
+        /// \brief For each state, a bitset of the terminal symbols that have an action (other than being ignored), or NULL
+        ///
+        /// Each state has expected_words() entries: bit (n%32) of entry (n/32) is set if terminal n has an action.
+        unsigned int* m_ExpectedTerminals;
 
         /// \brief True if this object owns the tables
         bool m_DeleteTables;
@@ -141,7 +152,7 @@ namespace lr {
         parser_tables(const lalr_builder& builder, const weak_symbols* weakSyms);
 
         /// \brief Creates a parser from a set of tables. Tables passed into this constructor will not be deleted by the destructor
-        parser_tables(int numStates, int endOfInputSymbol, int endOfGuardSymbol, action** terminalActions, action** nonterminalActions, action_count* actionCounts, int* endGuardStates, int numEndGuards, int numRules, reduce_rule* reduceRules, int numWeakToStrong, symbol_equivalent* weakToStrong);
+        parser_tables(int numStates, int endOfInputSymbol, int endOfGuardSymbol, action** terminalActions, action** nonterminalActions, action_count* actionCounts, int* endGuardStates, int numEndGuards, int numRules, reduce_rule* reduceRules, int numWeakToStrong, symbol_equivalent* weakToStrong, int* defaultReductions = NULL, int numTerminals = 0, unsigned int* expectedTerminals = NULL);
 
         /// \brief Copy constructor
         parser_tables(const parser_tables& copyFrom);
@@ -155,7 +166,21 @@ namespace lr {
         /// \brief Calculates the size in bytes of these parser tables
         virtual size_t size() const;
         
+        /// \brief Replaces the most common reduce action in each state with a default reduction
+        ///
+        /// A terminal whose only action in a state is to reduce the default rule no longer needs an entry in the
+        /// terminal action table: the parser performs the default reduction for any terminal that has no actions.
+        /// States that contain only a single reduction (consistent states) end up with no terminal actions at all.
+        /// As with yacc, this can cause a few extra reductions to happen before a syntax error is detected, but
+        /// it does not change the language that is accepted.
+        ///
+        /// This has no effect on tables that do not own their data.
+        void compress();
+        
     private:
+        /// \brief Rebuilds the expected terminals table from the terminal actions
+        void fill_expected_terminals();
+        
         /// \brief Compares a symbol to an action
         inline static bool compare_symbols(const action& a, const action& compareTo) {
             return a.symbolId < compareTo.symbolId;
@@ -195,6 +220,29 @@ namespace lr {
             return find_action(nonterminal, m_NonterminalActions[stateId], m_Counts[stateId].numNonterminals);
         }
         
+        /// \brief Returns the rule that should be reduced in the specified state if the lookahead terminal has no actions, or -1 if there is no default reduction
+        inline int default_reduction(int stateId) const {
+            return m_DefaultReductions ? m_DefaultReductions[stateId] : -1;
+        }
+        
+        /// \brief Finds the actions for a terminal symbol in the specified state, substituting the default reduction if the terminal has no actions
+        ///
+        /// defaultAction is used to store the default reduction action if it is needed, so it must remain valid while
+        /// the returned actions are being used.
+        inline void find_terminal_actions(int stateId, int terminal, action_iterator& act, action_iterator& end, action& defaultAction) const {
+            act = find_terminal(stateId, terminal);
+            end = last_terminal_action(stateId);
+            
+            if ((act == end || act->symbolId != terminal) && default_reduction(stateId) >= 0) {
+                defaultAction.type      = lr_action::act_reduce;
+                defaultAction.nextState = m_DefaultReductions[stateId];
+                defaultAction.symbolId  = terminal;
+                
+                act = &defaultAction;
+                end = act + 1;
+            }
+        }
+        
         /// \brief Returns the nonterminal identifier representing the end of input symbol
         inline int end_of_input() const { return m_EndOfInput; }
         
@@ -268,6 +316,26 @@ namespace lr {
 
         /// \brief The weak-to-strong equivalence table (ordered, count_weak_to_strong entries)
         inline const symbol_equivalent* weak_to_strong() const { return m_WeakToStrong; }
+        
+        /// \brief The default reduction for each state (one entry per state, -1 if a state has no default), or NULL if these tables have no default reductions
+        inline const int* default_reductions() const { return m_DefaultReductions; }
+        
+        /// \brief The number of terminal symbols covered by the expected terminals table, or 0 if these tables don't have one
+        inline int count_terminals() const { return m_NumTerminals; }
+        
+        /// \brief The number of entries in the expected terminals table for each state
+        inline int expected_words() const { return (m_NumTerminals + 31) / 32; }
+        
+        /// \brief The expected terminals table (expected_words() entries for each state), or NULL if these tables don't have one
+        inline const unsigned int* expected_terminals() const { return m_ExpectedTerminals; }
+        
+        /// \brief A bitset of the terminal symbols with actions in the specified state, or NULL if these tables have no expected terminals table
+        ///
+        /// Bit (n%32) of entry (n/32) is set if terminal n has an action. Terminals that are reduced by the default
+        /// reduction for the state are not included.
+        inline const unsigned int* expected_terminals(int stateId) const {
+            return m_ExpectedTerminals ? m_ExpectedTerminals + stateId * expected_words() : NULL;
+        }
     };
 }
 
@@ -0,0 +1,142 @@
+//
+//  push_parser.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _LR_PUSH_PARSER_H
+#define _LR_PUSH_PARSER_H
+
+#include "TameParse/Dfa/push_lexer.h"
+#include "TameParse/Lr/parser.h"
+#include "TameParse/Lr/batch_parser.h"
+
+namespace lr {
+    ///
+    /// \brief Parser that is given its input a piece at a time
+    ///
+    /// This is useful when the document arrives in pieces (from a network connection, for instance) and the
+    /// caller can't block waiting for the rest of it. Each piece is passed to feed(), which lexes and parses as
+    /// much of it as it can and then returns; finish() is called once the whole document has been received.
+    /// Only the characters of the lexeme that is currently being matched are kept between calls.
+    ///
+    /// The actions are created with a NULL stream (they never read from it, as the lexemes are fed to the parser
+    /// state).
+    ///
+    template<typename item_type, typename parser_actions, typename parser_trace = no_parser_trace, typename actions_factory = stream_actions_factory<parser_actions> > 
+    class push_parser {
+    public:
+        /// \brief The type of parser used by the push parser
+        typedef parser<item_type, parser_actions, parser_trace> parser_type;
+        
+        /// \brief The type of the parser state
+        typedef typename parser_type::state state_type;
+        
+    private:
+        /// \brief The lexer that splits the input into lexemes
+        dfa::push_lexer m_Lexer;
+        
+        /// \brief The parser state
+        state_type* m_State;
+        
+        /// \brief The result of the parse so far
+        parser_result::result m_Result;
+        
+        push_parser(const push_parser& noCopying);
+        push_parser& operator=(const push_parser& noCopying);
+        
+    public:
+        /// \brief Creates a push parser that will use the specified parser and lexer
+        push_parser(const parser_type& parser, const dfa::basic_lexer& lexer, int initialState = 0)
+        : m_Lexer(lexer)
+        , m_State(parser.create_parser(actions_factory::create(NULL), initialState))
+        , m_Result(parser_result::more) {
+        }
+        
+        /// \brief Destructor
+        ~push_parser() {
+            delete m_State;
+        }
+        
+    private:
+        /// \brief Passes the lexemes that are ready to the parser
+        void parse_lexemes() {
+            while (m_Result == parser_result::more) {
+                dfa::lexeme* next = m_Lexer.next();
+                if (!next) break;
+                
+                m_Result = m_State->feed(dfa::lexeme_container(next, true));
+            }
+        }
+        
+    public:
+        ///
+        /// \brief Adds some characters to the end of the document, and parses as much of it as possible
+        ///
+        /// Returns parser_result::more if the parser needs more input, or accept or reject if the parse has finished
+        /// (any more input is ignored once the parse has finished).
+        ///
+        template<typename iterator> parser_result::result feed(iterator begin, iterator end) {
+            if (m_Result != parser_result::more) return m_Result;
+            
+            m_Lexer.feed(begin, end);
+            parse_lexemes();
+            
+            return m_Result;
+        }
+        
+        /// \brief Adds a string to the end of the document, and parses as much of it as possible
+        template<typename string_type> inline parser_result::result feed(const string_type& text) {
+            return feed(text.begin(), text.end());
+        }
+        
+        /// \brief Indicates that the end of the document has been reached, and finishes the parse
+        ///
+        /// The result is parser_result::accept or parser_result::reject.
+        parser_result::result finish() {
+            if (m_Result != parser_result::more) return m_Result;
+            
+            m_Lexer.finish();
+            parse_lexemes();
+            
+            if (m_Result == parser_result::more) {
+                m_Result = m_State->finish();
+            }
+            
+            return m_Result;
+        }
+        
+        /// \brief The result of the parse so far
+        inline parser_result::result result() const { return m_Result; }
+        
+        /// \brief True if the document has been accepted
+        inline bool accepted() const { return m_Result == parser_result::accept; }
+        
+        /// \brief The parser state (which contains the final item once the document has been accepted)
+        inline state_type* get_state() { return m_State; }
+        
+        /// \brief The number of characters that have been received but not yet passed to the parser
+        inline size_t pending() const { return m_Lexer.pending(); }
+    };
+}
+
+#endif
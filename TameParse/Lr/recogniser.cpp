@@ -0,0 +1,239 @@
+//
+//  recogniser.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include "TameParse/Lr/recogniser.h"
+
+using namespace std;
+using namespace dfa;
+using namespace lr;
+
+/// \brief Creates a recogniser for the language defined by the specified parser tables
+recogniser::recogniser(const parser_tables& tables)
+: m_Tables(&tables)
+, m_LookaheadPos(0)
+, m_EndOfInput(false)
+, m_SymbolsRead(0)
+, m_GuardDepth(0)
+, m_ErrorSymbol(-1)
+, m_ErrorPosition(-1, -1, -1) {
+}
+
+/// \brief Reads the symbols from the specified stream, and returns true if they are accepted by the parser
+bool recogniser::recognise(lexeme_stream* stream, int initialState) {
+    stream_reader reader(stream);
+    return recognise_from(reader, initialState);
+}
+
+/// \brief Moves past the current lookahead symbol
+void recogniser::next() {
+    ++m_LookaheadPos;
+
+    // Start filling the lookahead from the beginning once everything in it has been used up
+    if (m_LookaheadPos >= m_Lookahead.size()) {
+        m_Lookahead.clear();
+        m_LookaheadPos = 0;
+    }
+}
+
+/// \brief Performs the actions for a guard symbol, returning false if it can't be shifted
+bool recogniser::process_guard(state_stack& stack, int guardSymbol) {
+    // Fetch the actions for this symbol
+    int             state   = stack.back();
+    action_iterator act     = m_Tables->find_nonterminal(state, guardSymbol);
+    action_iterator end     = m_Tables->last_nonterminal_action(state);
+
+    if (act == end)                     return false;
+    if (act->symbolId != guardSymbol)   return false;
+
+    // Check that the guard symbol will eventually be shifted
+    bool canReduce = false;
+    for (action_iterator checkAction = act; checkAction != end; ++checkAction) {
+        if (checkAction->symbolId != guardSymbol) break;
+
+        if (checkAction->type == lr_action::act_reduce || checkAction->type == lr_action::act_weakreduce) {
+            if (can_reduce(guardSymbol, false, checkAction, stack)) {
+                canReduce = true;
+                break;
+            }
+        } else if (checkAction->type == lr_action::act_shift || checkAction->type == lr_action::act_shiftstrong) {
+            canReduce = true;
+            break;
+        }
+    }
+
+    if (!canReduce) {
+        return false;
+    }
+
+    // Perform actions until the guard symbol is shifted
+    for (;;) {
+        if (act == end || act->symbolId != guardSymbol) {
+            // can_reduce was wrong (the parser does the same thing here)
+            return true;
+        }
+
+        if (act->type == lr_action::act_weakreduce && !can_reduce(guardSymbol, false, act, stack)) {
+            ++act;
+            continue;
+        }
+
+        if (act->type == lr_action::act_guard) {
+            ++act;
+            continue;
+        }
+
+        if (perform(stack, act)) {
+            break;
+        }
+
+        state   = stack.back();
+        act     = m_Tables->find_nonterminal(state, guardSymbol);
+        end     = m_Tables->last_nonterminal_action(state);
+    }
+
+    return true;
+}
+
+/// \brief Returns true if performing the specified action will eventually result in the symbol being shifted
+bool recogniser::can_reduce(int sym, bool isTerminal, action_iterator act, const state_stack& stack) {
+    // Accepting or shifting actions always succeed
+    if (act->type == lr_action::act_shift || act->type == lr_action::act_shiftstrong || act->type == lr_action::act_accept) {
+        return true;
+    }
+
+    // Fake up the action, then see if the symbol is shifted afterwards
+    size_t  pushedBase  = m_Pushed.size();
+    int     stackPos    = (int) stack.size() - 1;
+
+    fake_reduce(act, stack, stackPos, pushedBase);
+    bool result = can_reduce(sym, isTerminal, stack, stackPos, pushedBase);
+
+    // Throw away the fake states
+    m_Pushed.resize(pushedBase);
+    return result;
+}
+
+/// \brief Returns true if a symbol will be shifted from a stack made up of the specified stack up to stackPos, followed by the states in m_Pushed from pushedBase
+bool recogniser::can_reduce(int sym, bool isTerminal, const state_stack& stack, int stackPos, size_t pushedBase) {
+    // Get the actions for the current state
+    action_iterator         act;
+    action_iterator         end;
+    parser_tables::action   defaultAction;
+
+    find_actions(fake_state(stack, stackPos, pushedBase), sym, isTerminal, act, end, defaultAction);
+
+    while (act != end) {
+        // Fail if there are no actions for this symbol
+        if (act->symbolId != sym) return false;
+
+        switch (act->type) {
+            case lr_action::act_shift:
+            case lr_action::act_shiftstrong:
+            case lr_action::act_accept:
+                // The symbol will be shifted
+                return true;
+
+            case lr_action::act_guard:
+                // Guards are ignored, as for the parser
+                ++act;
+                break;
+
+            case lr_action::act_weakreduce:
+            {
+                // Try the reduction on a copy of the fake stack
+                size_t  weakBase    = m_Pushed.size();
+                int     weakPos     = stackPos;
+
+                for (size_t pushed = pushedBase; pushed < weakBase; ++pushed) {
+                    m_Pushed.push_back(m_Pushed[pushed]);
+                }
+
+                fake_reduce(act, stack, weakPos, weakBase);
+                bool result = can_reduce(sym, isTerminal, stack, weakPos, weakBase);
+                m_Pushed.resize(weakBase);
+
+                if (result) {
+                    return true;
+                }
+
+                // Keep looking for a stronger action
+                ++act;
+                break;
+            }
+
+            case lr_action::act_reduce:
+            case lr_action::act_divert:
+                // Update the fake stack and carry on from the new state
+                fake_reduce(act, stack, stackPos, pushedBase);
+                find_actions(fake_state(stack, stackPos, pushedBase), sym, isTerminal, act, end, defaultAction);
+                break;
+
+            default:
+                // Other actions fail
+                return false;
+        }
+    }
+
+    // Result is false if we run out of actions
+    return false;
+}
+
+/// \brief Updates a fake stack (as used by can_reduce) as if the specified action had been performed
+void recogniser::fake_reduce(action_iterator act, const state_stack& stack, int& stackPos, size_t pushedBase) {
+    switch (act->type) {
+        case lr_action::act_reduce:
+        case lr_action::act_weakreduce:
+        case lr_action::act_accept:
+        {
+            // Pop the states for the rule
+            const parser_tables::reduce_rule& rule = m_Tables->rule(act->nextState);
+
+            for (int x=0; x<rule.length; ++x) {
+                if (m_Pushed.size() > pushedBase) {
+                    m_Pushed.pop_back();
+                } else {
+                    --stackPos;
+                }
+            }
+
+            // Push the goto state
+            int gotoState = goto_state(fake_state(stack, stackPos, pushedBase), rule.identifier);
+            if (gotoState >= 0) {
+                m_Pushed.push_back(gotoState);
+            }
+            break;
+        }
+
+        case lr_action::act_divert:
+            // Divert actions push a new state, as for the parser
+            m_Pushed.push_back(act->nextState);
+            break;
+
+        case lr_action::act_shift:
+        case lr_action::act_shiftstrong:
+            m_Pushed.push_back(act->nextState);
+            break;
+    }
+}
@@ -0,0 +1,407 @@
+//
+//  recogniser.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _LR_RECOGNISER_H
+#define _LR_RECOGNISER_H
+
+#include <vector>
+#include <deque>
+
+#include "TameParse/Dfa/position.h"
+#include "TameParse/Dfa/lexer.h"
+#include "TameParse/Lr/parser_tables.h"
+#include "TameParse/Lr/lr_action.h"
+
+namespace lr {
+    ///
+    /// \brief Checks whether or not some input is in a language without building anything from it
+    ///
+    /// The recogniser runs the same tables as lr::parser, but its stack only contains state numbers and its lookahead
+    /// only contains symbol IDs and positions, which are read from the lexer with lexeme_stream::read_symbol(). There
+    /// are no items, so there are no parser actions: the result is just whether or not the input was accepted, and
+    /// where the first error is if it was not.
+    ///
+    /// The storage used by a recogniser is kept between calls to recognise(), so a recogniser that is reused for
+    /// many documents stops allocating memory once it has grown to fit them.
+    ///
+    /// recognise_from() reads symbols from any class with an inline next_symbol() method that works like read_symbol().
+    /// Generated parsers use this with dfa::symbol_reader, so that the lexer and the parser run in a single loop
+    /// with no virtual calls. dfa::batch_reader can be used to read tokens from a lexeme stream in batches.
+    ///
+    class recogniser {
+    public:
+        /// \brief Iterator for parser actions
+        typedef parser_tables::action_iterator action_iterator;
+
+    private:
+        /// \brief A lookahead symbol
+        struct symbol {
+            /// \brief The ID of the terminal that was matched
+            int matched;
+
+            /// \brief Where the symbol begins in the input
+            dfa::position pos;
+        };
+
+        /// \brief A stack of parser states
+        typedef std::vector<int> state_stack;
+
+        /// \brief Reads symbols from a lexeme stream
+        class stream_reader {
+        private:
+            /// \brief The stream to read from
+            dfa::lexeme_stream* m_Stream;
+
+        public:
+            explicit stream_reader(dfa::lexeme_stream* stream) : m_Stream(stream) { }
+
+            /// \brief Reads the next symbol from the stream
+            inline bool next_symbol(int& matched, dfa::position& pos) { return m_Stream->read_symbol(matched, pos); }
+        };
+
+        /// \brief The tables for the parser being recognised
+        const parser_tables* m_Tables;
+
+        /// \brief The symbols that have been read but not yet consumed
+        std::vector<symbol> m_Lookahead;
+
+        /// \brief The index into m_Lookahead of the current lookahead symbol
+        size_t m_LookaheadPos;
+
+        /// \brief True once the stream has run out of symbols
+        bool m_EndOfInput;
+
+        /// \brief The number of symbols read by the last call to recognise()
+        size_t m_SymbolsRead;
+
+        /// \brief The position of the end of the input
+        dfa::position m_EndPosition;
+
+        /// \brief The parser stack
+        state_stack m_Stack;
+
+        /// \brief Stacks used while checking guards (one for each level of nesting)
+        std::deque<state_stack> m_GuardStacks;
+
+        /// \brief The number of guards that are currently being checked
+        size_t m_GuardDepth;
+
+        /// \brief States pushed while working out whether or not a weak reduction will succeed
+        state_stack m_Pushed;
+
+        /// \brief The symbol that was rejected, or -1 if the input ended too soon
+        int m_ErrorSymbol;
+
+        /// \brief The position of the symbol that was rejected
+        dfa::position m_ErrorPosition;
+
+    public:
+        /// \brief Creates a recogniser for the language defined by the specified parser tables
+        ///
+        /// The tables are not copied, so they must remain valid for as long as the recogniser is in use.
+        explicit recogniser(const parser_tables& tables);
+
+        ///
+        /// \brief Reads the symbols from the specified stream, and returns true if they are accepted by the parser
+        ///
+        /// The initial state is the index of the start symbol, as for lr::parser::create_parser(). The stream is not
+        /// deleted by this call. If the input is rejected, error_symbol() and error_position() describe where the
+        /// problem was.
+        ///
+        bool recognise(dfa::lexeme_stream* stream, int initialState = 0);
+
+        /// \brief Reads the symbols from a reader with a next_symbol() method, and returns true if they are accepted by the parser
+        template<class symbol_reader> bool recognise_from(symbol_reader& reader, int initialState = 0);
+
+        /// \brief The terminal symbol that caused the last call to recognise() to fail, or -1 if the input ended unexpectedly
+        inline int error_symbol() const { return m_ErrorSymbol; }
+
+        /// \brief The position of the symbol that caused the last call to recognise() to fail
+        inline const dfa::position& error_position() const { return m_ErrorPosition; }
+
+        /// \brief The number of symbols read from the input by the last call to recognise()
+        inline size_t symbols_read() const { return m_SymbolsRead; }
+
+    private:
+        /// \brief Returns the lookahead symbol at the specified offset, or NULL if it is past the end of the input
+        template<class symbol_reader> inline const symbol* look(symbol_reader& reader, size_t offset);
+
+        /// \brief Moves past the current lookahead symbol
+        void next();
+
+        /// \brief Finds the actions for a symbol in the specified state
+        inline void find_actions(int state, int sym, bool isTerminal, action_iterator& act, action_iterator& end, parser_tables::action& defaultAction) const {
+            if (isTerminal) {
+                m_Tables->find_terminal_actions(state, sym, act, end, defaultAction);
+            } else {
+                act = m_Tables->find_nonterminal(state, sym);
+                end = m_Tables->last_nonterminal_action(state);
+            }
+        }
+
+        ///
+        /// \brief Runs the parser on the specified stack until the lookahead is accepted or rejected
+        ///
+        /// Returns the nonterminal that was accepted or -1 if the lookahead was rejected. When checking a guard, the
+        /// lookahead is read starting at the specified offset, and the end of guard symbol is reduced as soon as
+        /// possible.
+        ///
+        template<class symbol_reader> int run(symbol_reader& reader, state_stack& stack, size_t offset, bool isGuard);
+
+        /// \brief Returns the state that the parser moves to from the specified state after reducing a nonterminal, or -1 if there isn't one
+        inline int goto_state(int state, int nonterminal) const {
+            for (action_iterator gotoAct = m_Tables->find_nonterminal(state, nonterminal); gotoAct != m_Tables->last_nonterminal_action(state); ++gotoAct) {
+                if (gotoAct->type == lr_action::act_goto) {
+                    return gotoAct->nextState;
+                }
+            }
+
+            return -1;
+        }
+
+        /// \brief Performs an action on a stack, returning true if the lookahead symbol should be consumed
+        inline bool perform(state_stack& stack, const parser_tables::action* act);
+
+        /// \brief Returns the guard symbol matched by the lookahead at the specified offset, or -1 if the guard is not matched
+        template<class symbol_reader> int check_guard(symbol_reader& reader, int initialState, size_t offset);
+
+        /// \brief Performs the actions for a guard symbol, returning false if it can't be shifted
+        bool process_guard(state_stack& stack, int guardSymbol);
+
+        /// \brief Returns true if performing the specified action will eventually result in the symbol being shifted
+        bool can_reduce(int sym, bool isTerminal, action_iterator act, const state_stack& stack);
+
+        /// \brief Returns true if a symbol will be shifted from a stack made up of the specified stack up to stackPos, followed by the states in m_Pushed from pushedBase
+        bool can_reduce(int sym, bool isTerminal, const state_stack& stack, int stackPos, size_t pushedBase);
+
+        /// \brief Updates a fake stack (as used by can_reduce) as if the specified action had been performed
+        void fake_reduce(action_iterator act, const state_stack& stack, int& stackPos, size_t pushedBase);
+
+        /// \brief The state on top of a fake stack
+        inline int fake_state(const state_stack& stack, int stackPos, size_t pushedBase) const {
+            if (m_Pushed.size() > pushedBase) return m_Pushed.back();
+            return stack[stackPos];
+        }
+    };
+
+    /// \brief Performs an action on a stack, returning true if the lookahead symbol should be consumed
+    inline bool recogniser::perform(state_stack& stack, const parser_tables::action* act) {
+        switch (act->type) {
+            case lr_action::act_ignore:
+                // Discard the lookahead
+                return true;
+
+            case lr_action::act_shift:
+            case lr_action::act_shiftstrong:
+                // Push the new state
+                stack.push_back(act->nextState);
+                return true;
+
+            case lr_action::act_divert:
+                // Push the new state, leaving the lookahead as-is
+                stack.push_back(act->nextState);
+                return false;
+
+            case lr_action::act_reduce:
+            case lr_action::act_weakreduce:
+            case lr_action::act_accept:
+            {
+                // Pop the states for the rule, then go to the state for the nonterminal
+                const parser_tables::reduce_rule& rule = m_Tables->rule(act->nextState);
+                stack.resize(stack.size() - rule.length);
+
+                int gotoState = goto_state(stack.back(), rule.identifier);
+                if (gotoState >= 0) {
+                    stack.push_back(gotoState);
+                }
+                return false;
+            }
+
+            case lr_action::act_goto:
+                stack.back() = act->nextState;
+                return false;
+
+            case lr_action::act_guard:
+                // Guards are handled by run()
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    /// \brief Reads the symbols from a reader with a next_symbol() method, and returns true if they are accepted by the parser
+    template<class symbol_reader> bool recogniser::recognise_from(symbol_reader& reader, int initialState) {
+        // Reset the state left behind by the last call (the storage is kept)
+        m_LookaheadPos  = 0;
+        m_EndOfInput    = false;
+        m_SymbolsRead   = 0;
+        m_GuardDepth    = 0;
+        m_ErrorSymbol   = -1;
+        m_ErrorPosition = dfa::position(-1, -1, -1);
+
+        m_Lookahead.clear();
+        m_Stack.clear();
+        m_Pushed.clear();
+        m_Stack.push_back(initialState);
+
+        // Run the parser until it accepts or rejects
+        return run(reader, m_Stack, 0, false) >= 0;
+    }
+
+    /// \brief Returns the lookahead symbol at the specified offset, or NULL if it is past the end of the input
+    template<class symbol_reader> inline const recogniser::symbol* recogniser::look(symbol_reader& reader, size_t offset) {
+        size_t pos = m_LookaheadPos + offset;
+
+        // Read symbols until the requested one is available
+        while (pos >= m_Lookahead.size()) {
+            if (m_EndOfInput) return NULL;
+
+            symbol next;
+            if (!reader.next_symbol(next.matched, next.pos)) {
+                m_EndOfInput    = true;
+                m_EndPosition   = next.pos;
+                return NULL;
+            }
+
+            m_Lookahead.push_back(next);
+            ++m_SymbolsRead;
+        }
+
+        return &m_Lookahead[pos];
+    }
+
+    /// \brief Runs the parser on the specified stack until the lookahead is accepted or rejected
+    template<class symbol_reader> int recogniser::run(symbol_reader& reader, state_stack& stack, size_t offset, bool isGuard) {
+        for (;;) {
+            // Fetch the lookahead (end of input counts as a nonterminal)
+            const symbol*   la          = look(reader, offset);
+            int             state       = stack.back();
+            int             sym         = la ? la->matched : m_Tables->end_of_input();
+            bool            isTerminal  = la != NULL;
+
+            action_iterator         act;
+            action_iterator         end;
+            parser_tables::action   defaultAction;
+
+            find_actions(state, sym, isTerminal, act, end, defaultAction);
+
+            // Guards reduce the end of guard symbol as soon as possible
+            if (isGuard && m_Tables->has_end_of_guard(state)) {
+                action_iterator eogAct = m_Tables->find_nonterminal(state, m_Tables->end_of_guard());
+
+                if (eogAct != m_Tables->last_nonterminal_action(state) && eogAct->symbolId == m_Tables->end_of_guard()
+                    && can_reduce(m_Tables->end_of_guard(), false, eogAct, stack)) {
+                    sym         = m_Tables->end_of_guard();
+                    isTerminal  = false;
+                    act         = eogAct;
+                    end         = m_Tables->last_nonterminal_action(state);
+                }
+            }
+
+            // Work out which action to perform
+            bool ok = false;
+            for (; act != end; ++act) {
+                // Stop searching if the symbol is invalid
+                if (act->symbolId != sym) break;
+
+                if (act->type == lr_action::act_weakreduce) {
+                    // Weak reductions are only performed if the symbol will be shifted afterwards
+                    if (!can_reduce(sym, isTerminal, act, stack)) {
+                        continue;
+                    }
+                } else if (act->type == lr_action::act_guard) {
+                    // Check the guard, and try the next action if it's not matched
+                    int guardSym = check_guard(reader, act->nextState, offset);
+                    if (guardSym < 0) {
+                        continue;
+                    }
+
+                    // Perform the actions for the guard symbol
+                    if (process_guard(stack, guardSym)) {
+                        ok = true;
+                        break;
+                    } else {
+                        continue;
+                    }
+                } else if (act->type == lr_action::act_accept) {
+                    // Accepting actions finish the parse
+                    return m_Tables->rule(act->nextState).identifier;
+                }
+
+                // Perform this action, moving on to the next symbol if needed
+                if (perform(stack, act)) {
+                    if (isGuard) {
+                        ++offset;
+                    } else {
+                        next();
+                    }
+                }
+
+                ok = true;
+                break;
+            }
+
+            // Reject if no action could be performed
+            if (!ok) {
+                if (!isGuard) {
+                    // Checking guards may have read more symbols, so look up the lookahead again
+                    la = look(reader, offset);
+
+                    if (la) {
+                        m_ErrorSymbol   = la->matched;
+                        m_ErrorPosition = la->pos;
+                    } else {
+                        m_ErrorSymbol   = -1;
+                        m_ErrorPosition = m_EndPosition;
+                    }
+                }
+
+                return -1;
+            }
+        }
+    }
+
+    /// \brief Returns the guard symbol matched by the lookahead at the specified offset, or -1 if the guard is not matched
+    template<class symbol_reader> int recogniser::check_guard(symbol_reader& reader, int initialState, size_t offset) {
+        // Fetch a stack for this guard (a deque is used so that nested guards don't move it)
+        if (m_GuardDepth >= m_GuardStacks.size()) {
+            m_GuardStacks.push_back(state_stack());
+        }
+
+        state_stack& guardStack = m_GuardStacks[m_GuardDepth];
+        guardStack.clear();
+        guardStack.push_back(initialState);
+
+        // Run the guard
+        ++m_GuardDepth;
+        int result = run(reader, guardStack, offset, true);
+        --m_GuardDepth;
+
+        return result;
+    }
+}
+
+#endif
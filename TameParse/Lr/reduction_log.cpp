@@ -0,0 +1,82 @@
+//
+//  reduction_log.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <algorithm>
+
+#include "TameParse/Lr/reduction_log.h"
+
+using namespace std;
+using namespace dfa;
+using namespace lr;
+
+/// \brief Value used to indicate 'no entry'
+const reduction_log::entry_id reduction_log::no_entry;
+
+/// \brief Creates an empty log
+reduction_log::reduction_log() {
+}
+
+/// \brief Removes all of the entries from this log
+void reduction_log::clear() {
+    m_Entries.clear();
+    m_Lexemes.clear();
+}
+
+/// \brief Retrieves the child items of a reduction, in the order that they appear in the rule
+void reduction_log::children(entry_id id, vector<entry_id>& result) const {
+    result.clear();
+
+    for (entry_id child = last_child(id); child != no_entry; child = previous_sibling(id, child)) {
+        result.push_back(child);
+    }
+
+    reverse(result.begin(), result.end());
+}
+
+/// \brief Creates a new object that will read from the specified stream
+reduction_log_actions::reduction_log_actions(lexeme_stream* stream, bool ownStream)
+: m_Stream(stream)
+, m_OwnStream(ownStream)
+, m_Reader(stream) {
+}
+
+/// \brief Destructor
+reduction_log_actions::~reduction_log_actions() {
+    if (m_OwnStream && m_Stream) {
+        delete m_Stream;
+        m_Stream = NULL;
+    }
+}
+
+/// \brief Starts reading from a new stream, discarding the existing log
+void reduction_log_actions::reset(lexeme_stream* stream) {
+    if (m_OwnStream && m_Stream && m_Stream != stream) {
+        delete m_Stream;
+    }
+
+    m_Stream = stream;
+    m_Reader.reset(stream);
+    m_Log.clear();
+}
@@ -0,0 +1,227 @@
+//
+//  reduction_log.h
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#ifndef _LR_REDUCTION_LOG_H
+#define _LR_REDUCTION_LOG_H
+
+#include <vector>
+
+#include "TameParse/Dfa/lexeme.h"
+#include "TameParse/Dfa/lexer.h"
+
+namespace lr {
+    ///
+    /// \brief Record of the actions performed by a parser, from which an AST can be built later on
+    ///
+    /// Each shift and reduce action adds an entry to the end of the log. As the parser always reduces the
+    /// items on the top of its stack, the log is a postfix representation of the parse tree: the children of
+    /// a reduction are the subtrees that immediately precede it. Each entry records where its subtree starts,
+    /// so the children can be found by walking backwards from an entry without storing them separately.
+    ///
+    class reduction_log {
+    public:
+        /// \brief Identifies an entry in the log
+        typedef unsigned int entry_id;
+
+        /// \brief Value used to indicate 'no entry'
+        static const entry_id no_entry = 0xffffffffu;
+
+        /// \brief An entry in the log
+        struct entry {
+            /// \brief The rule that was reduced, or -1 if this entry is for a terminal symbol
+            int rule;
+
+            /// \brief The nonterminal or terminal symbol identifier
+            int symbol;
+
+            /// \brief The number of items in the rule
+            unsigned int length;
+
+            /// \brief The entry where the subtree for this entry begins
+            entry_id first;
+
+            /// \brief The index of the first lexeme covered by this entry
+            unsigned int firstToken;
+
+            /// \brief One past the index of the final lexeme covered by this entry
+            unsigned int endToken;
+
+            /// \brief The position of the lookahead symbol when this rule was reduced
+            dfa::position lookahead;
+        };
+
+    private:
+        /// \brief The entries in this log
+        std::vector<entry> m_Entries;
+
+        /// \brief The lexemes that were shifted, in order
+        std::vector<dfa::lexeme_container> m_Lexemes;
+
+    public:
+        /// \brief Creates an empty log
+        reduction_log();
+
+        /// \brief Removes all of the entries from this log
+        void clear();
+
+        /// \brief Adds a terminal symbol to this log
+        inline entry_id add_terminal(const dfa::lexeme_container& lexeme) {
+            entry newEntry;
+
+            newEntry.rule       = -1;
+            newEntry.symbol     = lexeme->matched();
+            newEntry.length     = 0;
+            newEntry.first      = (entry_id) m_Entries.size();
+            newEntry.firstToken = (unsigned int) m_Lexemes.size();
+            newEntry.endToken   = newEntry.firstToken + 1;
+
+            m_Lexemes.push_back(lexeme);
+            m_Entries.push_back(newEntry);
+            return newEntry.first;
+        }
+
+        /// \brief Adds a reduction to this log
+        ///
+        /// The items are supplied in the order that the parser supplies them, which is the reverse of the order
+        /// that they appear in the rule.
+        inline entry_id add_reduction(int nonterminal, int rule, const std::vector<entry_id>& items, const dfa::position& lookaheadPosition) {
+            entry newEntry;
+
+            newEntry.rule       = rule;
+            newEntry.symbol     = nonterminal;
+            newEntry.length     = (unsigned int) items.size();
+            newEntry.lookahead  = lookaheadPosition;
+
+            if (items.empty()) {
+                // Empty rules cover no lexemes
+                newEntry.first      = (entry_id) m_Entries.size();
+                newEntry.firstToken = (unsigned int) m_Lexemes.size();
+            } else {
+                // The subtree begins with the subtree of the first item
+                const entry& firstItem = m_Entries[items.back()];
+
+                newEntry.first      = firstItem.first;
+                newEntry.firstToken = firstItem.firstToken;
+            }
+            newEntry.endToken = (unsigned int) m_Lexemes.size();
+
+            m_Entries.push_back(newEntry);
+            return (entry_id) (m_Entries.size() - 1);
+        }
+
+    public:
+        /// \brief The number of entries in this log
+        inline size_t size() const { return m_Entries.size(); }
+
+        /// \brief Retrieves the entry with the specified identifier
+        inline const entry& operator[](entry_id id) const { return m_Entries[id]; }
+
+        /// \brief True if the specified entry represents a terminal symbol
+        inline bool is_terminal(entry_id id) const { return m_Entries[id].rule < 0; }
+
+        /// \brief The lexeme for a terminal entry
+        inline const dfa::lexeme_container& lexeme(entry_id id) const { return m_Lexemes[m_Entries[id].firstToken]; }
+
+        /// \brief The lexemes that have been shifted
+        inline const std::vector<dfa::lexeme_container>& lexemes() const { return m_Lexemes; }
+
+        /// \brief The last child of a reduction (or no_entry if the entry has no children)
+        inline entry_id last_child(entry_id id) const { return m_Entries[id].length > 0 ? id - 1 : no_entry; }
+
+        /// \brief The child of a reduction before the specified one (or no_entry if child is the first child)
+        inline entry_id previous_sibling(entry_id parent, entry_id child) const {
+            entry_id previous = m_Entries[child].first;
+            return previous > m_Entries[parent].first ? previous - 1 : no_entry;
+        }
+
+        /// \brief Retrieves the child items of a reduction, in the order that they appear in the rule
+        void children(entry_id id, std::vector<entry_id>& result) const;
+    };
+
+    ///
+    /// \brief Parser actions that record a reduction log instead of building an AST
+    ///
+    /// An AST can be built from the log for any entry using lazy_ast, so parsers that only need part of the tree
+    /// need not build the whole thing. These actions make no allocations except when the log needs to grow.
+    ///
+    class reduction_log_actions {
+    public:
+        /// \brief Stack items are identifiers for entries in the log
+        typedef reduction_log::entry_id node;
+
+    private:
+        /// \brief The stream that lexemes are read from
+        dfa::lexeme_stream* m_Stream;
+
+        /// \brief True if the stream should be destroyed along with this object
+        bool m_OwnStream;
+
+        /// \brief Reads lexemes from the stream (a batch at a time if set_batched() has been called)
+        dfa::lexeme_batch_reader m_Reader;
+
+        /// \brief The log of the actions performed by the parser
+        reduction_log m_Log;
+
+        reduction_log_actions(const reduction_log_actions& noCopying);
+        reduction_log_actions& operator=(const reduction_log_actions& noCopying);
+
+    public:
+        /// \brief Creates a new object that will read from the specified stream
+        reduction_log_actions(dfa::lexeme_stream* stream, bool ownStream = false);
+
+        /// \brief Destructor
+        ~reduction_log_actions();
+
+        /// \brief Starts reading from a new stream, discarding the existing log
+        void reset(dfa::lexeme_stream* stream);
+
+        /// \brief Sets whether or not lexemes are read from the stream a batch at a time (see dfa::lexeme_batch_reader)
+        ///
+        /// This is faster, but should only be turned on if the parser never changes the lexer state.
+        inline void set_batched(bool batched) {
+            m_Reader.set_batched(batched);
+        }
+
+        /// \brief Reads the next symbol from the stream
+        inline dfa::lexeme* read() {
+            return m_Reader.read();
+        }
+
+        /// \brief Records a shift action
+        inline node shift(const dfa::lexeme_container& lexeme) {
+            return m_Log.add_terminal(lexeme);
+        }
+
+        /// \brief Records a reduce action
+        inline node reduce(int nonterminal, int rule, const std::vector<node>& reduce, const dfa::position& lookaheadPosition) {
+            return m_Log.add_reduction(nonterminal, rule, reduce, lookaheadPosition);
+        }
+
+        /// \brief The log recorded by these actions
+        inline const reduction_log& log() const { return m_Log; }
+    };
+}
+
+#endif
@@ -42,19 +42,26 @@
 #include "TameParse/Dfa/character_lexer.h"
 #include "TameParse/Dfa/epsilon.h"
 #include "TameParse/Dfa/hard_coded_symbol_table.h"
+#include "TameParse/Dfa/incremental_lexer.h"
 #include "TameParse/Dfa/lexeme.h"
 #include "TameParse/Dfa/lexer.h"
+#include "TameParse/Dfa/line_index.h"
 #include "TameParse/Dfa/ndfa.h"
 #include "TameParse/Dfa/ndfa_regex.h"
+#include "TameParse/Dfa/pipelined_stream.h"
 #include "TameParse/Dfa/position.h"
+#include "TameParse/Dfa/push_lexer.h"
 #include "TameParse/Dfa/range.h"
 #include "TameParse/Dfa/remapped_symbol_map.h"
 #include "TameParse/Dfa/state.h"
 #include "TameParse/Dfa/state_machine.h"
 #include "TameParse/Dfa/symbol_map.h"
+#include "TameParse/Dfa/symbol_reader.h"
 #include "TameParse/Dfa/symbol_set.h"
 #include "TameParse/Dfa/symbol_table.h"
 #include "TameParse/Dfa/symbol_translator.h"
+#include "TameParse/Dfa/text_symbol_stream.h"
+#include "TameParse/Dfa/token.h"
 #include "TameParse/Dfa/transition.h"
 
 #include "TameParse/ContextFree/ebnf_items.h"
@@ -67,11 +74,16 @@
 
 #include "TameParse/Lr/action_rewriter.h"
 #include "TameParse/Lr/ast_parser.h"
+#include "TameParse/Lr/batch_parser.h"
+#include "TameParse/Lr/binary_tables.h"
+#include "TameParse/Lr/chunked_parser.h"
 #include "TameParse/Lr/conflict.h"
 #include "TameParse/Lr/ignored_symbols.h"
+#include "TameParse/Lr/incremental_parser.h"
 #include "TameParse/Lr/lalr_builder.h"
 #include "TameParse/Lr/lalr_machine.h"
 #include "TameParse/Lr/lalr_state.h"
+#include "TameParse/Lr/lazy_ast.h"
 #include "TameParse/Lr/lr1_item_set.h"
 #include "TameParse/Lr/lr_action.h"
 #include "TameParse/Lr/lr_item.h"
@@ -80,6 +92,9 @@
 #include "TameParse/Lr/parser_stack.h"
 #include "TameParse/Lr/parser_state.h"
 #include "TameParse/Lr/parser_tables.h"
+#include "TameParse/Lr/push_parser.h"
+#include "TameParse/Lr/recogniser.h"
+#include "TameParse/Lr/reduction_log.h"
 #include "TameParse/Lr/weak_symbols.h"
 
 #include "TameParse/Language/block.h"
@@ -104,16 +119,19 @@
 
 #include "TameParse/Compiler/compilation_stage.h"
 #include "TameParse/Compiler/console.h"
+#include "TameParse/Compiler/profiler.h"
 #include "TameParse/Compiler/error.h"
 #include "TameParse/Compiler/language_stage.h"
 #include "TameParse/Compiler/lexer_stage.h"
 #include "TameParse/Compiler/lr_parser_stage.h"
 #include "TameParse/Compiler/output_stage.h"
+#include "TameParse/Compiler/OutputStages/binary.h"
 #include "TameParse/Compiler/OutputStages/cplusplus.h"
 #include "TameParse/Compiler/std_console.h"
 #include "TameParse/Compiler/parser_stage.h"
 #include "TameParse/Compiler/import_stage.h"
 #include "TameParse/Compiler/language_builder_stage.h"
 #include "TameParse/Compiler/test_stage.h"
+#include "TameParse/Compiler/build_cache.h"
 
 #endif
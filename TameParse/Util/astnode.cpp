@@ -48,13 +48,63 @@ astnode::astnode(int itemIdentifier, int rule)
 /// \brief Creates an AST node from a lexeme
 astnode::astnode(const dfa::lexeme_container& terminal)
 : m_ItemIdentifier(-1)
+, m_Rule(-1)
 , m_Lexeme(terminal) {
 }
 
+/// \brief Copy constructor
+astnode::astnode(const astnode& copyFrom)
+: m_ItemIdentifier(copyFrom.m_ItemIdentifier)
+, m_Rule(copyFrom.m_Rule)
+, m_Lexeme(copyFrom.m_Lexeme)
+, m_Children(copyFrom.m_Children) {
+}
+
+/// \brief Move constructor
+astnode::astnode(astnode&& moveFrom) noexcept
+: m_ItemIdentifier(moveFrom.m_ItemIdentifier)
+, m_Rule(moveFrom.m_Rule)
+, m_Lexeme(std::move(moveFrom.m_Lexeme))
+, m_Children(std::move(moveFrom.m_Children)) {
+}
+
+/// \brief Destructor
+astnode::~astnode() {
+}
+
+/// \brief Assignment
+astnode& astnode::operator=(const astnode& assignFrom) {
+    if (&assignFrom == this) return *this;
+    
+    m_ItemIdentifier    = assignFrom.m_ItemIdentifier;
+    m_Rule              = assignFrom.m_Rule;
+    m_Lexeme            = assignFrom.m_Lexeme;
+    m_Children          = assignFrom.m_Children;
+    
+    return *this;
+}
+
+/// \brief Move assignment
+astnode& astnode::operator=(astnode&& moveFrom) noexcept {
+    if (&moveFrom == this) return *this;
+    
+    m_ItemIdentifier    = moveFrom.m_ItemIdentifier;
+    m_Rule              = moveFrom.m_Rule;
+    m_Lexeme            = std::move(moveFrom.m_Lexeme);
+    m_Children          = std::move(moveFrom.m_Children);
+    
+    return *this;
+}
+
 /// \brief Adds a new child node to this item
 void astnode::add_child(const astnode_container& newChild) {
     m_Children.push_back(newChild);
 }
+
+/// \brief Adds a new child node to this item, taking the reference from the supplied container
+void astnode::add_child(astnode_container&& newChild) {
+    m_Children.push_back(std::move(newChild));
+}
 /// \brief Clones this AST node
 astnode* astnode::clone() const {
     return new astnode(*this);
@@ -29,6 +29,7 @@
 #define _UTIL_ASTNODE_H
 
 #include <vector>
+#include <utility>
 
 #include "TameParse/Dfa/lexeme.h"
 #include "TameParse/Util/container.h"
@@ -68,9 +69,27 @@ namespace util {
         /// \brief Creates an AST node from a lexeme
         astnode(const dfa::lexeme_container& terminal);
         
+        /// \brief Copy constructor
+        astnode(const astnode& copyFrom);
+        
+        /// \brief Move constructor (takes over the lexeme and children of an existing node)
+        astnode(astnode&& moveFrom) noexcept;
+        
+        /// \brief Destructor
+        virtual ~astnode();
+        
+        /// \brief Assignment
+        astnode& operator=(const astnode& assignFrom);
+        
+        /// \brief Move assignment
+        astnode& operator=(astnode&& moveFrom) noexcept;
+        
         /// \brief Adds a new child node to this item
         void add_child(const astnode_container& newChild);
         
+        /// \brief Adds a new child node to this item, taking the reference from the supplied container
+        void add_child(astnode_container&& newChild);
+        
         /// \brief Adds a series of children to this item
         template<typename iterator> void add_children(iterator begin, iterator end) {
             for (iterator cur = begin; cur != end; ++cur) {
@@ -78,6 +97,15 @@ namespace util {
             }
         }
         
+        /// \brief Adds a series of children to this item, moving them out of the source range
+        ///
+        /// The containers in the source range are left empty after this call.
+        template<typename iterator> void move_children(iterator begin, iterator end) {
+            for (iterator cur = begin; cur != end; ++cur) {
+                m_Children.push_back(std::move(*cur));
+            }
+        }
+        
         /// \brief The ID of the rule for this node
         inline int rule() const { return m_Rule; }
         
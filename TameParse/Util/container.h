@@ -99,51 +99,53 @@ namespace util {
             }
         };
         
-        /// \brief Reference to the item in this container
+        /// \brief Reference to the item in this container (NULL if the container has been moved from)
         reference* m_Ref;
         
     private:
+        /// \brief The item in this container, or NULL if it has been moved from
+        inline ItemType* get() const { return m_Ref ? m_Ref->item : NULL; }
         
     public:
         /// \brief Dereferences the content of this container
-        inline ItemType* item() { return m_Ref->item; }
+        inline ItemType* item() { return get(); }
 
         /// \brief Dereferences the content of this container
-        inline const ItemType* item() const { return m_Ref->item; }
+        inline const ItemType* item() const { return get(); }
         
         /// \brief Dereferences the content of this container
         inline ItemType* operator->() {
-            return m_Ref->item;
+            return get();
         }
         
         /// \brief Dereferences the content of this container
         inline const ItemType* operator->() const {
-            return m_Ref->item;
+            return get();
         }
         
         /// \brief Dereferences the content of this container
         inline ItemType& operator*() {
-            return *m_Ref->item;
+            return *get();
         }
         
         /// \brief Dereferences the content of this container
         inline const ItemType& operator*() const {
-            return *m_Ref->item;
+            return *get();
         }
         
         /// \brief Dereferences the content of this container
         inline operator ItemType*() {
-            return m_Ref->item;
+            return get();
         }
         
         /// \brief Dereferences the content of this container
         inline operator const ItemType*() const {
-            return m_Ref->item;
+            return get();
         }
         
         /// \brief Ordering operator
         inline bool operator<(const container& compareTo) const {
-            return ItemType::compare(m_Ref->item, compareTo.m_Ref->item);
+            return ItemType::compare(get(), compareTo.get());
         }
         
         /// \brief Ordering operator
@@ -163,10 +165,13 @@ namespace util {
         
         /// \brief Comparison operator
         inline bool operator==(const container& compareTo) const {
-            if (m_Ref->item == compareTo.m_Ref->item)                   return true;
-            if (m_Ref->item == NULL || compareTo.m_Ref->item == NULL)   return false;
+            const ItemType* item        = get();
+            const ItemType* compareItem = compareTo.get();
             
-            return (*m_Ref->item) == *compareTo;
+            if (item == compareItem)                    return true;
+            if (item == NULL || compareItem == NULL)    return false;
+            
+            return (*item) == *compareItem;
         }
         
         /// \brief Comparison operator
@@ -181,9 +186,9 @@ namespace util {
             inline bool operator()(const container& a, const container& b) const {
                 static compare_item less_than;
                 
-                if (a.m_Ref->item == b.m_Ref->item)     return false;
-                if (!a.m_Ref->item)                     return true;
-                if (!b.m_Ref->item)                     return false;
+                if (a.get() == b.get())     return false;
+                if (!a.get())               return true;
+                if (!b.get())               return false;
                 
                 return less_than(*a, *b);
             }
@@ -222,23 +227,43 @@ namespace util {
         /// \brief Creates a new container
         inline container(const container<ItemType, ItemAllocator>& copyFrom) {
             m_Ref = copyFrom.m_Ref;
-            m_Ref->retain();
+            if (m_Ref) m_Ref->retain();
+        }
+        
+        /// \brief Creates a new container by taking the reference from an existing one
+        ///
+        /// The reference count is left unchanged. The container that is moved from is left empty, and behaves
+        /// as if it contains a NULL item.
+        inline container(container<ItemType, ItemAllocator>&& moveFrom) noexcept
+        : m_Ref(moveFrom.m_Ref) {
+            moveFrom.m_Ref = NULL;
         }
         
         /// \brief Assigns the content of this container
         inline container<ItemType, ItemAllocator>& operator=(const container<ItemType, ItemAllocator>& assignFrom) {
             if (&assignFrom == this) return *this;
             
-            assignFrom.m_Ref->retain();
-            m_Ref->release();
+            if (assignFrom.m_Ref) assignFrom.m_Ref->retain();
+            if (m_Ref) m_Ref->release();
             m_Ref = assignFrom.m_Ref;
 
             return *this;
         }
         
+        /// \brief Assigns the content of this container by taking the reference from another container
+        inline container<ItemType, ItemAllocator>& operator=(container<ItemType, ItemAllocator>&& moveFrom) noexcept {
+            if (&moveFrom == this) return *this;
+            
+            if (m_Ref) m_Ref->release();
+            m_Ref           = moveFrom.m_Ref;
+            moveFrom.m_Ref  = NULL;
+            
+            return *this;
+        }
+        
         /// \brief Deletes the item in this container
         inline ~container() {
-            m_Ref->release();
+            if (m_Ref) m_Ref->release();
             m_Ref = NULL;
         }        
     };
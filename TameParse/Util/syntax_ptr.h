@@ -73,13 +73,15 @@ namespace util {
         /// Generally, you should not use this constructor, it's mainly here to support pointer casting (the cast_to() function)
         inline explicit syntax_ptr(syntax_ptr_reference* ref)
         : m_Reference(ref) {
-            ++m_Reference->usageCount;
+            if (m_Reference) ++m_Reference->usageCount;
         }
         
     public:
         /// \brief Default constructor, assigns the pointer to NULL
+        ///
+        /// A NULL pointer doesn't need a reference, so this doesn't allocate anything.
         inline syntax_ptr()
-        : m_Reference(new syntax_ptr_reference()) {
+        : m_Reference(NULL) {
         }
         
         /// \brief Set to a specific pointer value
@@ -94,7 +96,16 @@ namespace util {
         inline syntax_ptr(const syntax_ptr<ptr_type>& copyFrom)
         : m_Reference(copyFrom.m_Reference) {
             // Increase the reference count for this object
-            ++m_Reference->usageCount;
+            if (m_Reference) ++m_Reference->usageCount;
+        }
+        
+        /// \brief Move constructor
+        ///
+        /// Takes over the reference from another syntax_ptr without changing its usage count. The object that is
+        /// moved from is left as a NULL pointer.
+        inline syntax_ptr(syntax_ptr<ptr_type>&& moveFrom) noexcept
+        : m_Reference(moveFrom.m_Reference) {
+            moveFrom.m_Reference = NULL;
         }
         
         /// \brief Assignment
@@ -103,38 +114,57 @@ namespace util {
             if (m_Reference == assignFrom.m_Reference) return *this;
             
             // Deallocate the reference
-            m_Reference->usageCount--;
-            if (m_Reference->usageCount <= 0) {
-                delete (ptr_type*) m_Reference->value;
-                m_Reference->value = NULL;
-                delete m_Reference;
-            }
-            m_Reference = NULL;
+            release();
             
             // Switch to the reference in the other object
             m_Reference = assignFrom.m_Reference;
-            ++m_Reference->usageCount;
+            if (m_Reference) ++m_Reference->usageCount;
+            
+            return *this;
+        }
+        
+        /// \brief Move assignment
+        syntax_ptr<ptr_type>& operator=(syntax_ptr<ptr_type>&& moveFrom) noexcept {
+            // Nothing to do if the reference is the same
+            if (m_Reference == moveFrom.m_Reference) return *this;
+            
+            // Deallocate the reference, and take over the one from the other object
+            release();
+            
+            m_Reference             = moveFrom.m_Reference;
+            moveFrom.m_Reference    = NULL;
             
             return *this;
         }
         
         /// \brief Destructs a syntax_ptr
         ~syntax_ptr() {
+            release();
+        }
+        
+    private:
+        /// \brief Releases the reference held by this object, freeing the value if this was the last reference to it
+        inline void release() {
+            if (!m_Reference) return;
+            
             m_Reference->usageCount--;
             if (m_Reference->usageCount <= 0) {
                 delete (ptr_type*) m_Reference->value;
                 m_Reference->value = NULL;
                 delete m_Reference;
-                m_Reference = NULL;
             }
+            m_Reference = NULL;
         }
         
+        /// \brief The value of this pointer (NULL references are the same as references to NULL)
+        inline const ptr_type* get() const { return m_Reference ? (const ptr_type*) m_Reference->value : NULL; }
+        
     public:
         /// \brief Converts this object back to its underlying type
-        inline operator const ptr_type*() const { return (ptr_type*) m_Reference->value; }
+        inline operator const ptr_type*() const { return get(); }
 
         /// \brief Evaluating this as a boolean returns whether or not the item is present
-        inline operator bool() const { return m_Reference->value != NULL; }
+        inline operator bool() const { return get() != NULL; }
         
         /// \brief Casts this pointer to a pointer of a different type (but maintains reference counting)
         ///
@@ -147,10 +177,10 @@ namespace util {
 
         // Other operators
         
-        inline const ptr_type* operator->() const { return (ptr_type*) m_Reference->value; }
-        inline const ptr_type& operator*() { return *(ptr_type*) m_Reference->value; }
+        inline const ptr_type* operator->() const { return get(); }
+        inline const ptr_type& operator*() { return *get(); }
         
-        inline const ptr_type* item() const { return (ptr_type*) m_Reference->value; }
+        inline const ptr_type* item() const { return get(); }
     };
 }
 
@@ -0,0 +1,139 @@
+//
+//  dfa_incremental_lexer.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy 
+//  of this software and associated documentation files (the \"Software\"), to 
+//  deal in the Software without restriction, including without limitation the 
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+//  sell copies of the Software, and to permit persons to whom the Software is 
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+
+#include "dfa_incremental_lexer.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Dfa/incremental_lexer.h"
+
+using namespace std;
+using namespace dfa;
+using namespace yy_language;
+
+/// \brief Returns true if the incremental lexer has the same lexemes as lexing its document from scratch
+static bool same_as_full_lex(const bootstrap& bs, const incremental_lexer& incremental) {
+    wstringstream   document(incremental.document());
+    lexeme_stream*  stream  = bs.get_lexer().create_stream_from(document);
+    bool            result  = true;
+    
+    const incremental_lexer::lexeme_list& lexemes = incremental.lexemes();
+    size_t lexemeId = 0;
+    
+    for (;;) {
+        lexeme* next = NULL;
+        (*stream) >> next;
+        if (!next) break;
+        
+        if (lexemeId >= lexemes.size()) {
+            result = false;
+        } else {
+            const lexeme* other = lexemes[lexemeId].item();
+            
+            if (other->matched() != next->matched())    result = false;
+            if (other->content() != next->content())    result = false;
+            if (other->pos() != next->pos())            result = false;
+        }
+        
+        ++lexemeId;
+        delete next;
+    }
+    
+    if (lexemeId != lexemes.size()) result = false;
+    
+    delete stream;
+    return result;
+}
+
+void test_dfa_incremental_lexer::run_tests() {
+    bootstrap bs;
+    
+    // Use the language definition as the document
+    const string&   definition = bootstrap::get_default_language_definition();
+    wstring         document(definition.begin(), definition.end());
+    
+    incremental_lexer incremental(bs.get_lexer(), 16);
+    incremental.lex(document);
+    
+    report("InitialSame", same_as_full_lex(bs, incremental));
+    report("InitialCheckpoints", incremental.checkpoint_count() > 1);
+    
+    // Rename a lexer symbol
+    size_t digit = document.find(L"digit ");
+    incremental.edit(digit, 5, L"number");
+    
+    report("RenameSame", same_as_full_lex(bs, incremental));
+    report("RenameRelexed", incremental.lexemes_lexed() <= 20);
+    report("RenameRemoved", incremental.lexemes_lexed() == incremental.lexemes_removed());
+    
+    // Join two lexemes together
+    size_t keywords = incremental.document().find(L"language\n\t\timport");
+    
+    incremental.edit(keywords + 8, 3, L"");
+    report("JoinSame", same_as_full_lex(bs, incremental));
+    report("JoinRemoved", incremental.lexemes_removed() == incremental.lexemes_lexed() + 3);
+    
+    incremental.edit(keywords + 8, 0, L"\n\t\t");
+    report("SplitSame", same_as_full_lex(bs, incremental));
+    
+    // Insert some new lines
+    incremental.edit(incremental.document().find(L"\t\tregex\t"), 0, L"\n\n\t\tnewline = /\\n/\n");
+    report("InsertSame", same_as_full_lex(bs, incremental));
+    report("InsertRelexed", incremental.lexemes_lexed() < incremental.lexemes().size() / 4);
+    
+    // Start a comment that runs to the end of the document
+    size_t lexerBlock = incremental.document().find(L"lexer {");
+    
+    incremental.edit(lexerBlock, 0, L"/* ");
+    report("CommentSame", same_as_full_lex(bs, incremental));
+    
+    incremental.edit(lexerBlock, 3, L"");
+    report("UncommentSame", same_as_full_lex(bs, incremental));
+    
+    // Edit the ends of the document
+    incremental.edit(incremental.document().size(), 0, L"\n// The end");
+    report("AppendSame", same_as_full_lex(bs, incremental));
+    
+    incremental.edit(0, 0, L"// Start\r\n");
+    report("PrependSame", same_as_full_lex(bs, incremental));
+    
+    // Make a series of edits throughout the document
+    bool allSame = true;
+    for (int edit = 0; edit < 40; ++edit) {
+        size_t pos = (incremental.document().size() * edit) / 40;
+        
+        switch (edit % 4) {
+            case 0: incremental.edit(pos, 0, L" ");         break;
+            case 1: incremental.edit(pos, 2, L"");          break;
+            case 2: incremental.edit(pos, 1, L"\n");        break;
+            case 3: incremental.edit(pos, 0, L"\"x");       break;
+        }
+        
+        if (!same_as_full_lex(bs, incremental)) allSame = false;
+    }
+    
+    report("ManyEditsSame", allSame);
+}
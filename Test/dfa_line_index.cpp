@@ -0,0 +1,235 @@
+//
+//  dfa_line_index.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+
+#include "dfa_line_index.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Dfa/line_index.h"
+#include "TameParse/Dfa/pipelined_stream.h"
+
+using namespace std;
+using namespace dfa;
+using namespace yy_language;
+
+/// \brief Returns true if an index of the specified string finds the same positions as position_tracker for every offset
+template<typename string_type> static bool same_as_tracker(const string_type& text) {
+    line_index          index(text.begin(), text.end());
+    position_tracker    tracker;
+    
+    if (index.size() != text.size()) return false;
+    
+    for (size_t offset = 0; offset <= text.size(); ++offset) {
+        // The position should be the same as the one found by reading every symbol
+        if (!(index.position_at(offset) == tracker.current_position())) return false;
+        
+        // Trackers created by the index should continue in the same way
+        position_tracker fromIndex = index.tracker_at(offset);
+        if (fromIndex.seen_return() != tracker.seen_return()) return false;
+        
+        if (offset < text.size()) {
+            fromIndex.update_position((int)(unsigned) text[offset]);
+            tracker.update_position((int)(unsigned) text[offset]);
+            
+            if (!(fromIndex.current_position() == tracker.current_position())) return false;
+        }
+    }
+    
+    return true;
+}
+
+/// \brief Returns true if indexing the specified characters all at once gives the same result as indexing them one at a time
+template<typename char_type> static bool same_as_symbols(const basic_string<char_type>& text) {
+    // Index the whole string (using the block scan for 8-bit characters)
+    line_index whole;
+    whole.append(text.data(), text.data() + text.size());
+    
+    // Index the characters one at a time
+    line_index single;
+    for (size_t offset = 0; offset < text.size(); ++offset) {
+        single.append((int)(unsigned) text[offset]);
+    }
+    
+    if (whole.size() != single.size()) return false;
+    if (whole.count_lines() != single.count_lines()) return false;
+    
+    for (size_t offset = 0; offset <= text.size(); ++offset) {
+        if (!(whole.position_at(offset) == single.position_at(offset))) return false;
+    }
+    
+    return true;
+}
+
+/// \brief Returns true if a stream reporting offsets only produces the same positions as a normal stream once they are resolved
+static bool same_when_resolved(lexeme_stream* expected, lexeme_stream* actual, const line_index& index) {
+    for (;;) {
+        lexeme* expectedLexeme  = NULL;
+        lexeme* actualLexeme    = NULL;
+        
+        (*expected) >> expectedLexeme;
+        (*actual) >> actualLexeme;
+        
+        if (!expectedLexeme || !actualLexeme) {
+            bool bothEnded = !expectedLexeme && !actualLexeme;
+            delete expectedLexeme;
+            delete actualLexeme;
+            return bothEnded;
+        }
+        
+        // The line shouldn't be known until the position is resolved
+        bool same = actualLexeme->pos().line() < 0
+                 && expectedLexeme->matched() == actualLexeme->matched()
+                 && expectedLexeme->pos() == index.resolve(actualLexeme->pos());
+        
+        delete expectedLexeme;
+        delete actualLexeme;
+        
+        if (!same) return false;
+    }
+}
+
+void test_dfa_line_index::run_tests() {
+    // Simple cases
+    report("Empty", same_as_tracker(string()));
+    report("NoBreaks", same_as_tracker(string("abcdef")));
+    report("LineFeeds", same_as_tracker(string("abc\ndef\n\nghi\n")));
+    report("CarriageReturns", same_as_tracker(string("abc\rdef\r\rghi\r")));
+    report("CrLf", same_as_tracker(string("abc\r\ndef\r\n\r\nghi\r\n")));
+    report("Mixed", same_as_tracker(string("\r\n\n\r\r\nab\vcd\fef\r\r\n\n\rgh")));
+    
+    // Count the lines
+    string      fourLines("a\nb\r\nc\rd");
+    line_index  lines(fourLines.begin(), fourLines.end());
+    report("CountLines", lines.count_lines() == 4);
+    
+    // Line breaks either side of the boundaries between 16 character blocks, including a CR/LF pair split across blocks
+    string blocks(80, 'x');
+    blocks[0]   = '\n';
+    blocks[15]  = '\r';
+    blocks[16]  = '\n';
+    blocks[31]  = '\n';
+    blocks[32]  = '\r';
+    blocks[47]  = '\v';
+    blocks[48]  = '\f';
+    blocks[63]  = '\r';
+    blocks[79]  = '\r';
+    
+    report("BlockBoundaries", same_as_tracker(blocks));
+    report("BlockScan", same_as_symbols(blocks));
+    
+    // Every line break in every position of a block
+    string everywhere;
+    for (int breakPos = 0; breakPos < 40; ++breakPos) {
+        everywhere += string(breakPos % 17, 'y');
+        everywhere += "\n\r\r\n\v\f"[breakPos % 6];
+    }
+    
+    report("EveryPosition", same_as_tracker(everywhere));
+    report("EveryPositionScan", same_as_symbols(everywhere));
+    
+    // NEL is only a line break where the characters are unsigned or wide (signed characters are sign extended)
+    basic_string<unsigned char> unsignedText(40, 'z');
+    unsignedText[3]     = 0x85;
+    unsignedText[17]    = 0x85;
+    unsignedText[18]    = '\r';
+    unsignedText[19]    = '\n';
+    unsignedText[30]    = 0xe5;
+    
+    report("UnsignedNel", same_as_tracker(unsignedText));
+    report("UnsignedNelScan", same_as_symbols(unsignedText));
+    
+    string signedText(unsignedText.begin(), unsignedText.end());
+    report("SignedNel", same_as_tracker(signedText));
+    report("SignedNelScan", same_as_symbols(signedText));
+    
+    // Unicode line breaks
+    wstring wide(L"ab\x2028" L"cd\x2029\x85" L"ef\r\ngh");
+    report("UnicodeBreaks", same_as_tracker(wide));
+    
+    // Adding text a piece at a time should give the same result as adding it all at once
+    line_index  whole(blocks.begin(), blocks.end());
+    line_index  pieces;
+    
+    pieces.append(blocks.data(), blocks.data() + 16);
+    pieces.append(blocks.data() + 16, blocks.data() + 33);
+    pieces.append(blocks.data() + 33, blocks.data() + blocks.size());
+    
+    bool samePieces = whole.size() == pieces.size();
+    for (size_t offset = 0; samePieces && offset <= blocks.size(); ++offset) {
+        samePieces = whole.position_at(offset) == pieces.position_at(offset);
+    }
+    report("AppendPieces", samePieces);
+    
+    // Positions that already have a line number shouldn't be changed
+    report("ResolveResolved", whole.resolve(position(5, 2, 1)) == position(5, 2, 1));
+    
+    // Lex a document with a variety of line breaks, reporting offsets only
+    bootstrap bs;
+    
+    const string&   definition  = bootstrap::get_default_language_definition();
+    wstring         document;
+    int             lineNumber  = 0;
+    
+    for (string::const_iterator chr = definition.begin(); chr != definition.end(); ++chr) {
+        if (*chr == '\n') {
+            // Vary the line breaks
+            switch (lineNumber++ % 3) {
+                case 0: document += L"\n";      break;
+                case 1: document += L"\r\n";    break;
+                case 2: document += L"\r";      break;
+            }
+        } else {
+            document += (wchar_t) *chr;
+        }
+    }
+    
+    line_index documentLines(document.begin(), document.end());
+    
+    wstringstream   expectedInput(document);
+    wstringstream   actualInput(document);
+    lexeme_stream*  expected    = bs.get_lexer().create_stream_from(expectedInput);
+    lexeme_stream*  actual      = bs.get_lexer().create_stream_from(actualInput);
+    
+    report("SetOffsetsOnly", actual->set_offsets_only(true));
+    
+    lexer_checkpoint checkpoint;
+    report("NoCheckpoint", !actual->get_checkpoint(checkpoint));
+    
+    report("ResolvedPositions", same_when_resolved(expected, actual, documentLines));
+    delete expected;
+    delete actual;
+    
+    // The pipelined stream should pass the setting on to the stream it reads from
+    wstringstream       expectedPipelinedInput(document);
+    wstringstream       actualPipelinedInput(document);
+    pipelined_stream*   pipelined = new pipelined_stream(bs.get_lexer().create_stream_from(actualPipelinedInput));
+    
+    expected = bs.get_lexer().create_stream_from(expectedPipelinedInput);
+    report("PipelinedOffsetsOnly", pipelined->set_offsets_only(true));
+    report("PipelinedResolvedPositions", same_when_resolved(expected, pipelined, documentLines));
+    delete expected;
+    delete pipelined;
+}
@@ -0,0 +1,227 @@
+//
+//  dfa_pipelined_stream.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+#include <stdexcept>
+
+#include "dfa_pipelined_stream.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Dfa/pipelined_stream.h"
+#include "TameParse/Lr/ast_parser.h"
+
+using namespace std;
+using namespace dfa;
+using namespace lr;
+using namespace yy_language;
+
+/// \brief Lexeme stream that produces a fixed number of lexemes, and records the initial state it was given
+class counting_stream : public lexeme_stream {
+private:
+    /// \brief The number of lexemes left to produce
+    int m_Remaining;
+    
+    /// \brief The last initial state set for this stream
+    int& m_InitialState;
+    
+public:
+    counting_stream(int count, int& initialState)
+    : m_Remaining(count)
+    , m_InitialState(initialState) {
+    }
+    
+    virtual lexeme_stream& operator>>(lexeme*& result) {
+        result = NULL;
+        if (m_Remaining <= 0) return *this;
+        
+        --m_Remaining;
+        result = new lexeme(lexeme::symbols(1, 'a'), position(), m_InitialState);
+        return *this;
+    }
+    
+    virtual void set_initial_state(int initialState) {
+        m_InitialState = initialState;
+    }
+};
+
+/// \brief Lexeme stream that produces a fixed number of lexemes and then throws an exception
+class failing_stream : public lexeme_stream {
+private:
+    /// \brief The number of lexemes left to produce before failing
+    int m_Remaining;
+    
+public:
+    explicit failing_stream(int count)
+    : m_Remaining(count) {
+    }
+    
+    virtual lexeme_stream& operator>>(lexeme*& result) {
+        result = NULL;
+        if (m_Remaining <= 0) throw runtime_error("failing_stream");
+        
+        --m_Remaining;
+        result = new lexeme(lexeme::symbols(1, 'a'), position(), 0);
+        return *this;
+    }
+};
+
+/// \brief Returns true if two streams produce the same lexemes
+static bool same_lexemes(lexeme_stream* expected, lexeme_stream* actual) {
+    for (;;) {
+        lexeme* expectedLexeme  = NULL;
+        lexeme* actualLexeme    = NULL;
+        
+        (*expected) >> expectedLexeme;
+        (*actual) >> actualLexeme;
+        
+        // Both streams should end at the same time
+        if (!expectedLexeme || !actualLexeme) {
+            bool bothEnded = !expectedLexeme && !actualLexeme;
+            delete expectedLexeme;
+            delete actualLexeme;
+            return bothEnded;
+        }
+        
+        bool same = expectedLexeme->matched() == actualLexeme->matched() 
+                 && expectedLexeme->pos() == actualLexeme->pos() 
+                 && expectedLexeme->content() == actualLexeme->content();
+        
+        delete expectedLexeme;
+        delete actualLexeme;
+        
+        if (!same) return false;
+    }
+}
+
+void test_dfa_pipelined_stream::run_tests() {
+    bootstrap bs;
+    
+    // Use the language definition as the document
+    const string&   definition  = bootstrap::get_default_language_definition();
+    wstring         document(definition.begin(), definition.end());
+    
+    // The pipelined stream should produce the same lexemes as the lexer
+    wstringstream       expectedInput(document);
+    wstringstream       actualInput(document);
+    lexeme_stream*      expected    = bs.get_lexer().create_stream_from(expectedInput);
+    pipelined_stream*   actual      = new pipelined_stream(bs.get_lexer().create_stream_from(actualInput));
+    
+    report("SameLexemes", same_lexemes(expected, actual));
+    delete expected;
+    delete actual;
+    
+    // ... even when the queue is too small to hold more than a couple of them
+    wstringstream   expectedSmallInput(document);
+    wstringstream   actualSmallInput(document);
+    
+    expected    = bs.get_lexer().create_stream_from(expectedSmallInput);
+    actual      = new pipelined_stream(bs.get_lexer().create_stream_from(actualSmallInput), 2);
+    
+    report("SmallQueue", same_lexemes(expected, actual));
+    delete expected;
+    delete actual;
+    
+    // The parser should accept the definition when it's read from a pipelined stream
+    wstringstream       parseInput(document);
+    ast_parser::state*  state = bs.get_parser().create_parser(new ast_parser_actions(new pipelined_stream(bs.get_lexer().create_stream_from(parseInput))));
+    
+    report("ParseDefinition", state->parse());
+    delete state;
+    
+    // The stream can be destroyed before all of the input has been read
+    int     initialState    = 0;
+    lexeme* first           = NULL;
+    actual = new pipelined_stream(new counting_stream(100000, initialState), 16);
+    
+    (*actual) >> first;
+    report("StopEarly", first != NULL);
+    delete first;
+    delete actual;
+    
+    // The initial state can be set before the first lexeme is read
+    actual = new pipelined_stream(new counting_stream(10, initialState), 16);
+    actual->set_initial_state(3);
+    
+    (*actual) >> first;
+    report("InitialStateBeforeStart", first != NULL && first->matched() == 3 && !actual->refused());
+    delete first;
+    
+    // ... but not afterwards, as the producer will already have read ahead
+    lexeme* afterRefusal = NULL;
+    actual->set_initial_state(4);
+    (*actual) >> afterRefusal;
+    
+    report("RefuseInitialState", actual->refused() && afterRefusal == NULL);
+    delete actual;
+    
+    // A stream for a language that changes the lexer state is read synchronously, so the state can change at any time
+    actual = new pipelined_stream(new counting_stream(10, initialState), 16, true);
+    actual->set_initial_state(3);
+    
+    lexeme* beforeChange    = NULL;
+    lexeme* afterChange     = NULL;
+    (*actual) >> beforeChange;
+    actual->set_initial_state(4);
+    (*actual) >> afterChange;
+    
+    report("SynchronousInitialState", actual->synchronous() && !actual->refused() 
+                                      && beforeChange != NULL && beforeChange->matched() == 3 
+                                      && afterChange != NULL && afterChange->matched() == 4);
+    delete beforeChange;
+    delete afterChange;
+    
+    // ... and only returns a single lexeme at a time when read in batches
+    lexeme* batch[8];
+    size_t  batchCount = actual->read_batch(batch, 8);
+    
+    report("SynchronousBatch", batchCount == 1);
+    for (size_t index = 0; index < batchCount; ++index) delete batch[index];
+    delete actual;
+    
+    // Exceptions thrown by the source stream should be thrown again on this thread, after the lexemes read before them
+    actual = new pipelined_stream(new failing_stream(3), 16);
+    
+    int     readBeforeError = 0;
+    bool    caught          = false;
+    try {
+        for (;;) {
+            lexeme* next = NULL;
+            (*actual) >> next;
+            if (!next) break;
+            
+            ++readBeforeError;
+            delete next;
+        }
+    } catch (runtime_error&) {
+        caught = true;
+    }
+    
+    // The stream ends once the exception has been passed on
+    lexeme* afterError = NULL;
+    (*actual) >> afterError;
+    
+    report("ProducerException", caught && readBeforeError == 3 && afterError == NULL);
+    delete actual;
+}
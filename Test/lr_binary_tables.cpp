@@ -0,0 +1,212 @@
+//
+//  lr_binary_tables.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy 
+//  of this software and associated documentation files (the \"Software\"), to 
+//  deal in the Software without restriction, including without limitation the 
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+//  sell copies of the Software, and to permit persons to whom the Software is 
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+//  IN THE SOFTWARE.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+
+#include "lr_binary_tables.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Lr/ast_parser.h"
+#include "TameParse/Lr/binary_tables.h"
+
+using namespace std;
+using namespace util;
+using namespace dfa;
+using namespace lr;
+using namespace yy_language;
+
+/// \brief Returns true if two ASTs are the same (including the positions of their lexemes)
+static bool same_tree(const astnode* a, const astnode* b) {
+    if (a == NULL || b == NULL)                         return a == b;
+    if (a->item_identifier() != b->item_identifier())   return false;
+    if (a->rule() != b->rule())                         return false;
+    
+    // Compare the lexemes
+    const lexeme* lexA = a->lexeme().item();
+    const lexeme* lexB = b->lexeme().item();
+    
+    if (lexA == NULL || lexB == NULL) {
+        if (lexA != lexB)                               return false;
+    } else {
+        if (lexA->matched() != lexB->matched())         return false;
+        if (lexA->content() != lexB->content())         return false;
+        if (lexA->pos() != lexB->pos())                 return false;
+    }
+    
+    // Compare the children
+    if (a->children().size() != b->children().size())  return false;
+    
+    for (size_t child = 0; child < a->children().size(); ++child) {
+        if (!same_tree(a->children()[child].item(), b->children()[child].item())) return false;
+    }
+    
+    return true;
+}
+
+/// \brief Returns true if two lexers produce the same lexemes for a document
+static bool same_lexemes(const lexer& expected, const lexer& actual, const wstring& document) {
+    wstringstream   expectedInput(document);
+    wstringstream   actualInput(document);
+    lexeme_stream*  expectedStream  = expected.create_stream_from(expectedInput);
+    lexeme_stream*  actualStream    = actual.create_stream_from(actualInput);
+    bool            result          = true;
+    
+    for (;;) {
+        lexeme* expectedLexeme  = NULL;
+        lexeme* actualLexeme    = NULL;
+        
+        (*expectedStream) >> expectedLexeme;
+        (*actualStream) >> actualLexeme;
+        
+        if (expectedLexeme == NULL || actualLexeme == NULL) {
+            if (expectedLexeme != actualLexeme) result = false;
+        } else {
+            if (expectedLexeme->matched() != actualLexeme->matched())   result = false;
+            if (expectedLexeme->content() != actualLexeme->content())   result = false;
+            if (expectedLexeme->pos() != actualLexeme->pos())           result = false;
+        }
+        
+        bool finished = expectedLexeme == NULL || actualLexeme == NULL;
+        
+        delete expectedLexeme;
+        delete actualLexeme;
+        
+        if (finished || !result) break;
+    }
+    
+    delete expectedStream;
+    delete actualStream;
+    
+    return result;
+}
+
+/// \brief Returns true if parsing a document with a lexer and set of tables produces the same AST as the bootstrap parser
+static bool same_as_bootstrap(const bootstrap& bs, const lexer& lex, const parser_tables& tables, const wstring& document) {
+    // Parse with the bootstrap parser
+    wstringstream       expectedInput(document);
+    lexeme_stream*      expectedStream  = bs.get_lexer().create_stream_from(expectedInput);
+    ast_parser::state*  expectedState   = bs.get_parser().create_parser(new ast_parser_actions(expectedStream));
+    bool                expectedAccept  = expectedState->parse();
+    
+    // Parse with the supplied tables
+    ast_parser          parser(tables);
+    wstringstream       actualInput(document);
+    lexeme_stream*      actualStream    = lex.create_stream_from(actualInput);
+    ast_parser::state*  actualState     = parser.create_parser(new ast_parser_actions(actualStream));
+    bool                actualAccept    = actualState->parse();
+    
+    bool result = expectedAccept && actualAccept && same_tree(expectedState->get_item().item(), actualState->get_item().item());
+    
+    delete expectedState;
+    delete actualState;
+    
+    return result;
+}
+
+/// \brief Copies some binary tables into a buffer that is suitably aligned for loading in place
+static vector<int> aligned_copy(const string& data) {
+    vector<int> result((data.size() + sizeof(int) - 1) / sizeof(int));
+    if (!data.empty()) memcpy(&result[0], data.data(), data.size());
+    return result;
+}
+
+void test_lr_binary_tables::run_tests() {
+    bootstrap bs;
+    
+    // Use the language definition as the document
+    const string&   definition = bootstrap::get_default_language_definition();
+    wstring         document(definition.begin(), definition.end());
+    
+    // Write out the tables for the bootstrap language
+    ndfa*           dfa = bs.create_dfa();
+    lexer           dfaLexer(*dfa);
+    stringstream    written;
+    
+    report("Write", binary_tables::write(written, *dfa, bs.get_parser().get_tables()));
+    delete dfa;
+    
+    string      data    = written.str();
+    vector<int> buffer  = aligned_copy(data);
+    
+    // Load the tables from memory
+    binary_tables fromMemory;
+    
+    report("LoadMemory", fromMemory.load(&buffer[0], data.size()));
+    report("LoadedMemory", fromMemory.loaded());
+    report("InPlace", fromMemory.in_place());
+    report("SameLexemes", fromMemory.loaded() && same_lexemes(dfaLexer, fromMemory.get_lexer(), document));
+    report("SameAst", fromMemory.loaded() && same_as_bootstrap(bs, fromMemory.get_lexer(), fromMemory.get_tables(), document));
+    
+    // Misaligned data has to be copied, but should produce the same results
+    vector<int>     misaligned(buffer.size() + 1);
+    const char*     misalignedData = ((const char*) &misaligned[0]) + 1;
+    memcpy((void*) misalignedData, data.data(), data.size());
+    
+    binary_tables fromCopy;
+    
+    report("LoadMisaligned", fromCopy.load(misalignedData, data.size()));
+    report("NotInPlace", fromCopy.loaded() && !fromCopy.in_place());
+    report("SameAstMisaligned", fromCopy.loaded() && same_as_bootstrap(bs, fromCopy.get_lexer(), fromCopy.get_tables(), document));
+    
+    // Load the tables from a file
+    const char* filename = "lr_binary_tables_test.tpt";
+    {
+        ofstream file(filename, ios::out | ios::binary | ios::trunc);
+        file.write(data.data(), data.size());
+    }
+    
+    binary_tables fromFile;
+    
+    report("LoadFile", fromFile.load(string(filename)));
+    report("SameAstFile", fromFile.loaded() && same_as_bootstrap(bs, fromFile.get_lexer(), fromFile.get_tables(), document));
+    
+    fromFile.unload();
+    report("Unload", !fromFile.loaded());
+    remove(filename);
+    
+    report("LoadMissingFile", !fromFile.load(string(filename)));
+    
+    // Damaged files should be rejected
+    string      badMagic    = data;
+    string      badVersion  = data;
+    
+    badMagic[0]     = 'X';
+    badVersion[4]   = (char) (binary_tables::file_version + 1);
+    
+    vector<int> badMagicBuffer      = aligned_copy(badMagic);
+    vector<int> badVersionBuffer    = aligned_copy(badVersion);
+    
+    binary_tables rejected;
+    
+    report("RejectMagic", !rejected.load(&badMagicBuffer[0], badMagic.size()));
+    report("RejectVersion", !rejected.load(&badVersionBuffer[0], badVersion.size()));
+    report("RejectTruncated", !rejected.load(&buffer[0], data.size() / 2));
+    report("RejectHeader", !rejected.load(&buffer[0], 8));
+    report("NotLoaded", !rejected.loaded());
+}
@@ -0,0 +1,160 @@
+//
+//  lr_compressed_tables.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include "lr_compressed_tables.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Lr/ast_parser.h"
+#include "TameParse/Lr/binary_tables.h"
+
+using namespace std;
+using namespace util;
+using namespace dfa;
+using namespace lr;
+using namespace yy_language;
+
+/// \brief Returns true if two ASTs are the same
+static bool same_tree(const astnode* a, const astnode* b) {
+    if (a == NULL || b == NULL)                         return a == b;
+    if (a->item_identifier() != b->item_identifier())   return false;
+    if (a->rule() != b->rule())                         return false;
+    if (a->children().size() != b->children().size())  return false;
+    
+    for (size_t child = 0; child < a->children().size(); ++child) {
+        if (!same_tree(a->children()[child].item(), b->children()[child].item())) return false;
+    }
+    
+    return true;
+}
+
+/// \brief Parses a document with the bootstrap lexer and the specified tables, returning NULL if it was rejected
+static ast_parser::state* parse(const bootstrap& bs, const parser_tables& tables, const wstring& document) {
+    ast_parser          parser(tables);
+    wstringstream       input(document);
+    lexeme_stream*      stream  = bs.get_lexer().create_stream_from(input);
+    ast_parser::state*  state   = parser.create_parser(new ast_parser_actions(stream));
+    
+    if (!state->parse()) {
+        delete state;
+        return NULL;
+    }
+    
+    return state;
+}
+
+/// \brief Returns true if the compressed tables produce the same AST as the original tables for a document
+static bool same_parse(const bootstrap& bs, const parser_tables& original, const parser_tables& compressed, const wstring& document) {
+    ast_parser::state*  expected    = parse(bs, original, document);
+    ast_parser::state*  actual      = parse(bs, compressed, document);
+    bool                result      = expected && actual && same_tree(expected->get_item().item(), actual->get_item().item());
+    
+    delete expected;
+    delete actual;
+    
+    return result;
+}
+
+/// \brief Counts the actions in a set of tables
+static int count_actions(const parser_tables& tables) {
+    int count = 0;
+    for (int stateId = 0; stateId < tables.count_states(); ++stateId) {
+        count += tables.count_actions_for_state(stateId);
+    }
+    return count;
+}
+
+void test_lr_compressed_tables::run_tests() {
+    bootstrap bs;
+    
+    // Use the language definition as the document
+    const string&           definition  = bootstrap::get_default_language_definition();
+    wstring                 document(definition.begin(), definition.end());
+    const parser_tables&    original    = bs.get_parser().get_tables();
+    
+    // Compress a copy of the bootstrap tables
+    parser_tables compressed(original);
+    compressed.compress();
+    
+    report("HasDefaults", compressed.default_reductions() != NULL && original.default_reductions() == NULL);
+    report("FewerActions", count_actions(compressed) < count_actions(original));
+    report("Smaller", compressed.size() < original.size());
+    
+    // States with a single reduction should only have actions for the ignored symbols left
+    bool foundConsistent = false;
+    for (int stateId = 0; stateId < compressed.count_states() && !foundConsistent; ++stateId) {
+        if (compressed.default_reduction(stateId) < 0) continue;
+        
+        foundConsistent = true;
+        for (const parser_tables::action* act = compressed.terminal_actions()[stateId]; act != compressed.last_terminal_action(stateId); ++act) {
+            if (act->type != lr_action::act_ignore) {
+                foundConsistent = false;
+                break;
+            }
+        }
+    }
+    report("ConsistentStates", foundConsistent);
+    
+    // Parsing should produce the same results
+    report("SameAst", same_parse(bs, original, compressed, document));
+    report("SameAstSmall", same_parse(bs, original, compressed, L"language Example { keywords { a b } grammar { <A> = a+ (b | <A>)* } }"));
+    
+    // Syntax errors should still be detected
+    ast_parser::state* rejected = parse(bs, compressed, L"language Example { keywords { a b } grammar { <A> = a ) } }");
+    report("RejectError", rejected == NULL);
+    delete rejected;
+    
+    rejected = parse(bs, compressed, L"language Example { keywords { a b } grammar { <A> = a");
+    report("RejectEndOfInput", rejected == NULL);
+    delete rejected;
+    
+    // Copies should keep the default reductions
+    parser_tables copy(compressed);
+    report("CopyDefaults", copy.default_reductions() != NULL && copy.default_reduction(0) == compressed.default_reduction(0));
+    report("SameAstCopy", same_parse(bs, original, copy, document));
+    report("CopyExpected", copy.expected_terminals() != NULL && copy.count_terminals() == compressed.count_terminals() 
+           && memcmp(copy.expected_terminals(), compressed.expected_terminals(), sizeof(unsigned int) * compressed.count_states() * compressed.expected_words()) == 0);
+    
+    // The default reductions should survive being written to a binary file
+    ndfa*           dfa = bs.create_dfa();
+    stringstream    written;
+    
+    binary_tables::write(written, *dfa, compressed);
+    delete dfa;
+    
+    string          data = written.str();
+    vector<int>     buffer((data.size() + sizeof(int) - 1) / sizeof(int));
+    binary_tables   loaded;
+    
+    memcpy(&buffer[0], data.data(), data.size());
+    
+    report("LoadBinary", loaded.load(&buffer[0], data.size()));
+    report("BinaryDefaults", loaded.loaded() && loaded.get_tables().default_reductions() != NULL);
+    report("BinaryExpected", loaded.loaded() && loaded.get_tables().expected_terminals() != NULL && loaded.get_tables().count_terminals() == compressed.count_terminals()
+           && memcmp(loaded.get_tables().expected_terminals(), compressed.expected_terminals(), sizeof(unsigned int) * compressed.count_states() * compressed.expected_words()) == 0);
+    report("SameAstBinary", loaded.loaded() && same_parse(bs, original, loaded.get_tables(), document));
+}
@@ -0,0 +1,333 @@
+//
+//  lr_concurrent.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy 
+//  of this software and associated documentation files (the \"Software\"), to 
+//  deal in the Software without restriction, including without limitation the 
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+//  sell copies of the Software, and to permit persons to whom the Software is 
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+
+#include "lr_concurrent.h"
+#include "TameParse/Util/utf8reader.h"
+#include "TameParse/Dfa/character_lexer.h"
+#include "TameParse/ContextFree/grammar.h"
+#include "TameParse/Lr/lalr_builder.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Lr/batch_parser.h"
+#include "TameParse/Lr/chunked_parser.h"
+
+using namespace std;
+using namespace util;
+using namespace dfa;
+using namespace contextfree;
+using namespace lr;
+using namespace yy_language;
+
+/// \brief Number of threads to run at once
+static const int c_NumThreads       = 8;
+
+/// \brief Number of times each thread parses the language definition
+static const int c_ParsesPerThread  = 4;
+
+/// \brief AST parser actions that throw an exception when they read the identifier 'explode'
+class exploding_actions : public ast_parser_actions {
+public:
+    exploding_actions(lexeme_stream* stream)
+    : ast_parser_actions(stream) {
+    }
+    
+    /// \brief Reads the next symbol from the stream
+    inline lexeme* read() {
+        lexeme* result = ast_parser_actions::read();
+        if (result && result->content<char>() == "explode") {
+            delete result;
+            throw runtime_error("explode");
+        }
+        
+        return result;
+    }
+};
+
+/// \brief Counts the nodes in an AST
+static int count_nodes(const astnode* node) {
+    int count = 1;
+    
+    for (astnode::node_list::const_iterator child = node->children().begin(); child != node->children().end(); ++child) {
+        count += count_nodes(child->item());
+    }
+    
+    return count;
+}
+
+/// \brief Counts the terminal symbols in an AST, and finds the position of the last one
+static int count_terminals(const astnode* node, position& lastPos) {
+    if (node->lexeme().item()) {
+        lastPos = node->lexeme()->pos();
+        return 1;
+    }
+    
+    int count = 0;
+    for (astnode::node_list::const_iterator child = node->children().begin(); child != node->children().end(); ++child) {
+        count += count_terminals(child->item(), lastPos);
+    }
+    
+    return count;
+}
+
+/// \brief Counts the terminal symbols in the chunks produced by a chunked parser, and finds the position of the last one
+template<typename chunk_list> static int count_chunk_terminals(const chunk_list& chunks, position& lastPos) {
+    int count = 0;
+    for (typename chunk_list::const_iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk) {
+        if (!chunk->accepted) return -1;
+        count += count_terminals(chunk->item.item(), lastPos);
+    }
+    
+    return count;
+}
+
+/// \brief Returns true if every chunk was parsed speculatively
+template<typename chunk_list> static bool all_speculative(const chunk_list& chunks) {
+    for (typename chunk_list::const_iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk) {
+        if (!chunk->speculative) return false;
+    }
+    
+    return true;
+}
+
+/// \brief Parses the default language definition, returning the number of nodes in the resulting AST or -1 if it can't be parsed
+static int parse_definition(const bootstrap& bs) {
+    // Create a stream for the language definition
+    stringstream    definition(bootstrap::get_default_language_definition());
+    utf8reader      reader(&definition);
+    
+    // Parse it
+    lexeme_stream*      stream  = bs.get_lexer().create_stream_from<wchar_t>(reader);
+    ast_parser::state*  state   = bs.get_parser().create_parser(new ast_parser_actions(stream));
+    
+    int result = -1;
+    if (state->parse()) {
+        result = count_nodes(state->get_item().item());
+    }
+    
+    delete state;
+    return result;
+}
+
+/// \brief Repeatedly parses the language definition, storing the number of nodes that were generated by each parse
+static void parse_repeatedly(const bootstrap* bs, int* results) {
+    for (int parse = 0; parse < c_ParsesPerThread; ++parse) {
+        results[parse] = parse_definition(*bs);
+    }
+}
+
+void test_lr_concurrent::run_tests() {
+    // The parser and lexer are shared between all of the threads
+    bootstrap bs;
+    
+    // Parse once on this thread to find out what the result should be
+    int expected = parse_definition(bs);
+    report("ParseSingleThreaded", expected > 0);
+    
+    // Parse on several threads at once
+    vector<int>     results(c_NumThreads * c_ParsesPerThread, 0);
+    vector<thread>  threads;
+    
+    for (int threadId = 0; threadId < c_NumThreads; ++threadId) {
+        threads.push_back(thread(parse_repeatedly, &bs, &results[threadId * c_ParsesPerThread]));
+    }
+    
+    for (vector<thread>::iterator toJoin = threads.begin(); toJoin != threads.end(); ++toJoin) {
+        toJoin->join();
+    }
+    
+    // Every parse should have produced the same result as the single-threaded one
+    bool allMatch = true;
+    for (vector<int>::const_iterator result = results.begin(); result != results.end(); ++result) {
+        if (*result != expected) allMatch = false;
+    }
+    
+    report("ParseMultiThreaded", allMatch);
+    
+    // Parse a batch of documents, some of which are invalid
+    typedef batch_parser<ast_parser_actions::astnode_container, ast_parser_actions> ast_batch_parser;
+    
+    vector<string> documents;
+    for (int docId = 0; docId < 32; ++docId) {
+        if (docId % 3 == 1) {
+            documents.push_back("rhubarb rhubarb rhubarb");
+        } else {
+            documents.push_back(bootstrap::get_default_language_definition());
+        }
+    }
+    
+    ast_batch_parser                batch(bs.get_parser(), bs.get_lexer(), 0, c_NumThreads);
+    ast_batch_parser::result_list   batchResults;
+    
+    batch.parse(documents, batchResults);
+    
+    // The results should be in the same order as the documents
+    bool batchMatches = batchResults.size() == documents.size();
+    for (size_t docId = 0; batchMatches && docId < batchResults.size(); ++docId) {
+        if (docId % 3 == 1) {
+            if (batchResults[docId].accepted)                                   batchMatches = false;
+            if (batchResults[docId].error_position.offset() < 0)                batchMatches = false;
+        } else {
+            if (!batchResults[docId].accepted)                                  batchMatches = false;
+            else if (count_nodes(batchResults[docId].item.item()) != expected)  batchMatches = false;
+        }
+    }
+    
+    report("BatchParse", batchMatches);
+    
+    // Exceptions thrown while parsing a document should be passed back to the caller once every document has been parsed
+    typedef batch_parser<ast_parser_actions::astnode_container, exploding_actions> exploding_batch_parser;
+    
+    documents[5] = "explode";
+    
+    parser<ast_parser_actions::astnode_container, exploding_actions>    explodingParser(bs.get_parser().get_tables());
+    exploding_batch_parser                                              explodingBatch(explodingParser, bs.get_lexer(), 0, c_NumThreads);
+    exploding_batch_parser::result_list                                 explodingResults;
+    bool                                                                caught = false;
+    
+    try {
+        explodingBatch.parse(documents, explodingResults);
+    } catch (runtime_error&) {
+        caught = true;
+    }
+    
+    report("BatchException", caught);
+    report("BatchExceptionOthersParsed", explodingResults.size() == documents.size() && explodingResults[3].accepted && explodingResults[6].accepted);
+    
+    // Parse a document made up of several copies of the language definition in chunks
+    typedef chunked_parser<ast_parser_actions::astnode_container, ast_parser_actions> ast_chunked_parser;
+    
+    const string&   definition  = bootstrap::get_default_language_definition();
+    string          document;
+    for (int copy = 0; copy < 4; ++copy) {
+        document += definition;
+        document += "\n";
+    }
+    
+    stringstream        sequentialInput(document);
+    ast_parser::state*  sequential  = bs.get_parser().create_parser(new ast_parser_actions(bs.get_lexer().create_stream_from(sequentialInput)));
+    position            expectedLast;
+    int                 expectedTerminals = -1;
+    
+    if (sequential->parse()) {
+        expectedTerminals = count_terminals(sequential->get_item().item(), expectedLast);
+    }
+    delete sequential;
+    
+    // Top-level blocks end with a brace at the start of a line
+    ast_chunked_parser              chunked(bs.get_parser(), bs.get_lexer(), 0, c_NumThreads);
+    ast_chunked_parser::chunk_list  chunks;
+    position                        chunkLast;
+    
+    bool chunkAccepted = chunked.parse(document, sequence_boundary<char>("\n}"), definition.size() / 2, chunks);
+    
+    report("ChunkParse", chunkAccepted && chunks.size() > 1 && all_speculative(chunks));
+    report("ChunkTerminals", count_chunk_terminals(chunks, chunkLast) == expectedTerminals && chunkLast == expectedLast);
+    
+    // Opening braces aren't safe boundaries, so the chunks will have to be parsed again
+    bool recoverAccepted = chunked.parse(document, sequence_boundary<char>("{"), 200, chunks);
+    
+    report("ChunkRecover", recoverAccepted && !all_speculative(chunks));
+    report("ChunkRecoverTerminals", count_chunk_terminals(chunks, chunkLast) == expectedTerminals && chunkLast == expectedLast);
+    
+    // Errors should be in the same place as they are when the document is parsed all at once
+    string broken = document;
+    broken.erase(broken.find('{', definition.size() * 2 + definition.size() / 2), 1);
+    
+    stringstream        brokenInput(broken);
+    ast_parser::state*  brokenState = bs.get_parser().create_parser(new ast_parser_actions(bs.get_lexer().create_stream_from(brokenInput)));
+    
+    bool sequentialRejected = !brokenState->parse();
+    report("ChunkError", sequentialRejected && !chunked.parse(broken, sequence_boundary<char>("\n}"), definition.size() / 2, chunks));
+    report("ChunkErrorPosition", brokenState->look().item() != NULL && !chunks.empty() && chunks.back().error_position == brokenState->look()->pos());
+    delete brokenState;
+    
+    // A list of statements, where an 'if' statement can be followed by an 'else'
+    grammar             ifGrammar;
+    terminal_dictionary ifTerms;
+    
+    nonterminal program(ifGrammar.id_for_nonterminal(L"Program"));
+    nonterminal statements(ifGrammar.id_for_nonterminal(L"Statements"));
+    nonterminal statement(ifGrammar.id_for_nonterminal(L"Statement"));
+    
+    int ifId        = ifTerms.add_symbol(L"'if'");
+    int elseId      = ifTerms.add_symbol(L"'else'");
+    int simpleId    = ifTerms.add_symbol(L"'s;'");
+    
+    // Program -> Statements
+    (ifGrammar += program) << statements;
+    
+    // Statements -> Statements Statement | (empty)
+    (ifGrammar += statements) << statements << statement;
+    (ifGrammar += statements);
+    
+    // Statement -> if s; | if s; else s; | s;
+    (ifGrammar += statement) << terminal(ifId) << terminal(simpleId);
+    (ifGrammar += statement) << terminal(ifId) << terminal(simpleId) << terminal(elseId) << terminal(simpleId);
+    (ifGrammar += statement) << terminal(simpleId);
+    
+    lalr_builder ifBuilder(ifGrammar, ifTerms);
+    ifBuilder.add_initial_state(program);
+    ifBuilder.complete_parser();
+    
+    typedef chunked_parser<int, simple_parser_actions> simple_chunked_parser;
+    
+    simple_parser                           ifParser(ifBuilder, NULL);
+    character_lexer                         ifLexer;
+    simple_chunked_parser                   ifChunked(ifParser, ifLexer, 0, c_NumThreads);
+    simple_chunked_parser::chunk_list       ifChunks;
+    
+    // 'if s;' is accepted on its own, but the 'else s;' chunk after it can only be parsed along with it
+    basic_string<wchar_t> ifElse;
+    ifElse += (wchar_t) simpleId;
+    ifElse += (wchar_t) ifId;
+    ifElse += (wchar_t) simpleId;
+    ifElse += (wchar_t) elseId;
+    ifElse += (wchar_t) simpleId;
+    ifElse += (wchar_t) simpleId;
+    
+    bool ifElseAccepted = ifChunked.parse(ifElse, sequence_boundary<wchar_t>(basic_string<wchar_t>(1, (wchar_t) simpleId)), 1, ifChunks);
+    
+    size_t ifElseLength = 0;
+    for (simple_chunked_parser::chunk_list::const_iterator chunk = ifChunks.begin(); chunk != ifChunks.end(); ++chunk) {
+        if (chunk->offset != ifElseLength || !chunk->accepted) ifElseLength = 0;
+        else ifElseLength += chunk->length;
+    }
+    
+    report("ChunkEarlierBoundary", ifElseAccepted && !all_speculative(ifChunks));
+    report("ChunkEarlierBoundaryCovered", ifElseLength == ifElse.size());
+    
+    // The else on its own is still an error
+    basic_string<wchar_t> elseOnly;
+    elseOnly += (wchar_t) simpleId;
+    elseOnly += (wchar_t) elseId;
+    elseOnly += (wchar_t) simpleId;
+    
+    report("ChunkEarlierBoundaryError", !ifChunked.parse(elseOnly, sequence_boundary<wchar_t>(basic_string<wchar_t>(1, (wchar_t) simpleId)), 1, ifChunks));
+}
@@ -0,0 +1,169 @@
+//
+//  lr_incremental.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy 
+//  of this software and associated documentation files (the \"Software\"), to 
+//  deal in the Software without restriction, including without limitation the 
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+//  sell copies of the Software, and to permit persons to whom the Software is 
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+
+#include "lr_incremental.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Lr/ast_parser.h"
+#include "TameParse/Lr/incremental_parser.h"
+
+using namespace std;
+using namespace util;
+using namespace dfa;
+using namespace lr;
+using namespace yy_language;
+
+/// \brief Incremental parser that produces an AST
+typedef incremental_parser<ast_parser_actions::astnode_container, ast_parser_actions> ast_incremental_parser;
+
+/// \brief Returns true if two ASTs are the same (including the positions of their lexemes)
+static bool same_tree(const astnode* a, const astnode* b) {
+    if (a == NULL || b == NULL)                         return a == b;
+    if (a->item_identifier() != b->item_identifier())   return false;
+    if (a->rule() != b->rule())                         return false;
+    
+    // Compare the lexemes
+    const lexeme* lexA = a->lexeme().item();
+    const lexeme* lexB = b->lexeme().item();
+    
+    if (lexA == NULL || lexB == NULL) {
+        if (lexA != lexB)                               return false;
+    } else {
+        if (lexA->matched() != lexB->matched())         return false;
+        if (lexA->content() != lexB->content())         return false;
+        if (lexA->pos() != lexB->pos())                 return false;
+    }
+    
+    // Compare the children
+    if (a->children().size() != b->children().size())  return false;
+    
+    for (size_t child = 0; child < a->children().size(); ++child) {
+        if (!same_tree(a->children()[child].item(), b->children()[child].item())) return false;
+    }
+    
+    return true;
+}
+
+/// \brief Returns true if the incremental parser has the same result as parsing its document from scratch
+static bool same_as_full_parse(const bootstrap& bs, const ast_incremental_parser& incremental) {
+    // Parse the document again
+    wstringstream       document(incremental.document());
+    lexeme_stream*      stream  = bs.get_lexer().create_stream_from(document);
+    ast_parser::state*  state   = bs.get_parser().create_parser(new ast_parser_actions(stream));
+    
+    bool accepted   = state->parse();
+    bool result     = accepted == incremental.accepted();
+    
+    if (result && accepted) {
+        result = same_tree(state->get_item().item(), incremental.item().item());
+    }
+    
+    delete state;
+    return result;
+}
+
+void test_lr_incremental::run_tests() {
+    bootstrap bs;
+    
+    // Use the language definition as the document
+    const string&   definition = bootstrap::get_default_language_definition();
+    wstring         document(definition.begin(), definition.end());
+    
+    ast_incremental_parser incremental(bs.get_parser().get_tables(), bs.get_lexer(), 0, 16);
+    
+    report("InitialParse", incremental.parse(document));
+    report("InitialSame", same_as_full_parse(bs, incremental));
+    report("InitialLexed", incremental.symbols_lexed() == incremental.symbol_count());
+    
+    // Rename a lexer symbol
+    size_t digit = document.find(L"digit ");
+    
+    report("RenameAccepted", incremental.edit(digit, 5, L"number"));
+    report("RenameSame", same_as_full_parse(bs, incremental));
+    report("RenameRelexed", incremental.symbols_lexed() <= 4);
+    report("RenameReused", incremental.nonterminals_reused() > 0);
+    
+    // Add a new line (moves all of the following symbols down a line)
+    size_t regex = incremental.document().find(L"\t\tregex\t");
+    
+    report("InsertLineAccepted", incremental.edit(regex, 0, L"\t\tanother = /[a-z]+/\n"));
+    report("InsertLineSame", same_as_full_parse(bs, incremental));
+    report("InsertLineReused", incremental.nonterminals_reused() > 0);
+    
+    // Remove a comment
+    size_t comment      = incremental.document().find(L"// Commonly used character sets");
+    size_t commentEnd   = incremental.document().find(L"\n", comment);
+    
+    report("DeleteAccepted", incremental.edit(comment, commentEnd - comment, L""));
+    report("DeleteSame", same_as_full_parse(bs, incremental));
+    
+    // Join two identifiers together by removing the whitespace between them, then split them up again
+    size_t keywords = incremental.document().find(L"\t\tlanguage\n\t\timport");
+    
+    report("JoinAccepted", incremental.edit(keywords + 10, 3, L""));
+    report("JoinSame", same_as_full_parse(bs, incremental));
+    report("SplitAccepted", incremental.edit(keywords + 10, 0, L"\n\t\t"));
+    report("SplitSame", same_as_full_parse(bs, incremental));
+    
+    // Introduce a syntax error, then fix it again
+    size_t lexerBlock = incremental.document().find(L"lexer {");
+    
+    report("ErrorRejected", !incremental.edit(lexerBlock + 6, 1, L"="));
+    report("ErrorSame", same_as_full_parse(bs, incremental));
+    report("ErrorPosition", incremental.error_position().offset() >= (int) lexerBlock);
+    report("FixAccepted", incremental.edit(lexerBlock + 6, 1, L"{"));
+    report("FixSame", same_as_full_parse(bs, incremental));
+    
+    // Edit the end of the document
+    size_t end = incremental.document().size();
+    
+    report("AppendAccepted", incremental.edit(end, 0, L"\n// The end\n"));
+    report("AppendSame", same_as_full_parse(bs, incremental));
+    
+    // Edit the start of the document
+    report("PrependAccepted", incremental.edit(0, 0, L"// Start\n"));
+    report("PrependSame", same_as_full_parse(bs, incremental));
+    
+    // Make a series of small edits (indenting the nonterminal definitions)
+    bool allSame = true;
+    for (int edit = 0; edit < 20; ++edit) {
+        size_t pos = incremental.document().find(L"\n\t\t<", (incremental.document().size() * edit) / 20);
+        if (pos == wstring::npos) continue;
+        
+        incremental.edit(pos + 1, 0, L" ");
+        if (!same_as_full_parse(bs, incremental)) allSame = false;
+    }
+    
+    report("ManyEditsSame", allSame);
+    report("ManyEditsAccepted", incremental.accepted());
+    
+    // Edits outside the document should be clamped even when nothing has been parsed yet
+    ast_incremental_parser unparsed(bs.get_parser().get_tables(), bs.get_lexer(), 0, 16);
+    
+    report("EditBeforeParse", unparsed.edit(1000, 5, document));
+    report("EditBeforeParseSame", same_as_full_parse(bs, unparsed));
+}
@@ -34,6 +34,7 @@
 #include "TameParse/ContextFree/grammar.h"
 #include "TameParse/Lr/lalr_builder.h"
 #include "TameParse/Lr/parser.h"
+#include "TameParse/Lr/parser_stack.h"
 #include "TameParse/Lr/conflict.h"
 #include "TameParse/Language/formatter.h"
 
@@ -43,6 +44,16 @@ using namespace contextfree;
 using namespace yy_language;
 using namespace lr;
 
+/// \brief The number of counted_item objects created with the default constructor
+static int s_DefaultItems = 0;
+
+/// \brief Stack item that counts how many times it's created with the default constructor
+class counted_item {
+public:
+    counted_item() { ++s_DefaultItems; }
+    counted_item(int) { }
+};
+
 static void dump(const item& it, const grammar& gram, const terminal_dictionary& dict) {
     if (it.type() == item::nonterminal) {
         wcerr << gram.name_for_nonterminal(it.symbol());
@@ -245,6 +256,28 @@ static bool no_duplicate_states(lalr_machine& m) {
 typedef basic_string<wchar_t> int_string;
 typedef basic_stringstream<wchar_t> int_stringstream;
 
+/// \brief Symbol stream that reads from a string
+class string_symbol_stream : public lexer_symbol_stream {
+private:
+    int_string  m_Symbols;
+    size_t      m_Pos;
+    
+public:
+    string_symbol_stream(const int_string& symbols)
+    : m_Symbols(symbols)
+    , m_Pos(0) {
+    }
+    
+    virtual lexer_symbol_stream& operator>>(int& result) {
+        if (m_Pos < m_Symbols.size()) {
+            result = m_Symbols[m_Pos++];
+        } else {
+            result = symbol_set::end_of_input;
+        }
+        return *this;
+    }
+};
+
 static bool can_parse(int_string& symbols, simple_parser& p, character_lexer& lex) {
     int_stringstream stream(symbols);
     simple_parser::state* state = p.create_parser(new simple_parser_actions(lex.create_stream_from(stream)));
@@ -359,6 +392,65 @@ void test_lalr_general::run_tests() {
     delete parse1;
     delete parse2;
     
+    // The same parse with a parser that collects statistics
+    typedef parser<int, simple_parser_actions, stats_parser_trace> stats_parser;
+    
+    stats_parser        statsParser(builder, NULL);
+    int_stringstream    stream3(test2);
+    stats_parser::state* parse3 = statsParser.create_parser(new simple_parser_actions(lex.create_stream_from(stream3)));
+    
+    report("StatsAccept", parse3->parse());
+    
+    const parser_stats& stats = parse3->get_trace().stats();
+    size_t ruleReductions = 0;
+    for (size_t ruleId = 0; ruleId < stats.rule_reductions.size(); ++ruleId) {
+        ruleReductions += stats.rule_reductions[ruleId];
+    }
+    
+    report("StatsShifts", stats.shifts == 4);
+    report("StatsReductions", stats.reductions > 0 && stats.reductions == ruleReductions);
+    report("StatsStackDepth", stats.max_stack_depth >= 3);
+    report("StatsLookahead", stats.max_lookahead >= 1);
+    report("StatsNoGuards", stats.guard_checks == 0);
+    
+    // Reset the state to parse a different string using a new lexer stream
+    int_stringstream stream4(test1);
+    parse3->reset(lex.create_stream_from(stream4));
+    
+    report("ResetAccept1", parse3->parse());
+    report("ResetStats", parse3->get_trace().stats().shifts == 1);
+    
+    delete parse3;
+    
+    // Reset the lexer stream and then the parser state to parse another string
+    int_stringstream    stream5(test1);
+    lexeme_stream*      resetStream = lex.create_stream_from(stream5);
+    simple_parser::state* parse4    = p.create_parser(new simple_parser_actions(resetStream));
+    
+    report("ResetAccept2", parse4->parse());
+    
+    bool streamReset = resetStream->reset(new string_symbol_stream(test2));
+    parse4->reset();
+    
+    report("ResetLexemeStream", streamReset);
+    report("ResetAccept3", parse4->parse());
+    
+    delete parse4;
+    
+    // Resetting a stack that is already big enough shouldn't create any new items
+    parser_stack<counted_item, 4>   countedStack;
+    counted_item                    pushed(1);
+    
+    for (int state = 0; state < 20; ++state) countedStack.push(state, pushed);
+    
+    int defaultItems = s_DefaultItems;
+    for (int pass = 0; pass < 3; ++pass) {
+        countedStack.reset(0);
+        for (int state = 0; state < 20; ++state) countedStack.push(state, pushed);
+    }
+    
+    report("ResetStackNoNewItems", s_DefaultItems == defaultItems);
+    
     // Create another parser, this one with a particular type of empty production (accepts arbitrary strings of ids)
     grammar emptyProd;
 
@@ -490,4 +582,18 @@ void test_lalr_general::run_tests() {
     // Also test [=> [=> 'd' ] ] 'd'
     // This actually tests two things: do multiple guards in one state work, and do recursive guards work?
     report("ContextSensitiveRecursiveGuards1", can_parse(oneD, simpleCsParser, lex));
+
+    // Guards should show up in the parser statistics
+    typedef parser<int, simple_parser_actions, stats_parser_trace> stats_parser;
+    
+    stats_parser            statsCsParser(csBuilder, NULL);
+    int_stringstream        csStream(threeOfEach);
+    stats_parser::state*    csState = statsCsParser.create_parser(new simple_parser_actions(lex.create_stream_from(csStream)));
+    
+    report("StatsContextSensitiveAccept", csState->parse());
+    report("StatsGuardChecks", csState->get_trace().stats().guard_checks > 0);
+    report("StatsGuardsMatched", csState->get_trace().stats().guards_matched > 0);
+    report("StatsGuardDepth", csState->get_trace().stats().max_guard_depth >= 6);
+    
+    delete csState;
 }
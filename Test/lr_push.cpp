@@ -0,0 +1,194 @@
+//
+//  lr_push.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy 
+//  of this software and associated documentation files (the \"Software\"), to 
+//  deal in the Software without restriction, including without limitation the 
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or 
+//  sell copies of the Software, and to permit persons to whom the Software is 
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS 
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include "lr_push.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Lr/ast_parser.h"
+#include "TameParse/Lr/push_parser.h"
+
+using namespace std;
+using namespace util;
+using namespace dfa;
+using namespace lr;
+using namespace yy_language;
+
+/// \brief Push parser that produces an AST
+typedef push_parser<ast_parser_actions::astnode_container, ast_parser_actions> ast_push_parser;
+
+/// \brief Returns true if two ASTs are the same (including the positions of their lexemes)
+static bool same_tree(const astnode* a, const astnode* b) {
+    if (a == NULL || b == NULL)                         return a == b;
+    if (a->item_identifier() != b->item_identifier())   return false;
+    if (a->rule() != b->rule())                         return false;
+    
+    // Compare the lexemes
+    const lexeme* lexA = a->lexeme().item();
+    const lexeme* lexB = b->lexeme().item();
+    
+    if (lexA == NULL || lexB == NULL) {
+        if (lexA != lexB)                               return false;
+    } else {
+        if (lexA->matched() != lexB->matched())         return false;
+        if (lexA->content() != lexB->content())         return false;
+        if (lexA->pos() != lexB->pos())                 return false;
+    }
+    
+    // Compare the children
+    if (a->children().size() != b->children().size())  return false;
+    
+    for (size_t child = 0; child < a->children().size(); ++child) {
+        if (!same_tree(a->children()[child].item(), b->children()[child].item())) return false;
+    }
+    
+    return true;
+}
+
+/// \brief Returns true if the push lexer produces the same lexemes as a normal stream when fed pieces of the specified size
+static bool same_lexemes(const bootstrap& bs, const wstring& document, size_t pieceSize) {
+    // Lex the whole document
+    wstringstream   input(document);
+    lexeme_stream*  stream = bs.get_lexer().create_stream_from(input);
+    vector<lexeme*> expected;
+    
+    for (;;) {
+        lexeme* next = NULL;
+        (*stream) >> next;
+        if (!next) break;
+        expected.push_back(next);
+    }
+    delete stream;
+    
+    // Feed it to the push lexer a piece at a time
+    push_lexer      lexer(bs.get_lexer());
+    vector<lexeme*> actual;
+    
+    for (size_t pos = 0; pos <= document.size(); pos += pieceSize) {
+        size_t end = pos + pieceSize;
+        if (end > document.size()) end = document.size();
+        
+        lexer.feed(document.begin() + pos, document.begin() + end);
+        if (end == document.size()) lexer.finish();
+        
+        for (lexeme* next = lexer.next(); next != NULL; next = lexer.next()) {
+            actual.push_back(next);
+        }
+    }
+    
+    // Compare the results
+    bool result = expected.size() == actual.size();
+    
+    for (size_t lexemeId = 0; result && lexemeId < expected.size(); ++lexemeId) {
+        if (expected[lexemeId]->matched() != actual[lexemeId]->matched())   result = false;
+        if (expected[lexemeId]->content() != actual[lexemeId]->content())   result = false;
+        if (expected[lexemeId]->pos() != actual[lexemeId]->pos())           result = false;
+    }
+    
+    for (size_t lexemeId = 0; lexemeId < expected.size(); ++lexemeId)  delete expected[lexemeId];
+    for (size_t lexemeId = 0; lexemeId < actual.size(); ++lexemeId)    delete actual[lexemeId];
+    
+    return result;
+}
+
+/// \brief Feeds a document to a push parser a piece at a time, and returns the final result
+static parser_result::result push_parse(ast_push_parser& parser, const wstring& document, size_t pieceSize) {
+    parser_result::result result = parser_result::more;
+    
+    for (size_t pos = 0; pos < document.size() && result == parser_result::more; pos += pieceSize) {
+        size_t end = pos + pieceSize;
+        if (end > document.size()) end = document.size();
+        
+        result = parser.feed(document.begin() + pos, document.begin() + end);
+    }
+    
+    return parser.finish();
+}
+
+/// \brief Returns true if the push parser produces the same AST as a normal parse when fed pieces of the specified size
+static bool same_as_full_parse(const bootstrap& bs, const wstring& document, size_t pieceSize) {
+    // Parse the whole document
+    wstringstream       input(document);
+    lexeme_stream*      stream  = bs.get_lexer().create_stream_from(input);
+    ast_parser::state*  state   = bs.get_parser().create_parser(new ast_parser_actions(stream));
+    
+    bool accepted = state->parse();
+    
+    // Feed it to a push parser
+    ast_push_parser     parser(bs.get_parser(), bs.get_lexer());
+    bool                pushAccepted = push_parse(parser, document, pieceSize) == parser_result::accept;
+    bool                result       = accepted && pushAccepted && parser.pending() == 0;
+    
+    if (result) {
+        result = same_tree(state->get_item().item(), parser.get_state()->get_item().item());
+    }
+    
+    delete state;
+    return result;
+}
+
+void test_lr_push::run_tests() {
+    bootstrap bs;
+    
+    // Use the language definition as the document
+    const string&   definition = bootstrap::get_default_language_definition();
+    wstring         document(definition.begin(), definition.end());
+    
+    // The lexer should produce the same lexemes however the input is divided up
+    report("LexerSingleCharacters", same_lexemes(bs, document, 1));
+    report("LexerSmallPieces", same_lexemes(bs, document, 7));
+    report("LexerLargePieces", same_lexemes(bs, document, 4096));
+    report("LexerWholeDocument", same_lexemes(bs, document, document.size()));
+    
+    // Carriage returns at the end of a piece should not change the line numbers
+    wstring crlf;
+    for (size_t pos = 0; pos < document.size(); ++pos) {
+        if (document[pos] == L'\n') crlf += L'\r';
+        crlf += document[pos];
+    }
+    
+    report("LexerCrLf", same_lexemes(bs, crlf, 3));
+    
+    // The parser should produce the same tree however the input is divided up
+    report("ParseSingleCharacters", same_as_full_parse(bs, document, 1));
+    report("ParseSmallPieces", same_as_full_parse(bs, document, 7));
+    report("ParseLargePieces", same_as_full_parse(bs, document, 4096));
+    report("ParseCrLf", same_as_full_parse(bs, crlf, 5));
+    
+    // An error should be reported as soon as the parser sees it
+    ast_push_parser early(bs.get_parser(), bs.get_lexer());
+    
+    report("EarlyRejectMore", early.feed(wstring(L"language Test { ")) == parser_result::more);
+    report("EarlyReject", early.feed(wstring(L"} } ")) == parser_result::reject);
+    report("EarlyRejectFinish", early.finish() == parser_result::reject);
+    
+    // A truncated document is rejected once the parser finds out that there is no more input
+    ast_push_parser truncated(bs.get_parser(), bs.get_lexer());
+    
+    report("TruncatedMore", truncated.feed(document.begin(), document.begin() + document.size() / 2) == parser_result::more);
+    report("TruncatedReject", truncated.finish() == parser_result::reject);
+}
@@ -0,0 +1,465 @@
+//
+//  lr_recogniser.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+
+#include "lr_recogniser.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Dfa/character_lexer.h"
+#include "TameParse/Dfa/lexer.h"
+#include "TameParse/Dfa/symbol_reader.h"
+#include "TameParse/Dfa/line_index.h"
+#include "TameParse/ContextFree/grammar.h"
+#include "TameParse/Lr/lalr_builder.h"
+#include "TameParse/Lr/ast_parser.h"
+#include "TameParse/Lr/recogniser.h"
+
+using namespace std;
+using namespace dfa;
+using namespace contextfree;
+using namespace lr;
+using namespace yy_language;
+
+/// \brief Parser actions that switch the lexer to a new state for every lexeme after a particular symbol is shifted
+///
+/// (The lexer goes back to its first state after each lexeme, so the state is set again after every shift)
+class state_changing_actions : public simple_parser_actions {
+private:
+    /// \brief The stream whose state is changed
+    lexeme_stream* m_Stream;
+    
+    /// \brief The symbol that changes the state
+    int m_Symbol;
+    
+    /// \brief The state that the lexer is switched to
+    int m_State;
+    
+    /// \brief True once the symbol that changes the state has been shifted
+    bool m_Changed;
+    
+public:
+    state_changing_actions(lexeme_stream* stream, int symbol, int state)
+    : simple_parser_actions(stream)
+    , m_Stream(stream)
+    , m_Symbol(symbol)
+    , m_State(state)
+    , m_Changed(false) {
+    }
+    
+    /// \brief Switches the lexer state once the lexeme that changes it has been shifted
+    inline int shift(const lexeme_container& lexeme) {
+        if (lexeme->matched() == m_Symbol) m_Changed = true;
+        if (m_Changed) m_Stream->set_initial_state(m_State);
+        return 0;
+    }
+};
+
+typedef parser<int, state_changing_actions> state_changing_parser;
+
+/// \brief Returns true if the recogniser accepts the specified symbols
+static bool can_recognise(const wstring& symbols, recogniser& recog, character_lexer& lex) {
+    wstringstream   input(symbols);
+    lexeme_stream*  stream = lex.create_stream_from(input);
+    
+    bool result = recog.recognise(stream);
+    
+    delete stream;
+    return result;
+}
+
+/// \brief Lexeme stream that counts how its source is read
+class batch_counting_stream : public lexeme_stream {
+private:
+    /// \brief The stream that lexemes are read from
+    lexeme_stream* m_Source;
+    
+public:
+    /// \brief The number of lexemes read one at a time
+    int single;
+    
+    /// \brief The number of batches of lexemes read
+    int batches;
+    
+    batch_counting_stream(lexeme_stream* source)
+    : m_Source(source)
+    , single(0)
+    , batches(0) {
+    }
+    
+    virtual ~batch_counting_stream() {
+        delete m_Source;
+    }
+    
+    /// \brief Reads a single lexeme
+    virtual lexeme_stream& operator>>(lexeme*& result) {
+        ++single;
+        (*m_Source) >> result;
+        return *this;
+    }
+    
+    /// \brief Reads a batch of lexemes
+    virtual size_t read_batch(lexeme** out, size_t count) {
+        ++batches;
+        return m_Source->read_batch(out, count);
+    }
+};
+
+/// \brief State machine that matches every character as a symbol on its own (state n+1 accepts symbol n)
+class character_state_machine {
+public:
+    inline int run_unsafe(int state, int symbol) const {
+        if (state != 0 || symbol < 0 || symbol >= 16) return -1;
+        return symbol + 1;
+    }
+};
+
+/// \brief Accepting symbols for character_state_machine
+static const int s_CharacterAccept[] = { -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+/// \brief Returns true if the recogniser accepts the specified symbols when they are read with a symbol_reader
+static bool can_recognise_from(const wstring& symbols, recogniser& recog) {
+    typedef symbol_reader<character_state_machine, wstringstream, wchar_t> reader;
+    
+    wstringstream   input(symbols);
+    reader          symbolReader(character_state_machine(), s_CharacterAccept, input);
+    
+    return recog.recognise_from(symbolReader);
+}
+
+void test_lr_recogniser::run_tests() {
+    bootstrap bs;
+    
+    // Use the language definition as the document
+    const string&           definition  = bootstrap::get_default_language_definition();
+    wstring                 document(definition.begin(), definition.end());
+    const parser_tables&    tables      = bs.get_parser().get_tables();
+    recogniser              recog(tables);
+    
+    wstringstream   validInput(document);
+    lexeme_stream*  validStream = bs.get_lexer().create_stream_from(validInput);
+    
+    report("AcceptDefinition", recog.recognise(validStream));
+    report("NoErrorSymbol", recog.error_symbol() == -1);
+    delete validStream;
+    
+    // Break the document by removing a brace from the middle
+    wstring broken = document;
+    broken.erase(broken.find(L'{', broken.size() / 2), 1);
+    
+    wstringstream   brokenInput(broken);
+    lexeme_stream*  brokenStream = bs.get_lexer().create_stream_from(brokenInput);
+    
+    report("RejectBroken", !recog.recognise(brokenStream));
+    delete brokenStream;
+    
+    position    brokenErrorPos      = recog.error_position();
+    int         brokenErrorSymbol   = recog.error_symbol();
+    
+    // The error should be in the same place as it is for the parser
+    wstringstream       expectedInput(broken);
+    ast_parser          astParser(tables);
+    ast_parser::state*  expected = astParser.create_parser(new ast_parser_actions(bs.get_lexer().create_stream_from(expectedInput)));
+    
+    report("ParserRejectsBroken", !expected->parse());
+    report("ErrorSymbol", expected->look().item() != NULL && expected->look()->matched() == recog.error_symbol());
+    report("ErrorPosition", expected->look().item() != NULL && expected->look()->pos() == recog.error_position());
+    delete expected;
+    
+    // Running out of input should be reported with an error symbol of -1
+    wstringstream   truncatedInput(document.substr(0, document.size() / 2));
+    lexeme_stream*  truncatedStream = bs.get_lexer().create_stream_from(truncatedInput);
+    
+    report("RejectTruncated", !recog.recognise(truncatedStream) && recog.error_symbol() == -1);
+    delete truncatedStream;
+    
+    // The recogniser can be reused after an error
+    wstringstream   againInput(document);
+    lexeme_stream*  againStream = bs.get_lexer().create_stream_from(againInput);
+    
+    report("AcceptAgain", recog.recognise(againStream));
+    delete againStream;
+    
+    // Batches of tokens should match the lexemes read one at a time (tokens only have an offset, so their positions come from a line index)
+    line_index      documentLines(document.begin(), document.end());
+    wstringstream   lexemeInput(document);
+    wstringstream   batchInput(document);
+    lexeme_stream*  lexemeStream    = bs.get_lexer().create_stream_from(lexemeInput);
+    lexeme_stream*  batchStream     = bs.get_lexer().create_stream_from(batchInput);
+    
+    bool    batchesMatch    = true;
+    token   batch[7];
+    size_t  batchCount      = 0;
+    size_t  batchPos        = 0;
+    
+    for (;;) {
+        // Fetch a new batch when the current one is used up
+        if (batchPos >= batchCount) {
+            batchCount  = batchStream->read_batch(batch, 7);
+            batchPos    = 0;
+        }
+        
+        const token&    next = batch[batchPos];
+        lexeme*         expectedLexeme;
+        (*lexemeStream) >> expectedLexeme;
+        
+        if (!expectedLexeme) {
+            batchesMatch = batchesMatch && next.matched() == symbol_set::end_of_input && batchPos+1 == batchCount && next.offset() == (int) document.size();
+            break;
+        }
+        
+        if (next.matched() != expectedLexeme->matched()) batchesMatch = false;
+        if (documentLines.position_at(next.offset()) != expectedLexeme->pos()) batchesMatch = false;
+        if (next.length() != (int) expectedLexeme->content().size()) batchesMatch = false;
+        
+        delete expectedLexeme;
+        ++batchPos;
+        
+        if (!batchesMatch) break;
+    }
+    
+    report("BatchMatchesLexemes", batchesMatch);
+    report("BatchAfterEnd", batchStream->read_batch(batch, 7) == 1 && batch[0].matched() == symbol_set::end_of_input);
+    
+    delete lexemeStream;
+    delete batchStream;
+    
+    // Batches of lexemes should match the lexemes read one at a time
+    wstringstream   singleInput(document);
+    wstringstream   lexemeBatchInput(document);
+    lexeme_stream*  singleStream        = bs.get_lexer().create_stream_from(singleInput);
+    lexeme_stream*  lexemeBatchStream   = bs.get_lexer().create_stream_from(lexemeBatchInput);
+    
+    bool    lexemeBatchesMatch  = true;
+    lexeme* lexemeBatch[5];
+    size_t  lexemeBatchCount    = 5;
+    
+    while (lexemeBatchesMatch && lexemeBatchCount == 5) {
+        lexemeBatchCount = lexemeBatchStream->read_batch(lexemeBatch, 5);
+        
+        for (size_t index = 0; index < lexemeBatchCount; ++index) {
+            lexeme* expectedLexeme;
+            (*singleStream) >> expectedLexeme;
+            
+            if (!expectedLexeme) {
+                lexemeBatchesMatch = false;
+            } else {
+                if (lexemeBatch[index]->matched() != expectedLexeme->matched()) lexemeBatchesMatch = false;
+                if (lexemeBatch[index]->pos() != expectedLexeme->pos()) lexemeBatchesMatch = false;
+                if (lexemeBatch[index]->content() != expectedLexeme->content()) lexemeBatchesMatch = false;
+            }
+            
+            delete expectedLexeme;
+            delete lexemeBatch[index];
+        }
+    }
+    
+    lexeme* afterEnd = NULL;
+    (*singleStream) >> afterEnd;
+    
+    report("LexemeBatchMatchesLexemes", lexemeBatchesMatch && afterEnd == NULL);
+    report("LexemeBatchAfterEnd", lexemeBatchStream->read_batch(lexemeBatch, 5) == 0);
+    
+    delete singleStream;
+    delete lexemeBatchStream;
+    
+    // The parser actions should read a lexeme at a time unless batches are turned on
+    wstringstream           singleCountedInput(document);
+    batch_counting_stream*  singleCounted       = new batch_counting_stream(bs.get_lexer().create_stream_from(singleCountedInput));
+    ast_parser::state*      singleCountedParser = astParser.create_parser(new ast_parser_actions(singleCounted));
+    
+    report("ParserReadsSingle", singleCountedParser->parse() && singleCounted->batches == 0 && singleCounted->single > 0);
+    delete singleCountedParser;
+    
+    wstringstream           countedInput(document);
+    batch_counting_stream*  counted         = new batch_counting_stream(bs.get_lexer().create_stream_from(countedInput));
+    ast_parser_actions*     countedActions  = new ast_parser_actions(counted);
+    countedActions->set_batched(true);
+    
+    ast_parser::state*      countedParser   = astParser.create_parser(countedActions);
+    
+    report("ParserReadsBatches", countedParser->parse() && counted->batches > 0 && counted->single == 0);
+    delete countedParser;
+    
+    // Words followed by a '#' and then single letters: the parser actions switch the lexer to the state that
+    // reads letters when the '#' is shifted
+    grammar             stateGrammar;
+    terminal_dictionary stateTerms;
+    
+    nonterminal stateProgram(stateGrammar.id_for_nonterminal(L"Program"));
+    nonterminal stateWords(stateGrammar.id_for_nonterminal(L"Words"));
+    nonterminal stateLetters(stateGrammar.id_for_nonterminal(L"Letters"));
+    
+    int wordId      = stateTerms.add_symbol(L"word");
+    int hashId      = stateTerms.add_symbol(L"'#'");
+    int letterId    = stateTerms.add_symbol(L"letter");
+    
+    (stateGrammar += stateProgram) << stateWords << terminal(hashId) << stateLetters;
+    (stateGrammar += stateWords) << stateWords << terminal(wordId);
+    (stateGrammar += stateWords) << terminal(wordId);
+    (stateGrammar += stateLetters) << stateLetters << terminal(letterId);
+    (stateGrammar += stateLetters) << terminal(letterId);
+    
+    lalr_builder stateBuilder(stateGrammar, stateTerms);
+    stateBuilder.add_initial_state(stateProgram);
+    stateBuilder.complete_parser();
+    
+    state_changing_parser stateParser(stateBuilder, NULL);
+    
+    // The lexer reads words in state 0 and single letters in state 1
+    ndfa_regex stateNdfa;
+    int letterState = stateNdfa.add_state();
+    
+    stateNdfa.add_regex(0, "[a-z]+", wordId);
+    stateNdfa.add_regex(0, "#", hashId);
+    stateNdfa.add_regex(letterState, "[a-z]", letterId);
+    
+    vector<int> stateInitial;
+    stateInitial.push_back(0);
+    stateInitial.push_back(letterState);
+    
+    ndfa*   stateUnique = stateNdfa.to_ndfa_with_unique_symbols();
+    ndfa*   stateDfa    = stateUnique->to_dfa(stateInitial);
+    lexer   stateLexer(*stateDfa);
+    
+    // The change takes effect straight away when lexemes are read one at a time
+    wstringstream                   stateInput(L"ab#cde");
+    state_changing_parser::state*   stateSingle = stateParser.create_parser(new state_changing_actions(stateLexer.create_stream_from(stateInput), hashId, 1));
+    
+    report("ParserChangesLexerState", stateSingle->parse());
+    delete stateSingle;
+    
+    // With batches turned on, 'cde' has already been read as a word in the same batch as the '#'
+    wstringstream               stateBatchInput(L"ab#cde");
+    state_changing_actions*     stateBatchActions   = new state_changing_actions(stateLexer.create_stream_from(stateBatchInput), hashId, 1);
+    stateBatchActions->set_batched(true);
+    
+    state_changing_parser::state* stateBatched = stateParser.create_parser(stateBatchActions);
+    
+    report("BatchedParserLexerStateLags", !stateBatched->parse());
+    delete stateBatched;
+    
+    delete stateUnique;
+    delete stateDfa;
+    
+    // The recogniser should give the same results when reading batches
+    wstringstream   batchValidInput(document);
+    wstringstream   batchBrokenInput(broken);
+    lexeme_stream*  batchValidStream    = bs.get_lexer().create_stream_from(batchValidInput);
+    lexeme_stream*  batchBrokenStream   = bs.get_lexer().create_stream_from(batchBrokenInput);
+    batch_reader    validReader(batchValidStream);
+    batch_reader    brokenReader(batchBrokenStream);
+    
+    report("BatchAcceptDefinition", recog.recognise_from(validReader));
+    report("BatchRejectBroken", !recog.recognise_from(brokenReader));
+    report("BatchErrorPosition", recog.error_position().offset() == brokenErrorPos.offset() && recog.error_symbol() == brokenErrorSymbol);
+    report("BatchErrorPositionResolved", line_index(broken.begin(), broken.end()).resolve(recog.error_position()) == brokenErrorPos);
+    
+    delete batchValidStream;
+    delete batchBrokenStream;
+    
+    // Guards: <Context-Sensitive> = [=> <Matching-Bs> 'c' ] <Matching-Cs> | <Match-D-Recursive>
+    terminal_dictionary terms;
+    grammar             contextSensitive;
+    character_lexer     lex;
+    
+    int aId = terms.add_symbol(L"'a'");
+    int bId = terms.add_symbol(L"'b'");
+    int cId = terms.add_symbol(L"'c'");
+    int dId = terms.add_symbol(L"'d'");
+    
+    terminal a(aId);
+    terminal b(bId);
+    terminal c(cId);
+    terminal d(dId);
+    
+    nonterminal matchingBs(contextSensitive.id_for_nonterminal(L"<Matching-Bs>"));
+    nonterminal matchingCs(contextSensitive.id_for_nonterminal(L"<Matching-Cs>"));
+    nonterminal csLan(contextSensitive.id_for_nonterminal(L"<Context-Sensitive>"));
+    
+    ebnf_repeating someBs;
+    (*someBs.get_rule()) << b;
+    
+    (contextSensitive += L"<Matching-Bs>") << a << matchingBs << b;
+    (contextSensitive += L"<Matching-Bs>") << a << b;
+    (contextSensitive += L"<Matching-Cs>") << a << matchingCs << c;
+    (contextSensitive += L"<Matching-Cs>") << a << someBs << c;
+    
+    guard matchBguard;
+    (*matchBguard.get_rule()) << matchingBs << c;
+    
+    (contextSensitive += L"<Context-Sensitive>") << matchBguard << matchingCs;
+    
+    // Recursive guard: [=> [=> 'd' ] 'd' ] 'd'
+    nonterminal matchOneD(contextSensitive.id_for_nonterminal(L"<Match-D-Recursive>"));
+    guard matchDRecursiveLevel1;
+    guard matchDRecursiveLevel2;
+    
+    (*matchDRecursiveLevel2.get_rule()) << d;
+    (*matchDRecursiveLevel1.get_rule()) << matchDRecursiveLevel2 << d;
+    
+    (contextSensitive += L"<Match-D-Recursive>") << matchDRecursiveLevel1 << d;
+    (contextSensitive += L"<Context-Sensitive>") << matchOneD;
+    
+    lalr_builder csBuilder(contextSensitive, terms);
+    csBuilder.add_initial_state(csLan);
+    csBuilder.complete_parser();
+    
+    parser_tables   csTables(csBuilder, NULL);
+    recogniser      csRecog(csTables);
+    
+    wstring threeOfEach     = wstring(3, (wchar_t) aId) + wstring(3, (wchar_t) bId) + wstring(3, (wchar_t) cId);
+    wstring tooFewBs        = wstring(3, (wchar_t) aId) + wstring(2, (wchar_t) bId) + wstring(3, (wchar_t) cId);
+    wstring tooFewAs        = wstring(2, (wchar_t) aId) + wstring(2, (wchar_t) bId) + wstring(3, (wchar_t) cId);
+    wstring tooManyBs       = wstring(3, (wchar_t) aId) + wstring(4, (wchar_t) bId) + wstring(3, (wchar_t) cId);
+    wstring oneD            = wstring(1, (wchar_t) dId);
+    
+    report("ContextSensitive1", can_recognise(threeOfEach, csRecog, lex));
+    report("ContextSensitive2", !can_recognise(tooFewBs, csRecog, lex));
+    report("ContextSensitive3", !can_recognise(tooFewAs, csRecog, lex));
+    report("ContextSensitive4", !can_recognise(tooManyBs, csRecog, lex));
+    report("RecursiveGuards", can_recognise(oneD, csRecog, lex));
+    
+    // Reading the symbols with a symbol_reader should give the same results
+    report("ReaderContextSensitive1", can_recognise_from(threeOfEach, csRecog));
+    report("ReaderSymbolsRead", csRecog.symbols_read() == threeOfEach.size());
+    can_recognise(tooFewBs, csRecog, lex);
+    position    streamErrorPos      = csRecog.error_position();
+    int         streamErrorSymbol   = csRecog.error_symbol();
+    
+    report("ReaderContextSensitive2", !can_recognise_from(tooFewBs, csRecog));
+    report("ReaderErrorPosition", csRecog.error_position() == streamErrorPos && csRecog.error_symbol() == streamErrorSymbol);
+    report("ReaderContextSensitive3", !can_recognise_from(tooFewAs, csRecog));
+    report("ReaderContextSensitive4", !can_recognise_from(tooManyBs, csRecog));
+    report("ReaderRecursiveGuards", can_recognise_from(oneD, csRecog));
+    
+    // Lexers that don't override read_batch() can still be read in batches
+    wstringstream   characterInput(threeOfEach);
+    lexeme_stream*  characterStream = lex.create_stream_from(characterInput);
+    batch_reader    characterReader(characterStream);
+    
+    report("DefaultBatch", csRecog.recognise_from(characterReader) && csRecog.symbols_read() == threeOfEach.size());
+    delete characterStream;
+}
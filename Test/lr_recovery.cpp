@@ -0,0 +1,238 @@
+//
+//  lr_recovery.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <sstream>
+#include <vector>
+
+#include "lr_recovery.h"
+
+#include "TameParse/Dfa/character_lexer.h"
+#include "TameParse/ContextFree/grammar.h"
+#include "TameParse/Lr/lalr_builder.h"
+#include "TameParse/Lr/ignored_symbols.h"
+#include "TameParse/Lr/parser.h"
+
+using namespace std;
+using namespace dfa;
+using namespace contextfree;
+using namespace lr;
+
+typedef basic_string<wchar_t> int_string;
+typedef basic_stringstream<wchar_t> int_stringstream;
+
+/// \brief Converts a string of characters to a string of terminal symbols
+static int_string symbols(const string& text, int id, int equals, int semicolon, int whitespace = -1) {
+    int_string result;
+    
+    for (string::const_iterator chr = text.begin(); chr != text.end(); ++chr) {
+        switch (*chr) {
+            case 'i': result += (wchar_t) id;           break;
+            case '=': result += (wchar_t) equals;       break;
+            case ';': result += (wchar_t) semicolon;    break;
+            case 'w': result += (wchar_t) whitespace;   break;
+        }
+    }
+    
+    return result;
+}
+
+/// \brief Parses a string of symbols with recovery turned on, and returns the errors that were found
+static bool parse_with_recovery(const int_string& input, simple_parser& parser, const recovery_options& options, simple_parser::error_list& errors, bool& accepted) {
+    character_lexer         lex;
+    int_stringstream        stream(input);
+    simple_parser::state*   state = parser.create_parser(new simple_parser_actions(lex.create_stream_from(stream)));
+    
+    state->set_recovery(options);
+    
+    bool result = state->parse();
+    
+    errors      = state->errors();
+    accepted    = errors.empty() || errors.back().repair != syntax_error::stopped;
+    
+    delete state;
+    return result;
+}
+
+void test_lr_recovery::run_tests() {
+    // A list of assignments, with an error production for statements
+    grammar             gram;
+    terminal_dictionary terms;
+    
+    nonterminal program(gram.id_for_nonterminal(L"Program"));
+    nonterminal statements(gram.id_for_nonterminal(L"Statements"));
+    nonterminal statement(gram.id_for_nonterminal(L"Statement"));
+    
+    int idId            = terms.add_symbol(L"'i'");
+    int equalsId        = terms.add_symbol(L"'='");
+    int semicolonId     = terms.add_symbol(L"';'");
+    int errorId         = terms.add_symbol(L"error");
+    int whitespaceId    = terms.add_symbol(L"whitespace");
+    
+    terminal id(idId);
+    terminal equals(equalsId);
+    terminal semicolon(semicolonId);
+    terminal errorSymbol(errorId);
+    
+    // Program -> Statements
+    (gram += program) << statements;
+    
+    // Statements -> Statements Statement | (empty)
+    (gram += statements) << statements << statement;
+    (gram += statements);
+    
+    // Statement -> i = i ; | error ;
+    (gram += statement) << id << equals << id << semicolon;
+    (gram += statement) << errorSymbol << semicolon;
+    
+    lalr_builder builder(gram, terms);
+    builder.add_initial_state(program);
+    builder.complete_parser();
+    
+    simple_parser parser(builder, NULL);
+    
+    recovery_options        options(errorId);
+    simple_parser::error_list errors;
+    bool                    accepted;
+    
+    // Valid input has no errors
+    report("NoErrors", parse_with_recovery(symbols("i=i;i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted));
+    report("NoErrors2", errors.empty());
+    
+    // A missing semicolon is inserted
+    report("Insert", !parse_with_recovery(symbols("i=i i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted));
+    report("Insert2", accepted && errors.size() == 1);
+    report("Insert3", errors.size() == 1 && errors[0].repair == syntax_error::inserted && errors[0].repair_symbol == semicolonId && errors[0].symbol == idId);
+    
+    // Including at the end of the input
+    parse_with_recovery(symbols("i=i;i=i", idId, equalsId, semicolonId), parser, options, errors, accepted);
+    report("InsertAtEnd", accepted && errors.size() == 1 && errors[0].repair == syntax_error::inserted && errors[0].symbol == parser.get_tables().end_of_input());
+    
+    // An extra semicolon is deleted
+    parse_with_recovery(symbols("i=i;;i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted);
+    report("Delete", accepted && errors.size() == 1 && errors[0].repair == syntax_error::deleted && errors[0].symbol == semicolonId);
+    
+    // A symbol in the wrong place is replaced
+    parse_with_recovery(symbols("i;i;i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted);
+    report("Replace", accepted && errors.size() == 1 && errors[0].repair == syntax_error::replaced && errors[0].repair_symbol == equalsId);
+    
+    // Statements that can't be repaired use the error production
+    parse_with_recovery(symbols("i=i=i;i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted);
+    report("ErrorProduction", accepted && errors.size() == 1 && errors[0].repair == syntax_error::skipped);
+    report("ErrorProduction2", errors.size() == 1 && errors[0].repair_symbol == errorId && errors[0].skipped_symbols == 2 && errors[0].popped_states == 3);
+    
+    // Every error in the input is found in one pass
+    parse_with_recovery(symbols("i=i=i;i=i;i i;i=i;;i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted);
+    report("MultipleErrors", accepted && errors.size() == 3);
+    report("MultipleErrors2", errors.size() == 3 && errors[0].repair == syntax_error::skipped && errors[1].repair == syntax_error::inserted && errors[2].repair == syntax_error::deleted);
+    
+    // Errors just after an earlier one are not reported
+    parse_with_recovery(symbols("i=i=i;;i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted);
+    report("CascadingErrors", accepted && errors.size() == 1);
+    
+    // The parser stops after the maximum number of errors
+    recovery_options oneError(errorId);
+    oneError.max_errors = 1;
+    
+    parse_with_recovery(symbols("i=i=i;i=i;i i;i=i;", idId, equalsId, semicolonId), parser, oneError, errors, accepted);
+    report("MaxErrors", !accepted && errors.size() == 2 && errors[1].repair == syntax_error::stopped);
+    
+    // Without repairs, the error production is used for everything
+    recovery_options noRepairs(errorId);
+    noRepairs.try_repairs = false;
+    
+    parse_with_recovery(symbols("i=i i=i;", idId, equalsId, semicolonId), parser, noRepairs, errors, accepted);
+    report("NoRepairs", accepted && errors.size() == 1 && errors[0].repair == syntax_error::skipped && errors[0].repair_symbol == errorId);
+    
+    // Without an error symbol, the stack is unwound to a state that can shift a symbol from the input
+    recovery_options noErrorSymbol;
+    noErrorSymbol.try_repairs = false;
+    
+    parse_with_recovery(symbols("i=i=i;i=i;", idId, equalsId, semicolonId), parser, noErrorSymbol, errors, accepted);
+    report("Unwind", accepted && errors.size() == 1 && errors[0].repair == syntax_error::skipped && errors[0].repair_symbol == -1);
+    report("Unwind2", errors.size() == 1 && errors[0].skipped_symbols == 0 && errors[0].popped_states == 2);
+    
+    // Input that ends too early can't be recovered without inserting symbols
+    parse_with_recovery(symbols("i=i;i=", idId, equalsId, semicolonId), parser, noErrorSymbol, errors, accepted);
+    report("UnwindAtEnd", accepted && errors.size() == 1 && errors[0].popped_states == 2);
+    
+    // Errors record the symbols that could have been accepted
+    parse_with_recovery(symbols("i=i i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted);
+    report("Expected", errors.size() == 1 && errors[0].is_expected(semicolonId) && !errors[0].is_expected(idId) && !errors[0].is_expected(equalsId));
+    
+    parse_with_recovery(symbols("i=i;=i=i;", idId, equalsId, semicolonId), parser, options, errors, accepted);
+    report("ExpectedAfterReduce", errors.size() == 1 && errors[0].is_expected(idId) && errors[0].is_expected(errorId) && !errors[0].is_expected(semicolonId));
+    
+    // With compressed tables, the default reductions are followed to find the same symbols
+    parser_tables compressed(parser.get_tables());
+    compressed.compress();
+    
+    simple_parser compressedParser(compressed);
+    
+    report("CompressedHasExpected", compressed.expected_terminals() != NULL && compressed.count_terminals() > semicolonId);
+    
+    parse_with_recovery(symbols("i=i;=i=i;", idId, equalsId, semicolonId), compressedParser, options, errors, accepted);
+    report("ExpectedDefaultReduction", errors.size() == 1 && errors[0].is_expected(idId) && errors[0].is_expected(errorId) && !errors[0].is_expected(semicolonId));
+    
+    // Tables without the expected terminals table give the same result
+    parser_tables noExpected(compressed.count_states(), compressed.end_of_input(), compressed.end_of_guard(), 
+                             const_cast<parser_tables::action**>(compressed.terminal_actions()), const_cast<parser_tables::action**>(compressed.nonterminal_actions()), 
+                             const_cast<parser_tables::action_count*>(compressed.action_counts()), const_cast<int*>(compressed.end_of_guard_states()), compressed.count_end_of_guards(), 
+                             compressed.count_reduce_rules(), const_cast<parser_tables::reduce_rule*>(compressed.reduce_rules()), 0, NULL, const_cast<int*>(compressed.default_reductions()));
+    simple_parser noExpectedParser(noExpected);
+    
+    parse_with_recovery(symbols("i=i;=i=i;", idId, equalsId, semicolonId), noExpectedParser, options, errors, accepted);
+    report("ExpectedWithoutTable", noExpected.expected_terminals() == NULL && errors.size() == 1 && errors[0].is_expected(idId) && errors[0].is_expected(errorId) && !errors[0].is_expected(semicolonId));
+    
+    // Ignored symbols don't count as being parsed when checking a repair
+    lalr_builder        ignoreBuilder(gram, terms);
+    ignored_symbols*    ignored = new ignored_symbols();
+    
+    ignored->add_item(terminal(whitespaceId));
+    ignoreBuilder.add_rewriter(action_rewriter_container(ignored, true));
+    ignoreBuilder.add_initial_state(program);
+    ignoreBuilder.complete_parser();
+    
+    simple_parser ignoreParser(ignoreBuilder, NULL);
+    
+    parse_with_recovery(symbols("i=i;wiw=iw;", idId, equalsId, semicolonId, whitespaceId), ignoreParser, options, errors, accepted);
+    report("IgnoredSymbols", accepted && errors.empty());
+    
+    parse_with_recovery(symbols("i=;wiw=i;", idId, equalsId, semicolonId, whitespaceId), ignoreParser, options, errors, accepted);
+    report("IgnoredSymbolsRepair", accepted && errors.size() == 1 && errors[0].repair == syntax_error::inserted && errors[0].repair_symbol == idId);
+    
+    // Without recovery, parsing stops at the first error
+    character_lexer         lex;
+    int_stringstream        stream(symbols("i=i i=i;", idId, equalsId, semicolonId));
+    simple_parser::state*   state = parser.create_parser(new simple_parser_actions(lex.create_stream_from(stream)));
+    
+    report("NoRecovery", !state->parse());
+    report("NoRecovery2", state->errors().empty() && state->look().item() && state->look()->matched() == idId);
+    
+    vector<unsigned int> expected;
+    state->expected_terminals(expected);
+    report("ExpectedTerminals", !expected.empty() && (expected[semicolonId / 32] & (1u << (semicolonId % 32))) != 0);
+    
+    delete state;
+}
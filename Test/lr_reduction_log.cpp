@@ -0,0 +1,163 @@
+//
+//  lr_reduction_log.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include "lr_reduction_log.h"
+#include "TameParse/Language/bootstrap.h"
+#include "TameParse/Lr/ast_parser.h"
+#include "TameParse/Lr/reduction_log.h"
+#include "TameParse/Lr/lazy_ast.h"
+
+using namespace std;
+using namespace util;
+using namespace dfa;
+using namespace lr;
+using namespace yy_language;
+
+/// \brief Parser that records a reduction log
+typedef parser<reduction_log::entry_id, reduction_log_actions> log_parser;
+
+/// \brief Returns true if two ASTs are the same
+static bool same_tree(const astnode* a, const astnode* b) {
+    if (a == NULL || b == NULL)                         return a == b;
+    if (a->item_identifier() != b->item_identifier())   return false;
+    if (a->rule() != b->rule())                         return false;
+    if (a->children().size() != b->children().size())  return false;
+    
+    for (size_t child = 0; child < a->children().size(); ++child) {
+        if (!same_tree(a->children()[child].item(), b->children()[child].item())) return false;
+    }
+    
+    return true;
+}
+
+void test_lr_reduction_log::run_tests() {
+    bootstrap bs;
+    
+    // Use the language definition as the document
+    const string&           definition  = bootstrap::get_default_language_definition();
+    wstring                 document(definition.begin(), definition.end());
+    const parser_tables&    tables      = bs.get_parser().get_tables();
+    
+    // Parse with the normal AST parser to get the expected result
+    wstringstream       expectedInput(document);
+    ast_parser          astParser(tables);
+    ast_parser::state*  expected    = astParser.create_parser(new ast_parser_actions(bs.get_lexer().create_stream_from(expectedInput)));
+    
+    report("ParseAst", expected->parse());
+    
+    // Parse again, recording a log
+    wstringstream       logInput(document);
+    log_parser          logParser(tables);
+    log_parser::state*  logged      = logParser.create_parser(new reduction_log_actions(bs.get_lexer().create_stream_from(logInput), true));
+    
+    report("ParseLog", logged->parse());
+    
+    const reduction_log&    log     = logged->get_actions()->log();
+    reduction_log::entry_id root    = logged->get_item();
+    
+    // The root should be the final entry, and should cover the whole log and every lexeme
+    report("RootIsLast", root == log.size() - 1);
+    report("RootCoversLog", log[root].first == 0);
+    report("RootCoversLexemes", log[root].firstToken == 0 && log[root].endToken == log.lexemes().size());
+    
+    // Every lexeme that was shifted should have a terminal entry
+    size_t terminalCount = 0;
+    for (reduction_log::entry_id entry = 0; entry < log.size(); ++entry) {
+        if (log.is_terminal(entry)) ++terminalCount;
+    }
+    report("TerminalEntries", terminalCount == log.lexemes().size());
+    
+    // The children of the root should match the children of the AST
+    const astnode*                  expectedRoot = expected->get_item().item();
+    vector<reduction_log::entry_id> children;
+    log.children(root, children);
+    
+    bool sameChildren = children.size() == expectedRoot->children().size() && children.size() == log[root].length;
+    for (size_t child = 0; sameChildren && child < children.size(); ++child) {
+        if (log[children[child]].symbol != expectedRoot->children()[child]->item_identifier()) sameChildren = false;
+    }
+    report("Children", sameChildren);
+    
+    // Building a subtree on its own should give the same result as the same part of the full AST
+    lazy_ast<ast_parser_actions> partial(log);
+    report("SameSubtree", !children.empty() && same_tree(partial.get_tree(children.back()).item(), expectedRoot->children().back().item()));
+    
+    // Building the whole thing should give the same AST as the normal parser
+    lazy_ast<ast_parser_actions> lazy(log);
+    report("SameAst", same_tree(lazy.get_tree(root).item(), expectedRoot));
+    report("SameTreeTwice", lazy.get_tree(root).item() == lazy.get_tree(root).item());
+    
+    // Fetching a node on its own should only build its terminals, and not the nonterminals below it
+    lazy_ast<ast_parser_actions>    shallow(log);
+    const astnode*                  shallowRoot = shallow.get(root).item();
+    
+    bool shallowNode = shallowRoot->item_identifier() == expectedRoot->item_identifier() 
+                    && shallowRoot->children().size() == expectedRoot->children().size()
+                    && shallow.count_children(root) == children.size();
+    for (size_t child = 0; shallowNode && child < children.size(); ++child) {
+        const astnode* shallowChild     = shallowRoot->children()[child].item();
+        const astnode* expectedChild    = expectedRoot->children()[child].item();
+        
+        if (log.is_terminal(children[child])) {
+            shallowNode = same_tree(shallowChild, expectedChild);
+        } else {
+            shallowNode = shallowChild->children().empty() && shallowChild->item_identifier() != expectedChild->item_identifier();
+        }
+    }
+    report("ShallowNode", shallowNode);
+    report("SameNodeTwice", shallow.get(root).item() == shallowRoot);
+    
+    // The children should be built when they are fetched
+    bool fetchedChildren = true;
+    for (size_t child = 0; child < children.size(); ++child) {
+        const astnode* fetched = shallow.child(root, child).item();
+        
+        if (fetched->item_identifier() != expectedRoot->children()[child]->item_identifier())    fetchedChildren = false;
+        if (fetched->children().size() != expectedRoot->children()[child]->children().size())   fetchedChildren = false;
+        if (fetched != shallow.get(children[child]).item())                                     fetchedChildren = false;
+    }
+    report("ChildOnAccess", fetchedChildren);
+    
+    // A small document with repetitions and an empty rule
+    wstringstream       smallInput(L"language Example { keywords { a b } grammar { <A> = a+ (b | <A>)* } }");
+    log_parser::state*  small   = logParser.create_parser(new reduction_log_actions(bs.get_lexer().create_stream_from(smallInput), true));
+    
+    wstringstream       smallExpectedInput(L"language Example { keywords { a b } grammar { <A> = a+ (b | <A>)* } }");
+    ast_parser::state*  smallExpected = astParser.create_parser(new ast_parser_actions(bs.get_lexer().create_stream_from(smallExpectedInput)));
+    
+    report("SmallParse", small->parse() && smallExpected->parse());
+    
+    lazy_ast<ast_parser_actions> smallLazy(small->get_actions()->log());
+    report("SmallSameAst", same_tree(smallLazy.get_tree(small->get_item()).item(), smallExpected->get_item().item()));
+    
+    delete small;
+    delete smallExpected;
+    delete logged;
+    delete expected;
+}
@@ -37,9 +37,21 @@
 #include "contextfree_followset.h"
 #include "lr_weaksymbols.h"
 #include "lr_lalr_general.h"
+#include "lr_concurrent.h"
+#include "lr_incremental.h"
+#include "lr_push.h"
+#include "lr_binary_tables.h"
+#include "lr_compressed_tables.h"
+#include "lr_reduction_log.h"
+#include "lr_recogniser.h"
+#include "lr_recovery.h"
+#include "util_container.h"
 #include "language_bootstrap.h"
 #include "language_primary.h"
 #include "dfa_multi_regex.h"
+#include "dfa_incremental_lexer.h"
+#include "dfa_pipelined_stream.h"
+#include "dfa_line_index.h"
 
 using namespace std;
 
@@ -62,6 +74,9 @@ int main (int argc, const char * argv[])
     test_dfa_symbol_translator  trans;          run(trans);
     test_dfa_single_regex       singleregex;    run(singleregex);
     test_dfa_multi_regex        multiregex;     run(multiregex);
+    test_dfa_incremental_lexer  incLexer;       run(incLexer);
+    test_dfa_pipelined_stream   pipelined;      run(pipelined);
+    test_dfa_line_index         lineIndex;      run(lineIndex);
     
     test_contextfree_firstset   firstset;       run(firstset);
     test_contextfree_followset  followset;      run(followset);
@@ -72,6 +87,17 @@ int main (int argc, const char * argv[])
     test_language_bootstrap     bootstrap;      run(bootstrap);
     test_language_primary       primary;        run(primary);
     
+    test_lr_concurrent          concurrent;     run(concurrent);
+    test_lr_incremental         incremental;    run(incremental);
+    test_lr_push                push;           run(push);
+    test_lr_binary_tables       binaryTables;   run(binaryTables);
+    test_lr_compressed_tables   compressed;     run(compressed);
+    test_lr_reduction_log       reductionLog;   run(reductionLog);
+    test_lr_recogniser          recogniser;     run(recogniser);
+    test_lr_recovery            recovery;       run(recovery);
+    
+    test_util_container         container;      run(container);
+    
     int exitCode = 0;
     if (s_Failed > 0) {
         cerr << endl << s_Failed << "/" << s_Run << " tests failed" << endl;
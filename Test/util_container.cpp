@@ -0,0 +1,102 @@
+//
+//  util_container.cpp
+//  Parse
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+#include <utility>
+
+#include "util_container.h"
+#include "TameParse/Util/container.h"
+#include "TameParse/Util/syntax_ptr.h"
+
+using namespace std;
+using namespace util;
+
+/// \brief Simple item that can be stored in a container
+class test_item {
+public:
+    int value;
+    
+    test_item() : value(0) { }
+    test_item(int val) : value(val) { }
+    
+    test_item* clone() const { return new test_item(value); }
+    
+    static bool compare(const test_item* a, const test_item* b) {
+        if (a == b) return false;
+        if (!a)     return true;
+        if (!b)     return false;
+        
+        return a->value < b->value;
+    }
+    
+    bool operator==(const test_item& compareTo) const { return value == compareTo.value; }
+};
+
+typedef container<test_item> item_container;
+
+void test_util_container::run_tests() {
+    // Moving a container leaves the original empty
+    item_container  original(test_item(4));
+    item_container  moved(std::move(original));
+    
+    report("MovedValue", moved->value == 4);
+    report("MovedFromEmpty", original.item() == NULL);
+    
+    // Moved-from containers can still be copied, assigned and compared
+    item_container copied(original);
+    report("CopyMovedFrom", copied.item() == NULL);
+    
+    item_container assigned(test_item(5));
+    assigned = original;
+    report("AssignMovedFrom", assigned.item() == NULL);
+    
+    report("CompareMovedFrom", original == copied && original != moved);
+    report("OrderMovedFrom", original < moved && !(moved < original));
+    
+    // ... and can be used again once assigned to
+    original = moved;
+    report("ReuseMovedFrom", original->value == 4 && original == moved);
+    
+    // Moving assignment
+    item_container target;
+    target = std::move(moved);
+    report("MoveAssign", target->value == 4 && moved.item() == NULL);
+    
+    // Syntax pointers behave in the same way
+    syntax_ptr<test_item>   pointer(new test_item(7));
+    syntax_ptr<test_item>   movedPointer(std::move(pointer));
+    
+    report("PointerMoved", movedPointer && movedPointer->value == 7);
+    report("PointerMovedFromNull", !pointer && pointer.item() == NULL);
+    
+    syntax_ptr<test_item> copiedPointer(pointer);
+    report("PointerCopyMovedFrom", !copiedPointer);
+    
+    syntax_ptr<test_item> assignedPointer(new test_item(8));
+    assignedPointer = pointer;
+    report("PointerAssignMovedFrom", !assignedPointer);
+    
+    report("PointerCastMovedFrom", !pointer.cast_to<test_item>());
+    report("PointerDefaultNull", !syntax_ptr<test_item>());
+}
@@ -0,0 +1,195 @@
+//
+//  flat_ast_test.cpp
+//  bench
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+//
+//
+// Checks that the flat AST generated with --flat-ast matches the standard AST
+//
+// Parses the same JSON document with both generated parsers, then walks the two trees together, checking that
+// each node has the same children and that the nodes cover the same parts of the input.
+//
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "TameParse/TameParse.h"
+
+#include "json.h"
+#include "json_flat.h"
+
+using namespace std;
+
+typedef yy_JSON         standard;
+typedef yy_flat::yy_JSON flat;
+
+/// \brief Number of nodes that have been compared
+static int s_Compared = 0;
+
+/// \brief Returns true if two nodes cover the same part of the input
+template<class standard_node, class flat_node> static bool same_span(const standard_node& node, const flat_node& flatNode) {
+    ++s_Compared;
+    return node->pos() == flatNode.pos() && node->final_pos() == flatNode.final_pos();
+}
+
+/// \brief Returns true if a terminal has the same symbol, text and position in both trees
+template<class standard_node, class flat_node> static bool same_terminal(const standard_node& node, const flat_node& flatNode) {
+    if (!node.item() || !flatNode.item()) return !node.item() && !flatNode.item();
+    
+    return node->get_lexeme()->matched() == flatNode.matched()
+        && node->template content<wchar_t>() == flatNode.template content<wchar_t>()
+        && same_span(node, flatNode);
+}
+
+static bool same_value(const util::syntax_ptr<standard::yy_Value_n>& value, const flat::yy_Value_n& flatValue);
+
+/// \brief Returns true if a list has the same items in both trees (an empty list can be missing from either tree)
+template<class standard_list, class flat_list, class item_compare> static bool same_list(const util::syntax_ptr<standard_list>& list, const flat_list& flatList, item_compare compare) {
+    size_t count        = list.item() ? list->size() : 0;
+    size_t flatCount    = flatList.item() ? flatList.size() : 0;
+    if (count != flatCount) return false;
+    if (count == 0) return true;
+    
+    typename flat_list::iterator flatItem = flatList.begin();
+    for (typename standard_list::iterator item = list->begin(); item != list->end(); ++item, ++flatItem) {
+        if (!compare(*item, *flatItem)) return false;
+    }
+    
+    return same_span(list, flatList);
+}
+
+/// \brief Compares the items in a list of pairs
+static bool same_pair_item(const util::syntax_ptr<standard::yy_list_of__comma__Pair_n_content>& item, const flat::yy_list_of__comma__Pair_n_content& flatItem) {
+    if (!same_terminal(item->yy__comma_, flatItem.yy__comma_())) return false;
+    
+    const util::syntax_ptr<standard::yy_Pair_n>&    pair        = item->yy_Pair;
+    flat::yy_Pair_n                                 flatPair    = flatItem.yy_Pair();
+    
+    return same_terminal(pair->yy_name, flatPair.yy_name())
+        && same_terminal(pair->yy__colon_, flatPair.yy__colon_())
+        && same_value(pair->yy_value, flatPair.yy_value())
+        && same_span(pair, flatPair)
+        && same_span(item, flatItem);
+}
+
+/// \brief Compares the items in a list of values
+static bool same_value_item(const util::syntax_ptr<standard::yy_list_of__comma__Value_n_content>& item, const flat::yy_list_of__comma__Value_n_content& flatItem) {
+    return same_terminal(item->yy__comma_, flatItem.yy__comma_())
+        && same_value(item->yy_Value, flatItem.yy_Value())
+        && same_span(item, flatItem);
+}
+
+/// \brief Returns true if an object is the same in both trees
+static bool same_object(const util::syntax_ptr<standard::yy_Object_n>& object, const flat::yy_Object_n& flatObject) {
+    if (!object.item() || !flatObject.item()) return !object.item() && !flatObject.item();
+    
+    // The first pair is stored in the same way as the items in the list
+    bool sameFirst = true;
+    if (object->yy_first.item() || flatObject.yy_first().item()) {
+        const util::syntax_ptr<standard::yy_Pair_n>&    first       = object->yy_first;
+        flat::yy_Pair_n                                 flatFirst   = flatObject.yy_first();
+        
+        sameFirst = first.item() && flatFirst.item()
+                 && same_terminal(first->yy_name, flatFirst.yy_name())
+                 && same_terminal(first->yy__colon_, flatFirst.yy__colon_())
+                 && same_value(first->yy_value, flatFirst.yy_value())
+                 && same_span(first, flatFirst);
+    }
+    
+    return same_terminal(object->yy__opencurly_, flatObject.yy__opencurly_())
+        && sameFirst
+        && same_list(object->yy_pairs, flatObject.yy_pairs(), same_pair_item)
+        && same_terminal(object->yy__closecurly_, flatObject.yy__closecurly_())
+        && same_span(object, flatObject);
+}
+
+/// \brief Returns true if an array is the same in both trees
+static bool same_array(const util::syntax_ptr<standard::yy_Array_n>& array, const flat::yy_Array_n& flatArray) {
+    if (!array.item() || !flatArray.item()) return !array.item() && !flatArray.item();
+    
+    return same_terminal(array->yy__opensquare_, flatArray.yy__opensquare_())
+        && same_value(array->yy_first, flatArray.yy_first())
+        && same_list(array->yy_remainder, flatArray.yy_remainder(), same_value_item)
+        && same_terminal(array->yy__closesquare_, flatArray.yy__closesquare_())
+        && same_span(array, flatArray);
+}
+
+/// \brief Returns true if a value is the same in both trees
+static bool same_value(const util::syntax_ptr<standard::yy_Value_n>& value, const flat::yy_Value_n& flatValue) {
+    if (!value.item() || !flatValue.item()) return !value.item() && !flatValue.item();
+    
+    // Only the child for the rule that was reduced should be set
+    return same_terminal(value->yy_string, flatValue.yy_string())
+        && same_terminal(value->yy_number, flatValue.yy_number())
+        && same_object(value->yy_Object, flatValue.yy_Object())
+        && same_array(value->yy_Array, flatValue.yy_Array())
+        && same_terminal(value->yy_true, flatValue.yy_true())
+        && same_terminal(value->yy_false, flatValue.yy_false())
+        && same_terminal(value->yy_null, flatValue.yy_null())
+        && same_span(value, flatValue);
+}
+
+int main(int argc, const char* argv[]) {
+    // A document that uses every rule in the JSON grammar, spread over several lines
+    const string document = 
+        "{ \"name\": \"flat\", \"count\": -12.5e3,\n"
+        "  \"flags\": [true, false, null],\n"
+        "  \"empty\": [], \"nothing\": {},\n"
+        "  \"nested\": { \"list\": [ [1], [\"two\\n\", { \"three\": 3 }] ] }\n"
+        "}\n";
+    
+    stringstream        input(document);
+    standard::state*    state = standard::create_yy_Object(input);
+    
+    stringstream        flatInput(document);
+    flat::state*        flatState = flat::create_yy_Object(flatInput);
+    
+    bool accepted       = state->parse();
+    bool flatAccepted   = flatState->parse();
+    bool same           = false;
+    
+    if (accepted && flatAccepted) {
+        util::syntax_ptr<standard::yy_Object_n> root        = state->get_item().cast_to<standard::yy_Object_n>();
+        flat::yy_Object_n                       flatRoot(&flatState->get_actions()->pool(), flatState->get_item());
+        
+        same = root.item() && flatRoot.item() && same_object(root, flatRoot);
+    }
+    
+    delete state;
+    delete flatState;
+    
+    if (!accepted || !flatAccepted) {
+        cerr << "Document was rejected (standard: " << accepted << ", flat: " << flatAccepted << ")" << endl;
+        return 1;
+    }
+    
+    if (!same) {
+        cerr << "The flat AST does not match the standard AST" << endl;
+        return 1;
+    }
+    
+    cerr << s_Compared << " nodes are the same in both trees" << endl;
+    return 0;
+}
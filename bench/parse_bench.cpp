@@ -0,0 +1,796 @@
+//
+//  parse_bench.cpp
+//  bench
+//
+//  Copyright (c) 2011-2012 Andrew Hunter
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the \"Software\"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+//  IN THE SOFTWARE.
+//
+
+//
+// Parse throughput benchmarks
+//
+// Generates parsers for several of the example languages, then measures how quickly they process synthetic
+// input of various sizes in each of these modes:
+//
+//   lex             lexing only
+//   validate        running the recogniser, which keeps no lexemes
+//   batch           validating with the lexer filling batches of tokens ahead of the recogniser
+//   fused-validate  validating with the generated loop that runs the lexer and the recogniser together without
+//                   virtual calls
+//   parse           parsing without building an AST
+//   lazy            parsing into a reduction log, from which the AST can be built lazily
+//   ast             parsing with full AST construction
+//   pipeline        parsing with full AST construction while the lexer runs on a second thread
+//   flat            parsing into a flat AST (generated with --flat-ast)
+//   stream          building the AST for each top-level item, then passing it to a callback that discards it
+//
+// With --batched, the parsing modes read lexemes from the lexer a batch at a time (none of these languages change
+// the lexer state). Each measurement runs in its own process so that the peak memory usage can be reported separately.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <new>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "TameParse/TameParse.h"
+
+#include "ansic.h"
+#include "c99.h"
+#include "pascal.h"
+#include "json.h"
+
+#include "ansic_flat.h"
+#include "c99_flat.h"
+#include "pascal_flat.h"
+#include "json_flat.h"
+
+using namespace std;
+
+// ===
+// Allocation counting
+// ===
+
+/// \brief Number of calls made to operator new since the process started
+static size_t s_Allocations = 0;
+
+/// \brief True if the parser actions should read lexemes a batch at a time
+static bool s_Batched = false;
+
+void* operator new(size_t size) {
+    ++s_Allocations;
+    void* result = malloc(size ? size : 1);
+    if (!result) throw std::bad_alloc();
+    return result;
+}
+
+void* operator new[](size_t size) {
+    ++s_Allocations;
+    void* result = malloc(size ? size : 1);
+    if (!result) throw std::bad_alloc();
+    return result;
+}
+
+void operator delete(void* ptr) noexcept                { free(ptr); }
+void operator delete[](void* ptr) noexcept              { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept        { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept      { free(ptr); }
+
+// ===
+// Streams
+// ===
+
+///
+/// \brief Symbol stream that reads bytes from a block of memory
+///
+class memory_symbol_stream : public dfa::lexer_symbol_stream {
+private:
+    /// \brief The next character to read
+    const unsigned char* m_Pos;
+
+    /// \brief The end of the buffer
+    const unsigned char* m_End;
+
+public:
+    memory_symbol_stream(const string& buffer)
+    : m_Pos((const unsigned char*) buffer.data())
+    , m_End((const unsigned char*) buffer.data() + buffer.size()) {
+    }
+
+    /// \brief Reads the next symbol from this stream
+    virtual lexer_symbol_stream& operator>>(int& result) {
+        if (m_Pos >= m_End) {
+            result = dfa::symbol_set::end_of_input;
+        } else {
+            result = *m_Pos;
+            ++m_Pos;
+        }
+        return *this;
+    }
+};
+
+///
+/// \brief Source of characters that reads from a buffer in memory without any virtual calls (for dfa::symbol_reader)
+///
+class memory_source {
+private:
+    /// \brief The next character to read
+    const unsigned char* m_Pos;
+
+    /// \brief The end of the buffer
+    const unsigned char* m_End;
+
+    /// \brief False once a read has gone past the end of the buffer
+    bool m_Good;
+
+public:
+    memory_source(const string& buffer)
+    : m_Pos((const unsigned char*) buffer.data())
+    , m_End((const unsigned char*) buffer.data() + buffer.size())
+    , m_Good(true) {
+    }
+
+    /// \brief Reads the next character, as for std::istream::get()
+    inline void get(unsigned char& result) {
+        if (m_Pos >= m_End) {
+            m_Good = false;
+        } else {
+            result = *m_Pos;
+            ++m_Pos;
+        }
+    }
+
+    /// \brief True if the last read was successful
+    inline bool good() const { return m_Good; }
+};
+
+///
+/// \brief Lexeme stream that counts the lexemes read from another stream
+///
+class counting_lexeme_stream : public dfa::lexeme_stream {
+private:
+    /// \brief The stream that this is reading from (destroyed with this object)
+    dfa::lexeme_stream* m_Source;
+
+    /// \brief Updated with the number of lexemes read from the stream
+    size_t& m_Count;
+
+public:
+    counting_lexeme_stream(dfa::lexeme_stream* source, size_t& count)
+    : m_Source(source)
+    , m_Count(count) {
+    }
+
+    virtual ~counting_lexeme_stream() {
+        delete m_Source;
+    }
+
+    /// \brief Reads the next lexeme from the source stream
+    virtual lexeme_stream& operator>>(dfa::lexeme*& result) {
+        (*m_Source) >> result;
+        if (result) ++m_Count;
+        return *this;
+    }
+
+    /// \brief Reads the next symbol from the source stream without keeping its text
+    virtual bool read_symbol(int& matched, dfa::position& pos) {
+        if (!m_Source->read_symbol(matched, pos)) return false;
+        ++m_Count;
+        return true;
+    }
+
+    /// \brief Reads a batch of tokens from the source stream
+    virtual size_t read_batch(dfa::token* out, size_t count) {
+        size_t read = m_Source->read_batch(out, count);
+
+        // The end of input token isn't a lexeme
+        m_Count += read;
+        if (read > 0 && out[read-1].matched() == dfa::symbol_set::end_of_input) --m_Count;
+
+        return read;
+    }
+
+    /// \brief Reads a batch of lexemes from the source stream
+    virtual size_t read_batch(dfa::lexeme** out, size_t count) {
+        size_t read = m_Source->read_batch(out, count);
+        m_Count += read;
+        return read;
+    }
+};
+
+///
+/// \brief Parser actions that count reductions but do not build any AST
+///
+class counting_actions {
+private:
+    /// \brief The lexer associated with the object, destroyed when the object is destructed
+    dfa::lexeme_stream* m_Lexer;
+
+    /// \brief Reads lexemes from the lexer (a batch at a time with --batched)
+    dfa::lexeme_batch_reader m_Reader;
+
+    /// \brief Updated with the number of reductions performed by the parser
+    size_t& m_Reductions;
+
+    counting_actions(const counting_actions& noCopying);
+    counting_actions& operator=(const counting_actions& noCopying);
+
+public:
+    counting_actions(dfa::lexeme_stream* lexer, size_t& reductions)
+    : m_Lexer(lexer)
+    , m_Reader(lexer)
+    , m_Reductions(reductions) {
+        m_Reader.set_batched(s_Batched);
+    }
+
+    ~counting_actions() { delete m_Lexer; }
+
+    /// \brief Reads the next symbol from the stream
+    inline dfa::lexeme* read() {
+        return m_Reader.read();
+    }
+
+    /// \brief Returns the item resulting from a shift action
+    inline int shift(const dfa::lexeme_container& lexeme) {
+        return 0;
+    }
+
+    /// \brief Returns the item resulting from a reduce action
+    inline int reduce(int nonterminal, int rule, const lr::parser<int, counting_actions>::reduce_list& reduce, const dfa::position& lookaheadPosition) {
+        ++m_Reductions;
+        return 0;
+    }
+};
+
+/// \brief Parser that only counts the actions it performs
+typedef lr::parser<int, counting_actions> counting_parser;
+
+// ===
+// Measurements
+// ===
+
+/// \brief The stages that can be measured
+enum bench_mode {
+    /// \brief Run the lexer only
+    mode_lex,
+
+    /// \brief Run the recogniser (validation only: no lexemes are kept)
+    mode_validate,
+
+    /// \brief Run the recogniser, reading batches of tokens from the lexer
+    mode_batch,
+
+    /// \brief Run the generated validation loop, which runs the lexer and the recogniser together
+    mode_fused_validate,
+
+    /// \brief Run the parser without building an AST
+    mode_parse,
+
+    /// \brief Run the parser, recording a reduction log instead of building an AST
+    mode_lazy,
+
+    /// \brief Run the parser and build the AST
+    mode_ast,
+
+    /// \brief Run the parser and build the AST, with the lexer running on a separate thread
+    mode_pipeline,
+
+    /// \brief Run the parser and build a flat AST
+    mode_flat,
+
+    /// \brief Run the parser, passing the AST for each top-level item to a callback instead of keeping it
+    mode_stream
+};
+
+/// \brief Names of the stages (indexed by bench_mode)
+static const char* s_ModeNames[] = { "lex", "validate", "batch", "fused-validate", "parse", "lazy", "ast", "pipeline", "flat", "stream" };
+
+///
+/// \brief Results from a single benchmark run
+///
+struct measurement {
+    /// \brief True if the input was accepted
+    bool success;
+
+    /// \brief Time taken to process the input
+    double seconds;
+
+    /// \brief Number of lexemes read from the lexer
+    size_t tokens;
+
+    /// \brief Number of reductions performed by the parser (0 if this was not measured)
+    size_t reductions;
+
+    /// \brief Number of allocations made while processing the input
+    size_t allocations;
+
+    /// \brief Peak resident set size of the process, in kilobytes
+    long peakRssKb;
+};
+
+/// \brief Returns the number of seconds elapsed since the specified time
+static double seconds_since(const chrono::steady_clock::time_point& start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/// \brief Subtree callback used by the streaming benchmark: counts the subtrees and then discards them
+template<class language> static void discard_subtree(const typename language::parser_actions::node& subtree, void* context) {
+    ++*(size_t*) context;
+}
+
+///
+/// \brief Runs the benchmark for the specified generated parser class
+///
+/// The flat AST benchmark uses flat_language, which should be generated from the same grammar with --flat-ast.
+/// The streaming benchmark passes the subtrees for streamNonterminal to a callback.
+///
+template<class language, class flat_language, int streamNonterminal> static measurement run_benchmark(bench_mode mode, const string& input) {
+    measurement result;
+    memset(&result, 0, sizeof(result));
+
+    // Create the lexer for this input
+    dfa::lexeme_stream* stream = new counting_lexeme_stream(language::lexer.create_stream(new memory_symbol_stream(input)), result.tokens);
+
+    size_t                      initialAllocations  = s_Allocations;
+    chrono::steady_clock::time_point start          = chrono::steady_clock::now();
+
+    switch (mode) {
+        case mode_lex:
+        {
+            // Read every lexeme from the stream
+            dfa::lexeme* next = NULL;
+            for (;;) {
+                (*stream) >> next;
+                if (!next) break;
+                delete next;
+            }
+
+            result.seconds  = seconds_since(start);
+            result.success  = true;
+            delete stream;
+            break;
+        }
+
+        case mode_validate:
+        {
+            // Run the recogniser over the symbol IDs from the lexer
+            lr::recogniser recogniser(language::lr_tables);
+
+            result.success  = recogniser.recognise(stream);
+            result.seconds  = seconds_since(start);
+            delete stream;
+            break;
+        }
+
+        case mode_batch:
+        {
+            // Run the recogniser, with the lexer producing a batch of tokens at a time
+            lr::recogniser      recogniser(language::lr_tables);
+            dfa::batch_reader   reader(stream);
+
+            result.success  = recogniser.recognise_from(reader);
+            result.seconds  = seconds_since(start);
+            delete stream;
+            break;
+        }
+
+        case mode_fused_validate:
+        {
+            // Run the lexer and the recogniser in a single loop, reading straight from the input (only validation
+            // is fused: the other parsing modes read lexemes from a stream)
+            lr::recogniser  recogniser(language::lr_tables);
+            memory_source   source(input);
+
+            result.success  = language::template validate<unsigned char>(source, 0, recogniser);
+            result.seconds  = seconds_since(start);
+            result.tokens   = recogniser.symbols_read();
+            delete stream;
+            break;
+        }
+
+        case mode_parse:
+        {
+            // Run a parser that doesn't generate any AST
+            counting_parser             parser(language::lr_tables);
+            counting_parser::state*     state = parser.create_parser(new counting_actions(stream, result.reductions));
+
+            result.success  = state->parse();
+            result.seconds  = seconds_since(start);
+            delete state;
+            break;
+        }
+
+        case mode_lazy:
+        {
+            // Run the parser that records a reduction log
+            lr::reduction_log_actions*      actions = new lr::reduction_log_actions(stream, true);
+            actions->set_batched(s_Batched);
+            
+            typename language::lazy_state*  state   = language::lazy_parser.create_parser(actions);
+
+            result.success  = state->parse();
+            result.seconds  = seconds_since(start);
+            delete state;
+            break;
+        }
+
+        case mode_ast:
+        {
+            // Run the generated AST parser
+            typename language::parser_actions*  actions = new typename language::parser_actions(stream, true);
+            actions->set_batched(s_Batched);
+            
+            typename language::state*           state   = language::ast_parser.create_parser(actions);
+
+            result.success  = state->parse();
+            result.seconds  = seconds_since(start);
+            delete state;
+            break;
+        }
+
+        case mode_pipeline:
+        {
+            // Run the generated AST parser, reading lexemes from a lexer on another thread
+            dfa::lexeme_stream*                 pipelined   = new dfa::pipelined_stream(stream);
+            typename language::parser_actions*  actions     = new typename language::parser_actions(pipelined, true);
+            actions->set_batched(s_Batched);
+            
+            typename language::state*           state       = language::ast_parser.create_parser(actions);
+
+            result.success  = state->parse();
+            result.seconds  = seconds_since(start);
+            delete state;
+            break;
+        }
+
+        case mode_flat:
+        {
+            // Run the generated parser for the flat AST
+            typename flat_language::parser_actions* actions = new typename flat_language::parser_actions(stream, true);
+            actions->set_batched(s_Batched);
+            
+            typename flat_language::state*          state   = flat_language::ast_parser.create_parser(actions);
+
+            result.success  = state->parse();
+            result.seconds  = seconds_since(start);
+            delete state;
+            break;
+        }
+
+        case mode_stream:
+        {
+            // Run the generated AST parser, discarding each top-level item once it has been parsed
+            size_t                                  subtrees = 0;
+            typename language::parser_actions*      actions  = new typename language::parser_actions(stream, true);
+            actions->on_reduce(streamNonterminal, discard_subtree<language>, &subtrees);
+            actions->set_batched(s_Batched);
+
+            typename language::state* state = language::ast_parser.create_parser(actions);
+
+            result.success  = state->parse() && subtrees > 0;
+            result.seconds  = seconds_since(start);
+            delete state;
+            break;
+        }
+    }
+
+    // Allocations made while destroying the parser or the AST aren't counted as they don't happen in the timed section
+    result.allocations = s_Allocations - initialAllocations;
+
+    // Fetch the peak memory usage
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    result.peakRssKb = usage.ru_maxrss / 1024;
+#else
+    result.peakRssKb = usage.ru_maxrss;
+#endif
+
+    return result;
+}
+
+// ===
+// Input generation
+// ===
+
+/// \brief Generates synthetic JSON input of at least the specified size
+static void generate_json(string& target, size_t size) {
+    target = "{ \"records\": [\n";
+
+    for (int index = 0; target.size() < size; ++index) {
+        ostringstream record;
+
+        if (index > 0) record << ",\n";
+        record  << "  { \"id\": " << index << ", \"name\": \"record " << index << "\", \"score\": -" << index % 1000 << ".25e3, "
+                << "\"active\": " << (index%2 ? "true" : "false") << ", \"parent\": null, "
+                << "\"tags\": [\"alpha\", \"beta\\n\", " << index % 17 << "], \"meta\": { \"depth\": { \"level\": [] } } }";
+
+        target += record.str();
+    }
+
+    target += "\n] }\n";
+}
+
+/// \brief Generates synthetic C input of at least the specified size (accepted by both the ANSI C and C99 parsers)
+static void generate_c(string& target, size_t size) {
+    target = "typedef struct node { struct node* next; int value; } node;\n\n";
+
+    for (int index = 0; target.size() < size; ++index) {
+        ostringstream function;
+
+        function    << "static int function_" << index << "(int count, const char* name, node* list) {\n"
+                    << "    int total = 0;\n"
+                    << "    int i;\n"
+                    << "    for (i = 0; i < count; i++) {\n"
+                    << "        total += name[i] * (i + " << index << ");\n"
+                    << "        if (total > 1000 && list->next != 0) { total = total % 7; } else { total = total - 1; }\n"
+                    << "    }\n"
+                    << "    while (total > 0) total--;\n"
+                    << "    /* Comment " << index << " */\n"
+                    << "    return (int) total + helper(count, &name[1], \"string " << index << "\");\n"
+                    << "}\n\n";
+
+        target += function.str();
+    }
+}
+
+/// \brief Generates synthetic Pascal input of at least the specified size
+static void generate_pascal(string& target, size_t size) {
+    target = "program Bench;\n\n";
+
+    for (int index = 0; target.size() < size; ++index) {
+        ostringstream procedure;
+
+        procedure   << "procedure P" << index << "(x : integer; var y : real);\n"
+                    << "var i, j : integer;\n"
+                    << "begin\n"
+                    << "  for i := 1 to x do\n"
+                    << "  begin\n"
+                    << "    j := i * 2 + " << index << ";\n"
+                    << "    { Comment " << index << " }\n"
+                    << "    if j > 10 then y := y + j / 3 else y := y - 1.5e2\n"
+                    << "  end;\n"
+                    << "  while x > 0 do x := x - 1\n"
+                    << "end;\n\n";
+
+        target += procedure.str();
+    }
+
+    target += "begin\n  writeln('done')\nend.\n";
+}
+
+// ===
+// Driver
+// ===
+
+///
+/// \brief Description of a language that can be benchmarked
+///
+struct bench_language {
+    /// \brief The name of this language
+    const char* name;
+
+    /// \brief Function that generates input for this language
+    void (*generate)(string& target, size_t size);
+
+    /// \brief Function that runs a benchmark for this language
+    measurement (*run)(bench_mode mode, const string& input);
+};
+
+/// \brief The languages that are benchmarked (with the top-level items that are discarded by the streaming benchmark)
+static const bench_language s_Languages[] = {
+    { "ansic",  generate_c,         run_benchmark<yy_Ansi_C, yy_flat::yy_Ansi_C, yy_Ansi_C::nt::yy_External_Declaration> },
+    { "c99",    generate_c,         run_benchmark<yy_C99, yy_flat::yy_C99, yy_C99::nt::yy_External_Declaration> },
+    { "pascal", generate_pascal,    run_benchmark<yy_Pascal, yy_flat::yy_Pascal, yy_Pascal::nt::yy_Procedure_Declaration> },
+    { "json",   generate_json,      run_benchmark<yy_JSON, yy_flat::yy_JSON, yy_JSON::nt::yy_Value> }
+};
+
+/// \brief Runs a benchmark in a child process, so the peak memory usage is for that benchmark alone
+static bool run_isolated(const bench_language& language, bench_mode mode, const string& input, measurement& result) {
+    // Flush any pending output so it isn't duplicated in the child
+    cout.flush();
+
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    pid_t child = fork();
+    if (child < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (child == 0) {
+        // Run the benchmark and send the results to the parent
+        close(fds[0]);
+        measurement childResult = language.run(mode, input);
+        ssize_t written = write(fds[1], &childResult, sizeof(childResult));
+        close(fds[1]);
+        _exit(written == sizeof(childResult) ? 0 : 1);
+    }
+
+    // Read the results from the child (this will fail if the child crashes or runs out of memory)
+    close(fds[1]);
+    ssize_t didRead = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(child, &status, 0);
+
+    return didRead == sizeof(result);
+}
+
+/// \brief Parses a size such as '16M' or '1G'
+static size_t parse_size(const string& size) {
+    char*   suffix  = NULL;
+    double  value   = strtod(size.c_str(), &suffix);
+
+    switch (suffix ? *suffix : 0) {
+        case 'k': case 'K': value *= 1024.0; break;
+        case 'm': case 'M': value *= 1024.0*1024.0; break;
+        case 'g': case 'G': value *= 1024.0*1024.0*1024.0; break;
+    }
+
+    return (size_t) value;
+}
+
+/// \brief Splits a comma separated list
+static vector<string> split_list(const string& list) {
+    vector<string>  result;
+    stringstream    items(list);
+    string          item;
+
+    while (getline(items, item, ',')) {
+        if (!item.empty()) result.push_back(item);
+    }
+
+    return result;
+}
+
+/// \brief Displays the usage message
+static void usage() {
+    cerr    << "Syntax: parse_bench [--sizes <size>,...] [--grammar <name>,...] [--mode lex|validate|batch|fused-validate|parse|lazy|ast|pipeline|flat|stream,...] [--repeat <n>] [--batched]\n"
+            << "  Sizes may have a K, M or G suffix (default: 1M,16M,256M,1G)\n"
+            << "  Grammars are ansic, c99, pascal and json (default: all)\n"
+            << "  Each measurement is made n times, and the fastest is reported (default: 1)\n"
+            << "  --batched makes the parsing modes read lexemes from the lexer a batch at a time\n";
+}
+
+int main(int argc, const char* argv[]) {
+    vector<string> sizes        = split_list("1M,16M,256M,1G");
+    vector<string> grammars;
+    vector<string> modes        = split_list("lex,validate,batch,fused-validate,parse,lazy,ast,pipeline,flat,stream");
+    int            repeat       = 1;
+
+    // Parse the command line
+    for (int arg = 1; arg < argc; ++arg) {
+        string option = argv[arg];
+
+        if (arg+1 < argc && option == "--sizes") {
+            sizes = split_list(argv[++arg]);
+        } else if (arg+1 < argc && option == "--grammar") {
+            grammars = split_list(argv[++arg]);
+        } else if (arg+1 < argc && option == "--mode") {
+            modes = split_list(argv[++arg]);
+        } else if (arg+1 < argc && option == "--repeat") {
+            repeat = atoi(argv[++arg]);
+            if (repeat < 1) repeat = 1;
+        } else if (option == "--batched") {
+            s_Batched = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    // Write out the header
+    cout    << left << setw(8) << "grammar" << right << setw(8) << "size" << "  " << left << setw(14) << "mode" << right
+            << setw(10) << "MB/s" << setw(14) << "tokens/s" << setw(14) << "reductions/s" << setw(14) << "allocs/token" << setw(14) << "peak RSS KB"
+            << endl;
+
+    bool allSucceeded = true;
+
+    for (size_t languageId = 0; languageId < sizeof(s_Languages)/sizeof(s_Languages[0]); ++languageId) {
+        const bench_language& language = s_Languages[languageId];
+
+        // Skip languages that weren't asked for
+        bool wanted = grammars.empty();
+        for (vector<string>::const_iterator grammar = grammars.begin(); grammar != grammars.end(); ++grammar) {
+            if (*grammar == language.name) wanted = true;
+        }
+        if (!wanted) continue;
+
+        for (vector<string>::const_iterator size = sizes.begin(); size != sizes.end(); ++size) {
+            // Generate the input for this run
+            string input;
+            language.generate(input, parse_size(*size));
+
+            // The reduction count is only available without the AST, but is the same for every run with the same input
+            size_t reductions = 0;
+
+            for (int mode = mode_lex; mode <= mode_stream; ++mode) {
+                // Skip modes that weren't asked for
+                bool wantMode = false;
+                for (vector<string>::const_iterator name = modes.begin(); name != modes.end(); ++name) {
+                    if (*name == s_ModeNames[mode]) wantMode = true;
+                }
+                if (!wantMode) continue;
+
+                cout << left << setw(8) << language.name << right << setw(8) << *size << "  " << left << setw(14) << s_ModeNames[mode] << right;
+
+                // Run the benchmark, keeping the fastest run
+                measurement result;
+                bool        completed = true;
+
+                for (int run = 0; completed && run < repeat; ++run) {
+                    measurement next;
+                    completed = run_isolated(language, (bench_mode) mode, input, next);
+
+                    if (completed && (run == 0 || !next.success || next.seconds < result.seconds)) {
+                        result = next;
+                    }
+                    if (!result.success) break;
+                }
+
+                if (!completed) {
+                    cout << "  failed (benchmark process did not complete)" << endl;
+                    allSucceeded = false;
+                    continue;
+                }
+
+                if (!result.success) {
+                    cout << "  failed (input was rejected after " << result.tokens << " tokens)" << endl;
+                    allSucceeded = false;
+                    continue;
+                }
+
+                if (result.reductions) reductions = result.reductions;
+
+                double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+
+                cout    << fixed << setprecision(2) << setw(10) << (input.size() / (1024.0*1024.0)) / seconds
+                        << setprecision(0) << setw(14) << result.tokens / seconds;
+
+                if (mode == mode_lex || reductions == 0) {
+                    cout << setw(14) << "-";
+                } else {
+                    cout << setw(14) << reductions / seconds;
+                }
+
+                cout    << setprecision(2) << setw(14) << (result.tokens ? (double) result.allocations / (double) result.tokens : 0.0)
+                        << setw(14) << result.peakRssKb
+                        << endl;
+            }
+        }
+    }
+
+    return allSucceeded ? 0 : 1;
+}
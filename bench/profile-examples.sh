@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# Runs the parser generator with --profile over each of the example languages
+#
+# Usage: profile-examples.sh [tameparse] [examples directory] [output directory]
+#
+# A JSON file with the time and memory used by each stage is written to the output directory
+# for each example, and a summary is written to stdout.
+
+# Name of the tameparse runner
+tameparse=${1:-../parsetool/tameparse}
+
+# The directory containing the examples
+examples_dir=${2:-${srcdir:-.}/../Examples}
+
+# Where the profile results and generated parsers are written
+output_dir=${3:-profile-results}
+
+mkdir -p "${output_dir}"
+
+printf "%-24s %14s %14s\n" "language" "wall seconds" "peak RSS KB"
+
+success=1
+
+for definition_file in ${examples_dir}/*.tp
+do
+	name=`basename "${definition_file}" .tp`
+
+	# The start symbols for the examples that don't specify a parser block
+	case "${name}" in
+		AnsiC|C99)	start_symbol="<Translation-Unit>" ;;
+		Pascal)		start_symbol="<Program>" ;;
+		*)			start_symbol=`grep -o -m 1 '^[[:space:]]*<[A-Za-z0-9_-]*>[[:space:]]*=' "${definition_file}" | grep -o '<[^>]*>'` ;;
+	esac
+
+	${tameparse} --enable-lr1-resolver --silent -T cplusplus -S "${start_symbol}" \
+		--profile "${output_dir}/${name}.json" -o "${output_dir}/${name}" "${definition_file}"
+
+	if [ "$?" -ne "0" ]; then
+		printf "%-24s %14s\n" "${name}" "failed"
+		success=0
+		continue
+	fi
+
+	# The first values in the file are the totals for the whole run
+	wall_seconds=`grep -m 1 '"wall_seconds"' "${output_dir}/${name}.json" | sed -e 's/.*: *//' -e 's/,//'`
+	peak_rss=`grep -m 1 '"peak_rss_kb"' "${output_dir}/${name}.json" | sed -e 's/.*: *//' -e 's/,//'`
+
+	printf "%-24s %14s %14s\n" "${name}" "${wall_seconds}" "${peak_rss}"
+done
+
+# Return failure if any of the languages could not be built
+if [ "$success" -ne "1" ]; then
+	exit 1
+fi
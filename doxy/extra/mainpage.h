@@ -52,6 +52,12 @@
 /// This will generate C++ source for a parser for the requested language. This
 /// parser depends on the tameparse library to operate.
 ///
+/// Alternatively, the tables for the lexer and parser can be written to a binary
+/// file with `--output-language=binary`. This produces `example.tpt`, which can
+/// be loaded at runtime with `lr::binary_tables` without compiling any generated
+/// code. Loading is fast: on little-endian machines the file is mapped into memory
+/// and used as it is.
+///
 /// ## Running the C++ parser
 ///
 /// (The following API details are preliminary, I plan to improve them so that
@@ -104,3 +110,131 @@
 ///
 /// will have an `identifier` field containing the details about the token that
 /// was matched.
+///
+/// ## Flat ASTs
+///
+/// Passing `--flat-ast` to the tool generates an AST that is stored in arrays
+/// owned by the parser actions instead of as separately allocated, reference
+/// counted objects. Nodes refer to their children by a 32-bit index and the
+/// text of each terminal is a span of a single buffer, so building the tree
+/// only allocates when one of the arrays needs to grow.
+///
+/// The node classes are then small handles that are passed by value, and
+/// fields are read with accessor methods. The root of the tree is retrieved
+/// with a function generated for each start symbol:
+///
+///     example::Example_n ast = example::get_Example(state);
+///     std::wstring name = ast.identifier()->content<wchar_t>();
+///
+/// The tree belongs to the parser state and is destroyed along with it.
+/// Repetitions are stored as linked lists: they are best read with an iterator
+/// as indexing them takes linear time.
+///
+/// ## Building the AST lazily
+///
+/// When the tool is run with `--lazy-ast`, the generated class also has a
+/// `create_lazy_X()` function for each start symbol. The parser it creates
+/// records a log of the rules it reduced (lr::reduction_log) instead of
+/// building the AST. Nodes for any entry in the log can then be built when
+/// they are first needed with the generated `lazy_ast` class:
+///
+///     example::lazy_state* state = example::create_lazy_Example(std::wcin);
+///     state->parse();
+///
+///     example::lazy_ast ast(state->get_actions()->log());
+///     example::Example_n* root = (example::Example_n*) ast.get(state->get_item()).item();
+///
+/// `get()` only builds the requested node: the nonterminals in it are left
+/// empty, and are built when they are fetched with `ast.child(entry, index)`.
+/// Use `get_tree()` to build a node along with everything below it.
+///
+/// Scanning the log for the entries for a particular nonterminal is cheap, so
+/// this suits programs that only need a small part of the tree.
+///
+/// ## Validating the input
+///
+/// To check whether or not some input is valid without building anything from
+/// it, use the generated `validate_X()` functions. These run the lexer and the
+/// parser tables with lr::recogniser, which only keeps symbol IDs and parser
+/// states, so the lexer doesn't create a lexeme for each token:
+///
+///     lr::recogniser recogniser(example::lr_tables);
+///     if (!example::validate_Example(std::wcin, recogniser)) {
+///         dfa::position error = recogniser.error_position();
+///     }
+///
+/// A recogniser can be reused for many documents, and stops allocating memory
+/// once it has grown to fit them.
+///
+/// When reading from a stream, these functions use dfa::symbol_reader to run
+/// the lexer's state machine in the same loop as the recogniser, without any
+/// virtual calls. `validate<char_type>(input, initialState, recogniser)` does
+/// the same for any class with `get()` and `good()` methods. Only validation
+/// is done this way: the parser actions that build the AST need lexemes, so
+/// the `create_X()` parsers still read them from a lexeme stream.
+///
+/// ## Lexing on a separate thread
+///
+/// For very large documents, the lexer can be run on its own thread while the
+/// parser runs on the current one by wrapping its stream in a dfa::pipelined_stream:
+///
+///     dfa::lexeme_stream* stream = new dfa::pipelined_stream(example::lexer.create_stream_from<wchar_t>(std::wcin));
+///     example::state* state = example::create_Example(stream, true);
+///
+/// The lexer reads ahead of the parser, so this can't be used if the parser
+/// changes the lexer's state while it runs. Pass true as the third argument
+/// to the constructor for such a language: the stream then reads the lexer
+/// on the parser's thread, one lexeme at a time. An exception thrown by the
+/// lexer on its own thread is thrown again from the parser's thread.
+///
+/// ## Recovering from syntax errors
+///
+/// By default, lr::parser::state::parse() stops at the first syntax error. To
+/// find every error in a document in a single pass, turn on error recovery
+/// before parsing:
+///
+///     state->set_recovery(lr::recovery_options(example::t::yy_error));
+///     if (!state->parse()) {
+///         const example::ast_parser_type::error_list& errors = state->errors();
+///     }
+///
+/// The parser first tries to fix each error by inserting, deleting or
+/// replacing a single symbol. If that doesn't work, it uses the error
+/// productions in the grammar. These use the reserved terminal `error`, which
+/// the lexer never produces:
+///
+///     <Statement> = identifier '=' <Expression> ';'
+///                 | error ';'
+///
+/// The parser discards entries from its stack until it finds a state that can
+/// shift `error`, and then skips symbols until one that can follow it is found.
+/// Grammars without error productions still recover, by skipping symbols until
+/// a state on the stack can shift one of them. Recovery costs nothing until
+/// the parser rejects a symbol.
+///
+/// Each error records the terminal symbols that the parser could have accepted
+/// in its place, which is useful for error messages:
+///
+///     if (errors[0].is_expected(example::t::identifier)) { ... }
+///
+/// lr::parser::state::expected_terminals() finds the same set for a parser
+/// that has stopped at an error. The generated tables store this set for every
+/// state, so it is quick to find.
+///
+/// ## Working out lines and columns later
+///
+/// Lexeme streams normally work out the line and column of every lexeme as
+/// they read it. Programs that rarely need them, for example to report an
+/// occasional error, can turn this off:
+///
+///     stream->set_offsets_only(true);
+///
+/// Lexemes then have the offset of their first symbol and -1 for the line and
+/// column. A dfa::line_index built from the same input fills these in when
+/// they are needed:
+///
+///     dfa::line_index lines(document.begin(), document.end());
+///     dfa::position where = lines.resolve(lexeme->pos());
+///
+/// Input made of 8-bit characters is indexed 16 characters at a time where the
+/// processor supports SSE2.
@@ -48,6 +48,7 @@ namespace fs = boost::filesystem;
 boost_console::boost_console(const boost_console& bc)
 : std_console(L"")
 , m_VarMap(bc.m_VarMap) {
+    set_profiler(bc.get_profiler());
 }
 
 /// \brief Constructor
@@ -67,6 +68,9 @@ boost_console::boost_console(int argc, const char** argv)
         ("output-language,T",   po::value<string>(),            "specifies the output language the parser will be generated in.")
         ("class-name,C",        po::value<string>(),            "specifies the name of the class to generate (overriding anything defined in the parser block of the input file)")
         ("namespace-name,N",    po::value<string>(),            "specifies the namespace to put the target class into.")
+        ("flat-ast",                                            "generate the AST as arrays of nodes that refer to each other by index, instead of as reference counted objects (C++ only).")
+        ("stats-parser",                                        "also generate a parser that collects statistics about each parse (C++ only).")
+        ("lazy-ast",                                            "also generate a parser that records the reductions it makes, so the AST can be built from them when it is needed (C++ only, not available with --flat-ast).")
         ("run-tests",                                           "if the language contains any tests, then run them")
         ("test",                                                "specifies that no output should be generated. This tool will instead try to read from stdin and indicate whether or not it can be accepted.");
 
@@ -76,6 +80,7 @@ boost_console::boost_console(int argc, const char** argv)
         ("help,h",                                              "display help message.")
         ("verbose,v",                                           "display verbose messages.")
         ("silent",                                              "suppress informational messages.")
+        ("profile",             po::value<string>(),            "record the time and memory used by each stage of the parser generator and write it to the specified file in JSON format ('-' writes to standard output).")
         ("version",                                             "display version information.")
         ("warranty",                                            "display warranty information.")
         ("license",                                             "display license information.");
@@ -86,6 +91,8 @@ boost_console::boost_console(int argc, const char** argv)
         ("compile-language,L",  po::value<string>(),            "specifies the name of the language block to compile (overriding anything defined in the parser block of the input file)")
         ("start-symbol,S",      po::value< vector<string> >(),  "specifies the name of the start symbol (overriding anything defined in the parser block of the input file)")
         ("enable-lr1-resolver",                                 "attempt to resolve reduce/reduce conflicts that would be allowed by a LR(1) parser")
+        ("compress-tables",                                     "use a default reduction in each parser state to make the parser tables smaller")
+        ("build-cache",         po::value<string>(),            "store the lexer and parser in the specified directory, and reuse them in later runs if the language has not changed.")
         ("show-parser",                                         "writes the generated parser to standard out");
     
     po::options_description errorOptions("Error reporting");
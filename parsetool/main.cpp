@@ -29,6 +29,7 @@
 #include "boost_console.h"
 
 #include <iostream>
+#include <sstream>
 #include <memory>
 
 using namespace std;
@@ -40,12 +41,90 @@ using namespace tameparse;
 using namespace yy_language;
 using namespace compiler;
 
+///
+/// \brief Writes out the results from a profiler when it goes out of scope
+///
+/// This is used to write out the results of the --profile option however the parser generator exits
+///
+class profile_writer {
+private:
+    /// \brief The console that the profile results are written with
+    boost_console& m_Console;
+
+    /// \brief The file that the results should be written to ('-' for stdout)
+    wstring m_Filename;
+
+    /// \brief The profiler to write out
+    profiler& m_Profiler;
+
+public:
+    profile_writer(boost_console& console, const wstring& filename, profiler& profiler)
+    : m_Console(console)
+    , m_Filename(filename)
+    , m_Profiler(profiler) {
+    }
+
+    ~profile_writer() {
+        if (m_Filename == L"-") {
+            // The other output is written to wcout, so we can't mix in narrow characters here
+            // (The JSON output only ever contains ASCII characters)
+            stringstream json;
+            m_Profiler.write_json(json);
+
+            string jsonString = json.str();
+            wcout << wstring(jsonString.begin(), jsonString.end()) << flush;
+            return;
+        }
+
+        ostream* profileFile = m_Console.open_binary_file_for_writing(m_Filename);
+        if (!profileFile) {
+            m_Console.report_error(error(error::sev_error, m_Filename, L"CANT_WRITE_PROFILE", L"Unable to write profile results", position(-1, -1, -1)));
+            return;
+        }
+
+        m_Profiler.write_json(*profileFile);
+        delete profileFile;
+    }
+};
+
+/// \brief Creates the message for a syntax error found by the --test option, listing the terminals that were expected
+static wstring syntax_error_message(const syntax_error& syntaxError, const terminal_dictionary& terminals, int errorSymbol) {
+    wstringstream msg;
+    bool          first = true;
+    
+    msg << L"Syntax error";
+    
+    for (int terminal = 0; terminal < (int) syntaxError.expected.size() * 32; ++terminal) {
+        // The error symbol is never in the input
+        if (terminal == errorSymbol || !syntaxError.is_expected(terminal)) continue;
+        
+        msg << (first ? L" (expected " : L", ") << terminals.name_for_symbol(terminal);
+        first = false;
+    }
+    
+    if (!first) {
+        msg << L")";
+    }
+    
+    return msg.str();
+}
+
 int main (int argc, const char * argv[])
 {
     // Create the console
     boost_console       console(argc, argv);
     console_container   cons(&console, false);
     
+    // Record where the time goes if the --profile option is specified
+    wstring                         profileFilename = console.get_option(L"profile");
+    profiler                        tameparseProfiler;
+    auto_ptr<profile_writer>        profileWriter;
+    
+    if (!profileFilename.empty()) {
+        console.set_profiler(&tameparseProfiler);
+        profileWriter = auto_ptr<profile_writer>(new profile_writer(console, profileFilename, tameparseProfiler));
+    }
+    
     try {
         // Give up if the console is set not to start
         if (!console.can_start()) {
@@ -217,18 +296,40 @@ int main (int argc, const char * argv[])
             return error::sev_error;
         }
         
-        // Generate the lexer for the target language
-        lexer_stage lexerStage(cons, importStage.file_with_language(buildLanguageName), compileLanguageStage);
-        lexerStage.compile();
-
-        // Stop if we have an error
-        if (console.exit_code()) {
-            return console.exit_code();
+        // Use the build cache if one was requested (it can't be used when the LALR builder needs to be displayed, as the
+        // cache only contains the final parser tables)
+        auto_ptr<build_cache>   buildCache(NULL);
+        wstring                 cacheDirectory = console.get_option(L"build-cache");
+        
+        if (!cacheDirectory.empty()
+            && console.get_option(L"show-parser").empty()
+            && console.get_option(L"show-parser-closure").empty()
+            && console.get_option(L"show-propagation").empty()) {
+            buildCache = auto_ptr<build_cache>(new build_cache(cons, importStage.file_with_language(buildLanguageName), cacheDirectory, &importStage, compileLanguageStage, buildLanguageName, startSymbols));
+            buildCache->compile();
         }
-
-        // Generate the parser
+        
+        // The lexer and parser stages for the target language
+        lexer_stage     lexerStage(cons, importStage.file_with_language(buildLanguageName), compileLanguageStage);
         lr_parser_stage lrParserStage(cons, importStage.file_with_language(buildLanguageName), compileLanguageStage, &lexerStage, startSymbols);
-        lrParserStage.compile();
+        
+        if (!buildCache.get() || !buildCache->load(lexerStage, lrParserStage)) {
+            // Generate the lexer for the target language
+            lexerStage.compile();
+
+            // Stop if we have an error
+            if (console.exit_code()) {
+                return console.exit_code();
+            }
+
+            // Generate the parser
+            lrParserStage.compile();
+            
+            // Store the results in the cache if they were built successfully
+            if (buildCache.get() && !console.exit_code()) {
+                buildCache->store(lexerStage, lrParserStage);
+            }
+        }
         
         // Write the parser out if requested
         if (!console.get_option(L"show-parser").empty() || !console.get_option(L"show-parser-closure").empty()) {
@@ -315,7 +416,10 @@ int main (int argc, const char * argv[])
         
         if (targetLanguage == L"cplusplus") {
             // Use the C++ language generator
-            outputStage = auto_ptr<output_stage>(new output_cplusplus(cons, importStage.file_with_language(buildLanguageName), &lexerStage, compileLanguageStage, &lrParserStage, prefixFilename, buildClassName, buildNamespaceName));
+            outputStage = auto_ptr<output_stage>(new output_cplusplus(cons, importStage.file_with_language(buildLanguageName), &lexerStage, compileLanguageStage, &lrParserStage, prefixFilename, buildClassName, buildNamespaceName, !console.get_option(L"flat-ast").empty(), !console.get_option(L"stats-parser").empty(), !console.get_option(L"lazy-ast").empty()));
+        } else if (targetLanguage == L"binary") {
+            // Write the lexer and parser tables to a binary file
+            outputStage = auto_ptr<output_stage>(new output_binary(cons, importStage.file_with_language(buildLanguageName), &lexerStage, compileLanguageStage, &lrParserStage, prefixFilename));
         } else if (targetLanguage == L"test") {
             // Special case: read from stdin, and try to parse the source language
             ast_parser parser(*lrParserStage.get_tables());
@@ -324,16 +428,18 @@ int main (int argc, const char * argv[])
             lexeme_stream* stdinStream      = lexerStage.get_lexer()->create_stream_from(wcin);
             ast_parser::state* stdInParser  = parser.create_parser(new ast_parser_actions(stdinStream));
             
+            // Carry on after syntax errors so that they can all be reported
+            stdInParser->set_recovery(recovery_options(compileLanguageStage->error_symbol()));
+            
             // Parse stdin
             if (stdInParser->parse()) {
                 console.verbose_stream() << formatter::to_string(*stdInParser->get_item(), *compileLanguageStage->grammar(), *compileLanguageStage->terminals()) << endl;
             } else {
-                position failPos(-1, -1, -1);
-                if (stdInParser->look().item()) {
-                    failPos = stdInParser->look()->pos();
-                }
+                const ast_parser::error_list& errors = stdInParser->errors();
                 
-                console.report_error(error(error::sev_error, L"stdin", L"TEST_PARSER_ERROR", L"Syntax error", failPos));
+                for (ast_parser::error_list::const_iterator syntaxError = errors.begin(); syntaxError != errors.end(); ++syntaxError) {
+                    console.report_error(error(error::sev_error, L"stdin", L"TEST_PARSER_ERROR", syntax_error_message(*syntaxError, *compileLanguageStage->terminals(), compileLanguageStage->error_symbol()), syntaxError->pos));
+                }
             }
         } else if (targetLanguage == L"test-trace") {
             // Special case: same as for test, but use the debug version of the parser